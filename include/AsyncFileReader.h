@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include "BoundedQueue.h"
+
+// Whole-file contents produced by the reader
+struct FileBuffer {
+  size_t fileIndex = 0;     // Index into the path list given to readAll
+  bool ok = false;
+  std::string content;
+  std::string error;
+};
+
+enum class ReaderBackend {
+  IoUring,      // Linux io_uring: opens and reads queued asynchronously from one thread
+  ThreadPool,   // Blocking open/pread/close on a pool of I/O threads
+  Stream        // std::ifstream per file on the pool (the original loader path)
+};
+
+// Reads many small files with many requests in flight and hands the finished
+// buffers to consumers through a bounded queue, in completion order.
+// io_uring is driven through raw syscalls (no liburing dependency) and is used
+// when the kernel supports the needed opcodes; otherwise the thread pool is used.
+class AsyncFileReader {
+public:
+  // queueDepth = files in flight at once; ioThreads = pool size for the fallback (0 = queueDepth)
+  explicit AsyncFileReader(size_t queueDepth = 64, unsigned int ioThreads = 0);
+
+  // Read every path into output (blocking while it is full), then close output
+  void readAll(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output);
+
+  // Force a backend (IoUring falls back to ThreadPool if unavailable)
+  void setBackend(ReaderBackend backend);
+  ReaderBackend getBackend() const { return backend; }
+
+  static bool isIoUringAvailable();
+  static const char* getBackendName(ReaderBackend backend);
+
+  // Ask the OS to drop the cached pages of these files so the next read is cold (best effort)
+  static void evictFromPageCache(const std::vector<std::string>& paths);
+
+private:
+  size_t queueDepth;
+  unsigned int ioThreads;
+  ReaderBackend backend;
+
+  bool readAllIoUring(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output);
+  void readAllThreadPool(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output, bool useStreams);
+  static void readFileBlocking(const std::string& path, FileBuffer& buffer, bool useStream);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+
+// Console micro-benchmarks for the data-parallel kernels.
+// Results are printed to stdout; nothing here touches OpenGL.
+class Benchmarks {
+public:
+  // Run every benchmark at its default sizes
+  static void runAll();
+
+  // Scalar valueToColor loop vs. the LUT kernel at each available SIMD level
+  static void runColorMapping(size_t pointCount);
+
+  // KD-tree build time plus k-NN, radius and box query throughput
+  static void runKdTree(size_t pointCount);
+
+  // Nearest-neighbour diff of two jittered raster scans of pointCount points each
+  static void runScanDiff(size_t pointCount);
+
+  // Similarity matrix of scanCount drifting raster scans, SIMD vs. scalar tile kernel
+  static void runSimilarity(size_t scanCount, size_t pointsPerScan);
+
+  // Levenberg-Marquardt Gaussian fits of passCount noisy passes plus the 3D peak
+  static void runGaussianFit(size_t passCount, size_t pointsPerPass);
+
+  // Local maxima and grid DBSCAN on a three-lobe raster of pointCount points
+  static void runPeakDetection(size_t pointCount);
+
+  // FFT lag estimation over passCount passes whose reverse direction lags by a known backlash
+  static void runHysteresis(size_t passCount, size_t pointsPerPass);
+
+  // Median, Savitzky-Golay and exponential pass filters at each available SIMD level
+  static void runPathFilters(size_t pointCount);
+
+  // Hilbert-ordered incremental Delaunay triangulation of a jittered raster
+  static void runSurface(size_t pointCount);
+
+  // Inverse-distance gridding of a volumetric lobe, its -3 dB iso-surface and contoured slices
+  static void runVolume(size_t pointCount, int resolution);
+
+  // -3 dB and 1/e^2 contour metrics of an elliptical mode with known widths
+  static void runBeamWidth(size_t pointCount);
+};
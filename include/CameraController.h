@@ -40,6 +40,12 @@ public:
     float centerX = 0.0f, float centerY = 0.0f, float centerZ = 0.0f);
   static Mat4 createOrthographicProjection(float left, float right, float bottom, float top, float near, float far);
 
+  // General 4x4 inverse (column-major); returns identity if the matrix is singular
+  static Mat4 inverse(const Mat4& m);
+
+  // Transform a point by a column-major matrix with perspective divide
+  static void transformPoint(const Mat4& m, const float in[3], float out[3]);
+
   // Camera settings
   void setMinMaxZoom(float minZoom, float maxZoom);
   void setCameraDistance(float distance) { baseCameraDistance = distance; }
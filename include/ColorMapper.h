@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+// Packed RGBA8 colour, bytes in memory order R, G, B, A (matches GL_RGBA + GL_UNSIGNED_BYTE)
+typedef uint32_t PackedColor;
+
+// 256-entry colour lookup table indexed by the normalised value
+typedef std::array<PackedColor, 256> ColorLut;
+
+class ColorMapper {
+public:
+  // Map a normalised value to colour (0=blue, 0.5=green, 1=red)
+  static void valueToColor(float normalizedValue, float& r, float& g, float& b);
+
+  // Pack float colour channels (0..1) into RGBA8
+  static PackedColor packColor(float r, float g, float b, float a = 1.0f);
+
+  // LUT sampled from valueToColor
+  static const ColorLut& getRainbowLut();
+
+  // Diverging blue - light grey - red LUT for signed data centred on zero
+  static const ColorLut& getDivergingLut();
+
+  // Colour used for values below the validity threshold
+  static PackedColor getInvalidColor();
+
+  // Map values to RGBA8 through the rainbow LUT.
+  // Values are normalised to [minValue, maxValue] and clamped; values below
+  // invalidThreshold (and NaNs) are grey. A degenerate range maps to mid-scale.
+  static void mapToRGBA(const float* values, size_t count, float minValue, float maxValue,
+    float invalidThreshold, PackedColor* rgbaOut);
+
+  // Same as above with a caller-supplied LUT
+  static void mapToRGBA(const float* values, size_t count, float minValue, float maxValue,
+    float invalidThreshold, const ColorLut& lut, PackedColor* rgbaOut);
+};
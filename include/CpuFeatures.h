@@ -0,0 +1,45 @@
+#pragma once
+
+// SIMD kernels are compiled per function with target attributes and picked at
+// runtime, so the rest of the project keeps building for the baseline ISA.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_FEATURES_X86 1
+#else
+#define CPU_FEATURES_X86 0
+#endif
+
+#if CPU_FEATURES_X86 && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define TARGET_AVX2
+#define TARGET_SSE41
+#endif
+
+enum class SimdLevel {
+  Scalar = 0,
+  SSE41 = 1,
+  AVX2 = 2
+};
+
+class CpuFeatures {
+public:
+  // Highest SIMD level usable for dispatch (detected once, capped by the override)
+  static SimdLevel getSimdLevel();
+
+  // Highest SIMD level the CPU and OS support
+  static SimdLevel getDetectedSimdLevel();
+
+  // Cap dispatch at a lower level (used by benchmarks to compare kernels)
+  static void setSimdLevelOverride(SimdLevel level);
+
+  // Remove any dispatch cap
+  static void clearSimdLevelOverride();
+
+  // Readable name of a SIMD level
+  static const char* getSimdLevelName(SimdLevel level);
+
+private:
+  static SimdLevel detectSimdLevel();
+  static int s_overrideLevel;
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include <GLFW/glfw3.h>
+#include <vector>
 
 class InputHandler {
 public:
@@ -21,6 +22,13 @@ public:
   // Zoom to fit functionality
   static void zoomToFit();
 
+  // Region selection drag in progress (left drag = box, Ctrl + left drag = lasso)
+  static bool isSelecting() { return s_selecting; }
+  static bool isLassoSelection() { return s_lassoSelection; }
+
+  // Drag path in window coordinates as x, y pairs (box: start and current corner)
+  static const std::vector<double>& getSelectionPath() { return s_selectionPath; }
+
 private:
   // Mouse control state
   static bool s_leftMousePressed;
@@ -28,4 +36,12 @@ private:
   static double s_lastMouseX;
   static double s_lastMouseY;
   static bool s_firstMouseMove;
+
+  // Region selection drag state
+  static bool s_selecting;
+  static bool s_lassoSelection;
+  static std::vector<double> s_selectionPath;
+
+  // Value threshold step for the V filter key (0 = off)
+  static int s_valueFilterStep;
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+struct JobState;
+
+// Completion handle for a submitted job; pass it to wait() or as a dependency
+typedef std::shared_ptr<JobState> JobHandle;
+
+// Scheduler counters summed over all threads since the last reset
+struct JobCounters {
+  unsigned int threadCount = 0;   // Workers plus the calling thread
+  uint64_t tasksExecuted = 0;
+  uint64_t steals = 0;            // Jobs taken from another thread's deque
+  double idleMilliseconds = 0.0;  // Time workers spent asleep with nothing to run
+};
+
+// Work-stealing scheduler shared by the loader, analysis and rendering prep.
+// Every worker owns a deque: it pushes and pops its own jobs at the back (LIFO,
+// cache-warm) while idle threads steal the oldest jobs from the front. Workers
+// that wait on a job run other jobs meanwhile, so nested parallelism is safe;
+// threads outside the pool only run the job they wait for, so a frame never
+// picks up someone else's long job. Jobs should not block on I/O; dedicated I/O
+// threads stay outside the pool.
+class JobSystem {
+public:
+  // Size the pool for threadCount threads including the caller (0 = one per core).
+  // Optional: first use starts the default pool. Must not be called while jobs run.
+  static void initialize(unsigned int threadCount = 0);
+
+  // Stop and join the workers; queued jobs that never started are dropped
+  static void shutdown();
+
+  // Workers plus the calling thread, i.e. the useful number of parallel chunks
+  static unsigned int getThreadCount();
+
+  // Queue job to run once every dependency has finished
+  static JobHandle submit(std::function<void()> job, const std::vector<JobHandle>& dependencies = {});
+
+  // Block until the job has finished; a worker runs other jobs in the meantime,
+  // any other thread runs this job itself if nobody has started it yet
+  static void wait(const JobHandle& job);
+  static void waitAll(const std::vector<JobHandle>& jobs);
+
+  // Call body(chunkBegin, chunkEnd) over [begin, end) split into chunks of at
+  // least grainSize; returns when every chunk has run. Small ranges run inline.
+  static void parallelFor(size_t begin, size_t end, size_t grainSize,
+    const std::function<void(size_t, size_t)>& body);
+
+  static JobCounters getCounters();
+  static void resetCounters();
+};
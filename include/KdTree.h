@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "PointBitset.h"
+
+// Result of a nearest-neighbour query
+struct KdNeighbor {
+  uint32_t index;         // Index into the positions the tree was built from
+  float distanceSquared;
+};
+
+// Static 3D KD-tree with an implicit layout: points are reordered so that the
+// subtree over [begin, end) splits at mid = (begin + end) / 2, with the left
+// child over [begin, mid) and the right child over [mid + 1, end). No node
+// structs or pointers are stored, only the reordered points and the split axis
+// of every mid position. Ranges of LEAF_SIZE points or fewer are scanned linearly.
+class KdTree {
+public:
+  static const size_t LEAF_SIZE = 8;
+
+  // Build over interleaved xyz positions; large trees build their top levels in parallel
+  void build(const float* xyz, size_t pointCount);
+
+  void clear();
+  size_t size() const { return indices.size(); }
+  bool empty() const { return indices.empty(); }
+
+  // k nearest neighbours of query, sorted by increasing distance
+  void findNearest(const float query[3], size_t k, std::vector<KdNeighbor>& out) const;
+
+  // Single nearest neighbour; false if the tree is empty
+  bool findNearest(const float query[3], KdNeighbor& out) const;
+
+  // All points within radius of query (unordered)
+  void findInRadius(const float query[3], float radius, std::vector<uint32_t>& out) const;
+
+  // All points inside the axis-aligned box [minCorner, maxCorner] (unordered)
+  void findInBox(const float minCorner[3], const float maxCorner[3], std::vector<uint32_t>& out) const;
+
+  // Point closest to the line origin + t * direction (direction normalised), within
+  // maxDistance of it. Optional visible mask skips hidden points; visitBudget caps
+  // the nodes examined so the query fits a frame. distanceSquared is the squared
+  // distance to the line. Returns false if nothing was found.
+  bool findNearestToRay(const float origin[3], const float direction[3], float maxDistance,
+    KdNeighbor& out, const PointBitset* visible = nullptr, size_t visitBudget = 0) const;
+
+  // Reordered position of slot i and the original index stored there
+  const float* getPoint(size_t slot) const { return &points[slot * 3]; }
+  uint32_t getIndex(size_t slot) const { return indices[slot]; }
+
+private:
+  std::vector<float> points;        // xyz in tree order
+  std::vector<uint32_t> indices;    // Original index of each slot
+  std::vector<uint8_t> splitAxis;   // Split axis of the node whose mid is this slot
+  float boundsMin[3] = { 0, 0, 0 };  // Root cell
+  float boundsMax[3] = { 0, 0, 0 };
+
+  void nearestRecursive(size_t begin, size_t end, const float query[3], size_t k, std::vector<KdNeighbor>& heap) const;
+  void radiusRecursive(size_t begin, size_t end, const float query[3], float radiusSquared, std::vector<uint32_t>& out) const;
+  struct RayQuery;
+  void rayRecursive(size_t begin, size_t end, const float cellMin[3], const float cellMax[3], RayQuery& query) const;
+  void boxRecursive(size_t begin, size_t end, const float minCorner[3], const float maxCorner[3], std::vector<uint32_t>& out) const;
+};
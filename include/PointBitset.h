@@ -0,0 +1,54 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Fixed-size bitset over point indices, stored as 64-bit words so that
+// set operations run a word at a time.
+class PointBitset {
+public:
+  PointBitset() = default;
+  explicit PointBitset(size_t bitCount, bool value = false);
+
+  // Resize to bitCount bits, all set to value
+  void assign(size_t bitCount, bool value = false);
+  size_t size() const { return bitCount; }
+
+  // Single-bit access
+  void set(size_t index) { words[index >> 6] |= (uint64_t(1) << (index & 63)); }
+  void reset(size_t index) { words[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+  bool test(size_t index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+
+  // Whole-set operations (operands must have the same size)
+  void setAll();
+  void clearAll();
+  void andWith(const PointBitset& other);
+  void orWith(const PointBitset& other);
+  void andNotWith(const PointBitset& other);
+
+  // Number of set bits
+  size_t count() const;
+
+  // Number of bits set in both this and other (same size), without building the intersection
+  size_t countAnd(const PointBitset& other) const;
+
+  // Append the indices of set bits in ascending order
+  void appendSetBits(std::vector<unsigned int>& out) const;
+
+  // Append index pairs (i, i + 1) for every i where both bits are set
+  void appendAdjacentPairs(std::vector<unsigned int>& out) const;
+
+  // Raw words (bits past size() are always zero)
+  const std::vector<uint64_t>& getWords() const { return words; }
+  std::vector<uint64_t>& getWords() { return words; }
+
+  // Bit helpers shared by the word-wise kernels
+  static int popCount(uint64_t word);
+  static int countTrailingZeros(uint64_t word);
+
+private:
+  std::vector<uint64_t> words;
+  size_t bitCount = 0;
+
+  void clearTail();
+};
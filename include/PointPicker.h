@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "CameraController.h"
+#include "KdTree.h"
+#include "PointBitset.h"
+
+// World-space ray through a screen position
+struct PickRay {
+  float origin[3];
+  float direction[3];  // Normalised
+};
+
+// Outcome of a hover pick
+struct PickResult {
+  bool hit = false;
+  uint32_t index = 0;            // Index of the picked scan point
+  float distance = 0.0f;         // Distance from the ray in world units
+  double elapsedMicroseconds = 0.0;
+};
+
+class PointPicker {
+public:
+  // Nodes a single pick may visit; keeps the query well inside a frame
+  static const size_t DEFAULT_VISIT_BUDGET = 20000;
+
+  // Window coordinates (origin top-left) to normalised device coordinates
+  static void windowToNdc(double cursorX, double cursorY, int windowWidth, int windowHeight, float ndcOut[2]);
+
+  // Ray through a cursor position (window coordinates, origin top-left)
+  static PickRay screenToRay(double cursorX, double cursorY, int windowWidth, int windowHeight,
+    const Mat4& view, const Mat4& projection);
+
+  // World-space length of pixelRadius pixels at the cursor (exact for orthographic views)
+  static float pixelsToWorld(double cursorX, double cursorY, int windowWidth, int windowHeight,
+    const Mat4& view, const Mat4& projection, float pixelRadius);
+
+  // Visible point closest to the cursor ray within pixelRadius pixels, through the KD-tree
+  static PickResult pick(const KdTree& tree, double cursorX, double cursorY, int windowWidth, int windowHeight,
+    const Mat4& view, const Mat4& projection, float pixelRadius,
+    const PointBitset* visible = nullptr, size_t visitBudget = DEFAULT_VISIT_BUDGET);
+
+private:
+  static void unproject(const Mat4& inverseViewProjection, double cursorX, double cursorY,
+    int windowWidth, int windowHeight, float ndcZ, float out[3]);
+  static Mat4 multiply(const Mat4& a, const Mat4& b);
+};
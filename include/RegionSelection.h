@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+#include "CameraController.h"
+#include "PointBitset.h"
+
+// Summary of the points inside a selection
+struct SelectionStatistics {
+  size_t count = 0;
+  size_t peakCount = 0;
+  float minValue = 0.0f;
+  float maxValue = 0.0f;
+  double meanValue = 0.0;
+  float centroid[3] = { 0.0f, 0.0f, 0.0f };
+};
+
+// Screen-space region selection. Points are projected with the render matrices
+// in parallel chunks of whole bitset words, so every thread writes its own words
+// of the result and no locking is needed. Regions are given in NDC (x, y in [-1, 1]).
+class RegionSelection {
+public:
+  // Select points whose projection falls inside the rectangle spanned by two corners
+  static void selectRectangle(const float* xyz, size_t pointCount, const Mat4& viewProjection,
+    const float cornerA[2], const float cornerB[2], const PointBitset* visible, PointBitset& out);
+
+  // Select points whose projection falls inside a closed polygon (x, y pairs, even-odd rule)
+  static void selectLasso(const float* xyz, size_t pointCount, const Mat4& viewProjection,
+    const std::vector<float>& polygon, const PointBitset* visible, PointBitset& out);
+
+  // Count, value min/max/mean, peak count and centroid of the selected points
+  static SelectionStatistics computeStatistics(const PointBitset& selection, const std::vector<float>& xyz,
+    const std::vector<float>& values, const PointBitset& peakBits);
+
+  // Whether an NDC point lies inside a polygon (x, y pairs, even-odd rule)
+  static bool pointInPolygon(float x, float y, const std::vector<float>& polygon);
+};
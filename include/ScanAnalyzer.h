@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include <atomic>
+#include <functional>
+#include "VerticesLoader.h"
+#include "ScanParser.h"
+#include "AsyncFileReader.h"
+
+// Per-file summary produced by the batch analyzer
+struct ScanSummary {
+  std::string filePath;
+  bool ok = false;
+  std::string error;
+
+  size_t fileBytes = 0;
+  size_t pointCount = 0;
+  size_t peakCount = 0;              // Points flagged isPeak
+
+  // Value range excluding outliers (same rule as the viewer), mean and percentiles
+  float minValue = 0.0f;
+  float maxValue = 0.0f;
+  double meanValue = 0.0;
+  std::vector<float> percentiles;    // One per ScanAnalyzer::PERCENTILES entry
+
+  // Position and value of the maximum measurement
+  float peakX = 0.0f, peakY = 0.0f, peakZ = 0.0f;
+  float peakValue = 0.0f;
+
+  BoundingBox bounds = { 0, 0, 0, 0, 0, 0 };
+  double parseMilliseconds = 0.0;
+};
+
+// One file of a batch, read and parsed
+struct ParsedScan {
+  size_t fileIndex = 0;              // Index into the path list
+  bool ok = false;
+  std::string error;
+  size_t fileBytes = 0;
+  std::vector<ScanPoint> points;
+  ScanFileHeader header;
+  double parseMilliseconds = 0.0;
+};
+
+// Headless analysis of scan files. Nothing here touches the static loader or
+// OpenGL, so files can be analyzed concurrently on any number of threads.
+class ScanAnalyzer {
+public:
+  static const int PERCENTILE_COUNT = 5;
+  static const double PERCENTILES[PERCENTILE_COUNT];   // 0.01, 0.05, 0.5, 0.95, 0.99
+
+  // Summarise one scan held in memory. points is scratch storage reused across calls.
+  static bool analyzeContent(const std::string& content, float scaleFactor, ScanSummary& summary,
+    std::vector<ScanPoint>& points);
+
+  // Summarise parsed points
+  static void analyzePoints(const std::vector<ScanPoint>& points, size_t fileBytes, ScanSummary& summary);
+
+  // Batch loop shared by the file analyses: reader reads the files on its I/O
+  // threads and each buffer is parsed as a job as it arrives; consume runs in
+  // that job once per file (failed ones included, with error set), in completion
+  // order. At most maxInFlight files are parsed at once (0 = two per pool thread).
+  // Once cancel is set no further files are read or parsed. Blocks on the reader,
+  // so call it from outside the job pool.
+  static void parseFiles(const std::vector<std::string>& filePaths, float scaleFactor, AsyncFileReader& reader,
+    const std::function<void(ParsedScan&)>& consume, const std::atomic<bool>* cancel = nullptr,
+    unsigned int maxInFlight = 0);
+
+  // Same with a default reader
+  static void parseFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+    const std::function<void(ParsedScan&)>& consume, const std::atomic<bool>* cancel = nullptr);
+
+  // parseFiles into one Result per file, kept in input order. Every result gets its
+  // filePath; files that cannot be read or parsed get error, the others are passed
+  // to analyze(scan, result) inside their parse job.
+  template <typename Result, typename Analyze>
+  static std::vector<Result> analyzeEach(const std::vector<std::string>& filePaths, float scaleFactor, Analyze analyze) {
+    std::vector<Result> results(filePaths.size());
+    parseFiles(filePaths, scaleFactor, [&](ParsedScan& scan) {
+      Result& result = results[scan.fileIndex];
+      result.filePath = filePaths[scan.fileIndex];
+      if (!scan.ok) result.error = scan.error;
+      else analyze(scan, result);
+    });
+    return results;
+  }
+
+  // Interleaved xyz positions and values of parsed points
+  static void splitPoints(const std::vector<ScanPoint>& points, std::vector<float>& positions, std::vector<float>& values);
+
+  // Field for the CSV writers, quoted when it holds a comma, quote or newline
+  static std::string csvField(const std::string& text);
+
+  // Read and summarise one file
+  static bool analyzeFile(const std::string& filePath, float scaleFactor, ScanSummary& summary);
+
+  // Summarise files with the default reader, at most threadCount parsed at once
+  // (0 = all pool threads); results keep the input order
+  static std::vector<ScanSummary> analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+    unsigned int threadCount = 0);
+
+  // Same, but files are read ahead by reader and parsed as jobs as they complete
+  static std::vector<ScanSummary> analyzeFilesAsync(const std::vector<std::string>& filePaths, float scaleFactor,
+    AsyncFileReader& reader, unsigned int threadCount = 0);
+
+  // One row / object per file
+  static void writeCsv(std::ostream& out, const std::vector<ScanSummary>& summaries);
+  static void writeJson(std::ostream& out, const std::vector<ScanSummary>& summaries);
+};
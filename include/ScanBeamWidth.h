@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include "ScanVolume.h"
+
+struct BeamWidthOptions {
+  VolumeGridOptions grid;         // Field the contours are traced on
+  int normalAxis = -1;            // Contour plane normal: -1 = the flat axis of a planar scan, else Z
+  BeamWidthOptions() { grid.resolution = 64; }
+};
+
+// One contour level around the peak
+struct BeamContour {
+  float fraction = 0.5f;          // Of the peak value
+  float level = 0.0f;
+  float axisWidths[3] = { 0, 0, 0 };  // Between the level crossings on the grid lines through the peak (0 = not crossed on both sides)
+  bool closed = false;            // A closed contour encloses the peak in the contour plane
+  float area = 0.0f;
+  float centroid[2] = { 0, 0 };   // u, v
+  float majorWidth = 0.0f;        // Full axes of the ellipse with the same second moments
+  float minorWidth = 0.0f;
+  float angleDegrees = 0.0f;      // Major axis from the u axis
+  float ellipticity = 0.0f;       // minor / major (1 = round)
+  std::vector<float> polygon;     // u v pairs of the enclosing contour
+};
+
+struct BeamWidthResult {
+  std::string filePath;
+  bool ok = false;
+  std::string error;
+  int normalAxis = 2, axisU = 0, axisV = 1;
+  float peakPosition[3] = { 0, 0, 0 };  // Highest grid node
+  float peakValue = 0.0f;         // Interpolated value there (the levels' reference)
+  int gridDims[3] = { 0, 0, 0 };
+  BeamContour contours[2];        // -3 dB, then 1/e^2
+  double milliseconds = 0.0;
+};
+
+// Mode-field widths of a scan. The measurements are gridded (ScanVolume), the
+// plane through the peak is contoured with marching squares at -3 dB and 1/e^2 of
+// the peak, and the closed contour around the peak gives area, centroid and the
+// equivalent ellipse (from the polygon's second moments). Widths along X, Y and Z
+// come from the level crossings on the grid lines through the peak, so they are
+// also defined for axis-pass scans whose contours do not close.
+class ScanBeamWidth {
+public:
+  static constexpr float HALF_POWER = 0.5011872f;        // -3 dB
+  static constexpr float ONE_OVER_E_SQUARED = 0.1353353f;
+
+  // Positions are interleaved xyz
+  static void analyze(const float* positions, const float* values, size_t pointCount,
+    const BeamWidthOptions& options, BeamWidthResult& out);
+
+  // Contours on an existing grid
+  static void analyzeGrid(const VolumeGrid& grid, const BeamWidthOptions& options, BeamWidthResult& out);
+
+  // Read files on I/O threads and analyze each as a job (ScanAnalyzer::analyzeEach); results keep the input order
+  static std::vector<BeamWidthResult> analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+    const BeamWidthOptions& options);
+
+  // One row per file with both contour levels
+  static void writeCsv(std::ostream& out, const std::vector<BeamWidthResult>& results);
+};
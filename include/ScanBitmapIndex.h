@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "PointBitset.h"
+
+class ScanStatistics;
+
+// Attribute filter over the loaded points. Masks hold one bit per axis or
+// direction code (OR within a mask); all criteria are ANDed together.
+struct ScanFilter {
+  bool peaksOnly = false;
+  uint32_t axisMask = 0;        // 0 = any axis
+  uint32_t directionMask = 0;   // 0 = any direction
+  bool useMinValue = false;
+  float minValue = 0.0f;        // Keep points with value >= minValue
+
+  bool isActive() const { return peaksOnly || axisMask != 0 || directionMask != 0 || useMinValue; }
+};
+
+// Bitmap indices over the per-point attributes, built once per load so that
+// filter combinations resolve with word-wide AND/OR instead of a reparse.
+class ScanBitmapIndex {
+public:
+  static const int VALUE_BUCKETS = 16;
+
+  // Build from the loader's columns. Value bucket edges are equal-frequency
+  // edges taken from the streaming statistics.
+  void build(const std::vector<float>& values, const std::vector<uint8_t>& peakFlags,
+    const std::vector<uint8_t>& axisCodes, int axisCount,
+    const std::vector<uint8_t>& directionCodes, int directionCount,
+    const ScanStatistics& valueStatistics);
+
+  void clear();
+
+  size_t getPointCount() const { return pointCount; }
+
+  // Resolve a filter into a selection bitset (values are needed to refine the threshold bucket)
+  void resolve(const ScanFilter& filter, const std::vector<float>& values, PointBitset& out) const;
+
+  // Resolve a filter straight into point and line index lists for an index buffer
+  void buildDrawLists(const ScanFilter& filter, const std::vector<float>& values,
+    std::vector<unsigned int>& pointIndices, std::vector<unsigned int>& lineIndices) const;
+
+  // Lower edge of value bucket k (bucket 0 starts at -infinity)
+  float getBucketEdge(int bucket) const { return bucketEdges[bucket]; }
+
+  const PointBitset& getPeakBits() const { return peakBits; }
+
+private:
+  size_t pointCount = 0;
+  PointBitset peakBits;
+  std::vector<PointBitset> axisBits;
+  std::vector<PointBitset> directionBits;
+
+  // Range-encoded value buckets: valueAtLeast[k] has the points with value >= bucketEdges[k]
+  std::vector<float> bucketEdges;
+  std::vector<PointBitset> valueAtLeast;
+
+  void orCodes(const std::vector<PointBitset>& bitmaps, uint32_t mask, PointBitset& out) const;
+};
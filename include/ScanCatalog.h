@@ -0,0 +1,85 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+// Summary metadata of one scan file, kept fixed-size so the catalog can be scanned as a flat array
+struct CatalogRecord {
+  int64_t timestamp = 0;       // Ordering time in seconds since 1970 (filename, else modification time)
+  int64_t modifiedTime = 0;    // Modification time when indexed; with fileBytes detects changed files
+  uint64_t fileBytes = 0;
+  uint32_t pointCount = 0;
+  uint32_t peakCount = 0;
+  float minValue = 0.0f, maxValue = 0.0f, meanValue = 0.0f;
+  float peakValue = 0.0f;      // Value and position of the maximum measurement
+  float peakX = 0.0f, peakY = 0.0f, peakZ = 0.0f;
+  uint8_t ok = 0;              // 0 = the file could not be parsed
+};
+
+// Conjunction of ranges; fields left at their defaults do not filter
+struct CatalogQuery {
+  float minPeakValue = -std::numeric_limits<float>::infinity();
+  float maxPeakValue = std::numeric_limits<float>::infinity();
+  float minMeanValue = -std::numeric_limits<float>::infinity();
+  float maxMeanValue = std::numeric_limits<float>::infinity();
+  uint32_t minPoints = 0;
+  uint32_t maxPoints = std::numeric_limits<uint32_t>::max();
+  uint32_t minPeaks = 0;
+  float peakMin[3] = { -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity() };
+  float peakMax[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+  int64_t since = std::numeric_limits<int64_t>::min();   // Absolute timestamp bounds
+  int64_t until = std::numeric_limits<int64_t>::max();
+  double maxAgeDays = std::numeric_limits<double>::infinity(); // Ages relative to the "now" passed to query()
+  double minAgeDays = 0.0;
+  std::string pathContains;
+  bool includeFailed = false;
+};
+
+struct CatalogUpdateStats {
+  size_t added = 0, changed = 0, removed = 0, unchanged = 0;
+  double milliseconds = 0.0;
+};
+
+// Persisted per-file summaries of every scan under a set of roots, so scans can
+// be browsed and filtered without opening the JSON files. Each root keeps its
+// own catalog file (FILE_NAME inside the root) holding paths relative to it.
+// update() re-lists the roots and only re-analyzes files that are new or whose
+// size or modification time changed.
+class ScanCatalog {
+public:
+  static const char* FILE_NAME;
+
+  // Load the roots' catalog files, bring them up to date and save any that changed
+  CatalogUpdateStats update(const std::vector<std::string>& roots, float scaleFactor = 1000.0f);
+
+  // Load the roots' catalog files only, without listing or analyzing anything
+  size_t load(const std::vector<std::string>& roots);
+
+  // Records and full paths, newest first
+  size_t size() const { return records.size(); }
+  const std::vector<CatalogRecord>& getRecords() const { return records; }
+  const std::vector<std::string>& getPaths() const { return paths; }
+
+  // Indices of matching records, newest first. now is in seconds since 1970 (see currentTime).
+  std::vector<size_t> query(const CatalogQuery& query, int64_t now) const;
+
+  static int64_t currentTime();
+
+  // Parse "peak>0.5 days<=7 points>=1000": space or comma separated comparisons
+  // (>, >=, <, <=, =) on peak, mean, points, peaks, x, y, z (peak position) and days (age),
+  // plus bare words matched against the path.
+  static bool parseQuery(const std::string& text, CatalogQuery& out, std::string& error);
+
+private:
+  std::vector<std::string> roots;
+  std::vector<CatalogRecord> records;
+  std::vector<std::string> paths;
+  std::vector<uint32_t> rootIndices;   // Root each record belongs to
+
+  static bool readCatalogFile(const std::string& root, std::vector<std::string>& relativePaths,
+    std::vector<CatalogRecord>& fileRecords);
+  static bool writeCatalogFile(const std::string& root, const std::vector<std::string>& relativePaths,
+    const std::vector<CatalogRecord>& fileRecords);
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Per-point comparison of a scan against a reference scan
+struct ScanDiffResult {
+  std::vector<float> deltas;       // value - matched reference value; NaN when unmatched
+  std::vector<uint32_t> matches;   // Index of the matched reference point
+  std::vector<float> distances;    // Distance to the matched reference point
+  size_t matchedCount = 0;
+  float minDelta = 0.0f, maxDelta = 0.0f;
+  double meanDelta = 0.0;
+  double rmsDelta = 0.0;
+  float maxAbsDelta = 0.0f;
+  double meanDistance = 0.0;
+  double buildMilliseconds = 0.0;  // Reference KD-tree
+  double matchMilliseconds = 0.0;  // Nearest-neighbour queries and deltas
+};
+
+// Matches every point of a scan to its nearest reference point (positions never
+// line up exactly between runs) and takes the value difference. The reference
+// is indexed with a KD-tree and the queries are split across the job system.
+class ScanDiff {
+public:
+  // Positions are interleaved xyz. Points farther than maxDistance from every
+  // reference point stay unmatched (maxDistance <= 0 matches at any distance),
+  // as do points whose own or matched reference value is an outlier.
+  static void compute(const float* positions, const float* values, size_t pointCount,
+    const float* referencePositions, const float* referenceValues, size_t referenceCount,
+    float maxDistance, ScanDiffResult& out);
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// A scan file found on disk with its ordering time
+struct ScanFileEntry {
+  std::string path;
+  int64_t timestamp = 0;          // Seconds since 1970 (filename times are taken as UTC)
+  bool timestampFromName = false; // false = taken from the file's modification time
+};
+
+// Discovery counters for the last discover() call
+struct ScanDiscoveryStats {
+  size_t directoriesVisited = 0;
+  size_t filesMatched = 0;
+  size_t statCalls = 0;           // Files whose name carried no timestamp
+  double milliseconds = 0.0;
+};
+
+// Finds scan files under one or more roots (e.g. logs/scanning/YYYY/MM/DD trees).
+// Directories are listed by a small pool of walker threads sharing one work list;
+// the entry type comes from the directory listing, so only files whose names
+// have no timestamp cost a stat call.
+class ScanDiscovery {
+public:
+  // Every matching file under roots, newest first. recursive = false lists the roots only.
+  static std::vector<ScanFileEntry> discover(const std::vector<std::string>& roots, bool recursive = true,
+    ScanDiscoveryStats* stats = nullptr);
+
+  // Paths only, newest first
+  static std::vector<std::string> discoverPaths(const std::vector<std::string>& roots, bool recursive = true);
+
+  // "*.json" with "scan" in the name
+  static bool isScanFileName(const std::string& fileName);
+
+  // First YYYYMMDD[_-T]HHMMSS or YYYY-MM-DD[_T ]HH-MM-SS (':' also accepted) in the name
+  static bool parseFileNameTimestamp(const std::string& fileName, int64_t& secondsOut);
+
+  // Newest first; ties (and same-second scans) fall back to the path so the order is stable
+  static void sortNewestFirst(std::vector<ScanFileEntry>& entries);
+};
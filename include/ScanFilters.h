@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+enum class ScanFilterType {
+  Median,
+  SavitzkyGolay,
+  Exponential
+};
+
+struct ScanFilterOptions {
+  ScanFilterType type = ScanFilterType::Median;
+  int radius = 2;                 // Median and Savitzky-Golay window of 2 * radius + 1 points (at most MAX_RADIUS)
+  int polynomialOrder = 2;        // Savitzky-Golay, below the window length
+  float alpha = 0.3f;             // Exponential smoothing factor (1 = unfiltered)
+  bool zeroPhase = true;          // Exponential: forward then backward pass, so peaks keep their position
+};
+
+// Denoising along the acquisition path. Every pass (run of points with the same
+// axis and direction) is filtered on its own, so a window never mixes the end of
+// one sweep with the start of the next; windows are mirrored at the pass ends.
+// Values outside the viewer's outlier limit are bridged by the previous value
+// and left as they are in the output.
+//
+// The kernels compute eight neighbouring outputs per AVX2 vector: the median as a
+// min/max sorting network over the shifted windows, Savitzky-Golay as a fused
+// multiply-add convolution, and the exponential recursion in blocks of eight
+// (each block is a triangular matrix product plus the carry of the previous one).
+class ScanFilters {
+public:
+  static constexpr int MAX_RADIUS = 10;
+
+  static const char* getFilterName(ScanFilterType type);
+
+  // Pass boundaries from the per-point axis and direction codes: bounds[p] is the
+  // first point of pass p and bounds.back() == count
+  static void findPasses(const uint8_t* axisCodes, const uint8_t* directionCodes, size_t count, std::vector<size_t>& bounds);
+
+  // Filter values in place, pass by pass (passes run as jobs)
+  static void apply(float* values, size_t count, const std::vector<size_t>& passBounds, const ScanFilterOptions& options);
+
+  // Least-squares smoothing weights for the centre of a 2 * radius + 1 window
+  static void savitzkyGolayCoefficients(int radius, int order, std::vector<float>& out);
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include "VerticesLoader.h"
+
+// 1D Gaussian a * exp(-(t - center)^2 / (2 sigma^2)) + offset fitted to one pass.
+// A pass is a run of consecutive measurements with the same axis and direction;
+// t is the position along the pass axis (scaled units).
+struct PassFit {
+  std::string axis, direction;
+  int axisIndex = 0;             // Coordinate t was taken from (0 = x, 1 = y, 2 = z)
+  size_t firstPoint = 0;         // Index of the pass's first measurement
+  size_t pointCount = 0;
+  bool converged = false;        // Converged on a positive peak centred inside the pass, with a usable center error and r-squared
+  int iterations = 0;
+  double amplitude = 0.0;
+  double center = 0.0;
+  double sigma = 0.0;
+  double offset = 0.0;
+  double centerError = 0.0;      // One-sigma standard error of the center
+  double rSquared = 0.0;
+
+  double fwhm() const;
+};
+
+// Axis-aligned Gaussian a * exp(-sum((x_k - center_k)^2 / (2 sigma_k^2))) + offset
+// fitted to the measurements around the global maximum. Every axis along which
+// those measurements spread is fitted, whether or not a pass runs along it; the
+// others keep the maximum's coordinate.
+struct PeakFit {
+  bool converged = false;
+  int iterations = 0;
+  size_t pointCount = 0;         // Measurements inside the fit window
+  bool axisFitted[3] = { false, false, false };
+  double amplitude = 0.0;
+  double offset = 0.0;
+  double center[3] = { 0.0, 0.0, 0.0 };
+  double sigma[3] = { 0.0, 0.0, 0.0 };
+  double rSquared = 0.0;
+  float maxPosition[3] = { 0.0f, 0.0f, 0.0f };  // Highest measurement (fit start)
+  float maxValue = 0.0f;
+
+  double fwhm(int axis) const;
+};
+
+struct ScanFitOptions {
+  size_t minPassPoints = 8;      // Shorter passes are not fitted
+  int maxIterations = 100;
+  double peakWindowSigmas = 3.0; // Peak fit window half-width in sigmas along each axis
+  double minPassRSquared = 0.8;  // Pass fits explaining less of the pass's variance do not count as converged
+  double minPeakRSquared = 0.8;  // Peak fits explaining less of the window's variance do not count as converged
+};
+
+struct ScanFitResult {
+  std::string filePath;
+  bool ok = false;
+  std::string error;
+  std::vector<PassFit> passes;
+  PeakFit peak;
+  size_t fitCount = 0;           // Fits attempted (passes plus the peak)
+  double fitMilliseconds = 0.0;   // Passes and peak
+  double peakMilliseconds = 0.0;
+};
+
+// Gaussian beam-profile fitting with Levenberg-Marquardt and analytic Jacobians.
+// Passes are independent, so they are fitted as parallel jobs.
+class ScanFit {
+public:
+  // Fit every pass of the measurements, then the peak
+  static void fitScan(const std::vector<ScanPoint>& points, const ScanFitOptions& options, ScanFitResult& result);
+
+  // Split measurements into passes (unfitted records: axis, direction, range)
+  static void findPasses(const std::vector<ScanPoint>& points, std::vector<PassFit>& passes);
+
+  // Single 1D fit over t/value samples in pass order; false if it did not converge or explains
+  // less than minRSquared of the variance
+  static bool fitGaussian1D(const float* t, const float* values, size_t count, int maxIterations, double minRSquared,
+    PassFit& fit);
+
+  // Read files on I/O threads and fit each as a job (ScanAnalyzer::analyzeEach); results keep the input order
+  static std::vector<ScanFitResult> fitFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+    const ScanFitOptions& options);
+
+  // One row per pass / one row per file
+  static void writePassCsv(std::ostream& out, const std::vector<ScanFitResult>& results);
+  static void writePeakCsv(std::ostream& out, const std::vector<ScanFitResult>& results);
+};
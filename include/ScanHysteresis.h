@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include "VerticesLoader.h"
+
+// Positional lag between a forward pass and the following reverse pass on the same axis
+struct PassPairLag {
+  std::string axis;
+  int axisIndex = 0;
+  size_t forwardPass = 0;        // Indices into the scan's passes (ScanFit::findPasses order)
+  size_t reversePass = 0;
+  double lag = 0.0;              // Reverse profile position minus forward profile position (scaled units)
+  double correlation = 0.0;      // Normalised cross-correlation at the lag (1 = identical shapes)
+  double residual = 0.0;         // RMS difference after removing the lag, relative to the profile's range
+  size_t samples = 0;            // Common resampling grid over the overlap of both passes
+  double step = 0.0;
+};
+
+// Summary over the pairs of one axis
+struct AxisHysteresis {
+  std::string axis;
+  int axisIndex = 0;
+  size_t pairCount = 0;
+  double meanLag = 0.0;
+  double lagStdDev = 0.0;        // Repeatability of the lag between pairs
+  double backlash = 0.0;         // Median |lag|: dead band between the two approach directions
+  double hysteresis = 0.0;       // Mean residual: profile mismatch a pure shift does not explain
+};
+
+// Welch power spectrum of the value sequence in acquisition order
+struct NoiseSpectrum {
+  std::vector<float> power;      // One-sided PSD per bin, values^2 per frequency unit
+  double binWidth = 0.0;         // Frequency step between bins
+  bool inHertz = false;          // false: cycles per sample (no timestamps)
+  size_t segmentLength = 0;
+  size_t segmentCount = 0;
+  double noiseFloor = 0.0;       // Median PSD over the upper half of the band
+  double noiseRms = 0.0;         // White-noise RMS implied by the floor
+  double peakFrequency = 0.0;    // Strongest bin above the lowest four (where the beam profile lives)
+};
+
+struct HysteresisResult {
+  std::string filePath;
+  bool ok = false;
+  std::string error;
+  double startTime = 0.0;        // Seconds since 1970 of the first measurement (0 = unknown)
+  std::vector<PassPairLag> pairs;
+  std::vector<AxisHysteresis> axes;
+  NoiseSpectrum spectrum;
+  double milliseconds = 0.0;
+};
+
+// Backlash and hysteresis from the scan's own forward/reverse passes. Each pair is
+// resampled onto a common grid and cross-correlated through a zero-padded FFT; the
+// lag is the correlation maximum refined to sub-sample precision with a parabola
+// through its neighbours.
+class ScanHysteresis {
+public:
+  static void analyze(const std::vector<ScanPoint>& points, HysteresisResult& out);
+
+  // Lag of profile B relative to profile A (positions t need not be sorted or uniform)
+  static bool estimateLag(const float* tA, const float* valuesA, size_t countA,
+    const float* tB, const float* valuesB, size_t countB, PassPairLag& out);
+
+  // sampleInterval in seconds, or 0 for a per-sample frequency axis
+  static void computeSpectrum(const float* values, size_t count, double sampleInterval, NoiseSpectrum& out);
+
+  // Read files on I/O threads and analyze each as a job (ScanAnalyzer::analyzeEach); results keep the input order
+  static std::vector<HysteresisResult> analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor);
+
+  // One row per file with the X, Y and Z summaries and the noise figures
+  static void writeCsv(std::ostream& out, const std::vector<HysteresisResult>& results);
+};
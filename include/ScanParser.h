@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "VerticesLoader.h"
+
+// File-level fields of a scan besides its measurements
+struct ScanFileHeader {
+  float baselineX = 0.0f, baselineY = 0.0f, baselineZ = 0.0f;
+  float baselineValue = 0.0f;
+  bool hasStatistics = false;       // "statistics" block with minValue/maxValue present
+  float statisticsMinValue = 0.0f;
+  float statisticsMaxValue = 0.0f;
+  bool hasTimestamps = false;       // Every measurement carried a parsable "timestamp"
+  double startTime = 0.0;           // Seconds since 1970 (UTC) of the first measurement; point times are relative to it
+};
+
+// Stateless parser for the scan JSON layout. Works on an in-memory buffer and
+// keeps no globals, so any number of threads can parse different files at once.
+// Only the "measurements" array is walked (to its closing bracket); objects that
+// follow it, such as "statistics", are never mistaken for measurements.
+class ScanParser {
+public:
+  // Read a whole file into content; false if it cannot be opened
+  static bool readFile(const std::string& filePath, std::string& content);
+
+  // Size and modification time (seconds) of a file, used to notice that a cached parse is stale
+  static bool getFileSignature(const std::string& filePath, uint64_t& bytes, int64_t& modifiedTime);
+
+  // Parse scan JSON text. Positions are made relative to the baseline and multiplied
+  // by scaleFactor. Points are appended to points. False if there is no measurements array.
+  static bool parse(const std::string& content, float scaleFactor, std::vector<ScanPoint>& points, ScanFileHeader& header);
+
+private:
+  static size_t findMatching(const std::string& content, size_t open, size_t limit);
+  static size_t findKey(const std::string& content, const char* key, size_t begin, size_t end);
+  static bool readNumber(const std::string& content, const char* key, size_t begin, size_t end, float& out);
+  static bool readString(const std::string& content, const char* key, size_t begin, size_t end, std::string& out);
+  static bool readTimestamp(const std::string& content, const char* key, size_t begin, size_t end, double& seconds);
+  static bool readBool(const std::string& content, const char* key, size_t begin, size_t end, bool& out);
+  static bool readPosition(const std::string& content, size_t begin, size_t end, float& x, float& y, float& z);
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct PeakOptions {
+  float thresholdFraction = 0.2f; // High-value points: value >= min + fraction * (max - min)
+  float epsilon = 0.0f;           // DBSCAN neighbourhood radius in scaled units (0 = 2% of the bounding box diagonal)
+  size_t minPoints = 5;           // Neighbours (including the point) that make a core point
+  float maximaRadius = 0.0f;      // Local-maximum neighbourhood (0 = epsilon)
+};
+
+// One high-value region (lobe) found by the clustering
+struct PeakCluster {
+  size_t pointCount = 0;
+  float peakValue = 0.0f;
+  uint32_t peakIndex = 0;         // Highest point of the lobe
+  float peakPosition[3] = { 0, 0, 0 };
+  float centroid[3] = { 0, 0, 0 };  // Value-weighted
+  float minCorner[3] = { 0, 0, 0 }; // Extent
+  float maxCorner[3] = { 0, 0, 0 };
+  size_t localMaxima = 0;         // Local maxima inside the lobe
+};
+
+struct PeakDetectionResult {
+  std::vector<int32_t> labels;       // Cluster of every input point; -1 = below threshold or noise
+  std::vector<PeakCluster> clusters; // Highest peak first
+  std::vector<uint32_t> localMaxima; // Point indices, highest first
+  float threshold = 0.0f;
+  float epsilon = 0.0f;
+  float maximaRadius = 0.0f;
+  size_t candidateCount = 0;         // Points at or above the threshold
+  size_t coreCount = 0;
+  size_t noiseCount = 0;
+  size_t cellCount = 0;              // Occupied grid cells
+  double gridMilliseconds = 0.0;
+  double maximaMilliseconds = 0.0;
+  double clusterMilliseconds = 0.0;
+};
+
+// Multi-lobe peak detection over the points above a value threshold. A uniform
+// grid with cells of epsilon / sqrt(3) (so any two points in one cell are
+// neighbours) indexes those points: a cell holding minPoints points is all core
+// without any distance test, and clusters are formed by joining whole cells
+// (union-find) as soon as one core pair across two cells is within epsilon.
+// Local maxima use the same grid. Maxima, core and border tests run as parallel
+// jobs over the cells; joining cells is a sequential union-find pass.
+class ScanPeaks {
+public:
+  // Positions are interleaved xyz; values outside the viewer's outlier limit are ignored
+  static void detect(const float* positions, const float* values, size_t pointCount,
+    const PeakOptions& options, PeakDetectionResult& out);
+};
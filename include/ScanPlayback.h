@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <cstddef>
+#include "ScanResidency.h"
+
+// Time-lapse playback over a sequence of scan files. load() starts a background
+// thread that decodes the frames into the residency cache; preload() (GL thread)
+// uploads decoded frames within a per-call time slice so the UI stays responsive.
+// Once uploaded, stepping only switches between resident GPU buffers: no file is
+// parsed or uploaded per frame. The sequence is cut short when it would not fit
+// the VRAM budget, so playback never evicts its own frames.
+class ScanPlayback {
+public:
+  explicit ScanPlayback(ScanResidency& residency);
+  ~ScanPlayback();
+
+  // Play files in the given order (previous sequence is dropped)
+  void load(const std::vector<std::string>& files, float scaleFactor);
+  void stop();
+
+  // Upload decoded frames for up to budgetMilliseconds; true once every frame is resident
+  bool preload(double budgetMilliseconds);
+
+  // Advance by elapsed wall time; true when the displayed frame changed.
+  // At 0 frames per second every call steps one frame (as fast as rendering allows).
+  bool advance(double elapsedSeconds);
+
+  void setPlaying(bool playing);
+  void setLooping(bool looping) { this->looping = looping; }
+  void setFramesPerSecond(float fps) { framesPerSecond = fps; }
+  void seek(size_t frame);
+
+  bool isActive() const { return !frames.empty(); }
+  bool isPlaying() const { return playing; }
+  bool isLooping() const { return looping; }
+  bool isReady() const { return !frames.empty() && uploadedCount == frames.size(); }
+  bool wasTrimmed() const { return trimmedCount > 0; }
+  float getFramesPerSecond() const { return framesPerSecond; }
+  size_t getFrameCount() const { return frames.size(); }
+  size_t getFrameIndex() const { return frameIndex; }
+  size_t getDecodedCount() const { return decodedCount; }
+  size_t getUploadedCount() const { return uploadedCount; }
+  size_t getTrimmedCount() const { return trimmedCount; }
+  size_t getUploadedBytes() const { return uploadedBytes; }
+  const std::string& getFramePath(size_t frame) const { return frames[frame]; }
+
+  // Buffers of the displayed frame, or nullptr if it is not resident
+  const GpuScanBuffers* getFrameBuffers();
+
+  // Frames actually shown per second, measured over the last second of playback
+  double getMeasuredRate() const { return measuredRate; }
+
+private:
+  ScanResidency& residency;
+  std::vector<std::string> frames;
+  float scaleFactor = 1000.0f;
+
+  std::thread decodeThread;
+  std::atomic<size_t> decodedCount;
+  std::atomic<bool> cancelDecode;
+
+  size_t uploadedCount = 0;
+  size_t uploadedBytes = 0;
+  size_t trimmedCount = 0;
+  std::vector<size_t> failedFrames;  // Dropped once preloading completes
+
+  size_t frameIndex = 0;
+  bool playing = false;
+  bool looping = true;
+  float framesPerSecond = 10.0f;
+  double frameTime = 0.0;       // Time accumulated toward the next step
+
+  double rateWindow = 0.0;      // Measured-rate window: elapsed time and frames shown
+  size_t rateFrames = 0;
+  double measuredRate = 0.0;
+
+  void joinDecodeThread();
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "VerticesLoader.h"
+#include "ScanParser.h"
+
+// One scan file decoded into memory: the parsed points plus the columns uploads need
+struct DecodedScan {
+  std::string filePath;
+  float scaleFactor = 1000.0f;
+  uint64_t fileBytes = 0;         // File signature at decode time
+  int64_t modifiedTime = 0;
+  ScanFileHeader header;
+  std::vector<ScanPoint> points;
+  std::vector<float> positions;   // Interleaved xyz
+  std::vector<float> values;
+  size_t memoryBytes = 0;         // Heap bytes held by the vectors above
+};
+
+// GPU buffers of one scan, created and released by the renderer's callbacks
+struct GpuScanBuffers {
+  unsigned int vertexBuffer = 0;
+  unsigned int colorBuffer = 0;
+  size_t pointCount = 0;
+  size_t bytes = 0;               // Video memory used, as reported by the upload callback
+};
+
+struct ResidencyStats {
+  size_t ramBytes = 0, ramBudget = 0;
+  size_t vramBytes = 0, vramBudget = 0;
+  size_t residentScans = 0;       // Decoded in RAM
+  size_t gpuResidentScans = 0;    // Uploaded to the GPU
+  uint64_t hits = 0, misses = 0;
+  uint64_t gpuHits = 0, gpuMisses = 0;
+  uint64_t evictions = 0, gpuEvictions = 0;
+
+  double hitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+  double gpuHitRate() const { return gpuHits + gpuMisses > 0 ? static_cast<double>(gpuHits) / (gpuHits + gpuMisses) : 0.0; }
+};
+
+// Keeps recently viewed scans decoded in RAM and uploaded to the GPU within byte
+// budgets. Every access moves the scan to the front of one recency list; when a
+// budget is exceeded the least recently viewed scans lose their CPU data or GPU
+// buffers (independently) until usage fits again. The scan being accessed is never
+// evicted, so a single scan larger than a budget still works. Evicted scans are
+// re-read and re-uploaded on their next access.
+//
+// acquire() may be called from any thread; the GPU functions only from the thread
+// owning the GL context. This class never calls OpenGL itself: the renderer supplies
+// upload/release callbacks.
+class ScanResidency {
+public:
+  typedef std::function<bool(const DecodedScan& scan, GpuScanBuffers& buffers)> UploadFunction;
+  typedef std::function<void(GpuScanBuffers& buffers)> ReleaseFunction;
+
+  static const size_t DEFAULT_RAM_BUDGET = size_t(1) << 30;    // 1 GiB
+  static const size_t DEFAULT_VRAM_BUDGET = size_t(512) << 20; // 512 MiB
+
+  explicit ScanResidency(size_t ramBudget = DEFAULT_RAM_BUDGET, size_t vramBudget = DEFAULT_VRAM_BUDGET);
+
+  // Decoded scan, read and parsed on a miss or when the file changed on disk.
+  // nullptr (with error set) if the file cannot be read or parsed.
+  std::shared_ptr<const DecodedScan> acquire(const std::string& filePath, float scaleFactor, std::string* error = nullptr);
+
+  // GPU buffers of the scan, uploaded on a miss. The pointer stays valid until the next
+  // acquireGpu, setBudgets or clear. nullptr if the scan cannot be decoded or uploaded.
+  const GpuScanBuffers* acquireGpu(const std::string& filePath, float scaleFactor, std::string* error = nullptr);
+
+  // Resident GPU buffers without checking the file on disk (counts as a GPU hit), or
+  // nullptr. For per-frame lookups of scans already validated by acquireGpu.
+  const GpuScanBuffers* findGpu(const std::string& filePath);
+
+  // Whether the scan is resident without touching its recency
+  bool isResident(const std::string& filePath) const;
+  bool isGpuResident(const std::string& filePath) const;
+
+  void setGpuCallbacks(UploadFunction upload, ReleaseFunction release);
+  void setBudgets(size_t ramBudget, size_t vramBudget);
+
+  // Drop every cached scan and GPU buffer. Call it (on the GPU thread) before the GL
+  // context goes away; buffers still resident at destruction are not released.
+  void clear();
+
+  ResidencyStats getStats() const;
+  void resetCounters();
+
+private:
+  struct Entry {
+    std::shared_ptr<const DecodedScan> scan;   // Null while only the GPU copy is resident
+    GpuScanBuffers gpu;
+    bool gpuResident = false;
+    // Source of the GPU copy, so a changed file or scale triggers a re-upload
+    uint64_t gpuFileBytes = 0;
+    int64_t gpuModifiedTime = 0;
+    float gpuScaleFactor = 0.0f;
+    std::list<std::string>::iterator recency;
+  };
+
+  mutable std::mutex mutex;
+  std::unordered_map<std::string, Entry> entries;
+  std::list<std::string> recency;              // Front = most recently viewed
+  UploadFunction upload;
+  ReleaseFunction release;
+  ResidencyStats stats;
+
+  static std::shared_ptr<DecodedScan> decode(const std::string& filePath, float scaleFactor, std::string* error);
+  Entry& touch(const std::string& filePath);
+  void enforceRamBudget(const std::string& keep);
+  void enforceVramBudget(const std::string& keep, std::vector<GpuScanBuffers>& toRelease);
+  void eraseIfEmpty(std::unordered_map<std::string, Entry>::iterator it);
+  void releaseBuffers(std::vector<GpuScanBuffers>& buffers);
+};
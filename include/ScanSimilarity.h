@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <ostream>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+enum class SimilarityMetric {
+  Correlation = 0,   // Pearson correlation over the cells both scans cover
+  Rmse = 1           // Root-mean-square value difference over those cells
+};
+
+struct SimilarityOptions {
+  int cellsPerAxis = 32;       // Grid resolution across the first scan's largest extent
+  float cellSize = 0.0f;       // Explicit cell edge in scaled units (overrides cellsPerAxis)
+  float scaleFactor = 1000.0f;
+  const std::atomic<bool>* cancel = nullptr;  // Once set, no more files are read and no more tiles start
+};
+
+// Mean value per occupied grid cell of one scan, sorted by cell key
+struct SimilarityCells {
+  std::vector<uint64_t> keys;
+  std::vector<float> means;
+};
+
+// Scans resampled onto one shared grid, the input of the pairwise pass
+struct ResampledScans {
+  std::vector<std::string> paths;    // Scans that could be read, in input order
+  std::vector<SimilarityCells> cells;
+  float cellSize = 0.0f;
+  std::vector<std::string> failed;   // Files that could not be read
+  bool cancelled = false;
+  double milliseconds = 0.0;
+};
+
+// Pairwise similarity of N scans, row-major N x N
+struct SimilarityMatrix {
+  std::vector<std::string> paths;    // Scans that could be read, in input order
+  std::vector<float> correlation;    // NaN where fewer than two common cells or no variance
+  std::vector<float> rmse;           // NaN where no common cells
+  std::vector<uint32_t> commonCells; // Cells covered by both scans
+  size_t cellCount = 0;              // Grid cells covered by at least one scan
+  float cellSize = 0.0f;
+  std::vector<std::string> failed;   // Files that could not be read
+  double resampleMilliseconds = 0.0;
+  double matrixMilliseconds = 0.0;
+  bool cancelled = false;            // Stopped early; the matrix is incomplete
+
+  size_t size() const { return paths.size(); }
+  float at(SimilarityMetric metric, size_t row, size_t column) const {
+    return (metric == SimilarityMetric::Rmse ? rmse : correlation)[row * paths.size() + column];
+  }
+};
+
+// Resamples every scan onto one shared grid (mean value per cell) and compares all
+// pairs. The pair sums are four masked dot-product families (x.x, m.m, x.m, x^2.m
+// with x the cell means and m the coverage masks), computed as blocked
+// matrix-product tiles with SIMD kernels, one upper-triangle tile per job.
+class ScanSimilarity {
+public:
+  // resample, then computeMatrix
+  static bool compute(const std::vector<std::string>& files, const SimilarityOptions& options, SimilarityMatrix& out);
+
+  // Read the files on I/O threads and bin each as a job once it is parsed. Waits on
+  // the reader, so call it from outside the job pool. False if no scan could be read.
+  static bool resample(const std::vector<std::string>& files, const SimilarityOptions& options, ResampledScans& out);
+
+  // Pairwise pass over resampled scans; pure compute, so it can run as a job
+  static void computeMatrix(const ResampledScans& scans, const SimilarityOptions& options, SimilarityMatrix& out);
+
+  // Same for scans already in memory (interleaved xyz and values per scan)
+  static void computeFromPoints(const std::vector<const float*>& positions, const std::vector<const float*>& values,
+    const std::vector<size_t>& pointCounts, const SimilarityOptions& options, SimilarityMatrix& out);
+
+  // Matrix with the full file paths (CSV-escaped) as header row and first column
+  static void writeCsv(std::ostream& out, const SimilarityMatrix& matrix, SimilarityMetric metric);
+
+  static const char* getMetricName(SimilarityMetric metric);
+};
@@ -0,0 +1,42 @@
+#pragma once
+#include "ScanVolume.h"
+#include <vector>
+#include <cstddef>
+
+// Planar cut through a volume grid, perpendicular to one axis. u and v are the two
+// remaining axes in xyz order (XY, XZ or YZ), nodes are cellSize apart.
+struct SliceImage {
+  int normalAxis = 2;
+  int axisU = 0, axisV = 1;
+  float position = 0.0f;          // Coordinate of the cut along normalAxis
+  int width = 0, height = 0;      // Nodes along u and v
+  float origin[2] = { 0, 0 };     // u, v of node (0, 0)
+  float cellSize = 0.0f;
+  std::vector<float> values;      // u varying fastest; NaN = empty
+};
+
+// Contour segments joined end to end
+struct ContourLine {
+  std::vector<float> points;      // u v pairs
+  bool closed = false;            // Last point connects back to the first
+};
+
+// Orthogonal slices and their iso-lines. A slice interpolates linearly between the
+// two grid layers around the cut (rows run as parallel jobs), so it can follow a
+// dragged position continuously. Contours come from marching squares over the
+// slice, bands of rows in parallel; saddle cells are split by the cell's mean.
+class ScanSlices {
+public:
+  static void slice(const VolumeGrid& grid, int normalAxis, float position, SliceImage& out);
+
+  // Segments where the slice crosses level, as u0 v0 u1 v1 quadruples. An edge
+  // crossing is computed the same way for both cells sharing it, so segment ends
+  // of neighbouring cells match exactly.
+  static void extractContours(const SliceImage& image, float level, std::vector<float>& segments);
+
+  // Join segments that share an end into polylines (open ones run border to border)
+  static void chainContours(const std::vector<float>& segments, std::vector<ContourLine>& out);
+
+  // Position of the highest grid node; false if the grid is empty
+  static bool findPeak(const VolumeGrid& grid, float position[3]);
+};
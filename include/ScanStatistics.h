@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// One-pass statistics over a stream of measurement values.
+// Mean/variance use Welford's update, percentiles come from a merging t-digest
+// and the histogram keeps a fixed number of bins whose range doubles as needed.
+// Non-finite values are ignored.
+class ScanStatistics {
+public:
+  explicit ScanStatistics(int histogramBins = 64, double compression = 100.0);
+
+  // Add one value to all estimators
+  void add(float value);
+
+  // Add a block of values
+  void addRange(const float* values, size_t count);
+
+  // Reset to the empty state
+  void clear();
+
+  // Moments
+  size_t getCount() const { return count; }
+  double getMean() const { return mean; }
+  double getVariance() const;   // Sample variance (n - 1)
+  double getStdDev() const;
+  float getMin() const { return minValue; }
+  float getMax() const { return maxValue; }
+
+  // Approximate value at a fraction in [0, 1] (0.5 = median)
+  float getPercentile(double fraction) const;
+
+  // Histogram: bin i covers [low + i * width, low + (i + 1) * width)
+  const std::vector<uint64_t>& getHistogramCounts() const { return histogram; }
+  double getHistogramLow() const { return histogramLow; }
+  double getHistogramBinWidth() const { return histogramBinWidth; }
+
+  // Number of t-digest centroids currently held (after merging pending values)
+  size_t getCentroidCount() const;
+
+private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  // Welford moments
+  size_t count;
+  double mean;
+  double m2;
+  float minValue;
+  float maxValue;
+
+  // t-digest
+  double compression;
+  mutable std::vector<Centroid> centroids;
+  mutable std::vector<float> pending;
+
+  // Histogram
+  std::vector<uint64_t> histogram;
+  double histogramLow;
+  double histogramBinWidth;     // 0 until two distinct values have been seen
+  float firstValue;
+  uint64_t firstValueCount;
+
+  void mergePending() const;
+  void addToHistogram(float value, uint64_t weight);
+  void growHistogramDown();
+  void growHistogramUp();
+};
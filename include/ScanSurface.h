@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Plane the scan is projected onto before triangulating; Auto drops the axis of smallest extent
+enum class SurfacePlane {
+  Auto,
+  XY,
+  XZ,
+  YZ
+};
+
+struct SurfaceOptions {
+  SurfacePlane plane = SurfacePlane::Auto;
+  float maxEdgeFactor = 4.0f;     // Drop triangles with an edge longer than this many median edges (0 = keep all)
+};
+
+struct SurfaceMesh {
+  std::vector<uint32_t> triangles;  // Index triples into the scan's points
+  int axisU = 0, axisV = 1;         // Projection plane
+  int heightAxis = 2;               // Axis the value is drawn along
+  size_t vertexCount = 0;           // Distinct projected points that were triangulated
+  size_t duplicateCount = 0;        // Points sharing a projected position with an earlier one
+  size_t delaunayCount = 0;         // Triangles before the edge-length filter
+  double sortMilliseconds = 0.0;    // Hilbert ordering of the insertions
+  double triangulateMilliseconds = 0.0;
+  double filterMilliseconds = 0.0;
+};
+
+// Value surface over a planar raster scan. The projected points are inserted in
+// Hilbert-curve order into an incremental Delaunay triangulation (walk from the
+// last inserted triangle, split, then Lawson edge flips), so each insertion only
+// touches a few neighbouring triangles. Triangles bridging gaps in the raster are
+// dropped by edge length; the rest is drawn as one indexed mesh.
+class ScanSurface {
+public:
+  // Positions are interleaved xyz
+  static void build(const float* positions, size_t pointCount, const SurfaceOptions& options, SurfaceMesh& out);
+
+  // Delaunay triangulation of interleaved 2D points; triples are counter-clockwise.
+  // Returns the number of duplicate points left out.
+  static size_t triangulate(const double* uv, size_t pointCount, std::vector<uint32_t>& triangles, double* sortMilliseconds = nullptr);
+
+  // Mesh vertices: the scan positions with the height axis replaced by the value,
+  // normalised over [minValue, maxValue] and scaled to height. Outlier and NaN values
+  // take the mean height of their inlier triangle neighbours instead of spiking.
+  static void liftVertices(const float* positions, const float* values, size_t pointCount, const SurfaceMesh& mesh,
+    float minValue, float maxValue, float height, std::vector<float>& out);
+};
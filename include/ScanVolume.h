@@ -0,0 +1,59 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+struct VolumeGridOptions {
+  int resolution = 48;            // Grid nodes along the longest axis; the other axes keep the cell size
+  size_t neighbours = 8;          // Nearest measurements blended into each node
+  float power = 2.0f;             // Inverse-distance weighting exponent
+  float maxDistanceFactor = 2.0f; // Nodes farther than this many spacings from every measurement stay empty
+  const std::atomic<bool>* cancel = nullptr;  // Once set, the remaining slabs are skipped
+};
+
+// Regular grid of interpolated values, x varying fastest. Empty nodes are NaN.
+struct VolumeGrid {
+  int dims[3] = { 0, 0, 0 };
+  float origin[3] = { 0, 0, 0 };
+  float cellSize = 0.0f;
+  std::vector<float> values;
+  float minValue = 0.0f, maxValue = 0.0f;  // Over the filled nodes
+  float peakValue = 0.0f;         // Highest measurement (levels are relative to it)
+  float spacing = 0.0f;           // Median nearest-neighbour distance of the measurements
+  size_t measurementCount = 0;
+  size_t emptyCount = 0;
+  double indexMilliseconds = 0.0;
+  double gridMilliseconds = 0.0;
+  bool cancelled = false;         // Stopped through the cancel flag; values are incomplete
+
+  bool isVolumetric() const { return dims[0] > 1 && dims[1] > 1 && dims[2] > 1; }
+  size_t nodeIndex(int x, int y, int z) const { return (static_cast<size_t>(z) * dims[1] + y) * dims[0] + x; }
+};
+
+struct IsoSurfaceMesh {
+  float level = 0.0f;
+  std::vector<float> vertices;      // xyz
+  std::vector<float> normals;       // Unit grid gradients, pointing towards lower values
+  std::vector<uint32_t> triangles;  // Counter-clockwise seen from the lower side
+  double milliseconds = 0.0;
+};
+
+// Volumetric view of an XYZ scan. The measurements are indexed in a KD-tree and
+// every grid node takes the inverse-distance weighted mean of its nearest ones;
+// z slabs of nodes run as parallel jobs. Iso-surfaces are extracted per slab of
+// cells with marching tetrahedra (every cell split into six tetrahedra along its
+// main diagonal), which needs no case table and has no ambiguous faces. Vertices
+// on shared tetrahedron edges are welded within a slab.
+class ScanVolume {
+public:
+  // Positions are interleaved xyz; values outside the viewer's outlier limit are ignored
+  static void grid(const float* positions, const float* values, size_t pointCount,
+    const VolumeGridOptions& options, VolumeGrid& out);
+
+  // Surface where the grid crosses level (empty for grids without three dimensions)
+  static void extractIsoSurface(const VolumeGrid& grid, float level, IsoSurfaceMesh& out);
+
+  // Absolute level decibels relative to the grid's peak value (-3 dB = half the peak)
+  static float levelFromDecibels(const VolumeGrid& grid, float decibels);
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Result of a min/max/sum pass over a value array
+struct ValueReduction {
+  float minValue = std::numeric_limits<float>::max();
+  float maxValue = std::numeric_limits<float>::lowest();
+  double sum = 0.0;
+  size_t count = 0;  // Number of values that passed the range test
+};
+
+class SimdReductions {
+public:
+  // Min/max/sum of the values strictly inside (lowerLimit, upperLimit).
+  // Values outside the interval and NaNs are skipped.
+  static ValueReduction reduceValues(const float* values, size_t count,
+    float lowerLimit = -std::numeric_limits<float>::infinity(),
+    float upperLimit = std::numeric_limits<float>::infinity());
+
+  // Axis-aligned bounds of interleaved xyz positions (minOut/maxOut are x, y, z)
+  static bool reducePositions(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]);
+
+  // Min/max/sum of the values whose bit is set in selectionWords (bit i selects values[i]).
+  // Words past count must be zero-padded, as PointBitset keeps them.
+  static ValueReduction reduceSelectedValues(const float* values, const uint64_t* selectionWords, size_t count);
+
+  // Per-component sum of the selected interleaved xyz positions; returns the number summed
+  static size_t sumSelectedPositions(const float* xyz, const uint64_t* selectionWords, size_t pointCount, double sumOut[3]);
+};
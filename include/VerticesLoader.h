@@ -1,17 +1,34 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <cstdint>
+#include "ScanStatistics.h"
+#include "ScanBitmapIndex.h"
+#include "KdTree.h"
+
+class ScanResidency;
 
 struct ScanPoint {
   float x, y, z;     // Normalized position
   float value;       // Measurement value for color mapping
-  bool isPeak;       // Whether this point is a peak
+  bool isPeak = false; // Whether this point is a peak
   std::string axis;  // Axis that was scanned
   std::string direction; // Direction of scan
+  float time = -1.0f; // Seconds since the scan's first timestamped measurement (-1 = no timestamp)
+};
+
+// Axis-aligned bounds of the loaded points
+struct BoundingBox {
+  float minX, maxX;
+  float minY, maxY;
+  float minZ, maxZ;
 };
 
 class VerticesLoader {
 public:
+  // Values outside (-limit, limit) are treated as outliers for the value range
+  static constexpr float VALUE_OUTLIER_LIMIT = 1000.0f;
+
   // Load scan data from JSON file
   static bool loadScanFromFile(const std::string& filePath, float scaleFactor = 1000.0f);
 
@@ -21,18 +38,43 @@ public:
   // Initialize file list and load first file
   static bool initializeScanFiles(const std::string& directory = "logs/scanning", float scaleFactor = 1000.0f);
 
+  // Same over several roots, searched recursively (e.g. logs/scanning/YYYY/MM/DD archives)
+  static bool initializeScanFiles(const std::vector<std::string>& directories, float scaleFactor = 1000.0f);
+
   // Cycle to next scan file
   static bool loadNextScanFile(float scaleFactor = 1000.0f);
 
   // Cycle to previous scan file
   static bool loadPreviousScanFile(float scaleFactor = 1000.0f);
 
+  // Load a file by path; it becomes the current file when it is in the cycled list
+  static bool selectScanFile(const std::string& filePath, float scaleFactor = 1000.0f);
+
+  // Path of the loaded scan (empty when nothing is loaded)
+  static const std::string& getCurrentScanFile();
+
+  // Files cycled through by Tab, newest first
+  static const std::vector<std::string>& getAvailableFiles();
+
   // Get current file index and total count
   static std::pair<int, int> getCurrentFileInfo();
 
+  // Append a point, extending the bounding box and value range incrementally
+  static void appendScanPoint(const ScanPoint& point);
+
   // Generate vertices from loaded scan data
   static std::vector<float> generateScanVertices();
 
+  // Interleaved xyz positions kept alongside scanPoints (no copy)
+  static const std::vector<float>& getPositionData();
+
+  // Measurement values kept alongside scanPoints (no copy)
+  static const std::vector<float>& getValueData();
+
+  // Per-point acquisition times (see ScanPoint::time); valid when hasTimestamps()
+  static const std::vector<float>& getTimeData();
+  static bool hasTimestamps();
+
   // Generate vertices with values (x, y, z, value) for color mapping
   static std::vector<float> generateScanVerticesWithValues();
 
@@ -45,25 +87,72 @@ public:
   // Get measurement values for color mapping
   static std::vector<float> getMeasurementValues();
 
+  // Per-point attribute columns (axis/direction strings interned as small codes)
+  static const std::vector<uint8_t>& getPeakFlags();
+  static const std::vector<uint8_t>& getAxisCodes();
+  static const std::vector<uint8_t>& getDirectionCodes();
+  static const std::vector<std::string>& getAxisNames();
+  static const std::vector<std::string>& getDirectionNames();
+
+  // Decoded scans (and their GPU buffers) kept within RAM/VRAM budgets; loads go through it
+  static ScanResidency& getResidency();
+
+  // Bitmap indices over peak/axis/direction/value, rebuilt after each load
+  static const ScanBitmapIndex& getBitmapIndex();
+
+  // KD-tree over the loaded positions, built on first use after each load
+  static const KdTree& getSpatialIndex();
+
   // Get min/max values for color scaling
   static std::pair<float, float> getValueRange();
 
+  // Streaming statistics (moments, histogram, percentiles) of the loaded values
+  static const ScanStatistics& getValueStatistics();
+
+  // Value range between two percentiles, e.g. (0.01, 0.99) for auto-ranging colours
+  static std::pair<float, float> getPercentileRange(double lowFraction, double highFraction);
+
+  // Bounding box maintained while points are appended (O(1))
+  static BoundingBox getBoundingBox();
+
+  // Recompute bounds and value range from scratch with the SIMD kernels
+  static void recomputeBounds();
+
+  // Number of points flagged as peaks
+  static int getPeakCount();
+
   // Get scan information
   static std::string getScanInfo();
 
   // Clear loaded data
   static void clear();
 
+  // Scan JSON files (name contains "scan") under a directory and its subdirectories, newest first
+  static std::vector<std::string> findScanFiles(const std::string& directory);
+
 private:
   static std::vector<ScanPoint> scanPoints;
+  static std::vector<float> positionData;
+  static std::vector<float> valueData;
+  static std::vector<float> timeData;
+  static bool timestamped;
+  static BoundingBox boundingBox;
+  static int peakCount;
+  static ScanStatistics valueStatistics;
+  static std::vector<uint8_t> peakFlags;
+  static std::vector<uint8_t> axisCodes;
+  static std::vector<uint8_t> directionCodes;
+  static std::vector<std::string> axisNames;
+  static std::vector<std::string> directionNames;
+  static ScanBitmapIndex bitmapIndex;
+  static KdTree spatialIndex;
+  static bool spatialIndexValid;
   static std::string currentScanFile;
   static float minValue, maxValue;
   static std::vector<std::string> availableFiles;
   static int currentFileIndex;
 
   // Helper functions
-  static std::vector<std::string> findScanFiles(const std::string& directory);
-  static std::string getMostRecentFile(const std::vector<std::string>& files);
   static bool parseScanFile(const std::string& filePath, float scaleFactor);
-  static void sortFilesByDate(std::vector<std::string>& files);
+  static uint8_t internCode(std::vector<std::string>& names, const std::string& name);
 };
\ No newline at end of file
@@ -1,9 +1,9 @@
 #version 330 core
 
-uniform vec3 color;
+in vec4 vertexColor;
 out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(color, 1.0);
+    FragColor = vertexColor;
 }
\ No newline at end of file
@@ -1,13 +1,19 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec3 color;
+uniform bool useVertexColor; // Per-point colours for the point cloud, uniform colour otherwise
+
+out vec4 vertexColor;
 
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1.0);
     gl_PointSize = 5.0; // Set point size explicitly
+    vertexColor = useVertexColor ? aColor : vec4(color, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,431 @@
+#include "AsyncFileReader.h"
+#include "ScanParser.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+#define ASYNC_READER_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#else
+#define ASYNC_READER_IO_URING 0
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ASYNC_READER_POSIX 1
+#else
+#define ASYNC_READER_POSIX 0
+#endif
+
+#if ASYNC_READER_IO_URING
+
+// Minimal io_uring wrapper over the raw syscalls: one submission and one
+// completion ring, mapped the way the kernel describes in io_uring_params.
+class IoUringRing {
+public:
+  ~IoUringRing() { shutdown(); }
+
+  bool init(unsigned int entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ringFd < 0) return false;
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) { sqRing = nullptr; shutdown(); return false; }
+    if (singleMap) {
+      cqRing = sqRing;
+    }
+    else {
+      cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+      if (cqRing == MAP_FAILED) { cqRing = nullptr; shutdown(); return false; }
+    }
+    sqeSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMap = mmap(nullptr, sqeSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqeMap == MAP_FAILED) { shutdown(); return false; }
+    sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+    char* sq = static_cast<char*>(sqRing);
+    sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+    sqEntries = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_entries);
+    sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(cqRing);
+    cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  // True if the kernel implements every opcode in ops
+  bool supports(const std::vector<int>& ops) {
+    const size_t probeOps = 256;
+    std::vector<char> storage(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op), 0);
+    io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, probeOps) < 0) return false;
+    for (int op : ops) {
+      if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+  }
+
+  // Next free submission entry (zeroed); nullptr if the ring is full
+  io_uring_sqe* getSqe() {
+    unsigned int head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    unsigned int tail = localTail;
+    if (tail - head >= sqEntries) return nullptr;
+    io_uring_sqe* sqe = &sqes[tail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[tail & sqMask] = tail & sqMask;
+    localTail = tail + 1;
+    pending++;
+    return sqe;
+  }
+
+  // Publish queued entries and wait for at least waitFor completions
+  bool submitAndWait(unsigned int waitFor) {
+    __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+    while (true) {
+      long result = syscall(__NR_io_uring_enter, ringFd, pending, waitFor, waitFor > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+      if (result >= 0) {
+        pending -= std::min<unsigned int>(pending, static_cast<unsigned int>(result));
+        return true;
+      }
+      if (errno != EINTR) return false;
+    }
+  }
+
+  // Pop one completion if available
+  bool popCompletion(io_uring_cqe& out) {
+    unsigned int head = *cqHead;
+    if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+    out = cqes[head & cqMask];
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+private:
+  int ringFd = -1;
+  void* sqRing = nullptr;
+  void* cqRing = nullptr;
+  size_t sqRingSize = 0, cqRingSize = 0, sqeSize = 0;
+  io_uring_sqe* sqes = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  unsigned int* sqHead = nullptr;
+  unsigned int* sqTail = nullptr;
+  unsigned int* sqArray = nullptr;
+  unsigned int sqMask = 0, sqEntries = 0;
+  unsigned int* cqHead = nullptr;
+  unsigned int* cqTail = nullptr;
+  unsigned int cqMask = 0;
+  unsigned int localTail = 0;
+  unsigned int pending = 0;
+
+  void shutdown() {
+    if (sqes) munmap(sqes, sqeSize);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ringFd >= 0) close(ringFd);
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringFd = -1;
+  }
+};
+
+static bool setupRing(IoUringRing& ring, unsigned int entries) {
+  return ring.init(entries) && ring.supports({ IORING_OP_OPENAT, IORING_OP_READ });
+}
+
+#endif
+
+AsyncFileReader::AsyncFileReader(size_t queueDepth, unsigned int ioThreads)
+  : queueDepth(std::max<size_t>(1, queueDepth)),
+  ioThreads(ioThreads > 0 ? ioThreads : static_cast<unsigned int>(std::min<size_t>(queueDepth, 64))),
+  backend(isIoUringAvailable() ? ReaderBackend::IoUring : ReaderBackend::ThreadPool) {
+}
+
+void AsyncFileReader::setBackend(ReaderBackend requested) {
+  backend = (requested == ReaderBackend::IoUring && !isIoUringAvailable()) ? ReaderBackend::ThreadPool : requested;
+}
+
+bool AsyncFileReader::isIoUringAvailable() {
+#if ASYNC_READER_IO_URING
+  // Probed once: seccomp filters and older kernels both reject io_uring
+  static const bool available = []() {
+    IoUringRing ring;
+    return setupRing(ring, 4);
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+const char* AsyncFileReader::getBackendName(ReaderBackend backend) {
+  switch (backend) {
+  case ReaderBackend::IoUring: return "io_uring";
+  case ReaderBackend::ThreadPool: return "pread pool";
+  case ReaderBackend::Stream: return "ifstream pool";
+  default: return "unknown";
+  }
+}
+
+void AsyncFileReader::evictFromPageCache(const std::vector<std::string>& paths) {
+#if ASYNC_READER_POSIX && defined(POSIX_FADV_DONTNEED)
+  for (const std::string& path : paths) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) continue;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+#else
+  (void)paths;
+#endif
+}
+
+void AsyncFileReader::readAll(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output) {
+  bool done = false;
+  if (backend == ReaderBackend::IoUring) {
+    done = readAllIoUring(paths, output);
+  }
+  if (!done) {
+    readAllThreadPool(paths, output, backend == ReaderBackend::Stream);
+  }
+  output.close();
+}
+
+void AsyncFileReader::readFileBlocking(const std::string& path, FileBuffer& buffer, bool useStream) {
+#if ASYNC_READER_POSIX
+  if (!useStream) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      buffer.error = "cannot open file";
+      return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      close(fd);
+      buffer.error = "cannot stat file";
+      return;
+    }
+
+    buffer.content.resize(static_cast<size_t>(info.st_size));
+    size_t done = 0;
+    while (done < buffer.content.size()) {
+      ssize_t got = pread(fd, &buffer.content[done], buffer.content.size() - done, static_cast<off_t>(done));
+      if (got < 0 && errno == EINTR) continue;
+      if (got <= 0) break;
+      done += static_cast<size_t>(got);
+    }
+    close(fd);
+    buffer.content.resize(done);
+    buffer.ok = true;
+    return;
+  }
+#endif
+  buffer.ok = ScanParser::readFile(path, buffer.content);
+  if (!buffer.ok) buffer.error = "cannot open file";
+}
+
+void AsyncFileReader::readAllThreadPool(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output, bool useStreams) {
+  std::atomic<size_t> nextFile(0);
+  auto worker = [&]() {
+    for (size_t i = nextFile++; i < paths.size(); i = nextFile++) {
+      FileBuffer buffer;
+      buffer.fileIndex = i;
+      readFileBlocking(paths[i], buffer, useStreams);
+      if (!output.push(std::move(buffer))) return;
+    }
+  };
+
+  unsigned int threadCount = static_cast<unsigned int>(std::min<size_t>(ioThreads, std::max<size_t>(1, paths.size())));
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+  worker();
+  for (std::thread& thread : threads) thread.join();
+}
+
+bool AsyncFileReader::readAllIoUring(const std::vector<std::string>& paths, BoundedQueue<FileBuffer>& output) {
+#if ASYNC_READER_IO_URING
+  IoUringRing ring;
+  unsigned int depth = static_cast<unsigned int>(std::min<size_t>(queueDepth, 4096));
+  if (!setupRing(ring, depth)) return false;
+
+  // One slot per file in flight; each slot has exactly one request queued at a
+  // time (its open, then reads until the file is complete), so the submission
+  // ring can never overflow.
+  struct Slot {
+    size_t fileIndex = 0;
+    int fd = -1;
+    size_t done = 0;
+    bool opening = false;
+    FileBuffer buffer;
+  };
+  std::vector<Slot> slots(depth);
+  std::vector<unsigned int> freeSlots;
+  for (unsigned int s = depth; s > 0; --s) freeSlots.push_back(s - 1);
+
+  auto queueRead = [&](unsigned int s) {
+    Slot& slot = slots[s];
+    io_uring_sqe* sqe = ring.getSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = slot.fd;
+    sqe->addr = reinterpret_cast<unsigned long long>(&slot.buffer.content[slot.done]);
+    sqe->len = static_cast<unsigned int>(std::min<size_t>(slot.buffer.content.size() - slot.done, 1u << 30));
+    sqe->off = slot.done;
+    sqe->user_data = s;
+  };
+
+  // Close the file, hand the buffer over and recycle the slot
+  bool outputOpen = true;
+  auto finish = [&](unsigned int s, const char* error) {
+    Slot& slot = slots[s];
+    if (slot.fd >= 0) close(slot.fd);
+    slot.fd = -1;
+    if (error) {
+      slot.buffer.ok = false;
+      slot.buffer.error = error;
+      slot.buffer.content.clear();
+    }
+    else {
+      slot.buffer.content.resize(slot.done);
+      slot.buffer.ok = true;
+    }
+    if (outputOpen) outputOpen = output.push(std::move(slot.buffer));
+    slot.buffer = FileBuffer();
+    freeSlots.push_back(s);
+  };
+
+  size_t nextFile = 0;
+  size_t inFlight = 0;
+  while (outputOpen && (nextFile < paths.size() || inFlight > 0)) {
+    // Keep the ring full of opens
+    while (!freeSlots.empty() && nextFile < paths.size()) {
+      unsigned int s = freeSlots.back();
+      freeSlots.pop_back();
+      Slot& slot = slots[s];
+      slot.fileIndex = nextFile;
+      slot.fd = -1;
+      slot.done = 0;
+      slot.opening = true;
+      slot.buffer.fileIndex = nextFile;
+
+      io_uring_sqe* sqe = ring.getSqe();
+      sqe->opcode = IORING_OP_OPENAT;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = reinterpret_cast<unsigned long long>(paths[nextFile].c_str());
+      sqe->open_flags = O_RDONLY | O_CLOEXEC;
+      sqe->user_data = s;
+      nextFile++;
+      inFlight++;
+    }
+
+    if (!ring.submitAndWait(1)) {
+      // The ring broke down; finish the remaining files synchronously
+      for (Slot& slot : slots) {
+        if (slot.fd >= 0) close(slot.fd);
+      }
+      for (size_t s = 0; s < slots.size(); ++s) {
+        bool active = std::find(freeSlots.begin(), freeSlots.end(), static_cast<unsigned int>(s)) == freeSlots.end();
+        if (!active) continue;
+        FileBuffer buffer;
+        buffer.fileIndex = slots[s].fileIndex;
+        readFileBlocking(paths[slots[s].fileIndex], buffer, false);
+        output.push(std::move(buffer));
+      }
+      for (; nextFile < paths.size(); ++nextFile) {
+        FileBuffer buffer;
+        buffer.fileIndex = nextFile;
+        readFileBlocking(paths[nextFile], buffer, false);
+        if (!output.push(std::move(buffer))) break;
+      }
+      return true;
+    }
+
+    io_uring_cqe cqe;
+    while (ring.popCompletion(cqe)) {
+      unsigned int s = static_cast<unsigned int>(cqe.user_data);
+      Slot& slot = slots[s];
+
+      if (slot.opening) {
+        slot.opening = false;
+        if (cqe.res < 0) {
+          finish(s, "cannot open file");
+          inFlight--;
+          continue;
+        }
+        slot.fd = cqe.res;
+        // The inode is already in memory after the open, so this does not block on the disk
+        struct stat info;
+        if (fstat(slot.fd, &info) != 0) {
+          finish(s, "cannot stat file");
+          inFlight--;
+          continue;
+        }
+        slot.buffer.content.resize(static_cast<size_t>(info.st_size));
+        if (slot.buffer.content.empty()) {
+          finish(s, nullptr);
+          inFlight--;
+          continue;
+        }
+        queueRead(s);
+        continue;
+      }
+
+      if (cqe.res < 0) {
+        finish(s, "read failed");
+        inFlight--;
+      }
+      else if (cqe.res == 0) {
+        finish(s, nullptr); // File shrank; keep what was read
+        inFlight--;
+      }
+      else {
+        slot.done += static_cast<size_t>(cqe.res);
+        if (slot.done < slot.buffer.content.size()) {
+          queueRead(s); // Short read
+        }
+        else {
+          finish(s, nullptr);
+          inFlight--;
+        }
+      }
+    }
+  }
+
+  // Consumers stopped early: wait out the requests still in flight before their buffers go away
+  while (inFlight > 0 && ring.submitAndWait(1)) {
+    io_uring_cqe cqe;
+    while (ring.popCompletion(cqe)) {
+      Slot& slot = slots[static_cast<unsigned int>(cqe.user_data)];
+      if (slot.opening && cqe.res >= 0) close(cqe.res);
+      if (slot.fd >= 0) close(slot.fd);
+      slot.fd = -1;
+      inFlight--;
+    }
+  }
+  return true;
+#else
+  (void)paths;
+  (void)output;
+  return false;
+#endif
+}
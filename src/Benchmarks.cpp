@@ -0,0 +1,532 @@
+#include "Benchmarks.h"
+#include "ColorMapper.h"
+#include "CpuFeatures.h"
+#include "KdTree.h"
+#include "ScanDiff.h"
+#include "ScanSimilarity.h"
+#include "ScanFit.h"
+#include "ScanPeaks.h"
+#include "ScanHysteresis.h"
+#include "ScanFilters.h"
+#include "ScanSurface.h"
+#include "ScanVolume.h"
+#include "ScanSlices.h"
+#include "ScanBeamWidth.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cmath>
+
+// Milliseconds taken by the fastest of a few runs of fn
+template <typename Fn>
+static double timeBestOf(int runs, Fn&& fn) {
+  double best = 0.0;
+  for (int run = 0; run < runs; ++run) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (run == 0 || ms < best) best = ms;
+  }
+  return best;
+}
+
+static void printResult(const char* label, size_t count, double ms, double baselineMs, const char* unit = "Mpts/s") {
+  std::cout << "  " << std::left << std::setw(24) << label << std::right
+    << std::setw(10) << std::fixed << std::setprecision(2) << ms << " ms"
+    << std::setw(10) << std::setprecision(2) << (count / (ms * 1000.0)) << " " << unit;
+  if (baselineMs > 0.0) {
+    std::cout << std::setw(8) << std::setprecision(2) << (baselineMs / ms) << "x";
+  }
+  std::cout << std::defaultfloat << std::endl;
+}
+
+void Benchmarks::runAll() {
+  std::cout << "=== Micro-benchmarks (SIMD: "
+    << CpuFeatures::getSimdLevelName(CpuFeatures::getDetectedSimdLevel()) << ", "
+    << JobSystem::getThreadCount() << " threads) ===" << std::endl;
+  JobSystem::resetCounters();
+  runColorMapping(1000000);
+  runColorMapping(10000000);
+  runKdTree(100000);
+  runKdTree(1000000);
+  runKdTree(10000000);
+  runScanDiff(500000);
+  runSimilarity(1000, 4096);
+  runGaussianFit(10000, 300);
+  runPeakDetection(1000000);
+  runHysteresis(10000, 300);
+  runPathFilters(1000000);
+  runSurface(1000000);
+  runVolume(1000000, 64);
+  runBeamWidth(250000);
+
+  JobCounters counters = JobSystem::getCounters();
+  std::cout << "Job system: " << counters.tasksExecuted << " jobs, " << counters.steals << " steals, "
+    << std::fixed << std::setprecision(1) << counters.idleMilliseconds << " ms worker idle"
+    << std::defaultfloat << std::endl;
+  std::cout << "==========================================" << std::endl;
+}
+
+void Benchmarks::runColorMapping(size_t pointCount) {
+  const float MIN_VALID_VALUE = 0.000005f;
+
+  // Detector-like values: mostly small positives with some invalid readings
+  std::vector<float> values(pointCount);
+  std::mt19937 rng(1234);
+  std::lognormal_distribution<float> signal(-9.0f, 1.0f);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  for (auto& v : values) {
+    v = unit(rng) < 0.05f ? -unit(rng) * 0.00001f : signal(rng);
+  }
+  float minValue = 0.00001f;
+  float maxValue = 0.001f;
+
+  std::cout << "Colour mapping, " << pointCount << " points:" << std::endl;
+
+  // Reference: the per-point branchy loop the renderer used to run
+  std::vector<float> rgb;
+  double scalarMs = timeBestOf(3, [&]() {
+    rgb.clear();
+    rgb.reserve(pointCount * 3);
+    for (float val : values) {
+      float r, g, b;
+      if (val < 0 || val < MIN_VALID_VALUE) {
+        r = g = b = 0.5f;
+      }
+      else {
+        float normalizedValue = (val - minValue) / (maxValue - minValue);
+        normalizedValue = std::max(0.0f, std::min(1.0f, normalizedValue));
+        ColorMapper::valueToColor(normalizedValue, r, g, b);
+      }
+      rgb.push_back(r);
+      rgb.push_back(g);
+      rgb.push_back(b);
+    }
+  });
+  printResult("valueToColor loop", pointCount, scalarMs, 0.0);
+
+  std::vector<PackedColor> rgba(pointCount);
+  SimdLevel detected = CpuFeatures::getDetectedSimdLevel();
+  for (int level = 0; level <= static_cast<int>(detected); ++level) {
+    CpuFeatures::setSimdLevelOverride(static_cast<SimdLevel>(level));
+    double ms = timeBestOf(3, [&]() {
+      ColorMapper::mapToRGBA(values.data(), pointCount, minValue, maxValue, MIN_VALID_VALUE, rgba.data());
+    });
+    std::string label = std::string("LUT kernel (") + CpuFeatures::getSimdLevelName(static_cast<SimdLevel>(level)) + ")";
+    printResult(label.c_str(), pointCount, ms, scalarMs);
+  }
+  CpuFeatures::clearSimdLevelOverride();
+}
+
+void Benchmarks::runKdTree(size_t pointCount) {
+  const size_t QUERY_COUNT = 100000;
+  const size_t K = 8;
+
+  // Uniform cloud in a 100-unit cube
+  std::vector<float> xyz(pointCount * 3);
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<float> coord(-50.0f, 50.0f);
+  for (auto& c : xyz) c = coord(rng);
+
+  std::vector<float> queries(QUERY_COUNT * 3);
+  for (auto& c : queries) c = coord(rng);
+
+  std::cout << "KD-tree, " << pointCount << " points:" << std::endl;
+
+  KdTree tree;
+  double buildMs = timeBestOf(1, [&]() { tree.build(xyz.data(), pointCount); });
+  printResult("build", pointCount, buildMs, 0.0);
+
+  // Radius and box sizes chosen to hit roughly 8 points on average
+  float radius = 100.0f * std::cbrt(static_cast<float>(K) / pointCount * 3.0f / (4.0f * 3.14159265f));
+  float halfBox = 50.0f * std::cbrt(static_cast<float>(K) / pointCount);
+
+  std::vector<KdNeighbor> neighbors;
+  std::vector<uint32_t> found;
+  size_t hits = 0;
+
+  double knnMs = timeBestOf(1, [&]() {
+    for (size_t q = 0; q < QUERY_COUNT; ++q) {
+      tree.findNearest(&queries[q * 3], K, neighbors);
+      hits += neighbors.size();
+    }
+  });
+  printResult("k-NN (k=8) queries", QUERY_COUNT, knnMs, 0.0, "Mqueries/s");
+
+  double radiusMs = timeBestOf(1, [&]() {
+    for (size_t q = 0; q < QUERY_COUNT; ++q) {
+      tree.findInRadius(&queries[q * 3], radius, found);
+      hits += found.size();
+    }
+  });
+  printResult("radius queries", QUERY_COUNT, radiusMs, 0.0, "Mqueries/s");
+
+  double boxMs = timeBestOf(1, [&]() {
+    for (size_t q = 0; q < QUERY_COUNT; ++q) {
+      const float* c = &queries[q * 3];
+      float lo[3] = { c[0] - halfBox, c[1] - halfBox, c[2] - halfBox };
+      float hi[3] = { c[0] + halfBox, c[1] + halfBox, c[2] + halfBox };
+      tree.findInBox(lo, hi, found);
+      hits += found.size();
+    }
+  });
+  printResult("box queries", QUERY_COUNT, boxMs, 0.0, "Mqueries/s");
+
+  std::cout << "  (" << hits << " results)" << std::endl;
+}
+
+void Benchmarks::runScanDiff(size_t pointCount) {
+  // Serpentine raster like a real scan path; the reference run is offset by up to a
+  // fifth of the line spacing so no position matches exactly
+  const size_t lineLength = 1000;
+  std::vector<float> xyz(pointCount * 3), referenceXyz(pointCount * 3);
+  std::vector<float> values(pointCount), referenceValues(pointCount);
+  std::mt19937 rng(2468);
+  std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+  for (size_t i = 0; i < pointCount; ++i) {
+    size_t line = i / lineLength, step = i % lineLength;
+    float x = static_cast<float>(line % 2 == 0 ? step : lineLength - 1 - step);
+    float y = static_cast<float>(line);
+    float z = 0.1f * std::sin(x * 0.05f) * std::cos(y * 0.05f);
+    xyz[i * 3] = x;
+    xyz[i * 3 + 1] = y;
+    xyz[i * 3 + 2] = z;
+    referenceXyz[i * 3] = x + jitter(rng);
+    referenceXyz[i * 3 + 1] = y + jitter(rng);
+    referenceXyz[i * 3 + 2] = z;
+    values[i] = std::exp(-((x - 500.0f) * (x - 500.0f) + (y - 250.0f) * (y - 250.0f)) / 20000.0f);
+    referenceValues[i] = values[i] * 0.95f;
+  }
+
+  std::cout << "Scan diff, " << pointCount << " vs " << pointCount << " points:" << std::endl;
+  ScanDiffResult result;
+  double totalMs = timeBestOf(1, [&]() {
+    ScanDiff::compute(xyz.data(), values.data(), pointCount, referenceXyz.data(), referenceValues.data(), pointCount, 0.0f, result);
+  });
+  printResult("reference build", pointCount, result.buildMilliseconds, 0.0);
+  printResult("match + deltas", pointCount, result.matchMilliseconds, 0.0);
+  printResult("total", pointCount, totalMs, 0.0);
+  std::cout << "  (" << result.matchedCount << " matched, mean distance " << result.meanDistance << ")" << std::endl;
+}
+
+void Benchmarks::runSimilarity(size_t scanCount, size_t pointsPerScan) {
+  // 64 x 64 raster per scan whose peak drifts slowly across the session
+  const size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(pointsPerScan)));
+  std::vector<float> xyz(scanCount * side * side * 3), values(scanCount * side * side);
+  std::mt19937 rng(97531);
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  for (size_t s = 0; s < scanCount; ++s) {
+    float centre = side * (0.3f + 0.4f * s / scanCount);
+    for (size_t i = 0; i < side * side; ++i) {
+      float x = static_cast<float>(i % side), y = static_cast<float>(i / side);
+      size_t p = s * side * side + i;
+      xyz[p * 3] = x;
+      xyz[p * 3 + 1] = y;
+      xyz[p * 3 + 2] = 0.0f;
+      values[p] = std::exp(-((x - centre) * (x - centre) + (y - centre) * (y - centre)) / (side * 2.0f)) + noise(rng);
+    }
+  }
+  std::vector<const float*> positions, valueRows;
+  std::vector<size_t> counts(scanCount, side * side);
+  for (size_t s = 0; s < scanCount; ++s) {
+    positions.push_back(&xyz[s * side * side * 3]);
+    valueRows.push_back(&values[s * side * side]);
+  }
+
+  SimilarityOptions options;
+  options.cellsPerAxis = static_cast<int>(side);
+  SimilarityMatrix matrix;
+  std::cout << "Similarity matrix, " << scanCount << " scans x " << side * side << " points:" << std::endl;
+  size_t pairs = scanCount * (scanCount + 1) / 2;
+
+  CpuFeatures::setSimdLevelOverride(SimdLevel::Scalar);
+  ScanSimilarity::computeFromPoints(positions, valueRows, counts, options, matrix);
+  double scalarMs = matrix.matrixMilliseconds;
+  printResult("scalar pairs", pairs, scalarMs, 0.0, "Mpairs/s");
+  CpuFeatures::clearSimdLevelOverride();
+
+  if (CpuFeatures::getSimdLevel() == SimdLevel::AVX2) {
+    ScanSimilarity::computeFromPoints(positions, valueRows, counts, options, matrix);
+    printResult("AVX2 pairs", pairs, matrix.matrixMilliseconds, scalarMs, "Mpairs/s");
+  }
+  std::cout << "  (" << matrix.cellCount << " cells, resample " << std::fixed << std::setprecision(1)
+    << matrix.resampleMilliseconds << " ms, r(first, last) = " << std::setprecision(3)
+    << matrix.correlation[scanCount - 1] << ")" << std::defaultfloat << std::endl;
+}
+
+void Benchmarks::runGaussianFit(size_t passCount, size_t pointsPerPass) {
+  // Back-and-forth passes along x, y and z through a Gaussian beam, with detector noise
+  const char* axes[3] = { "X", "Y", "Z" };
+  std::vector<ScanPoint> points(passCount * pointsPerPass);
+  std::mt19937 rng(8642);
+  std::normal_distribution<float> noise(0.0f, 0.00002f);
+  for (size_t pass = 0; pass < passCount; ++pass) {
+    int axis = static_cast<int>(pass / 2 % 3);
+    bool negative = pass % 2 == 1;
+    for (size_t i = 0; i < pointsPerPass; ++i) {
+      float s = -15.0f + 30.0f * i / (pointsPerPass - 1);
+      if (negative) s = -s;
+      ScanPoint& point = points[pass * pointsPerPass + i];
+      point.x = axis == 0 ? s : 0.0f;
+      point.y = axis == 1 ? s : 0.0f;
+      point.z = axis == 2 ? s : 0.0f;
+      float r2 = (point.x - 0.4f) * (point.x - 0.4f) / 16.0f + (point.y + 0.3f) * (point.y + 0.3f) / 9.0f + point.z * point.z / 6.25f;
+      point.value = 0.001f * std::exp(-0.5f * r2) + 0.00001f + noise(rng);
+      point.axis = axes[axis];
+      point.direction = negative ? "Negative" : "Positive";
+    }
+  }
+
+  std::cout << "Gaussian fits, " << passCount << " passes x " << pointsPerPass << " points:" << std::endl;
+  ScanFitOptions options;
+  ScanFitResult result;
+  ScanFit::fitScan(points, options, result);
+  size_t converged = 0, iterations = 0;
+  for (const PassFit& pass : result.passes) {
+    if (pass.converged) converged++;
+    iterations += pass.iterations;
+  }
+  double passMs = result.fitMilliseconds - result.peakMilliseconds;
+  printResult("pass fits", result.passes.size(), passMs, 0.0, "Mfits/s");
+  printResult("3D peak fit", result.peak.pointCount, result.peakMilliseconds, 0.0);
+  std::cout << "  (" << std::fixed << std::setprecision(0) << result.passes.size() / (passMs / 1000.0) << " pass fits/s, "
+    << converged << " converged, " << std::setprecision(1) << static_cast<double>(iterations) / result.passes.size()
+    << " iterations per pass, peak at (" << std::setprecision(3) << result.peak.center[0] << ", "
+    << result.peak.center[1] << ", " << result.peak.center[2] << "))" << std::defaultfloat << std::endl;
+}
+
+void Benchmarks::runPeakDetection(size_t pointCount) {
+  // Serpentine raster over three lobes of different height and width, with noise
+  const size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(pointCount)));
+  std::vector<float> xyz(side * side * 3), values(side * side);
+  std::mt19937 rng(1357);
+  std::normal_distribution<float> noise(0.0f, 0.02f);
+  for (size_t i = 0; i < side * side; ++i) {
+    size_t line = i / side, step = i % side;
+    float x = 100.0f * (line % 2 == 0 ? step : side - 1 - step) / side;
+    float y = 100.0f * line / side;
+    xyz[i * 3] = x;
+    xyz[i * 3 + 1] = y;
+    xyz[i * 3 + 2] = 0.01f * std::sin(x);
+    values[i] = std::exp(-((x - 30.0f) * (x - 30.0f) + (y - 30.0f) * (y - 30.0f)) / 50.0f)
+      + 0.6f * std::exp(-((x - 70.0f) * (x - 70.0f) + (y - 40.0f) * (y - 40.0f)) / 30.0f)
+      + 0.4f * std::exp(-((x - 50.0f) * (x - 50.0f) + (y - 80.0f) * (y - 80.0f)) / 80.0f) + noise(rng);
+  }
+
+  std::cout << "Peak detection, " << side * side << " points:" << std::endl;
+  PeakDetectionResult result;
+  for (float fraction : { 0.2f, 0.05f }) {
+    PeakOptions options;
+    options.thresholdFraction = fraction;
+    double ms = timeBestOf(3, [&]() { ScanPeaks::detect(xyz.data(), values.data(), side * side, options, result); });
+    std::string label = "threshold " + std::to_string(static_cast<int>(fraction * 100.0f + 0.5f)) + "%";
+    printResult(label.c_str(), side * side, ms, 0.0);
+    std::cout << "  (" << result.candidateCount << " candidates in " << result.cellCount << " cells, "
+      << result.clusters.size() << " lobes, " << result.localMaxima.size() << " local maxima; grid "
+      << std::fixed << std::setprecision(1) << result.gridMilliseconds << " ms, maxima " << result.maximaMilliseconds
+      << " ms, clusters " << result.clusterMilliseconds << " ms)" << std::defaultfloat << std::endl;
+  }
+}
+
+void Benchmarks::runHysteresis(size_t passCount, size_t pointsPerPass) {
+  // Back-and-forth passes through a Gaussian beam; reverse passes see it shifted by the backlash
+  const char* axes[3] = { "X", "Y", "Z" };
+  const float backlash = 0.037f;
+  std::vector<ScanPoint> points(passCount * pointsPerPass);
+  std::mt19937 rng(9753);
+  std::normal_distribution<float> noise(0.0f, 0.00002f);
+  for (size_t pass = 0; pass < passCount; ++pass) {
+    int axis = static_cast<int>(pass / 2 % 3);
+    bool negative = pass % 2 == 1;
+    for (size_t i = 0; i < pointsPerPass; ++i) {
+      float s = -15.0f + 30.0f * i / (pointsPerPass - 1);
+      if (negative) s = -s;
+      float beam = negative ? s - backlash : s;
+      ScanPoint& point = points[pass * pointsPerPass + i];
+      point.x = axis == 0 ? s : 0.0f;
+      point.y = axis == 1 ? s : 0.0f;
+      point.z = axis == 2 ? s : 0.0f;
+      point.value = 0.001f * std::exp(-0.5f * (beam - 0.4f) * (beam - 0.4f) / 9.0f) + 0.00001f + noise(rng);
+      point.axis = axes[axis];
+      point.direction = negative ? "Negative" : "Positive";
+    }
+  }
+
+  std::cout << "Hysteresis, " << passCount << " passes x " << pointsPerPass << " points:" << std::endl;
+  HysteresisResult result;
+  double ms = timeBestOf(3, [&]() { ScanHysteresis::analyze(points, result); });
+  printResult("pairs + spectrum", result.pairs.size(), ms, 0.0, "Mpairs/s");
+
+  std::vector<float> values(points.size());
+  for (size_t i = 0; i < points.size(); ++i) values[i] = points[i].value;
+  NoiseSpectrum spectrum;
+  double spectrumMs = timeBestOf(3, [&]() { ScanHysteresis::computeSpectrum(values.data(), values.size(), 0.0, spectrum); });
+  printResult("Welch spectrum", values.size(), spectrumMs, 0.0);
+
+  // All pairs share the same shift, so the spread is the noise-limited lag precision
+  const AxisHysteresis& x = result.axes[0];
+  std::cout << "  (" << std::fixed << std::setprecision(0) << result.pairs.size() / (ms / 1000.0) << " pairs/s, "
+    << std::setprecision(4) << "backlash " << backlash << ", X lag " << x.meanLag << " +/- " << x.lagStdDev
+    << " over " << x.pairCount << " pairs, " << spectrum.segmentCount << " segments)" << std::defaultfloat << std::endl;
+}
+
+void Benchmarks::runPathFilters(size_t pointCount) {
+  // Noisy Gaussian passes of 333 points, as the scanner writes them
+  const size_t PASS_LENGTH = 333;
+  std::vector<float> values(pointCount);
+  std::vector<uint8_t> axisCodes(pointCount), directionCodes(pointCount);
+  std::mt19937 rng(2468);
+  std::normal_distribution<float> noise(0.0f, 0.00002f);
+  for (size_t i = 0; i < pointCount; ++i) {
+    size_t pass = i / PASS_LENGTH;
+    float s = -15.0f + 30.0f * (i % PASS_LENGTH) / (PASS_LENGTH - 1);
+    values[i] = 0.001f * std::exp(-0.5f * s * s / 9.0f) + noise(rng);
+    axisCodes[i] = static_cast<uint8_t>(pass / 2 % 3);
+    directionCodes[i] = static_cast<uint8_t>(pass % 2);
+  }
+  std::vector<size_t> passBounds;
+  ScanFilters::findPasses(axisCodes.data(), directionCodes.data(), pointCount, passBounds);
+
+  std::cout << "Path filters, " << pointCount << " points in " << passBounds.size() - 1 << " passes:" << std::endl;
+  std::vector<float> filtered;
+  SimdLevel detected = CpuFeatures::getDetectedSimdLevel();
+  for (ScanFilterType type : { ScanFilterType::Median, ScanFilterType::SavitzkyGolay, ScanFilterType::Exponential }) {
+    ScanFilterOptions options;
+    options.type = type;
+    options.radius = 3;
+    double scalarMs = 0.0;
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::AVX2 }) {
+      if (level > detected) continue;
+      CpuFeatures::setSimdLevelOverride(level);
+      double ms = timeBestOf(3, [&]() {
+        filtered = values;
+        ScanFilters::apply(filtered.data(), pointCount, passBounds, options);
+      });
+      if (level == SimdLevel::Scalar) scalarMs = ms;
+      std::string label = std::string(ScanFilters::getFilterName(type)) + " (" + CpuFeatures::getSimdLevelName(level) + ")";
+      printResult(label.c_str(), pointCount, ms, level == SimdLevel::Scalar ? 0.0 : scalarMs);
+    }
+  }
+  CpuFeatures::clearSimdLevelOverride();
+}
+
+void Benchmarks::runSurface(size_t pointCount) {
+  // Serpentine raster in XY with jittered steps and a slight Z tilt
+  size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(pointCount)));
+  if (side < 2) side = 2;
+  std::vector<float> positions(pointCount * 3);
+  std::mt19937 rng(1357);
+  std::normal_distribution<float> jitter(0.0f, 0.02f);
+  for (size_t i = 0; i < pointCount; ++i) {
+    size_t row = i / side;
+    size_t column = row % 2 == 0 ? i % side : side - 1 - i % side;
+    positions[i * 3] = static_cast<float>(column) + jitter(rng);
+    positions[i * 3 + 1] = static_cast<float>(row) + jitter(rng);
+    positions[i * 3 + 2] = 0.001f * static_cast<float>(column);
+  }
+
+  std::cout << "Delaunay surface, " << pointCount << " raster points:" << std::endl;
+  SurfaceMesh mesh;
+  double ms = timeBestOf(3, [&]() {
+    ScanSurface::build(positions.data(), pointCount, SurfaceOptions(), mesh);
+  });
+  printResult("Build", pointCount, ms, 0.0);
+  std::cout << "  " << mesh.triangles.size() / 3 << " of " << mesh.delaunayCount << " triangles kept; sort "
+    << std::fixed << std::setprecision(1) << mesh.sortMilliseconds << " ms, triangulate " << mesh.triangulateMilliseconds
+    << " ms, filter " << mesh.filterMilliseconds << " ms" << std::defaultfloat << std::endl;
+}
+
+void Benchmarks::runVolume(size_t pointCount, int resolution) {
+  // Gaussian coupling lobe sampled on a jittered XYZ raster
+  size_t side = std::max<size_t>(2, static_cast<size_t>(std::cbrt(static_cast<double>(pointCount))));
+  std::vector<float> positions(pointCount * 3), values(pointCount);
+  std::mt19937 rng(8642);
+  std::normal_distribution<float> jitter(0.0f, 0.05f);
+  float centre = 0.5f * (side - 1), sigma = 0.2f * side;
+  for (size_t i = 0; i < pointCount; ++i) {
+    size_t cell[3] = { i % side, i / side % side, i / (side * side) };
+    float r2 = 0.0f;
+    for (int a = 0; a < 3; ++a) {
+      positions[i * 3 + a] = static_cast<float>(cell[a]) + jitter(rng);
+      r2 += (positions[i * 3 + a] - centre) * (positions[i * 3 + a] - centre);
+    }
+    values[i] = 0.001f * std::exp(-0.5f * r2 / (sigma * sigma));
+  }
+
+  std::cout << "Volume gridding, " << pointCount << " points onto " << resolution << "^3 nodes:" << std::endl;
+  VolumeGridOptions options;
+  options.resolution = resolution;
+  VolumeGrid grid;
+  double gridMs = timeBestOf(3, [&]() {
+    ScanVolume::grid(positions.data(), values.data(), pointCount, options, grid);
+  });
+  printResult("IDW grid", grid.values.size(), gridMs, 0.0, "Mnodes/s");
+
+  IsoSurfaceMesh mesh;
+  float level = ScanVolume::levelFromDecibels(grid, -3.0f);
+  double isoMs = timeBestOf(3, [&]() {
+    ScanVolume::extractIsoSurface(grid, level, mesh);
+  });
+  size_t cells = static_cast<size_t>(grid.dims[0] - 1) * (grid.dims[1] - 1) * (grid.dims[2] - 1);
+  printResult("Iso-surface -3 dB", cells, isoMs, 0.0, "Mcells/s");
+  std::cout << "  " << mesh.triangles.size() / 3 << " triangles, " << mesh.vertices.size() / 3 << " vertices; KD-tree "
+    << std::fixed << std::setprecision(1) << grid.indexMilliseconds << " ms" << std::defaultfloat << std::endl;
+
+  // The three cuts through the peak with four contour levels each, as the slice view redoes them while dragging
+  float peak[3] = { 0, 0, 0 };
+  ScanSlices::findPeak(grid, peak);
+  SliceImage image;
+  std::vector<float> segments;
+  size_t sliceNodes = 0;
+  double sliceMs = timeBestOf(3, [&]() {
+    sliceNodes = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+      ScanSlices::slice(grid, axis, peak[axis], image);
+      sliceNodes += image.values.size();
+      for (float decibels : { -1.0f, -3.0f, -6.0f, -10.0f }) {
+        ScanSlices::extractContours(image, ScanVolume::levelFromDecibels(grid, decibels), segments);
+      }
+    }
+  });
+  printResult("Slices + contours", sliceNodes, sliceMs, 0.0, "Mnodes/s");
+}
+
+void Benchmarks::runBeamWidth(size_t pointCount) {
+  // Elliptical Gaussian mode (sigma 3 x 1.5) on a jittered XY raster
+  size_t side = std::max<size_t>(2, static_cast<size_t>(std::sqrt(static_cast<double>(pointCount))));
+  std::vector<float> positions, values;
+  positions.reserve(side * side * 3);
+  values.reserve(side * side);
+  std::mt19937 rng(9753);
+  std::normal_distribution<float> jitter(0.0f, 0.01f);
+  for (size_t row = 0; row < side; ++row) {
+    for (size_t column = 0; column < side; ++column) {
+      float x = -15.0f + 30.0f * column / (side - 1) + jitter(rng);
+      float y = -15.0f + 30.0f * row / (side - 1) + jitter(rng);
+      positions.insert(positions.end(), { x, y, 0.0f });
+      values.push_back(0.001f * std::exp(-0.5f * (x * x / 9.0f + y * y / 2.25f)));
+    }
+  }
+
+  std::cout << "Beam widths, " << values.size() << " raster points:" << std::endl;
+  BeamWidthResult result;
+  double ms = timeBestOf(3, [&]() {
+    result = BeamWidthResult();
+    ScanBeamWidth::analyze(positions.data(), values.data(), values.size(), BeamWidthOptions(), result);
+  });
+  printResult("Grid + contours", values.size(), ms, 0.0);
+  // Expected full widths: 2.355 sigma at -3 dB, 4 sigma at 1/e^2
+  const char* names[2] = { "-3 dB", "1/e^2" };
+  for (int c = 0; c < 2; ++c) {
+    const BeamContour& contour = result.contours[c];
+    std::cout << "  " << names[c] << ": widths " << std::fixed << std::setprecision(3) << contour.axisWidths[0] << " x "
+      << contour.axisWidths[1] << ", ellipticity " << contour.ellipticity << ", area " << contour.area
+      << std::defaultfloat << std::endl;
+  }
+}
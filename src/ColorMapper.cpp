@@ -0,0 +1,201 @@
+#include "ColorMapper.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+void ColorMapper::valueToColor(float normalizedValue, float& r, float& g, float& b) {
+  // Clamp value between 0 and 1
+  normalizedValue = std::max(0.0f, std::min(1.0f, normalizedValue));
+
+  if (normalizedValue < 0.5f) {
+    // Blue to Green (0 to 0.5)
+    float t = normalizedValue * 2.0f;
+    r = 0.0f;
+    g = t;
+    b = 1.0f - t;
+  }
+  else {
+    // Green to Red (0.5 to 1)
+    float t = (normalizedValue - 0.5f) * 2.0f;
+    r = t;
+    g = 1.0f - t;
+    b = 0.0f;
+  }
+}
+
+PackedColor ColorMapper::packColor(float r, float g, float b, float a) {
+  auto toByte = [](float c) {
+    return static_cast<PackedColor>(std::lround(std::max(0.0f, std::min(1.0f, c)) * 255.0f));
+  };
+  return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+}
+
+const ColorLut& ColorMapper::getRainbowLut() {
+  static const ColorLut lut = []() {
+    ColorLut table;
+    for (int i = 0; i < 256; ++i) {
+      float r, g, b;
+      valueToColor(i / 255.0f, r, g, b);
+      table[i] = packColor(r, g, b);
+    }
+    return table;
+  }();
+  return lut;
+}
+
+const ColorLut& ColorMapper::getDivergingLut() {
+  // Cool-warm end points, interpolated through a light grey centre
+  static const ColorLut lut = []() {
+    const float low[3] = { 0.230f, 0.299f, 0.754f };
+    const float mid[3] = { 0.865f, 0.865f, 0.865f };
+    const float high[3] = { 0.706f, 0.016f, 0.150f };
+    ColorLut table;
+    for (int i = 0; i < 256; ++i) {
+      float t = i / 255.0f;
+      const float* from = t < 0.5f ? low : mid;
+      const float* to = t < 0.5f ? mid : high;
+      float f = t < 0.5f ? t * 2.0f : (t - 0.5f) * 2.0f;
+      table[i] = packColor(from[0] + (to[0] - from[0]) * f, from[1] + (to[1] - from[1]) * f, from[2] + (to[2] - from[2]) * f);
+    }
+    return table;
+  }();
+  return lut;
+}
+
+PackedColor ColorMapper::getInvalidColor() {
+  static const PackedColor grey = packColor(0.5f, 0.5f, 0.5f);
+  return grey;
+}
+
+// Points per job when a mapping is split across threads
+static const size_t PARALLEL_GRAIN = 65536;
+
+// LUT index = clamp((value - minValue) * scale + bias, 0, 255)
+struct LutTransform {
+  float minValue;
+  float scale;
+  float bias;
+};
+
+static LutTransform makeLutTransform(float minValue, float maxValue) {
+  if (maxValue > minValue) {
+    return { minValue, 255.0f / (maxValue - minValue), 0.5f };
+  }
+  // Single value: every valid point gets the mid-scale colour
+  return { minValue, 0.0f, 128.0f };
+}
+
+static void mapToRGBAScalar(const float* values, size_t count, const LutTransform& t,
+  float invalidThreshold, const PackedColor* lut, PackedColor invalid, PackedColor* out) {
+  for (size_t i = 0; i < count; ++i) {
+    float v = values[i];
+    if (!(v >= invalidThreshold)) {
+      out[i] = invalid;
+      continue;
+    }
+    float f = std::max(0.0f, std::min(255.0f, (v - t.minValue) * t.scale + t.bias));
+    out[i] = lut[static_cast<int>(f)];
+  }
+}
+
+#if CPU_FEATURES_X86
+
+static TARGET_SSE41 void mapToRGBASSE41(const float* values, size_t count, const LutTransform& t,
+  float invalidThreshold, const PackedColor* lut, PackedColor invalid, PackedColor* out) {
+  const __m128 minV = _mm_set1_ps(t.minValue);
+  const __m128 scale = _mm_set1_ps(t.scale);
+  const __m128 bias = _mm_set1_ps(t.bias);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 top = _mm_set1_ps(255.0f);
+  const __m128 threshold = _mm_set1_ps(invalidThreshold);
+  const __m128i grey = _mm_set1_epi32(static_cast<int>(invalid));
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 v = _mm_loadu_ps(values + i);
+    // Not-greater-or-equal is also true for NaN
+    __m128 invalidMask = _mm_cmpnge_ps(v, threshold);
+    __m128 f = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v, minV), scale), bias);
+    f = _mm_min_ps(_mm_max_ps(f, zero), top);
+    __m128i idx = _mm_cvttps_epi32(f);
+
+    // No gather before AVX2: look the four entries up individually
+    __m128i colors = _mm_setr_epi32(
+      static_cast<int>(lut[_mm_extract_epi32(idx, 0) & 255]),
+      static_cast<int>(lut[_mm_extract_epi32(idx, 1) & 255]),
+      static_cast<int>(lut[_mm_extract_epi32(idx, 2) & 255]),
+      static_cast<int>(lut[_mm_extract_epi32(idx, 3) & 255]));
+    colors = _mm_blendv_epi8(colors, grey, _mm_castps_si128(invalidMask));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), colors);
+  }
+
+  mapToRGBAScalar(values + i, count - i, t, invalidThreshold, lut, invalid, out + i);
+}
+
+static TARGET_AVX2 void mapToRGBAAVX2(const float* values, size_t count, const LutTransform& t,
+  float invalidThreshold, const PackedColor* lut, PackedColor invalid, PackedColor* out) {
+  const __m256 minV = _mm256_set1_ps(t.minValue);
+  const __m256 scale = _mm256_set1_ps(t.scale);
+  const __m256 bias = _mm256_set1_ps(t.bias);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 top = _mm256_set1_ps(255.0f);
+  const __m256 threshold = _mm256_set1_ps(invalidThreshold);
+  const __m256i grey = _mm256_set1_epi32(static_cast<int>(invalid));
+  const int* table = reinterpret_cast<const int*>(lut);
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 v = _mm256_loadu_ps(values + i);
+    __m256 invalidMask = _mm256_cmp_ps(v, threshold, _CMP_NGE_UQ);
+    __m256 f = _mm256_fmadd_ps(_mm256_sub_ps(v, minV), scale, bias);
+    // max/min return the second operand for NaN, so NaN lands on index 0 (then greyed)
+    f = _mm256_min_ps(_mm256_max_ps(f, zero), top);
+    __m256i idx = _mm256_cvttps_epi32(f);
+    __m256i colors = _mm256_i32gather_epi32(table, idx, 4);
+    colors = _mm256_blendv_epi8(colors, grey, _mm256_castps_si256(invalidMask));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), colors);
+  }
+
+  mapToRGBAScalar(values + i, count - i, t, invalidThreshold, lut, invalid, out + i);
+}
+
+#endif
+
+void ColorMapper::mapToRGBA(const float* values, size_t count, float minValue, float maxValue,
+  float invalidThreshold, PackedColor* rgbaOut) {
+  mapToRGBA(values, count, minValue, maxValue, invalidThreshold, getRainbowLut(), rgbaOut);
+}
+
+void ColorMapper::mapToRGBA(const float* values, size_t count, float minValue, float maxValue,
+  float invalidThreshold, const ColorLut& lut, PackedColor* rgbaOut) {
+  if (values == nullptr || rgbaOut == nullptr || count == 0) return;
+
+  LutTransform t = makeLutTransform(minValue, maxValue);
+  PackedColor invalid = getInvalidColor();
+  SimdLevel level = CpuFeatures::getSimdLevel();
+
+  // Points are independent, so large uploads are split across the job system
+  JobSystem::parallelFor(0, count, PARALLEL_GRAIN, [&](size_t first, size_t last) {
+    const float* in = values + first;
+    PackedColor* out = rgbaOut + first;
+    size_t n = last - first;
+    switch (level) {
+#if CPU_FEATURES_X86
+    case SimdLevel::AVX2:
+      mapToRGBAAVX2(in, n, t, invalidThreshold, lut.data(), invalid, out);
+      break;
+    case SimdLevel::SSE41:
+      mapToRGBASSE41(in, n, t, invalidThreshold, lut.data(), invalid, out);
+      break;
+#endif
+    default:
+      mapToRGBAScalar(in, n, t, invalidThreshold, lut.data(), invalid, out);
+      break;
+    }
+  });
+}
@@ -0,0 +1,73 @@
+#include "CpuFeatures.h"
+
+#if CPU_FEATURES_X86 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+int CpuFeatures::s_overrideLevel = -1;
+
+SimdLevel CpuFeatures::getSimdLevel() {
+  SimdLevel detected = getDetectedSimdLevel();
+  if (s_overrideLevel >= 0 && s_overrideLevel < static_cast<int>(detected)) {
+    return static_cast<SimdLevel>(s_overrideLevel);
+  }
+  return detected;
+}
+
+SimdLevel CpuFeatures::getDetectedSimdLevel() {
+  static const SimdLevel detected = detectSimdLevel();
+  return detected;
+}
+
+void CpuFeatures::setSimdLevelOverride(SimdLevel level) {
+  s_overrideLevel = static_cast<int>(level);
+}
+
+void CpuFeatures::clearSimdLevelOverride() {
+  s_overrideLevel = -1;
+}
+
+const char* CpuFeatures::getSimdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::AVX2: return "AVX2";
+  case SimdLevel::SSE41: return "SSE4.1";
+  default: return "Scalar";
+  }
+}
+
+SimdLevel CpuFeatures::detectSimdLevel() {
+#if CPU_FEATURES_X86 && defined(_MSC_VER)
+  int info[4] = { 0 };
+  __cpuid(info, 0);
+  int maxLeaf = info[0];
+  if (maxLeaf < 1) return SimdLevel::Scalar;
+
+  __cpuid(info, 1);
+  bool sse41 = (info[2] & (1 << 19)) != 0;
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  bool fma = (info[2] & (1 << 12)) != 0;
+
+  bool avx2 = false;
+  if (maxLeaf >= 7 && osxsave && avx && fma) {
+    // The OS must save the YMM registers for AVX to be usable
+    unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) == 0x6) {
+      __cpuidex(info, 7, 0);
+      avx2 = (info[1] & (1 << 5)) != 0;
+    }
+  }
+
+  if (avx2) return SimdLevel::AVX2;
+  if (sse41) return SimdLevel::SSE41;
+  return SimdLevel::Scalar;
+#elif CPU_FEATURES_X86 && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+  if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE41;
+  return SimdLevel::Scalar;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
@@ -1,11 +1,20 @@
 ﻿#include "InputHandler.h"
 #include "CameraController.h"
 #include "VerticesLoader.h"
+#include "Benchmarks.h"
+#include "imgui.h"
 #include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 // External references - these need to be accessible from main.cpp
 extern CameraController camera;
 extern void updateScanBuffers();
+extern void applyScanFilter();
+extern ScanFilter g_scanFilter;
+extern void applyRegionSelection(GLFWwindow* window, const std::vector<double>& path, bool lasso);
+extern void clearRegionSelection();
 
 // Static member definitions
 bool InputHandler::s_leftMousePressed = false;
@@ -13,6 +22,34 @@ bool InputHandler::s_rightMousePressed = false;
 double InputHandler::s_lastMouseX = 0.0;
 double InputHandler::s_lastMouseY = 0.0;
 bool InputHandler::s_firstMouseMove = true;
+int InputHandler::s_valueFilterStep = 0;
+bool InputHandler::s_selecting = false;
+bool InputHandler::s_lassoSelection = false;
+std::vector<double> InputHandler::s_selectionPath;
+
+// Minimum spacing of lasso vertices in pixels
+static const double LASSO_VERTEX_SPACING = 3.0;
+
+// Percentiles stepped through by the value threshold filter
+static const double VALUE_FILTER_PERCENTILES[] = { 0.5, 0.75, 0.9, 0.99 };
+static const int VALUE_FILTER_STEPS = 4;
+
+// Advance a single-code mask: any -> code 0 -> code 1 -> ... -> any
+static uint32_t nextCodeMask(uint32_t mask, size_t codeCount) {
+  size_t usable = std::min<size_t>(codeCount, 32);
+  if (mask == 0) return usable > 0 ? 1u : 0u;
+  uint64_t next = static_cast<uint64_t>(mask) << 1;
+  return next < (uint64_t(1) << usable) ? static_cast<uint32_t>(next) : 0u;
+}
+
+// Name of the single code selected by a mask
+static std::string codeMaskName(uint32_t mask, const std::vector<std::string>& names) {
+  if (mask == 0) return "any";
+  for (size_t i = 0; i < names.size() && i < 32; ++i) {
+    if (mask & (1u << i)) return names[i].empty() ? "(none)" : names[i];
+  }
+  return "?";
+}
 
 void InputHandler::initialize() {
   s_leftMousePressed = false;
@@ -20,9 +57,15 @@ void InputHandler::initialize() {
   s_lastMouseX = 0.0;
   s_lastMouseY = 0.0;
   s_firstMouseMove = true;
+  s_selecting = false;
+  s_lassoSelection = false;
+  s_selectionPath.clear();
 }
 
 void InputHandler::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+  // Keys typed into an ImGui text field are not viewer shortcuts
+  if (ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureKeyboard) return;
+
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
     glfwSetWindowShouldClose(window, GLFW_TRUE);
 
@@ -88,6 +131,52 @@ void InputHandler::keyCallback(GLFWwindow* window, int key, int scancode, int ac
     }
   }
 
+  // Attribute filters - resolved through the bitmap index, only index buffers are re-uploaded
+  if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+    g_scanFilter.peaksOnly = !g_scanFilter.peaksOnly;
+    std::cout << "Peaks only: " << (g_scanFilter.peaksOnly ? "on" : "off") << std::endl;
+    applyScanFilter();
+  }
+  if (key == GLFW_KEY_A && action == GLFW_PRESS) {
+    g_scanFilter.axisMask = nextCodeMask(g_scanFilter.axisMask, VerticesLoader::getAxisNames().size());
+    std::cout << "Axis filter: " << codeMaskName(g_scanFilter.axisMask, VerticesLoader::getAxisNames()) << std::endl;
+    applyScanFilter();
+  }
+  if (key == GLFW_KEY_D && action == GLFW_PRESS) {
+    g_scanFilter.directionMask = nextCodeMask(g_scanFilter.directionMask, VerticesLoader::getDirectionNames().size());
+    std::cout << "Direction filter: " << codeMaskName(g_scanFilter.directionMask, VerticesLoader::getDirectionNames()) << std::endl;
+    applyScanFilter();
+  }
+  if (key == GLFW_KEY_V && action == GLFW_PRESS) {
+    s_valueFilterStep = (s_valueFilterStep + 1) % (VALUE_FILTER_STEPS + 1);
+    g_scanFilter.useMinValue = s_valueFilterStep > 0;
+    if (g_scanFilter.useMinValue) {
+      double fraction = VALUE_FILTER_PERCENTILES[s_valueFilterStep - 1];
+      g_scanFilter.minValue = VerticesLoader::getValueStatistics().getPercentile(fraction);
+      std::cout << "Value filter: >= P" << fraction * 100.0 << " (" << g_scanFilter.minValue << ")" << std::endl;
+    }
+    else {
+      std::cout << "Value filter: off" << std::endl;
+    }
+    applyScanFilter();
+  }
+  if (key == GLFW_KEY_C && action == GLFW_PRESS) {
+    g_scanFilter = ScanFilter();
+    s_valueFilterStep = 0;
+    std::cout << "Filters cleared" << std::endl;
+    applyScanFilter();
+  }
+
+  // Clear the region selection with X
+  if (key == GLFW_KEY_X && action == GLFW_PRESS) {
+    clearRegionSelection();
+  }
+
+  // Run console micro-benchmarks with F8
+  if (key == GLFW_KEY_F8 && action == GLFW_PRESS) {
+    Benchmarks::runAll();
+  }
+
   // Cycle through scan files with Tab key
   if (key == GLFW_KEY_TAB && action == GLFW_PRESS) {
     std::cout << "Loading next scan file..." << std::endl;
@@ -118,6 +207,9 @@ void InputHandler::keyCallback(GLFWwindow* window, int key, int scancode, int ac
 }
 
 void InputHandler::scrollCallback(GLFWwindow* window, double xoffset, double yoffset) {
+  // Let ImGui windows scroll without zooming the scene
+  if (ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse) return;
+
   if (yoffset > 0) {
     camera.zoomIn(5.0f);
   }
@@ -127,6 +219,9 @@ void InputHandler::scrollCallback(GLFWwindow* window, double xoffset, double yof
 }
 
 void InputHandler::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+  // Clicks on ImGui windows are not meant for the scene (releases still go through)
+  if (action == GLFW_PRESS && ImGui::GetCurrentContext() && ImGui::GetIO().WantCaptureMouse) return;
+
   double xpos, ypos;
   glfwGetCursorPos(window, &xpos, &ypos);
 
@@ -149,11 +244,36 @@ void InputHandler::mouseButtonCallback(GLFWwindow* window, int button, int actio
       zoomToFit();
     }
   }
-  // Removed left mouse button handling since we're not using it for panning anymore
+  else if (button == GLFW_MOUSE_BUTTON_LEFT) {
+    // Left drag selects a box, Ctrl + left drag a lasso
+    if (action == GLFW_PRESS) {
+      s_leftMousePressed = true;
+      s_selecting = true;
+      s_lassoSelection = (mods & GLFW_MOD_CONTROL) != 0;
+      s_selectionPath.assign({ xpos, ypos });
+    }
+    else if (action == GLFW_RELEASE) {
+      s_leftMousePressed = false;
+      if (s_selecting) {
+        if (s_lassoSelection) {
+          s_selectionPath.push_back(xpos);
+          s_selectionPath.push_back(ypos);
+        }
+        else {
+          s_selectionPath.resize(2);
+          s_selectionPath.push_back(xpos);
+          s_selectionPath.push_back(ypos);
+        }
+        applyRegionSelection(window, s_selectionPath, s_lassoSelection);
+        s_selecting = false;
+        s_selectionPath.clear();
+      }
+    }
+  }
 }
 
 void InputHandler::cursorPositionCallback(GLFWwindow* window, double xpos, double ypos) {
-  // Handle mouse movement for rotation only
+  // Handle mouse movement for rotation
   if (!s_firstMouseMove) {
     double deltaX = xpos - s_lastMouseX;
     double deltaY = ypos - s_lastMouseY;
@@ -172,7 +292,23 @@ void InputHandler::cursorPositionCallback(GLFWwindow* window, double xpos, doubl
           std::cout << "Rotation active..." << std::endl;
         }
       }
-      // Left mouse no longer does anything - removed panning
+    }
+  }
+
+  // Extend the selection drag
+  if (s_selecting) {
+    if (s_lassoSelection) {
+      double dx = xpos - s_selectionPath[s_selectionPath.size() - 2];
+      double dy = ypos - s_selectionPath.back();
+      if (dx * dx + dy * dy >= LASSO_VERTEX_SPACING * LASSO_VERTEX_SPACING) {
+        s_selectionPath.push_back(xpos);
+        s_selectionPath.push_back(ypos);
+      }
+    }
+    else {
+      s_selectionPath.resize(2);
+      s_selectionPath.push_back(xpos);
+      s_selectionPath.push_back(ypos);
     }
   }
 
@@ -197,12 +333,21 @@ void InputHandler::printControlInstructions() {
   std::cout << "  - or Numpad-       : Zoom Out" << std::endl;
   std::cout << "  Arrow Keys         : Pan View (←↑↓→)" << std::endl;
   std::cout << "  Right Mouse Drag   : Rotate View" << std::endl;
+  std::cout << "  Hover Point        : Show Position/Value Tooltip" << std::endl;
+  std::cout << "  Left Mouse Drag    : Box Select" << std::endl;
+  std::cout << "  Ctrl+Left Drag     : Lasso Select" << std::endl;
   std::cout << "  Space              : Reset Pan to Center" << std::endl;
   std::cout << "  Ctrl+Space         : Reset Rotation" << std::endl;
   std::cout << "  Home               : Reset Rotation" << std::endl;
   std::cout << "  Tab                : Next Scan File" << std::endl;
   std::cout << "  Shift + Tab        : Previous Scan File" << std::endl;
   std::cout << "  R                  : Reload Scan Data" << std::endl;
+  std::cout << "  P                  : Toggle Peaks-only Filter" << std::endl;
+  std::cout << "  A / D              : Cycle Axis / Direction Filter" << std::endl;
+  std::cout << "  V                  : Cycle Value Threshold (P50/P75/P90/P99)" << std::endl;
+  std::cout << "  C                  : Clear Filters" << std::endl;
+  std::cout << "  X                  : Clear Selection" << std::endl;
+  std::cout << "  F8                 : Run Micro-benchmarks (console)" << std::endl;
   std::cout << "  ESC                : Exit" << std::endl;
 
   auto fileInfo = VerticesLoader::getCurrentFileInfo();
@@ -212,27 +357,16 @@ void InputHandler::printControlInstructions() {
 }
 
 void InputHandler::zoomToFit() {
-  // Get the vertices to calculate bounding box
-  std::vector<float> scanVertices = VerticesLoader::generateScanVertices();
-
-  if (scanVertices.empty()) {
+  if (VerticesLoader::getPositionData().empty()) {
     std::cout << "No vertices to fit" << std::endl;
     return;
   }
 
-  // Calculate bounding box
-  float minX = scanVertices[0], maxX = scanVertices[0];
-  float minY = scanVertices[1], maxY = scanVertices[1];
-  float minZ = scanVertices[2], maxZ = scanVertices[2];
-
-  for (size_t i = 0; i < scanVertices.size(); i += 3) {
-    minX = std::min(minX, scanVertices[i]);
-    maxX = std::max(maxX, scanVertices[i]);
-    minY = std::min(minY, scanVertices[i + 1]);
-    maxY = std::max(maxY, scanVertices[i + 1]);
-    minZ = std::min(minZ, scanVertices[i + 2]);
-    maxZ = std::max(maxZ, scanVertices[i + 2]);
-  }
+  // Bounding box is maintained by the loader while points are appended
+  BoundingBox box = VerticesLoader::getBoundingBox();
+  float minX = box.minX, maxX = box.maxX;
+  float minY = box.minY, maxY = box.maxY;
+  float minZ = box.minZ, maxZ = box.maxZ;
 
   // Calculate the size of the bounding box
   float sizeX = maxX - minX;
@@ -0,0 +1,324 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+struct JobState {
+  std::function<void()> work;
+  std::atomic<int> pendingDependencies{ 0 };
+  std::atomic<bool> done{ false };
+  std::mutex mutex;                       // Guards dependents and the done transition
+  std::vector<JobHandle> dependents;      // Jobs released when this one finishes
+};
+
+// One deque per worker plus one shared by threads outside the pool.
+// Counters live next to the deque so each thread mostly touches its own line.
+struct alignas(64) JobQueue {
+  std::mutex mutex;
+  std::deque<JobHandle> jobs;
+  std::atomic<uint64_t> tasksExecuted{ 0 };
+  std::atomic<uint64_t> steals{ 0 };
+  std::atomic<uint64_t> idleMicroseconds{ 0 };
+};
+
+class Scheduler {
+public:
+  ~Scheduler() { stop(); }
+
+  void start(unsigned int workerCount) {
+    stop();
+    queues.clear();
+    for (unsigned int q = 0; q <= workerCount; ++q) queues.push_back(std::make_unique<JobQueue>());
+    externalQueue = workerCount;
+    stopping = false;
+    for (unsigned int w = 0; w < workerCount; ++w) {
+      workers.emplace_back([this, w]() { workerLoop(w); });
+    }
+    started = true;
+  }
+
+  void stop() {
+    if (!started) return;
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stopping = true;
+    }
+    sleepCondition.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+    for (auto& queue : queues) queue->jobs.clear();
+    queuedJobs = 0;
+    started = false;
+  }
+
+  void ensureStarted() {
+    std::call_once(defaultStart, [this]() {
+      if (!started) start(defaultWorkerCount());
+    });
+  }
+
+  // At least one worker, so jobs nobody waits on still run on a single core
+  static unsigned int defaultWorkerCount() {
+    return std::max(2u, std::thread::hardware_concurrency()) - 1;
+  }
+
+  unsigned int threadCount() const { return static_cast<unsigned int>(workers.size()) + 1; }
+
+  void push(const JobHandle& job) {
+    JobQueue& queue = *queues[ownQueue()];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(job);
+    }
+    queuedJobs++;
+    // Taking the lock orders the increment before a sleeper's predicate check
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    sleepCondition.notify_one();
+  }
+
+  // Run one queued job if any thread has one; false when every deque is empty
+  bool runOne() {
+    JobHandle job = takeJob();
+    if (!job) return false;
+    execute(job);
+    return true;
+  }
+
+  void waitFor(const JobHandle& job) {
+    // Threads outside the pool (the render loop, loader threads) only run the job
+    // they wait for, never unrelated queued work that could hold them up for long
+    bool worker = workerIndex >= 0;
+    while (!job->done.load(std::memory_order_acquire)) {
+      if (worker ? runOne() : runQueued(job)) continue;
+      // The job is running elsewhere: sleep briefly until something finishes or is queued
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      finishedCondition.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+        return job->done.load(std::memory_order_acquire) || (worker && queuedJobs > 0);
+      });
+    }
+  }
+
+  void release(const JobHandle& job) {
+    if (--job->pendingDependencies == 0) push(job);
+  }
+
+  JobCounters counters() const {
+    JobCounters total;
+    total.threadCount = threadCount();
+    for (const auto& queue : queues) {
+      total.tasksExecuted += queue->tasksExecuted;
+      total.steals += queue->steals;
+      total.idleMilliseconds += queue->idleMicroseconds / 1000.0;
+    }
+    return total;
+  }
+
+  void resetCounters() {
+    resetTime = std::chrono::steady_clock::now().time_since_epoch().count();
+    for (auto& queue : queues) {
+      queue->tasksExecuted = 0;
+      queue->steals = 0;
+      queue->idleMicroseconds = 0;
+    }
+  }
+
+private:
+  std::vector<std::unique_ptr<JobQueue>> queues;
+  std::vector<std::thread> workers;
+  size_t externalQueue = 0;
+  std::atomic<int> queuedJobs{ 0 };
+  std::atomic<std::chrono::steady_clock::rep> resetTime{ 0 };
+  std::mutex sleepMutex;
+  std::condition_variable sleepCondition;
+  std::condition_variable finishedCondition;
+  bool stopping = false;
+  bool started = false;
+  std::once_flag defaultStart;
+
+  static thread_local int workerIndex;
+
+  size_t ownQueue() const {
+    return workerIndex >= 0 ? static_cast<size_t>(workerIndex) : externalQueue;
+  }
+
+  // Take job out of the shared external deque and run it; false if it is not queued there
+  bool runQueued(const JobHandle& job) {
+    {
+      JobQueue& queue = *queues[externalQueue];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      auto it = std::find(queue.jobs.rbegin(), queue.jobs.rend(), job);
+      if (it == queue.jobs.rend()) return false;
+      queue.jobs.erase(std::next(it).base());
+      queuedJobs--;
+    }
+    execute(job);
+    return true;
+  }
+
+  // Own deque from the back, then the other deques from the front
+  JobHandle takeJob() {
+    if (queuedJobs.load() <= 0) return nullptr;
+
+    size_t own = ownQueue();
+    {
+      JobQueue& queue = *queues[own];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.jobs.empty()) {
+        JobHandle job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        queuedJobs--;
+        return job;
+      }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+      JobQueue& victim = *queues[(own + offset) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.jobs.empty()) continue;
+      JobHandle job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      queuedJobs--;
+      queues[own]->steals++;
+      return job;
+    }
+    return nullptr;
+  }
+
+  void execute(const JobHandle& job) {
+    try {
+      job->work();
+    }
+    catch (const std::exception& e) {
+      std::cerr << "Job failed: " << e.what() << std::endl;
+    }
+    job->work = nullptr;
+    queues[ownQueue()]->tasksExecuted++;
+
+    std::vector<JobHandle> released;
+    {
+      std::lock_guard<std::mutex> lock(job->mutex);
+      job->done.store(true, std::memory_order_release);
+      released.swap(job->dependents);
+    }
+    for (const JobHandle& dependent : released) release(dependent);
+
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    finishedCondition.notify_all();
+  }
+
+  void workerLoop(unsigned int index) {
+    workerIndex = static_cast<int>(index);
+    while (true) {
+      if (runOne()) continue;
+
+      auto idleStart = std::chrono::steady_clock::now();
+      std::unique_lock<std::mutex> lock(sleepMutex);
+      sleepCondition.wait(lock, [this]() { return stopping || queuedJobs > 0; });
+      bool exit = stopping;
+      lock.unlock();
+
+      // Only the part of the sleep after the last counter reset is reported
+      std::chrono::steady_clock::time_point since(std::chrono::steady_clock::duration(resetTime.load()));
+      idleStart = std::max(idleStart, since);
+      queues[index]->idleMicroseconds += static_cast<uint64_t>(
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - idleStart).count());
+      if (exit) break;
+    }
+    workerIndex = -1;
+  }
+};
+
+thread_local int Scheduler::workerIndex = -1;
+
+static Scheduler& getScheduler() {
+  static Scheduler scheduler;
+  scheduler.ensureStarted();
+  return scheduler;
+}
+
+void JobSystem::initialize(unsigned int threadCount) {
+  Scheduler& scheduler = getScheduler();
+  unsigned int workerCount = threadCount > 0 ? threadCount - 1 : Scheduler::defaultWorkerCount();
+  if (scheduler.threadCount() != workerCount + 1) scheduler.start(workerCount);
+}
+
+void JobSystem::shutdown() {
+  getScheduler().stop();
+}
+
+unsigned int JobSystem::getThreadCount() {
+  return getScheduler().threadCount();
+}
+
+JobHandle JobSystem::submit(std::function<void()> job, const std::vector<JobHandle>& dependencies) {
+  Scheduler& scheduler = getScheduler();
+  JobHandle state = std::make_shared<JobState>();
+  state->work = std::move(job);
+
+  // One extra count held while dependencies are registered, so a dependency
+  // finishing mid-loop cannot queue the job early
+  state->pendingDependencies = static_cast<int>(dependencies.size()) + 1;
+  for (const JobHandle& dependency : dependencies) {
+    bool finished = true;
+    if (dependency) {
+      std::lock_guard<std::mutex> lock(dependency->mutex);
+      finished = dependency->done.load(std::memory_order_acquire);
+      if (!finished) dependency->dependents.push_back(state);
+    }
+    if (finished) state->pendingDependencies--;
+  }
+  scheduler.release(state);
+  return state;
+}
+
+void JobSystem::wait(const JobHandle& job) {
+  if (job) getScheduler().waitFor(job);
+}
+
+void JobSystem::waitAll(const std::vector<JobHandle>& jobs) {
+  for (const JobHandle& job : jobs) wait(job);
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grainSize,
+  const std::function<void(size_t, size_t)>& body) {
+  if (end <= begin) return;
+  size_t count = end - begin;
+  grainSize = std::max<size_t>(grainSize, 1);
+
+  // A few chunks per thread leave room for stealing when chunks run unevenly
+  unsigned int threads = getThreadCount();
+  size_t chunkSize = std::max(grainSize, (count + threads * 4 - 1) / (threads * 4));
+  if (threads == 1 || count <= chunkSize) {
+    body(begin, end);
+    return;
+  }
+
+  std::vector<JobHandle> chunks;
+  for (size_t chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+    size_t chunkEnd = std::min(end, chunkBegin + chunkSize);
+    chunks.push_back(submit([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }));
+  }
+  // The caller takes the first chunk itself, then helps with the rest.
+  // The chunks reference body, so they must finish before an exception leaves this frame.
+  try {
+    body(begin, std::min(end, begin + chunkSize));
+  }
+  catch (...) {
+    waitAll(chunks);
+    throw;
+  }
+  waitAll(chunks);
+}
+
+JobCounters JobSystem::getCounters() {
+  return getScheduler().counters();
+}
+
+void JobSystem::resetCounters() {
+  getScheduler().resetCounters();
+}
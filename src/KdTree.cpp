@@ -0,0 +1,312 @@
+#include "KdTree.h"
+#include "SimdReductions.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Point plus original index, the unit that nth_element shuffles during the build
+struct KdBuildPoint {
+  float p[3];
+  uint32_t index;
+};
+
+// Subtrees smaller than this are never handed to the job system
+static const size_t PARALLEL_BUILD_THRESHOLD = 65536;
+
+static float distanceSquared(const float* a, const float* b) {
+  float dx = a[0] - b[0];
+  float dy = a[1] - b[1];
+  float dz = a[2] - b[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+static bool neighborLess(const KdNeighbor& a, const KdNeighbor& b) {
+  return a.distanceSquared < b.distanceSquared;
+}
+
+// Partition [begin, end) around its median along the widest axis of its cell
+static void buildRange(KdBuildPoint* pts, size_t begin, size_t end, const float cellMin[3], const float cellMax[3],
+  uint8_t* splitAxis, int parallelDepth) {
+  if (end - begin <= KdTree::LEAF_SIZE) return;
+
+  int axis = 0;
+  float widest = cellMax[0] - cellMin[0];
+  for (int a = 1; a < 3; ++a) {
+    if (cellMax[a] - cellMin[a] > widest) {
+      widest = cellMax[a] - cellMin[a];
+      axis = a;
+    }
+  }
+
+  size_t mid = (begin + end) / 2;
+  std::nth_element(pts + begin, pts + mid, pts + end, [axis](const KdBuildPoint& a, const KdBuildPoint& b) {
+    return a.p[axis] < b.p[axis];
+  });
+  splitAxis[mid] = static_cast<uint8_t>(axis);
+
+  float split = pts[mid].p[axis];
+  float leftMax[3] = { cellMax[0], cellMax[1], cellMax[2] };
+  float rightMin[3] = { cellMin[0], cellMin[1], cellMin[2] };
+  leftMax[axis] = split;
+  rightMin[axis] = split;
+
+  if (parallelDepth > 0 && end - begin >= PARALLEL_BUILD_THRESHOLD) {
+    JobHandle left = JobSystem::submit([=]() { buildRange(pts, begin, mid, cellMin, leftMax, splitAxis, parallelDepth - 1); });
+    buildRange(pts, mid + 1, end, rightMin, cellMax, splitAxis, parallelDepth - 1);
+    JobSystem::wait(left);
+  }
+  else {
+    buildRange(pts, begin, mid, cellMin, leftMax, splitAxis, 0);
+    buildRange(pts, mid + 1, end, rightMin, cellMax, splitAxis, 0);
+  }
+}
+
+void KdTree::build(const float* xyz, size_t pointCount) {
+  clear();
+  if (xyz == nullptr || pointCount == 0) return;
+
+  std::vector<KdBuildPoint> pts(pointCount);
+  JobSystem::parallelFor(0, pointCount, PARALLEL_BUILD_THRESHOLD, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      pts[i] = { { xyz[i * 3], xyz[i * 3 + 1], xyz[i * 3 + 2] }, static_cast<uint32_t>(i) };
+    }
+  });
+
+  float cellMin[3], cellMax[3];
+  SimdReductions::reducePositions(xyz, pointCount, cellMin, cellMax);
+
+  // Two subtrees per scheduler thread so stolen halves can even out
+  int parallelDepth = 0;
+  unsigned int threads = JobSystem::getThreadCount();
+  if (threads > 1) {
+    while ((1u << parallelDepth) < threads * 2) parallelDepth++;
+  }
+
+  for (int c = 0; c < 3; ++c) {
+    boundsMin[c] = cellMin[c];
+    boundsMax[c] = cellMax[c];
+  }
+
+  splitAxis.assign(pointCount, 0);
+  buildRange(pts.data(), 0, pointCount, cellMin, cellMax, splitAxis.data(), parallelDepth);
+
+  points.resize(pointCount * 3);
+  indices.resize(pointCount);
+  JobSystem::parallelFor(0, pointCount, PARALLEL_BUILD_THRESHOLD, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      points[i * 3] = pts[i].p[0];
+      points[i * 3 + 1] = pts[i].p[1];
+      points[i * 3 + 2] = pts[i].p[2];
+      indices[i] = pts[i].index;
+    }
+  });
+}
+
+void KdTree::clear() {
+  points.clear();
+  indices.clear();
+  splitAxis.clear();
+}
+
+void KdTree::findNearest(const float query[3], size_t k, std::vector<KdNeighbor>& out) const {
+  out.clear();
+  if (k == 0 || empty()) return;
+  out.reserve(k);
+  nearestRecursive(0, size(), query, k, out);
+  std::sort_heap(out.begin(), out.end(), neighborLess);
+}
+
+bool KdTree::findNearest(const float query[3], KdNeighbor& out) const {
+  std::vector<KdNeighbor> result;
+  findNearest(query, 1, result);
+  if (result.empty()) return false;
+  out = result[0];
+  return true;
+}
+
+void KdTree::nearestRecursive(size_t begin, size_t end, const float query[3], size_t k, std::vector<KdNeighbor>& heap) const {
+  // heap is a max-heap on distance holding the best k candidates so far
+  auto consider = [&](size_t slot) {
+    float d = distanceSquared(&points[slot * 3], query);
+    if (heap.size() < k) {
+      heap.push_back({ indices[slot], d });
+      std::push_heap(heap.begin(), heap.end(), neighborLess);
+    }
+    else if (d < heap.front().distanceSquared) {
+      std::pop_heap(heap.begin(), heap.end(), neighborLess);
+      heap.back() = { indices[slot], d };
+      std::push_heap(heap.begin(), heap.end(), neighborLess);
+    }
+  };
+
+  if (end - begin <= LEAF_SIZE) {
+    for (size_t slot = begin; slot < end; ++slot) consider(slot);
+    return;
+  }
+
+  size_t mid = (begin + end) / 2;
+  int axis = splitAxis[mid];
+  float diff = query[axis] - points[mid * 3 + axis];
+
+  consider(mid);
+
+  // Near side first, far side only if the splitting plane is closer than the worst candidate
+  if (diff < 0.0f) {
+    nearestRecursive(begin, mid, query, k, heap);
+    if (heap.size() < k || diff * diff < heap.front().distanceSquared) {
+      nearestRecursive(mid + 1, end, query, k, heap);
+    }
+  }
+  else {
+    nearestRecursive(mid + 1, end, query, k, heap);
+    if (heap.size() < k || diff * diff < heap.front().distanceSquared) {
+      nearestRecursive(begin, mid, query, k, heap);
+    }
+  }
+}
+
+void KdTree::findInRadius(const float query[3], float radius, std::vector<uint32_t>& out) const {
+  out.clear();
+  if (empty() || radius < 0.0f) return;
+  radiusRecursive(0, size(), query, radius * radius, out);
+}
+
+void KdTree::radiusRecursive(size_t begin, size_t end, const float query[3], float radiusSquared, std::vector<uint32_t>& out) const {
+  if (end - begin <= LEAF_SIZE) {
+    for (size_t slot = begin; slot < end; ++slot) {
+      if (distanceSquared(&points[slot * 3], query) <= radiusSquared) out.push_back(indices[slot]);
+    }
+    return;
+  }
+
+  size_t mid = (begin + end) / 2;
+  int axis = splitAxis[mid];
+  float diff = query[axis] - points[mid * 3 + axis];
+
+  if (distanceSquared(&points[mid * 3], query) <= radiusSquared) out.push_back(indices[mid]);
+
+  if (diff <= 0.0f || diff * diff <= radiusSquared) radiusRecursive(begin, mid, query, radiusSquared, out);
+  if (diff >= 0.0f || diff * diff <= radiusSquared) radiusRecursive(mid + 1, end, query, radiusSquared, out);
+}
+
+// State of a nearest-to-ray search
+struct KdTree::RayQuery {
+  const float* origin;
+  const float* direction;
+  const PointBitset* visible;
+  float bestDistanceSquared;
+  uint32_t bestIndex;
+  bool found;
+  size_t visitsLeft;
+};
+
+// Whether the infinite line hits the box grown by margin on every side (slab test)
+static bool lineHitsBox(const float origin[3], const float direction[3], const float boxMin[3], const float boxMax[3], float margin) {
+  float tNear = -std::numeric_limits<float>::max();
+  float tFar = std::numeric_limits<float>::max();
+  for (int c = 0; c < 3; ++c) {
+    float lo = boxMin[c] - margin;
+    float hi = boxMax[c] + margin;
+    if (std::fabs(direction[c]) < 1e-12f) {
+      if (origin[c] < lo || origin[c] > hi) return false;
+      continue;
+    }
+    float t0 = (lo - origin[c]) / direction[c];
+    float t1 = (hi - origin[c]) / direction[c];
+    if (t0 > t1) std::swap(t0, t1);
+    tNear = std::max(tNear, t0);
+    tFar = std::min(tFar, t1);
+    if (tNear > tFar) return false;
+  }
+  return true;
+}
+
+bool KdTree::findNearestToRay(const float origin[3], const float direction[3], float maxDistance,
+  KdNeighbor& out, const PointBitset* visible, size_t visitBudget) const {
+  if (empty() || maxDistance < 0.0f) return false;
+
+  RayQuery query = { origin, direction, visible, maxDistance * maxDistance, 0, false,
+    visitBudget > 0 ? visitBudget : std::numeric_limits<size_t>::max() };
+  rayRecursive(0, size(), boundsMin, boundsMax, query);
+
+  if (!query.found) return false;
+  out = { query.bestIndex, query.bestDistanceSquared };
+  return true;
+}
+
+void KdTree::rayRecursive(size_t begin, size_t end, const float cellMin[3], const float cellMax[3], RayQuery& query) const {
+  if (query.visitsLeft == 0) return;
+  query.visitsLeft--;
+
+  // Skip cells the line cannot get closer to than the current best
+  if (!lineHitsBox(query.origin, query.direction, cellMin, cellMax, std::sqrt(query.bestDistanceSquared))) return;
+
+  auto consider = [&](size_t slot) {
+    uint32_t index = indices[slot];
+    if (query.visible != nullptr && !query.visible->test(index)) return;
+    const float* p = &points[slot * 3];
+    float v[3] = { p[0] - query.origin[0], p[1] - query.origin[1], p[2] - query.origin[2] };
+    // |v x direction|^2 rather than |v|^2 - t^2, which cancels badly far from the origin
+    const float* d = query.direction;
+    float cx = v[1] * d[2] - v[2] * d[1];
+    float cy = v[2] * d[0] - v[0] * d[2];
+    float cz = v[0] * d[1] - v[1] * d[0];
+    float perpendicular = cx * cx + cy * cy + cz * cz;
+    if (perpendicular <= query.bestDistanceSquared) {
+      query.bestDistanceSquared = perpendicular;
+      query.bestIndex = index;
+      query.found = true;
+    }
+  };
+
+  if (end - begin <= LEAF_SIZE) {
+    for (size_t slot = begin; slot < end; ++slot) consider(slot);
+    return;
+  }
+
+  size_t mid = (begin + end) / 2;
+  int axis = splitAxis[mid];
+  float split = points[mid * 3 + axis];
+  consider(mid);
+
+  float leftMax[3] = { cellMax[0], cellMax[1], cellMax[2] };
+  float rightMin[3] = { cellMin[0], cellMin[1], cellMin[2] };
+  leftMax[axis] = split;
+  rightMin[axis] = split;
+
+  rayRecursive(begin, mid, cellMin, leftMax, query);
+  rayRecursive(mid + 1, end, rightMin, cellMax, query);
+}
+
+void KdTree::findInBox(const float minCorner[3], const float maxCorner[3], std::vector<uint32_t>& out) const {
+  out.clear();
+  if (empty()) return;
+  boxRecursive(0, size(), minCorner, maxCorner, out);
+}
+
+void KdTree::boxRecursive(size_t begin, size_t end, const float minCorner[3], const float maxCorner[3], std::vector<uint32_t>& out) const {
+  auto inside = [&](size_t slot) {
+    const float* p = &points[slot * 3];
+    return p[0] >= minCorner[0] && p[0] <= maxCorner[0] &&
+      p[1] >= minCorner[1] && p[1] <= maxCorner[1] &&
+      p[2] >= minCorner[2] && p[2] <= maxCorner[2];
+  };
+
+  if (end - begin <= LEAF_SIZE) {
+    for (size_t slot = begin; slot < end; ++slot) {
+      if (inside(slot)) out.push_back(indices[slot]);
+    }
+    return;
+  }
+
+  size_t mid = (begin + end) / 2;
+  int axis = splitAxis[mid];
+  float split = points[mid * 3 + axis];
+
+  if (inside(mid)) out.push_back(indices[mid]);
+
+  // Left holds values <= split, right holds values >= split
+  if (minCorner[axis] <= split) boxRecursive(begin, mid, minCorner, maxCorner, out);
+  if (maxCorner[axis] >= split) boxRecursive(mid + 1, end, minCorner, maxCorner, out);
+}
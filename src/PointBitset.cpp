@@ -0,0 +1,107 @@
+#include "PointBitset.h"
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+PointBitset::PointBitset(size_t bitCount, bool value) {
+  assign(bitCount, value);
+}
+
+void PointBitset::assign(size_t newBitCount, bool value) {
+  bitCount = newBitCount;
+  words.assign((bitCount + 63) / 64, value ? ~uint64_t(0) : 0);
+  clearTail();
+}
+
+void PointBitset::setAll() {
+  std::fill(words.begin(), words.end(), ~uint64_t(0));
+  clearTail();
+}
+
+void PointBitset::clearAll() {
+  std::fill(words.begin(), words.end(), 0);
+}
+
+void PointBitset::andWith(const PointBitset& other) {
+  for (size_t w = 0; w < words.size(); ++w) words[w] &= other.words[w];
+}
+
+void PointBitset::orWith(const PointBitset& other) {
+  for (size_t w = 0; w < words.size(); ++w) words[w] |= other.words[w];
+}
+
+void PointBitset::andNotWith(const PointBitset& other) {
+  for (size_t w = 0; w < words.size(); ++w) words[w] &= ~other.words[w];
+}
+
+size_t PointBitset::count() const {
+  size_t total = 0;
+  for (uint64_t word : words) total += popCount(word);
+  return total;
+}
+
+size_t PointBitset::countAnd(const PointBitset& other) const {
+  size_t total = 0;
+  for (size_t w = 0; w < words.size(); ++w) total += popCount(words[w] & other.words[w]);
+  return total;
+}
+
+void PointBitset::appendSetBits(std::vector<unsigned int>& out) const {
+  out.reserve(out.size() + count());
+  for (size_t w = 0; w < words.size(); ++w) {
+    uint64_t word = words[w];
+    while (word) {
+      out.push_back(static_cast<unsigned int>(w * 64 + countTrailingZeros(word)));
+      word &= word - 1;
+    }
+  }
+}
+
+void PointBitset::appendAdjacentPairs(std::vector<unsigned int>& out) const {
+  for (size_t w = 0; w < words.size(); ++w) {
+    // Bit i of "next" is bit i + 1 of the set, carrying in from the following word
+    uint64_t next = words[w] >> 1;
+    if (w + 1 < words.size()) next |= words[w + 1] << 63;
+    uint64_t word = words[w] & next;
+    while (word) {
+      unsigned int i = static_cast<unsigned int>(w * 64 + countTrailingZeros(word));
+      out.push_back(i);
+      out.push_back(i + 1);
+      word &= word - 1;
+    }
+  }
+}
+
+int PointBitset::popCount(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<int>(__popcnt64(word));
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(word);
+#else
+  int bits = 0;
+  while (word) { word &= word - 1; bits++; }
+  return bits;
+#endif
+}
+
+int PointBitset::countTrailingZeros(uint64_t word) {
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  int bits = 0;
+  while (!(word & 1)) { word >>= 1; bits++; }
+  return bits;
+#endif
+}
+
+void PointBitset::clearTail() {
+  if (bitCount % 64 != 0 && !words.empty()) {
+    words.back() &= (uint64_t(1) << (bitCount % 64)) - 1;
+  }
+}
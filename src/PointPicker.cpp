@@ -0,0 +1,86 @@
+#include "PointPicker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Mat4 PointPicker::multiply(const Mat4& a, const Mat4& b) {
+  Mat4 result = { 0 };
+  for (int col = 0; col < 4; col++) {
+    for (int row = 0; row < 4; row++) {
+      float sum = 0.0f;
+      for (int k = 0; k < 4; k++) {
+        sum += a[k * 4 + row] * b[col * 4 + k];
+      }
+      result[col * 4 + row] = sum;
+    }
+  }
+  return result;
+}
+
+void PointPicker::unproject(const Mat4& inverseViewProjection, double cursorX, double cursorY,
+  int windowWidth, int windowHeight, float ndcZ, float out[3]) {
+  float ndc[3] = { 0.0f, 0.0f, ndcZ };
+  windowToNdc(cursorX, cursorY, windowWidth, windowHeight, ndc);
+  CameraController::transformPoint(inverseViewProjection, ndc, out);
+}
+
+void PointPicker::windowToNdc(double cursorX, double cursorY, int windowWidth, int windowHeight, float ndcOut[2]) {
+  ndcOut[0] = static_cast<float>(2.0 * cursorX / std::max(1, windowWidth) - 1.0);
+  ndcOut[1] = static_cast<float>(1.0 - 2.0 * cursorY / std::max(1, windowHeight));
+}
+
+PickRay PointPicker::screenToRay(double cursorX, double cursorY, int windowWidth, int windowHeight,
+  const Mat4& view, const Mat4& projection) {
+  Mat4 inverseViewProjection = CameraController::inverse(multiply(projection, view));
+
+  float nearPoint[3], farPoint[3];
+  unproject(inverseViewProjection, cursorX, cursorY, windowWidth, windowHeight, -1.0f, nearPoint);
+  unproject(inverseViewProjection, cursorX, cursorY, windowWidth, windowHeight, 1.0f, farPoint);
+
+  PickRay ray;
+  float length = 0.0f;
+  for (int c = 0; c < 3; ++c) {
+    ray.origin[c] = nearPoint[c];
+    ray.direction[c] = farPoint[c] - nearPoint[c];
+    length += ray.direction[c] * ray.direction[c];
+  }
+  length = std::sqrt(length);
+  for (int c = 0; c < 3; ++c) {
+    ray.direction[c] = length > 0.0f ? ray.direction[c] / length : (c == 2 ? -1.0f : 0.0f);
+  }
+  return ray;
+}
+
+float PointPicker::pixelsToWorld(double cursorX, double cursorY, int windowWidth, int windowHeight,
+  const Mat4& view, const Mat4& projection, float pixelRadius) {
+  Mat4 inverseViewProjection = CameraController::inverse(multiply(projection, view));
+
+  float center[3], offset[3];
+  unproject(inverseViewProjection, cursorX, cursorY, windowWidth, windowHeight, -1.0f, center);
+  unproject(inverseViewProjection, cursorX + pixelRadius, cursorY, windowWidth, windowHeight, -1.0f, offset);
+
+  float dx = offset[0] - center[0];
+  float dy = offset[1] - center[1];
+  float dz = offset[2] - center[2];
+  return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+PickResult PointPicker::pick(const KdTree& tree, double cursorX, double cursorY, int windowWidth, int windowHeight,
+  const Mat4& view, const Mat4& projection, float pixelRadius,
+  const PointBitset* visible, size_t visitBudget) {
+  auto start = std::chrono::steady_clock::now();
+
+  PickResult result;
+  PickRay ray = screenToRay(cursorX, cursorY, windowWidth, windowHeight, view, projection);
+  float worldRadius = pixelsToWorld(cursorX, cursorY, windowWidth, windowHeight, view, projection, pixelRadius);
+
+  KdNeighbor nearest;
+  if (tree.findNearestToRay(ray.origin, ray.direction, worldRadius, nearest, visible, visitBudget)) {
+    result.hit = true;
+    result.index = nearest.index;
+    result.distance = std::sqrt(nearest.distanceSquared);
+  }
+
+  result.elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  return result;
+}
@@ -0,0 +1,108 @@
+#include "RegionSelection.h"
+#include "SimdReductions.h"
+#include "JobSystem.h"
+#include <algorithm>
+
+// Chunks smaller than this many words (64 points each) are not worth a job
+static const size_t MIN_WORDS_PER_JOB = 1024;
+
+// Project every point and set its bit when inside(ndcX, ndcY) holds.
+// Work is split on word boundaries so jobs never share a word.
+template <typename Inside>
+static void selectParallel(const float* xyz, size_t pointCount, const Mat4& m, const PointBitset* visible,
+  PointBitset& out, Inside inside) {
+  out.assign(pointCount);
+  if (xyz == nullptr || pointCount == 0) return;
+
+  std::vector<uint64_t>& words = out.getWords();
+  size_t wordCount = words.size();
+
+  auto projectWords = [&](size_t firstWord, size_t lastWord) {
+    for (size_t w = firstWord; w < lastWord; ++w) {
+      size_t begin = w * 64;
+      size_t end = std::min(pointCount, begin + 64);
+      uint64_t word = 0;
+      for (size_t i = begin; i < end; ++i) {
+        const float* p = xyz + i * 3;
+        float clipW = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+        if (clipW <= 0.0f) continue; // Behind the camera
+        float ndcX = (m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12]) / clipW;
+        float ndcY = (m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13]) / clipW;
+        if (inside(ndcX, ndcY)) word |= uint64_t(1) << (i - begin);
+      }
+      if (visible != nullptr) word &= visible->getWords()[w];
+      words[w] = word;
+    }
+  };
+
+  JobSystem::parallelFor(0, wordCount, MIN_WORDS_PER_JOB, projectWords);
+}
+
+void RegionSelection::selectRectangle(const float* xyz, size_t pointCount, const Mat4& viewProjection,
+  const float cornerA[2], const float cornerB[2], const PointBitset* visible, PointBitset& out) {
+  float minX = std::min(cornerA[0], cornerB[0]);
+  float maxX = std::max(cornerA[0], cornerB[0]);
+  float minY = std::min(cornerA[1], cornerB[1]);
+  float maxY = std::max(cornerA[1], cornerB[1]);
+
+  selectParallel(xyz, pointCount, viewProjection, visible, out, [=](float x, float y) {
+    return x >= minX && x <= maxX && y >= minY && y <= maxY;
+  });
+}
+
+void RegionSelection::selectLasso(const float* xyz, size_t pointCount, const Mat4& viewProjection,
+  const std::vector<float>& polygon, const PointBitset* visible, PointBitset& out) {
+  if (polygon.size() < 6) {
+    out.assign(pointCount);
+    return;
+  }
+
+  // Bounding rectangle rejects most points before the polygon test
+  float minX = polygon[0], maxX = polygon[0], minY = polygon[1], maxY = polygon[1];
+  for (size_t v = 2; v + 1 < polygon.size(); v += 2) {
+    minX = std::min(minX, polygon[v]);
+    maxX = std::max(maxX, polygon[v]);
+    minY = std::min(minY, polygon[v + 1]);
+    maxY = std::max(maxY, polygon[v + 1]);
+  }
+
+  selectParallel(xyz, pointCount, viewProjection, visible, out, [&](float x, float y) {
+    return x >= minX && x <= maxX && y >= minY && y <= maxY && pointInPolygon(x, y, polygon);
+  });
+}
+
+bool RegionSelection::pointInPolygon(float x, float y, const std::vector<float>& polygon) {
+  size_t vertexCount = polygon.size() / 2;
+  bool inside = false;
+  for (size_t i = 0, j = vertexCount - 1; i < vertexCount; j = i++) {
+    float xi = polygon[i * 2], yi = polygon[i * 2 + 1];
+    float xj = polygon[j * 2], yj = polygon[j * 2 + 1];
+    if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+SelectionStatistics RegionSelection::computeStatistics(const PointBitset& selection, const std::vector<float>& xyz,
+  const std::vector<float>& values, const PointBitset& peakBits) {
+  SelectionStatistics stats;
+  if (selection.size() == 0 || selection.size() != values.size() || xyz.size() != values.size() * 3) return stats;
+
+  const uint64_t* words = selection.getWords().data();
+  ValueReduction reduction = SimdReductions::reduceSelectedValues(values.data(), words, values.size());
+  stats.count = reduction.count;
+  if (stats.count == 0) return stats;
+
+  stats.minValue = reduction.minValue;
+  stats.maxValue = reduction.maxValue;
+  stats.meanValue = reduction.sum / static_cast<double>(reduction.count);
+  stats.peakCount = peakBits.size() == selection.size() ? selection.countAnd(peakBits) : 0;
+
+  double sum[3];
+  SimdReductions::sumSelectedPositions(xyz.data(), words, values.size(), sum);
+  for (int c = 0; c < 3; ++c) {
+    stats.centroid[c] = static_cast<float>(sum[c] / static_cast<double>(stats.count));
+  }
+  return stats;
+}
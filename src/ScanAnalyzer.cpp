@@ -0,0 +1,250 @@
+#include "ScanAnalyzer.h"
+#include "ScanParser.h"
+#include "ScanStatistics.h"
+#include "JobSystem.h"
+#include "json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <thread>
+
+const double ScanAnalyzer::PERCENTILES[ScanAnalyzer::PERCENTILE_COUNT] = { 0.01, 0.05, 0.5, 0.95, 0.99 };
+
+bool ScanAnalyzer::analyzeContent(const std::string& content, float scaleFactor, ScanSummary& summary,
+  std::vector<ScanPoint>& points) {
+  auto start = std::chrono::steady_clock::now();
+
+  points.clear();
+  ScanFileHeader header;
+  if (!ScanParser::parse(content, scaleFactor, points, header)) {
+    summary.ok = false;
+    summary.error = "no measurements array";
+    return false;
+  }
+
+  analyzePoints(points, content.size(), summary);
+  summary.parseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return true;
+}
+
+void ScanAnalyzer::analyzePoints(const std::vector<ScanPoint>& points, size_t fileBytes, ScanSummary& summary) {
+  summary.fileBytes = fileBytes;
+  summary.pointCount = points.size();
+  summary.peakCount = 0;
+  summary.minValue = std::numeric_limits<float>::max();
+  summary.maxValue = std::numeric_limits<float>::lowest();
+
+  // One pass for bounds, range, peak flags and the maximum; the digest gives percentiles
+  ScanStatistics statistics;
+  size_t peakIndex = 0;
+  for (size_t i = 0; i < points.size(); ++i) {
+    const ScanPoint& p = points[i];
+    if (i == 0) {
+      summary.bounds = { p.x, p.x, p.y, p.y, p.z, p.z };
+    }
+    else {
+      summary.bounds.minX = std::min(summary.bounds.minX, p.x);
+      summary.bounds.maxX = std::max(summary.bounds.maxX, p.x);
+      summary.bounds.minY = std::min(summary.bounds.minY, p.y);
+      summary.bounds.maxY = std::max(summary.bounds.maxY, p.y);
+      summary.bounds.minZ = std::min(summary.bounds.minZ, p.z);
+      summary.bounds.maxZ = std::max(summary.bounds.maxZ, p.z);
+    }
+
+    if (p.isPeak) summary.peakCount++;
+    statistics.add(p.value);
+
+    if (p.value > -VerticesLoader::VALUE_OUTLIER_LIMIT && p.value < VerticesLoader::VALUE_OUTLIER_LIMIT) {
+      if (p.value > summary.maxValue) peakIndex = i;
+      summary.minValue = std::min(summary.minValue, p.value);
+      summary.maxValue = std::max(summary.maxValue, p.value);
+    }
+  }
+
+  if (summary.minValue > summary.maxValue) {
+    summary.minValue = summary.maxValue = 0.0f; // Nothing inside the outlier limits
+  }
+
+  summary.meanValue = statistics.getMean();
+  summary.percentiles.resize(PERCENTILE_COUNT);
+  for (int k = 0; k < PERCENTILE_COUNT; ++k) {
+    summary.percentiles[k] = statistics.getPercentile(PERCENTILES[k]);
+  }
+
+  if (!points.empty()) {
+    const ScanPoint& peak = points[peakIndex];
+    summary.peakX = peak.x;
+    summary.peakY = peak.y;
+    summary.peakZ = peak.z;
+    summary.peakValue = peak.value;
+  }
+
+  summary.ok = true;
+  summary.error.clear();
+}
+
+bool ScanAnalyzer::analyzeFile(const std::string& filePath, float scaleFactor, ScanSummary& summary) {
+  summary = ScanSummary();
+  summary.filePath = filePath;
+
+  std::string content;
+  if (!ScanParser::readFile(filePath, content)) {
+    summary.error = "cannot open file";
+    return false;
+  }
+
+  std::vector<ScanPoint> points;
+  return analyzeContent(content, scaleFactor, summary, points);
+}
+
+void ScanAnalyzer::parseFiles(const std::vector<std::string>& filePaths, float scaleFactor, AsyncFileReader& reader,
+  const std::function<void(ParsedScan&)>& consume, const std::atomic<bool>* cancel, unsigned int maxInFlight) {
+  if (filePaths.empty()) return;
+  if (maxInFlight == 0) maxInFlight = JobSystem::getThreadCount() * 2;
+
+  // The reader blocks on I/O, so it keeps its own thread instead of occupying a worker.
+  // A few buffers per parse job keep them busy without holding the whole directory in memory
+  BoundedQueue<FileBuffer> buffers(maxInFlight * 2);
+  std::thread readerThread([&]() { reader.readAll(filePaths, buffers); });
+
+  std::vector<JobHandle> jobs;
+  size_t oldest = 0;
+  FileBuffer buffer;
+  while (buffers.pop(buffer)) {
+    if (cancel && cancel->load()) {
+      buffers.close();  // Stops the reader; what it already queued is dropped
+      continue;
+    }
+    auto file = std::make_shared<FileBuffer>(std::move(buffer));
+    jobs.push_back(JobSystem::submit([file, scaleFactor, &consume]() {
+      auto start = std::chrono::steady_clock::now();
+      ParsedScan scan;
+      scan.fileIndex = file->fileIndex;
+      scan.fileBytes = file->content.size();
+      if (!file->ok) {
+        scan.error = file->error;
+      }
+      else if (!ScanParser::parse(file->content, scaleFactor, scan.points, scan.header)) {
+        scan.error = "no measurements array";
+      }
+      else {
+        scan.ok = true;
+      }
+      std::string().swap(file->content);
+      scan.parseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      consume(scan);
+    }));
+    buffer = FileBuffer();
+
+    // Throttle on the oldest job so parsed files do not pile up ahead of consume
+    if (jobs.size() - oldest >= maxInFlight) {
+      JobSystem::wait(jobs[oldest]);
+      jobs[oldest++].reset();
+    }
+  }
+  JobSystem::waitAll(jobs);
+  readerThread.join();
+}
+
+void ScanAnalyzer::parseFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+  const std::function<void(ParsedScan&)>& consume, const std::atomic<bool>* cancel) {
+  AsyncFileReader reader;
+  parseFiles(filePaths, scaleFactor, reader, consume, cancel);
+}
+
+void ScanAnalyzer::splitPoints(const std::vector<ScanPoint>& points, std::vector<float>& positions, std::vector<float>& values) {
+  positions.resize(points.size() * 3);
+  values.resize(points.size());
+  for (size_t p = 0; p < points.size(); ++p) {
+    positions[p * 3] = points[p].x;
+    positions[p * 3 + 1] = points[p].y;
+    positions[p * 3 + 2] = points[p].z;
+    values[p] = points[p].value;
+  }
+}
+
+std::vector<ScanSummary> ScanAnalyzer::analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+  unsigned int threadCount) {
+  AsyncFileReader reader;
+  return analyzeFilesAsync(filePaths, scaleFactor, reader, threadCount);
+}
+
+std::vector<ScanSummary> ScanAnalyzer::analyzeFilesAsync(const std::vector<std::string>& filePaths, float scaleFactor,
+  AsyncFileReader& reader, unsigned int threadCount) {
+  std::vector<ScanSummary> summaries(filePaths.size());
+  parseFiles(filePaths, scaleFactor, reader, [&](ParsedScan& scan) {
+    ScanSummary& summary = summaries[scan.fileIndex];
+    summary.filePath = filePaths[scan.fileIndex];
+    if (!scan.ok) {
+      summary.error = scan.error;
+      return;
+    }
+    auto start = std::chrono::steady_clock::now();
+    analyzePoints(scan.points, scan.fileBytes, summary);
+    summary.parseMilliseconds = scan.parseMilliseconds +
+      std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }, nullptr, threadCount);
+  return summaries;
+}
+
+std::string ScanAnalyzer::csvField(const std::string& text) {
+  if (text.find_first_of(",\"\n") == std::string::npos) return text;
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"') quoted += '"';
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+void ScanAnalyzer::writeCsv(std::ostream& out, const std::vector<ScanSummary>& summaries) {
+  out << "file,ok,bytes,points,peaks,min_value,max_value,mean_value";
+  for (int k = 0; k < PERCENTILE_COUNT; ++k) out << ",p" << static_cast<int>(PERCENTILES[k] * 100.0 + 0.5);
+  out << ",peak_x,peak_y,peak_z,peak_value,min_x,max_x,min_y,max_y,min_z,max_z,parse_ms,error\n";
+
+  for (const ScanSummary& s : summaries) {
+    out << csvField(s.filePath) << "," << (s.ok ? 1 : 0) << "," << s.fileBytes << "," << s.pointCount << "," << s.peakCount
+      << "," << s.minValue << "," << s.maxValue << "," << s.meanValue;
+    for (int k = 0; k < PERCENTILE_COUNT; ++k) {
+      out << "," << (k < static_cast<int>(s.percentiles.size()) ? s.percentiles[k] : 0.0f);
+    }
+    out << "," << s.peakX << "," << s.peakY << "," << s.peakZ << "," << s.peakValue
+      << "," << s.bounds.minX << "," << s.bounds.maxX << "," << s.bounds.minY << "," << s.bounds.maxY
+      << "," << s.bounds.minZ << "," << s.bounds.maxZ << "," << s.parseMilliseconds << "," << csvField(s.error) << "\n";
+  }
+}
+
+void ScanAnalyzer::writeJson(std::ostream& out, const std::vector<ScanSummary>& summaries) {
+  nlohmann::json files = nlohmann::json::array();
+  for (const ScanSummary& s : summaries) {
+    nlohmann::json file;
+    file["file"] = s.filePath;
+    file["ok"] = s.ok;
+    if (!s.ok) {
+      file["error"] = s.error;
+      files.push_back(file);
+      continue;
+    }
+
+    file["bytes"] = s.fileBytes;
+    file["points"] = s.pointCount;
+    file["peaks"] = s.peakCount;
+    file["value"] = { { "min", s.minValue }, { "max", s.maxValue }, { "mean", s.meanValue } };
+
+    nlohmann::json percentiles;
+    for (int k = 0; k < PERCENTILE_COUNT && k < static_cast<int>(s.percentiles.size()); ++k) {
+      percentiles["p" + std::to_string(static_cast<int>(PERCENTILES[k] * 100.0 + 0.5))] = s.percentiles[k];
+    }
+    file["percentiles"] = percentiles;
+    file["peak"] = { { "x", s.peakX }, { "y", s.peakY }, { "z", s.peakZ }, { "value", s.peakValue } };
+    file["aabb"] = {
+      { "min", { s.bounds.minX, s.bounds.minY, s.bounds.minZ } },
+      { "max", { s.bounds.maxX, s.bounds.maxY, s.bounds.maxZ } }
+    };
+    file["parseMs"] = s.parseMilliseconds;
+    files.push_back(file);
+  }
+  out << files.dump(2) << "\n";
+}
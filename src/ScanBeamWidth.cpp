@@ -0,0 +1,183 @@
+#include "ScanBeamWidth.h"
+#include "ScanSlices.h"
+#include "ScanAnalyzer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Crossing of level walking from the peak node along one grid axis; false at an empty node or the border
+static bool findCrossing(const VolumeGrid& grid, const int peak[3], int axis, int step, float level, float& position) {
+  int node[3] = { peak[0], peak[1], peak[2] };
+  float previous = grid.values[grid.nodeIndex(node[0], node[1], node[2])];
+  for (int i = peak[axis] + step; i >= 0 && i < grid.dims[axis]; i += step) {
+    node[axis] = i;
+    float value = grid.values[grid.nodeIndex(node[0], node[1], node[2])];
+    if (std::isnan(value)) return false;
+    if (value < level) {
+      float t = (previous - level) / (previous - value);
+      position = grid.origin[axis] + (i - step + step * t) * grid.cellSize;
+      return true;
+    }
+    previous = value;
+  }
+  return false;
+}
+
+static bool containsPoint(const std::vector<float>& polygon, float u, float v) {
+  bool inside = false;
+  size_t count = polygon.size() / 2;
+  for (size_t i = 0, j = count - 1; i < count; j = i++) {
+    float ui = polygon[i * 2], vi = polygon[i * 2 + 1];
+    float uj = polygon[j * 2], vj = polygon[j * 2 + 1];
+    if ((vi > v) != (vj > v) && u < uj + (v - vj) / (vi - vj) * (ui - uj)) inside = !inside;
+  }
+  return inside;
+}
+
+// Area, centroid and central second moments of a simple polygon (Green's theorem), relative to an origin near it
+static void polygonMoments(const std::vector<float>& polygon, float originU, float originV, BeamContour& out) {
+  double area = 0.0, su = 0.0, sv = 0.0, suu = 0.0, svv = 0.0, suv = 0.0;
+  size_t count = polygon.size() / 2;
+  for (size_t i = 0; i < count; ++i) {
+    size_t j = (i + 1) % count;
+    double u0 = polygon[i * 2] - originU, v0 = polygon[i * 2 + 1] - originV;
+    double u1 = polygon[j * 2] - originU, v1 = polygon[j * 2 + 1] - originV;
+    double cross = u0 * v1 - u1 * v0;
+    area += cross;
+    su += (u0 + u1) * cross;
+    sv += (v0 + v1) * cross;
+    suu += (u0 * u0 + u0 * u1 + u1 * u1) * cross;
+    svv += (v0 * v0 + v0 * v1 + v1 * v1) * cross;
+    suv += (u0 * v1 + 2.0 * u0 * v0 + 2.0 * u1 * v1 + u1 * v0) * cross;
+  }
+  area *= 0.5;
+  if (std::fabs(area) <= 0.0) return;
+  double cu = su / (6.0 * area), cv = sv / (6.0 * area);
+  double varU = suu / (12.0 * area) - cu * cu;
+  double varV = svv / (12.0 * area) - cv * cv;
+  double covUV = suv / (24.0 * area) - cu * cv;
+
+  // A uniform ellipse with semi-axis a has variance a^2 / 4 along it
+  double mean = 0.5 * (varU + varV);
+  double spread = std::sqrt(0.25 * (varU - varV) * (varU - varV) + covUV * covUV);
+  double major = std::max(0.0, mean + spread), minor = std::max(0.0, mean - spread);
+  out.area = static_cast<float>(std::fabs(area));
+  out.centroid[0] = static_cast<float>(originU + cu);
+  out.centroid[1] = static_cast<float>(originV + cv);
+  out.majorWidth = static_cast<float>(4.0 * std::sqrt(major));
+  out.minorWidth = static_cast<float>(4.0 * std::sqrt(minor));
+  out.angleDegrees = static_cast<float>(0.5 * std::atan2(2.0 * covUV, varU - varV) * 180.0 / 3.14159265358979323846);
+  out.ellipticity = out.majorWidth > 0.0f ? out.minorWidth / out.majorWidth : 0.0f;
+}
+
+void ScanBeamWidth::analyzeGrid(const VolumeGrid& grid, const BeamWidthOptions& options, BeamWidthResult& out) {
+  std::copy(grid.dims, grid.dims + 3, out.gridDims);
+  if (!ScanSlices::findPeak(grid, out.peakPosition)) {
+    out.error = "empty grid";
+    return;
+  }
+  // Levels are relative to the peak of the interpolated field the contours are traced on
+  int peak[3];
+  for (int a = 0; a < 3; ++a) peak[a] = static_cast<int>(std::lround((out.peakPosition[a] - grid.origin[a]) / grid.cellSize));
+  out.peakValue = grid.values[grid.nodeIndex(peak[0], peak[1], peak[2])];
+  if (out.peakValue <= 0.0f) {
+    out.error = "no positive values";
+    return;
+  }
+
+  // Flat axis of a planar scan, otherwise the requested one
+  out.normalAxis = options.normalAxis >= 0 && options.normalAxis < 3 ? options.normalAxis : 2;
+  if (options.normalAxis < 0) {
+    for (int a = 0; a < 3; ++a) {
+      if (grid.dims[a] == 1) out.normalAxis = a;
+    }
+  }
+  SliceImage image;
+  ScanSlices::slice(grid, out.normalAxis, out.peakPosition[out.normalAxis], image);
+  out.axisU = image.axisU;
+  out.axisV = image.axisV;
+
+  const float fractions[2] = { HALF_POWER, ONE_OVER_E_SQUARED };
+  std::vector<float> segments;
+  std::vector<ContourLine> lines;
+  for (int c = 0; c < 2; ++c) {
+    BeamContour& contour = out.contours[c];
+    contour = BeamContour();
+    contour.fraction = fractions[c];
+    contour.level = out.peakValue * fractions[c];
+
+    for (int a = 0; a < 3; ++a) {
+      float low, high;
+      if (grid.dims[a] > 1 && findCrossing(grid, peak, a, -1, contour.level, low) && findCrossing(grid, peak, a, 1, contour.level, high)) {
+        contour.axisWidths[a] = high - low;
+      }
+    }
+
+    // Innermost closed contour around the peak
+    ScanSlices::extractContours(image, contour.level, segments);
+    ScanSlices::chainContours(segments, lines);
+    float peakU = out.peakPosition[out.axisU], peakV = out.peakPosition[out.axisV];
+    for (ContourLine& line : lines) {
+      if (!line.closed || line.points.size() < 6 || !containsPoint(line.points, peakU, peakV)) continue;
+      BeamContour candidate = contour;
+      polygonMoments(line.points, peakU, peakV, candidate);
+      if (!contour.closed || candidate.area < contour.area) {
+        candidate.closed = true;
+        candidate.polygon = std::move(line.points);
+        contour = std::move(candidate);
+      }
+    }
+  }
+  out.ok = true;
+}
+
+void ScanBeamWidth::analyze(const float* positions, const float* values, size_t pointCount,
+  const BeamWidthOptions& options, BeamWidthResult& out) {
+  auto start = std::chrono::steady_clock::now();
+  VolumeGrid grid;
+  ScanVolume::grid(positions, values, pointCount, options.grid, grid);
+  if (grid.measurementCount == 0) out.error = "no valid measurements";
+  else analyzeGrid(grid, options, out);
+  out.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<BeamWidthResult> ScanBeamWidth::analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+  const BeamWidthOptions& options) {
+  return ScanAnalyzer::analyzeEach<BeamWidthResult>(filePaths, scaleFactor, [&](ParsedScan& scan, BeamWidthResult& result) {
+    std::vector<float> positions, values;
+    ScanAnalyzer::splitPoints(scan.points, positions, values);
+    analyze(positions.data(), values.data(), scan.points.size(), options, result);
+  });
+}
+
+void ScanBeamWidth::writeCsv(std::ostream& out, const std::vector<BeamWidthResult>& results) {
+  const char* levelNames[2] = { "3db", "e2" };
+  const char* axisNames = "xyz";
+  out << "file,ok,plane,peak_x,peak_y,peak_z,peak_value";
+  for (const char* level : levelNames) {
+    out << "," << level << "_width_x," << level << "_width_y," << level << "_width_z," << level << "_closed,"
+      << level << "_area," << level << "_major," << level << "_minor," << level << "_angle," << level << "_ellipticity";
+  }
+  out << ",ms,error\n";
+
+  for (const BeamWidthResult& result : results) {
+    out << ScanAnalyzer::csvField(result.filePath) << "," << (result.ok ? 1 : 0) << ",";
+    if (result.ok) out << axisNames[result.axisU] << axisNames[result.axisV];
+    out << "," << result.peakPosition[0] << "," << result.peakPosition[1] << "," << result.peakPosition[2] << "," << result.peakValue;
+    for (const BeamContour& contour : result.contours) {
+      for (float width : contour.axisWidths) {
+        out << ",";
+        if (width > 0.0f) out << width;
+      }
+      out << "," << (contour.closed ? 1 : 0);
+      if (contour.closed) {
+        out << "," << contour.area << "," << contour.majorWidth << "," << contour.minorWidth << "," << contour.angleDegrees
+          << "," << contour.ellipticity;
+      }
+      else {
+        out << ",,,,,";
+      }
+    }
+    out << "," << result.milliseconds << "," << ScanAnalyzer::csvField(result.error) << "\n";
+  }
+}
@@ -0,0 +1,117 @@
+#include "ScanBitmapIndex.h"
+#include "ScanStatistics.h"
+#include <algorithm>
+#include <limits>
+
+void ScanBitmapIndex::clear() {
+  pointCount = 0;
+  peakBits = PointBitset();
+  axisBits.clear();
+  directionBits.clear();
+  bucketEdges.clear();
+  valueAtLeast.clear();
+}
+
+void ScanBitmapIndex::build(const std::vector<float>& values, const std::vector<uint8_t>& peakFlags,
+  const std::vector<uint8_t>& axisCodes, int axisCount,
+  const std::vector<uint8_t>& directionCodes, int directionCount,
+  const ScanStatistics& valueStatistics) {
+  clear();
+  pointCount = values.size();
+
+  peakBits.assign(pointCount);
+  axisBits.assign(axisCount, PointBitset(pointCount));
+  directionBits.assign(directionCount, PointBitset(pointCount));
+
+  // Equal-frequency bucket edges; bucket 0 is open below so every point lands somewhere
+  bucketEdges.assign(VALUE_BUCKETS, std::numeric_limits<float>::lowest());
+  for (int k = 1; k < VALUE_BUCKETS; ++k) {
+    float edge = valueStatistics.getPercentile(static_cast<double>(k) / VALUE_BUCKETS);
+    bucketEdges[k] = std::max(edge, bucketEdges[k - 1]);
+  }
+
+  // Bucket membership first (one bit per point), turned into range encoding below
+  std::vector<PointBitset> bucketBits(VALUE_BUCKETS, PointBitset(pointCount));
+
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (peakFlags[i]) peakBits.set(i);
+    if (axisCodes[i] < axisCount) axisBits[axisCodes[i]].set(i);
+    if (directionCodes[i] < directionCount) directionBits[directionCodes[i]].set(i);
+
+    // Largest k with edge[k] <= value (NaN falls into bucket 0)
+    int bucket = static_cast<int>(std::upper_bound(bucketEdges.begin(), bucketEdges.end(), values[i]) - bucketEdges.begin()) - 1;
+    bucketBits[std::max(0, bucket)].set(i);
+  }
+
+  // valueAtLeast[k] = bucket[k] | bucket[k + 1] | ... (suffix OR)
+  valueAtLeast.assign(VALUE_BUCKETS, PointBitset(pointCount));
+  valueAtLeast[VALUE_BUCKETS - 1] = bucketBits[VALUE_BUCKETS - 1];
+  for (int k = VALUE_BUCKETS - 2; k >= 0; --k) {
+    valueAtLeast[k] = bucketBits[k];
+    valueAtLeast[k].orWith(valueAtLeast[k + 1]);
+  }
+}
+
+void ScanBitmapIndex::orCodes(const std::vector<PointBitset>& bitmaps, uint32_t mask, PointBitset& out) const {
+  out.assign(pointCount);
+  for (size_t code = 0; code < bitmaps.size() && code < 32; ++code) {
+    if (mask & (1u << code)) out.orWith(bitmaps[code]);
+  }
+}
+
+void ScanBitmapIndex::resolve(const ScanFilter& filter, const std::vector<float>& values, PointBitset& out) const {
+  out.assign(pointCount, true);
+  if (pointCount == 0) return;
+
+  if (filter.peaksOnly) {
+    out.andWith(peakBits);
+  }
+
+  PointBitset scratch;
+  if (filter.axisMask != 0) {
+    orCodes(axisBits, filter.axisMask, scratch);
+    out.andWith(scratch);
+  }
+  if (filter.directionMask != 0) {
+    orCodes(directionBits, filter.directionMask, scratch);
+    out.andWith(scratch);
+  }
+
+  if (filter.useMinValue) {
+    // Buckets above the threshold's bucket pass outright; only the bucket
+    // containing the threshold needs the values checked.
+    int k = static_cast<int>(std::upper_bound(bucketEdges.begin(), bucketEdges.end(), filter.minValue) - bucketEdges.begin()) - 1;
+    k = std::max(0, k);
+
+    PointBitset passing(pointCount);
+    if (k + 1 < VALUE_BUCKETS) passing = valueAtLeast[k + 1];
+
+    PointBitset boundary = valueAtLeast[k];
+    boundary.andNotWith(passing);
+    boundary.andWith(out);
+
+    const std::vector<uint64_t>& words = boundary.getWords();
+    for (size_t w = 0; w < words.size(); ++w) {
+      uint64_t word = words[w];
+      while (word) {
+        size_t i = w * 64 + PointBitset::countTrailingZeros(word);
+        if (values[i] >= filter.minValue) passing.set(i);
+        word &= word - 1;
+      }
+    }
+
+    out.andWith(passing);
+  }
+}
+
+void ScanBitmapIndex::buildDrawLists(const ScanFilter& filter, const std::vector<float>& values,
+  std::vector<unsigned int>& pointIndices, std::vector<unsigned int>& lineIndices) const {
+  PointBitset selection;
+  resolve(filter, values, selection);
+
+  pointIndices.clear();
+  lineIndices.clear();
+  selection.appendSetBits(pointIndices);
+  // Keep path segments whose two ends both survive the filter
+  selection.appendAdjacentPairs(lineIndices);
+}
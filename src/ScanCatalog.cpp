@@ -0,0 +1,364 @@
+#include "ScanCatalog.h"
+#include "ScanAnalyzer.h"
+#include "ScanDiscovery.h"
+#include "ScanParser.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <unordered_map>
+
+const char* ScanCatalog::FILE_NAME = "scan_catalog.bin";
+
+// File layout: magic, record size, record count, the raw records, then length-prefixed relative paths
+static const char CATALOG_MAGIC[8] = { 'S', 'C', 'A', 'N', 'C', 'A', 'T', '1' };
+
+static std::string joinPath(const std::string& root, const std::string& relative) {
+  return (std::filesystem::path(root) / relative).string();
+}
+
+bool ScanCatalog::readCatalogFile(const std::string& root, std::vector<std::string>& relativePaths,
+  std::vector<CatalogRecord>& fileRecords) {
+  relativePaths.clear();
+  fileRecords.clear();
+
+  std::ifstream in(joinPath(root, FILE_NAME), std::ios::binary);
+  if (!in) return false;
+
+  char magic[sizeof(CATALOG_MAGIC)];
+  uint32_t recordSize = 0, count = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+  in.read(reinterpret_cast<char*>(&count), sizeof(count));
+  // A different layout (older version or another compiler's padding) is rebuilt from scratch
+  if (!in || std::memcmp(magic, CATALOG_MAGIC, sizeof(magic)) != 0 || recordSize != sizeof(CatalogRecord)) {
+    std::cerr << "Ignoring incompatible catalog in " << root << std::endl;
+    return false;
+  }
+
+  fileRecords.resize(count);
+  in.read(reinterpret_cast<char*>(fileRecords.data()), static_cast<std::streamsize>(count * sizeof(CatalogRecord)));
+  relativePaths.resize(count);
+  for (uint32_t i = 0; i < count && in; ++i) {
+    uint32_t length = 0;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    relativePaths[i].resize(length);
+    in.read(&relativePaths[i][0], length);
+  }
+
+  if (!in) {
+    std::cerr << "Truncated catalog in " << root << ", rebuilding" << std::endl;
+    relativePaths.clear();
+    fileRecords.clear();
+    return false;
+  }
+  return true;
+}
+
+bool ScanCatalog::writeCatalogFile(const std::string& root, const std::vector<std::string>& relativePaths,
+  const std::vector<CatalogRecord>& fileRecords) {
+  // Written beside the old file and renamed over it, so readers never see half a catalog
+  std::string finalPath = joinPath(root, FILE_NAME);
+  std::string tempPath = finalPath + ".tmp";
+  {
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      std::cerr << "Cannot write catalog " << tempPath << std::endl;
+      return false;
+    }
+    uint32_t recordSize = sizeof(CatalogRecord);
+    uint32_t count = static_cast<uint32_t>(fileRecords.size());
+    out.write(CATALOG_MAGIC, sizeof(CATALOG_MAGIC));
+    out.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    out.write(reinterpret_cast<const char*>(fileRecords.data()), static_cast<std::streamsize>(count * sizeof(CatalogRecord)));
+    for (const std::string& path : relativePaths) {
+      uint32_t length = static_cast<uint32_t>(path.size());
+      out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+      out.write(path.data(), length);
+    }
+    if (!out) {
+      std::cerr << "Error writing catalog " << tempPath << std::endl;
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tempPath, finalPath, ec);
+  if (ec) {
+    std::cerr << "Cannot replace catalog " << finalPath << ": " << ec.message() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+size_t ScanCatalog::load(const std::vector<std::string>& catalogRoots) {
+  roots = catalogRoots;
+  records.clear();
+  paths.clear();
+  rootIndices.clear();
+
+  std::vector<std::string> relativePaths;
+  std::vector<CatalogRecord> fileRecords;
+  for (size_t r = 0; r < roots.size(); ++r) {
+    readCatalogFile(roots[r], relativePaths, fileRecords);
+    for (size_t i = 0; i < fileRecords.size(); ++i) {
+      records.push_back(fileRecords[i]);
+      paths.push_back(joinPath(roots[r], relativePaths[i]));
+      rootIndices.push_back(static_cast<uint32_t>(r));
+    }
+  }
+
+  // Newest first across all roots
+  std::vector<size_t> order(records.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return records[a].timestamp > records[b].timestamp;
+  });
+  std::vector<CatalogRecord> sortedRecords(records.size());
+  std::vector<std::string> sortedPaths(records.size());
+  std::vector<uint32_t> sortedRoots(records.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    sortedRecords[i] = records[order[i]];
+    sortedPaths[i] = std::move(paths[order[i]]);
+    sortedRoots[i] = rootIndices[order[i]];
+  }
+  records.swap(sortedRecords);
+  paths.swap(sortedPaths);
+  rootIndices.swap(sortedRoots);
+  return records.size();
+}
+
+CatalogUpdateStats ScanCatalog::update(const std::vector<std::string>& catalogRoots, float scaleFactor) {
+  auto start = std::chrono::steady_clock::now();
+  CatalogUpdateStats stats;
+
+  // What was indexed last time, by full path
+  load(catalogRoots);
+  std::unordered_map<std::string, size_t> previous;
+  previous.reserve(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) previous.emplace(paths[i], i);
+
+  // Discovery already returns newest first, so the new arrays come out ordered
+  std::vector<ScanFileEntry> entries = ScanDiscovery::discover(roots);
+  std::vector<CatalogRecord> newRecords(entries.size());
+  std::vector<std::string> newPaths(entries.size());
+  std::vector<uint32_t> newRootIndices(entries.size(), 0);
+  std::vector<bool> rootDirty(roots.size(), false);
+  std::vector<size_t> stale;
+  size_t reused = 0;
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    // Longest root that prefixes the path (roots may be nested)
+    size_t bestLength = 0;
+    for (size_t r = 0; r < roots.size(); ++r) {
+      if (roots[r].size() >= bestLength && entries[i].path.compare(0, roots[r].size(), roots[r]) == 0) {
+        bestLength = roots[r].size();
+        newRootIndices[i] = static_cast<uint32_t>(r);
+      }
+    }
+
+    CatalogRecord& record = newRecords[i];
+    record.timestamp = entries[i].timestamp;
+    ScanParser::getFileSignature(entries[i].path, record.fileBytes, record.modifiedTime);
+    newPaths[i] = std::move(entries[i].path);
+
+    auto found = previous.find(newPaths[i]);
+    if (found != previous.end()) {
+      const CatalogRecord& old = records[found->second];
+      if (old.fileBytes == record.fileBytes && old.modifiedTime == record.modifiedTime) {
+        record = old;
+        record.timestamp = entries[i].timestamp;
+        stats.unchanged++;
+        reused++;
+        continue;
+      }
+      stats.changed++;
+    }
+    else {
+      stats.added++;
+    }
+    rootDirty[newRootIndices[i]] = true;
+    stale.push_back(i);
+  }
+
+  // Anything indexed before but no longer listed was removed
+  stats.removed = records.size() - (reused + stats.changed);
+  if (stats.removed > 0) {
+    std::unordered_map<std::string, bool> listed;
+    for (const std::string& path : newPaths) listed.emplace(path, true);
+    for (size_t i = 0; i < paths.size(); ++i) {
+      if (listed.find(paths[i]) == listed.end()) rootDirty[rootIndices[i]] = true;
+    }
+  }
+
+  // New and changed files are analyzed in parallel on the job system
+  if (!stale.empty()) {
+    std::vector<std::string> stalePaths;
+    stalePaths.reserve(stale.size());
+    for (size_t i : stale) stalePaths.push_back(newPaths[i]);
+    std::vector<ScanSummary> summaries = ScanAnalyzer::analyzeFiles(stalePaths, scaleFactor);
+
+    for (size_t s = 0; s < stale.size(); ++s) {
+      const ScanSummary& summary = summaries[s];
+      CatalogRecord& record = newRecords[stale[s]];
+      record.ok = summary.ok ? 1 : 0;
+      record.pointCount = static_cast<uint32_t>(summary.pointCount);
+      record.peakCount = static_cast<uint32_t>(summary.peakCount);
+      record.minValue = summary.minValue;
+      record.maxValue = summary.maxValue;
+      record.meanValue = static_cast<float>(summary.meanValue);
+      record.peakValue = summary.peakValue;
+      record.peakX = summary.peakX;
+      record.peakY = summary.peakY;
+      record.peakZ = summary.peakZ;
+    }
+  }
+
+  records.swap(newRecords);
+  paths.swap(newPaths);
+  rootIndices.swap(newRootIndices);
+
+  // Only roots whose contents changed are rewritten
+  for (size_t r = 0; r < roots.size(); ++r) {
+    bool missing = !std::filesystem::exists(joinPath(roots[r], FILE_NAME));
+    if (!rootDirty[r] && !missing) continue;
+
+    std::filesystem::path rootPath(roots[r]);
+    std::vector<std::string> relativePaths;
+    std::vector<CatalogRecord> fileRecords;
+    for (size_t i = 0; i < records.size(); ++i) {
+      if (rootIndices[i] != r) continue;
+      relativePaths.push_back(std::filesystem::path(paths[i]).lexically_relative(rootPath).generic_string());
+      fileRecords.push_back(records[i]);
+    }
+    if (std::filesystem::is_directory(rootPath)) writeCatalogFile(roots[r], relativePaths, fileRecords);
+  }
+
+  stats.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return stats;
+}
+
+int64_t ScanCatalog::currentTime() {
+  return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::vector<size_t> ScanCatalog::query(const CatalogQuery& q, int64_t now) const {
+  // Age limits become timestamp bounds once, so the loop only compares numbers
+  int64_t since = q.since;
+  int64_t until = q.until;
+  if (std::isfinite(q.maxAgeDays)) since = std::max(since, now - static_cast<int64_t>(q.maxAgeDays * 86400.0));
+  if (q.minAgeDays > 0.0) until = std::min(until, now - static_cast<int64_t>(q.minAgeDays * 86400.0));
+
+  std::vector<size_t> matches;
+  for (size_t i = 0; i < records.size(); ++i) {
+    const CatalogRecord& r = records[i];
+    if (!r.ok && !q.includeFailed) continue;
+    if (r.timestamp < since || r.timestamp > until) continue;
+    if (r.peakValue < q.minPeakValue || r.peakValue > q.maxPeakValue) continue;
+    if (r.meanValue < q.minMeanValue || r.meanValue > q.maxMeanValue) continue;
+    if (r.pointCount < q.minPoints || r.pointCount > q.maxPoints || r.peakCount < q.minPeaks) continue;
+    if (r.peakX < q.peakMin[0] || r.peakX > q.peakMax[0] ||
+      r.peakY < q.peakMin[1] || r.peakY > q.peakMax[1] ||
+      r.peakZ < q.peakMin[2] || r.peakZ > q.peakMax[2]) {
+      continue;
+    }
+    if (!q.pathContains.empty() && paths[i].find(q.pathContains) == std::string::npos) continue;
+    matches.push_back(i);
+  }
+  return matches;
+}
+
+// Narrow [low, high] with "op value"; strict comparisons step to the adjacent float
+static void applyFloatLimit(const std::string& op, float value, float& low, float& high) {
+  if (op == ">") low = std::max(low, std::nextafter(value, std::numeric_limits<float>::infinity()));
+  else if (op == ">=") low = std::max(low, value);
+  else if (op == "<") high = std::min(high, std::nextafter(value, -std::numeric_limits<float>::infinity()));
+  else if (op == "<=") high = std::min(high, value);
+  else {
+    low = std::max(low, value);
+    high = std::min(high, value);
+  }
+}
+
+bool ScanCatalog::parseQuery(const std::string& text, CatalogQuery& out, std::string& error) {
+  out = CatalogQuery();
+  error.clear();
+
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t end = text.find_first_of(" ,\t", pos);
+    if (end == std::string::npos) end = text.size();
+    std::string token = text.substr(pos, end - pos);
+    pos = end + 1;
+    if (token.empty()) continue;
+
+    size_t opStart = token.find_first_of("<>=");
+    if (opStart == std::string::npos) {
+      if (!out.pathContains.empty()) {
+        error = "only one path word is supported: " + token;
+        return false;
+      }
+      out.pathContains = token;
+      continue;
+    }
+
+    std::string field = token.substr(0, opStart);
+    std::transform(field.begin(), field.end(), field.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    size_t opEnd = opStart + 1;
+    if (opEnd < token.size() && token[opEnd] == '=') opEnd++;
+    std::string op = token.substr(opStart, opEnd - opStart);
+    std::string number = token.substr(opEnd);
+
+    char* parsedEnd = nullptr;
+    double value = std::strtod(number.c_str(), &parsedEnd);
+    if (number.empty() || parsedEnd == number.c_str() || *parsedEnd != '\0') {
+      error = "expected a number in " + token;
+      return false;
+    }
+    float f = static_cast<float>(value);
+
+    if (field == "peak") applyFloatLimit(op, f, out.minPeakValue, out.maxPeakValue);
+    else if (field == "mean") applyFloatLimit(op, f, out.minMeanValue, out.maxMeanValue);
+    else if (field == "x") applyFloatLimit(op, f, out.peakMin[0], out.peakMax[0]);
+    else if (field == "y") applyFloatLimit(op, f, out.peakMin[1], out.peakMax[1]);
+    else if (field == "z") applyFloatLimit(op, f, out.peakMin[2], out.peakMax[2]);
+    else if (field == "points" || field == "peaks") {
+      // Integer counts: strict bounds move by one
+      if (value < 0.0) value = 0.0;
+      uint32_t n = static_cast<uint32_t>(std::min(value, 4294967294.0));
+      uint32_t& low = field == "points" ? out.minPoints : out.minPeaks;
+      if (op == ">") low = std::max(low, n + 1);
+      else if (op == ">=") low = std::max(low, n);
+      else if (field == "peaks") {
+        error = "peaks only supports > and >=";
+        return false;
+      }
+      else if (op == "<") out.maxPoints = std::min(out.maxPoints, n == 0 ? 0 : n - 1);
+      else if (op == "<=") out.maxPoints = std::min(out.maxPoints, n);
+      else {
+        low = std::max(low, n);
+        out.maxPoints = std::min(out.maxPoints, n);
+      }
+    }
+    else if (field == "days") {
+      // "days<7" = newer than 7 days, "days>30" = older than 30 days
+      if (op == "<" || op == "<=") out.maxAgeDays = std::min(out.maxAgeDays, value);
+      else if (op == ">" || op == ">=") out.minAgeDays = std::max(out.minAgeDays, value);
+      else {
+        error = "days needs <, <=, > or >=";
+        return false;
+      }
+    }
+    else {
+      error = "unknown field '" + field + "' (peak, mean, points, peaks, x, y, z, days)";
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,71 @@
+#include "ScanDiff.h"
+#include "KdTree.h"
+#include "JobSystem.h"
+#include "VerticesLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// Queries per job; consecutive scan points are close, so a chunk walks the same tree branches
+static const size_t MATCH_GRAIN = 4096;
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+void ScanDiff::compute(const float* positions, const float* values, size_t pointCount,
+  const float* referencePositions, const float* referenceValues, size_t referenceCount,
+  float maxDistance, ScanDiffResult& out) {
+  out = ScanDiffResult();
+  out.deltas.assign(pointCount, std::numeric_limits<float>::quiet_NaN());
+  out.matches.assign(pointCount, 0);
+  out.distances.assign(pointCount, std::numeric_limits<float>::infinity());
+  if (pointCount == 0 || referenceCount == 0) return;
+
+  auto start = std::chrono::steady_clock::now();
+  KdTree tree;
+  tree.build(referencePositions, referenceCount);
+  auto built = std::chrono::steady_clock::now();
+
+  const float maxDistanceSquared = maxDistance > 0.0f ? maxDistance * maxDistance : std::numeric_limits<float>::infinity();
+  JobSystem::parallelFor(0, pointCount, MATCH_GRAIN, [&](size_t first, size_t last) {
+    KdNeighbor neighbor;
+    for (size_t i = first; i < last; ++i) {
+      // A sentinel reading on either side has no meaningful difference, so the point stays unmatched
+      if (!isInlier(values[i])) continue;
+      if (!tree.findNearest(&positions[i * 3], neighbor) || neighbor.distanceSquared > maxDistanceSquared) continue;
+      if (!isInlier(referenceValues[neighbor.index])) continue;
+      out.matches[i] = neighbor.index;
+      out.distances[i] = std::sqrt(neighbor.distanceSquared);
+      out.deltas[i] = values[i] - referenceValues[neighbor.index];
+    }
+  });
+
+  // Summary over the matched points
+  double sum = 0.0, sumSquares = 0.0, distanceSum = 0.0;
+  float minDelta = std::numeric_limits<float>::infinity();
+  float maxDelta = -std::numeric_limits<float>::infinity();
+  for (size_t i = 0; i < pointCount; ++i) {
+    float delta = out.deltas[i];
+    if (std::isnan(delta)) continue;
+    out.matchedCount++;
+    sum += delta;
+    sumSquares += static_cast<double>(delta) * delta;
+    distanceSum += out.distances[i];
+    minDelta = std::min(minDelta, delta);
+    maxDelta = std::max(maxDelta, delta);
+  }
+  if (out.matchedCount > 0) {
+    out.minDelta = minDelta;
+    out.maxDelta = maxDelta;
+    out.maxAbsDelta = std::max(std::fabs(minDelta), std::fabs(maxDelta));
+    out.meanDelta = sum / out.matchedCount;
+    out.rmsDelta = std::sqrt(sumSquares / out.matchedCount);
+    out.meanDistance = distanceSum / out.matchedCount;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  out.buildMilliseconds = std::chrono::duration<double, std::milli>(built - start).count();
+  out.matchMilliseconds = std::chrono::duration<double, std::milli>(end - built).count();
+}
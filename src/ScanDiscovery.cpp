@@ -0,0 +1,202 @@
+#include "ScanDiscovery.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// Walker threads at most; listing is syscall-bound, so more threads than this rarely helps
+static const unsigned int MAX_WALKER_THREADS = 8;
+
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Value of count digits at text[pos], or -1 if any is not a digit
+static int readNumber(const std::string& text, size_t pos, size_t count) {
+  if (pos + count > text.size()) return -1;
+  int value = 0;
+  for (size_t i = pos; i < pos + count; ++i) {
+    if (!isDigit(text[i])) return -1;
+    value = value * 10 + (text[i] - '0');
+  }
+  return value;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+static int64_t daysFromCivil(int year, int month, int day) {
+  year -= month <= 2 ? 1 : 0;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t yearOfEra = year - era * 400;
+  int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+static bool makeTimestamp(int year, int month, int day, int hour, int minute, int second, int64_t& out) {
+  if (year < 1970 || month < 1 || month > 12 || day < 1 || day > 31 ||
+    hour > 23 || minute > 59 || second > 60) {
+    return false;
+  }
+  out = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+  return true;
+}
+
+bool ScanDiscovery::isScanFileName(const std::string& fileName) {
+  static const std::string EXTENSION = ".json";
+  if (fileName.size() < EXTENSION.size() ||
+    fileName.compare(fileName.size() - EXTENSION.size(), EXTENSION.size(), EXTENSION) != 0) {
+    return false;
+  }
+  return fileName.find("scan") != std::string::npos;
+}
+
+bool ScanDiscovery::parseFileNameTimestamp(const std::string& fileName, int64_t& secondsOut) {
+  for (size_t i = 0; i + 15 <= fileName.size(); ++i) {
+    // Only start at the beginning of a digit run
+    if (!isDigit(fileName[i]) || (i > 0 && isDigit(fileName[i - 1]))) continue;
+
+    // Compact: YYYYMMDD_HHMMSS (separator '_', '-' or 'T')
+    char sep = fileName[i + 8];
+    if ((sep == '_' || sep == '-' || sep == 'T') && (i + 15 == fileName.size() || !isDigit(fileName[i + 15]))) {
+      int date = readNumber(fileName, i, 8);
+      int time = readNumber(fileName, i + 9, 6);
+      if (date >= 0 && time >= 0 &&
+        makeTimestamp(date / 10000, date / 100 % 100, date % 100, time / 10000, time / 100 % 100, time % 100, secondsOut)) {
+        return true;
+      }
+    }
+
+    // Dashed: YYYY-MM-DD_HH-MM-SS (separator '_', 'T' or ' '; time parts '-' or ':')
+    if (i + 19 <= fileName.size() && fileName[i + 4] == '-' && fileName[i + 7] == '-') {
+      char dateSep = fileName[i + 10];
+      char a = fileName[i + 13], b = fileName[i + 16];
+      if ((dateSep == '_' || dateSep == 'T' || dateSep == ' ') && (a == '-' || a == ':') && b == a) {
+        int year = readNumber(fileName, i, 4), month = readNumber(fileName, i + 5, 2), day = readNumber(fileName, i + 8, 2);
+        int hour = readNumber(fileName, i + 11, 2), minute = readNumber(fileName, i + 14, 2);
+        int second = readNumber(fileName, i + 17, 2);
+        if (year >= 0 && month >= 0 && day >= 0 && hour >= 0 && minute >= 0 && second >= 0 &&
+          makeTimestamp(year, month, day, hour, minute, second, secondsOut)) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void ScanDiscovery::sortNewestFirst(std::vector<ScanFileEntry>& entries) {
+  std::sort(entries.begin(), entries.end(), [](const ScanFileEntry& a, const ScanFileEntry& b) {
+    if (a.timestamp != b.timestamp) return a.timestamp > b.timestamp;
+    return a.path > b.path;
+  });
+}
+
+std::vector<ScanFileEntry> ScanDiscovery::discover(const std::vector<std::string>& roots, bool recursive,
+  ScanDiscoveryStats* stats) {
+  namespace fs = std::filesystem;
+  auto start = std::chrono::steady_clock::now();
+
+  // Modification times are converted through "now" on both clocks (no clock_cast in C++17)
+  const auto fileNow = fs::file_time_type::clock::now();
+  const auto systemNow = std::chrono::system_clock::now();
+
+  std::vector<std::string> pending;
+  for (const std::string& root : roots) {
+    std::error_code ec;
+    if (fs::is_directory(root, ec)) pending.push_back(root);
+    else std::cerr << "Scan directory not found: " << root << std::endl;
+  }
+
+  std::vector<ScanFileEntry> entries;
+  std::mutex mutex;
+  std::condition_variable changed;
+  size_t activeWalkers = 0;
+  std::atomic<size_t> directoriesVisited(0), statCalls(0);
+
+  auto walker = [&]() {
+    std::vector<ScanFileEntry> found;
+    std::vector<std::string> subdirectories;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      // Finished once nothing is queued and nobody is listing a directory that could add more
+      changed.wait(lock, [&]() { return !pending.empty() || activeWalkers == 0; });
+      if (pending.empty()) break;
+
+      std::string directory = std::move(pending.back());
+      pending.pop_back();
+      activeWalkers++;
+      lock.unlock();
+
+      directoriesVisited++;
+      subdirectories.clear();
+      std::error_code ec;
+      for (fs::directory_iterator it(directory, fs::directory_options::skip_permission_denied, ec), end;
+        !ec && it != end; it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        std::error_code typeError;
+        // The type normally comes from the listing itself; symlinked directories are not followed
+        if (entry.is_directory(typeError)) {
+          if (recursive && !entry.is_symlink(typeError)) subdirectories.push_back(entry.path().string());
+          continue;
+        }
+
+        std::string fileName = entry.path().filename().string();
+        if (!isScanFileName(fileName) || !entry.is_regular_file(typeError)) continue;
+
+        ScanFileEntry file;
+        file.path = entry.path().string();
+        file.timestampFromName = parseFileNameTimestamp(fileName, file.timestamp);
+        if (!file.timestampFromName) {
+          statCalls++;
+          fs::file_time_type modified = entry.last_write_time(typeError);
+          if (!typeError) {
+            auto systemTime = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+              modified - fileNow + systemNow);
+            file.timestamp = std::chrono::duration_cast<std::chrono::seconds>(systemTime.time_since_epoch()).count();
+          }
+        }
+        found.push_back(std::move(file));
+      }
+      if (ec) std::cerr << "Error reading directory " << directory << ": " << ec.message() << std::endl;
+
+      lock.lock();
+      activeWalkers--;
+      for (std::string& subdirectory : subdirectories) pending.push_back(std::move(subdirectory));
+      changed.notify_all();
+    }
+    for (ScanFileEntry& file : found) entries.push_back(std::move(file));
+  };
+
+  unsigned int threadCount = std::min(MAX_WALKER_THREADS, std::max(1u, std::thread::hardware_concurrency()));
+  if (!recursive) threadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(pending.size()));
+  std::vector<std::thread> threads;
+  for (unsigned int t = 1; t < threadCount; ++t) threads.emplace_back(walker);
+  walker();
+  for (std::thread& thread : threads) thread.join();
+
+  // Overlapping roots list the same files twice
+  std::sort(entries.begin(), entries.end(), [](const ScanFileEntry& a, const ScanFileEntry& b) { return a.path < b.path; });
+  entries.erase(std::unique(entries.begin(), entries.end(),
+    [](const ScanFileEntry& a, const ScanFileEntry& b) { return a.path == b.path; }), entries.end());
+  sortNewestFirst(entries);
+
+  if (stats != nullptr) {
+    stats->directoriesVisited = directoriesVisited;
+    stats->filesMatched = entries.size();
+    stats->statCalls = statCalls;
+    stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+  return entries;
+}
+
+std::vector<std::string> ScanDiscovery::discoverPaths(const std::vector<std::string>& roots, bool recursive) {
+  std::vector<ScanFileEntry> entries = discover(roots, recursive);
+  std::vector<std::string> paths;
+  paths.reserve(entries.size());
+  for (ScanFileEntry& entry : entries) paths.push_back(std::move(entry.path));
+  return paths;
+}
@@ -0,0 +1,279 @@
+#include "ScanFilters.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include "VerticesLoader.h"
+#include <algorithm>
+#include <cmath>
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+// Points per job when passes are spread over the job system
+static const size_t POINTS_PER_JOB = 16384;
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+// Scalar kernels write out[0, n) from padded[0, n + 2 * radius) starting at output `first`
+// (the vector kernels hand their tail over this way)
+static void medianScalar(const float* padded, float* out, size_t first, size_t n, int radius) {
+  const int width = 2 * radius + 1;
+  float window[2 * ScanFilters::MAX_RADIUS + 1];
+  for (size_t i = first; i < n; ++i) {
+    std::copy(padded + i, padded + i + width, window);
+    std::nth_element(window, window + radius, window + width);
+    out[i] = window[radius];
+  }
+}
+
+static void convolveScalar(const float* padded, float* out, size_t first, size_t n, const float* weights, int width) {
+  for (size_t i = first; i < n; ++i) {
+    float sum = 0.0f;
+    for (int k = 0; k < width; ++k) sum += weights[k] * padded[i + k];
+    out[i] = sum;
+  }
+}
+
+// y[i] = y[i - 1] + alpha * (x[i] - y[i - 1]), starting at y[first - 1]
+static void exponentialScalar(float* values, size_t first, size_t n, float alpha) {
+  for (size_t i = std::max<size_t>(first, 1); i < n; ++i) values[i] = values[i - 1] + alpha * (values[i] - values[i - 1]);
+}
+
+#if CPU_FEATURES_X86
+
+// Odd-even transposition sort of WIDTH vectors: after WIDTH rounds every lane is sorted,
+// so v[WIDTH / 2] holds the eight medians
+template <int WIDTH>
+static TARGET_AVX2 size_t medianAVX2(const float* padded, float* out, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 v[WIDTH];
+    for (int k = 0; k < WIDTH; ++k) v[k] = _mm256_loadu_ps(padded + i + k);
+    for (int round = 0; round < WIDTH; ++round) {
+      for (int k = round & 1; k + 1 < WIDTH; k += 2) {
+        __m256 low = _mm256_min_ps(v[k], v[k + 1]);
+        v[k + 1] = _mm256_max_ps(v[k], v[k + 1]);
+        v[k] = low;
+      }
+    }
+    _mm256_storeu_ps(out + i, v[WIDTH / 2]);
+  }
+  return i;
+}
+
+static size_t medianAVX2(const float* padded, float* out, size_t n, int radius) {
+  switch (radius) {
+  case 1: return medianAVX2<3>(padded, out, n);
+  case 2: return medianAVX2<5>(padded, out, n);
+  case 3: return medianAVX2<7>(padded, out, n);
+  case 4: return medianAVX2<9>(padded, out, n);
+  case 5: return medianAVX2<11>(padded, out, n);
+  case 6: return medianAVX2<13>(padded, out, n);
+  case 7: return medianAVX2<15>(padded, out, n);
+  case 8: return medianAVX2<17>(padded, out, n);
+  case 9: return medianAVX2<19>(padded, out, n);
+  case 10: return medianAVX2<21>(padded, out, n);
+  default: return 0;
+  }
+}
+
+static TARGET_AVX2 size_t convolveAVX2(const float* padded, float* out, size_t n, const float* weights, int width) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 sum = _mm256_setzero_ps();
+    for (int k = 0; k < width; ++k) {
+      sum = _mm256_fmadd_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(padded + i + k), sum);
+    }
+    _mm256_storeu_ps(out + i, sum);
+  }
+  return i;
+}
+
+// Eight steps of the recursion at once: with a = 1 - alpha,
+// y[i + j] = a^(j + 1) y[i - 1] + sum_{m <= j} alpha a^(j - m) x[i + m]
+static TARGET_AVX2 size_t exponentialAVX2(float* values, size_t n, float alpha) {
+  if (n < 9) return 1;
+  const float a = 1.0f - alpha;
+  float carry[8], columns[8][8];
+  for (int j = 0; j < 8; ++j) {
+    carry[j] = std::pow(a, static_cast<float>(j + 1));
+    for (int m = 0; m < 8; ++m) columns[m][j] = j >= m ? alpha * std::pow(a, static_cast<float>(j - m)) : 0.0f;
+  }
+  __m256 carryVector = _mm256_loadu_ps(carry);
+  __m256 column[8];
+  for (int m = 0; m < 8; ++m) column[m] = _mm256_loadu_ps(columns[m]);
+
+  // The input terms do not depend on the previous block; only the final multiply-add and the
+  // broadcast of its last lane are on the loop-carried chain
+  const __m256i lastLane = _mm256_set1_epi32(7);
+  __m256 previous = _mm256_set1_ps(values[0]);
+  size_t i = 1;
+  for (; i + 8 <= n; i += 8) {
+    __m256 even = _mm256_mul_ps(column[0], _mm256_broadcast_ss(values + i));
+    __m256 odd = _mm256_mul_ps(column[1], _mm256_broadcast_ss(values + i + 1));
+    for (int m = 2; m < 8; m += 2) {
+      even = _mm256_fmadd_ps(column[m], _mm256_broadcast_ss(values + i + m), even);
+      odd = _mm256_fmadd_ps(column[m + 1], _mm256_broadcast_ss(values + i + m + 1), odd);
+    }
+    __m256 y = _mm256_fmadd_ps(carryVector, previous, _mm256_add_ps(even, odd));
+    _mm256_storeu_ps(values + i, y);
+    previous = _mm256_permutevar8x32_ps(y, lastLane);
+  }
+  return i;
+}
+
+#endif
+
+static void median(SimdLevel level, const float* padded, float* out, size_t n, int radius) {
+  size_t done = 0;
+#if CPU_FEATURES_X86
+  if (level == SimdLevel::AVX2) done = medianAVX2(padded, out, n, radius);
+#endif
+  (void)level;
+  medianScalar(padded, out, done, n, radius);
+}
+
+static void convolve(SimdLevel level, const float* padded, float* out, size_t n, const float* weights, int width) {
+  size_t done = 0;
+#if CPU_FEATURES_X86
+  if (level == SimdLevel::AVX2) done = convolveAVX2(padded, out, n, weights, width);
+#endif
+  (void)level;
+  convolveScalar(padded, out, done, n, weights, width);
+}
+
+static void exponential(SimdLevel level, float* values, size_t n, float alpha) {
+  size_t done = 1;
+#if CPU_FEATURES_X86
+  if (level == SimdLevel::AVX2) done = exponentialAVX2(values, n, alpha);
+#endif
+  (void)level;
+  exponentialScalar(values, done, n, alpha);
+}
+
+const char* ScanFilters::getFilterName(ScanFilterType type) {
+  switch (type) {
+  case ScanFilterType::Median: return "Median";
+  case ScanFilterType::SavitzkyGolay: return "Savitzky-Golay";
+  case ScanFilterType::Exponential: return "Exponential";
+  default: return "Unknown";
+  }
+}
+
+void ScanFilters::findPasses(const uint8_t* axisCodes, const uint8_t* directionCodes, size_t count, std::vector<size_t>& bounds) {
+  bounds.clear();
+  for (size_t i = 0; i < count; ++i) {
+    if (i == 0 || axisCodes[i] != axisCodes[i - 1] || directionCodes[i] != directionCodes[i - 1]) bounds.push_back(i);
+  }
+  bounds.push_back(count);
+}
+
+void ScanFilters::savitzkyGolayCoefficients(int radius, int order, std::vector<float>& out) {
+  const int width = 2 * radius + 1;
+  order = std::max(0, std::min(order, width - 1));
+  const int terms = order + 1;
+
+  // Normal equations of the polynomial fit, solved for the value at the centre:
+  // (J^T J) z = e0 with J[k][p] = k^p, then weight_k = sum_p z_p k^p
+  std::vector<double> system(terms * (terms + 1), 0.0);
+  for (int row = 0; row < terms; ++row) {
+    for (int column = 0; column < terms; ++column) {
+      for (int k = -radius; k <= radius; ++k) system[row * (terms + 1) + column] += std::pow(static_cast<double>(k), row + column);
+    }
+    system[row * (terms + 1) + terms] = row == 0 ? 1.0 : 0.0;
+  }
+  for (int pivot = 0; pivot < terms; ++pivot) {
+    int best = pivot;
+    for (int row = pivot + 1; row < terms; ++row) {
+      if (std::fabs(system[row * (terms + 1) + pivot]) > std::fabs(system[best * (terms + 1) + pivot])) best = row;
+    }
+    for (int column = 0; column <= terms; ++column) std::swap(system[pivot * (terms + 1) + column], system[best * (terms + 1) + column]);
+    for (int row = 0; row < terms; ++row) {
+      if (row == pivot) continue;
+      double factor = system[row * (terms + 1) + pivot] / system[pivot * (terms + 1) + pivot];
+      for (int column = pivot; column <= terms; ++column) system[row * (terms + 1) + column] -= factor * system[pivot * (terms + 1) + column];
+    }
+  }
+
+  out.assign(width, 0.0f);
+  for (int k = -radius; k <= radius; ++k) {
+    double weight = 0.0;
+    for (int p = 0; p < terms; ++p) {
+      weight += system[p * (terms + 1) + terms] / system[p * (terms + 1) + p] * std::pow(static_cast<double>(k), p);
+    }
+    out[k + radius] = static_cast<float>(weight);
+  }
+}
+
+// One pass: bridge outliers, mirror the ends, filter into `filtered`, copy back the inliers
+static void filterPass(SimdLevel level, float* values, size_t n, const ScanFilterOptions& options,
+  const std::vector<float>& weights, std::vector<float>& padded, std::vector<float>& filtered) {
+  if (n < 2) return;
+  filtered.resize(n);
+  size_t firstInlier = 0;
+  while (firstInlier < n && !isInlier(values[firstInlier])) ++firstInlier;
+  if (firstInlier == n) return;
+  float held = values[firstInlier];
+  for (size_t i = 0; i < n; ++i) {
+    if (isInlier(values[i])) held = values[i];
+    filtered[i] = held;
+  }
+
+  if (options.type == ScanFilterType::Exponential) {
+    float alpha = std::max(0.0f, std::min(1.0f, options.alpha));
+    exponential(level, filtered.data(), n, alpha);
+    if (options.zeroPhase) {
+      std::reverse(filtered.begin(), filtered.end());
+      exponential(level, filtered.data(), n, alpha);
+      std::reverse(filtered.begin(), filtered.end());
+    }
+  }
+  else {
+    // Passes shorter than the window use the widest window that still mirrors inside them
+    int radius = static_cast<int>(std::min<size_t>(options.radius, n - 1));
+    padded.resize(n + 2 * radius);
+    std::copy(filtered.begin(), filtered.end(), padded.begin() + radius);
+    for (int j = 0; j < radius; ++j) {
+      padded[radius - 1 - j] = filtered[j + 1];
+      padded[radius + n + j] = filtered[n - 2 - j];
+    }
+    if (options.type == ScanFilterType::Median) {
+      median(level, padded.data(), filtered.data(), n, radius);
+    }
+    else if (radius == options.radius) {
+      convolve(level, padded.data(), filtered.data(), n, weights.data(), 2 * radius + 1);
+    }
+    else {
+      std::vector<float> shortWeights;
+      ScanFilters::savitzkyGolayCoefficients(radius, options.polynomialOrder, shortWeights);
+      convolve(level, padded.data(), filtered.data(), n, shortWeights.data(), 2 * radius + 1);
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    if (isInlier(values[i])) values[i] = filtered[i];
+  }
+}
+
+void ScanFilters::apply(float* values, size_t count, const std::vector<size_t>& passBounds, const ScanFilterOptions& options) {
+  if (values == nullptr || count == 0 || passBounds.size() < 2) return;
+  ScanFilterOptions clamped = options;
+  clamped.radius = std::max(1, std::min(options.radius, MAX_RADIUS));
+
+  std::vector<float> weights;
+  if (clamped.type == ScanFilterType::SavitzkyGolay) savitzkyGolayCoefficients(clamped.radius, clamped.polynomialOrder, weights);
+
+  const SimdLevel level = CpuFeatures::getSimdLevel();
+  const size_t passCount = passBounds.size() - 1;
+  const size_t grain = std::max<size_t>(1, POINTS_PER_JOB * passCount / count);
+  JobSystem::parallelFor(0, passCount, grain, [&](size_t first, size_t last) {
+    std::vector<float> padded, filtered;
+    for (size_t p = first; p < last; ++p) {
+      size_t begin = std::min(passBounds[p], count);
+      size_t end = std::min(passBounds[p + 1], count);
+      if (end > begin) filterPass(level, values + begin, end - begin, clamped, weights, padded, filtered);
+    }
+  });
+}
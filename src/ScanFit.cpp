@@ -0,0 +1,502 @@
+#include "ScanFit.h"
+#include "ScanAnalyzer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+static const int MAX_PARAMETERS = 8;           // 3D peak: amplitude, offset, 3 centers, 3 sigmas
+static const double FWHM_PER_SIGMA = 2.3548200450309493; // 2 sqrt(2 ln 2)
+static const size_t MIN_PEAK_AXIS_POSITIONS = 3;  // Distinct window positions needed to fit a peak axis
+
+double PassFit::fwhm() const {
+  return FWHM_PER_SIGMA * sigma;
+}
+
+double PeakFit::fwhm(int axis) const {
+  return FWHM_PER_SIGMA * sigma[axis];
+}
+
+// Cholesky solve of the n x n symmetric positive definite system a x = b; false if a is not positive definite
+static bool solveCholesky(int n, const double* a, const double* b, double* x) {
+  double l[MAX_PARAMETERS * MAX_PARAMETERS];
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j <= i; ++j) {
+      double sum = a[i * n + j];
+      for (int k = 0; k < j; ++k) sum -= l[i * n + k] * l[j * n + k];
+      if (i == j) {
+        if (!(sum > 0.0)) return false;
+        l[i * n + i] = std::sqrt(sum);
+      }
+      else {
+        l[i * n + j] = sum / l[j * n + j];
+      }
+    }
+  }
+  double y[MAX_PARAMETERS];
+  for (int i = 0; i < n; ++i) {
+    double sum = b[i];
+    for (int k = 0; k < i; ++k) sum -= l[i * n + k] * y[k];
+    y[i] = sum / l[i * n + i];
+  }
+  for (int i = n - 1; i >= 0; --i) {
+    double sum = y[i];
+    for (int k = i + 1; k < n; ++k) sum -= l[k * n + i] * x[k];
+    x[i] = sum / l[i * n + i];
+  }
+  return true;
+}
+
+// Samples per job when accumulating large fits (the peak window of a dense scan)
+static const size_t ACCUMULATE_GRAIN = 16384;
+
+// Sum of squared residuals over [first, last); with normal != nullptr also the lower triangle of J^T J and J^T r
+template <typename Model>
+static double accumulateRange(const Model& model, int n, const double* p, size_t first, size_t last,
+  double* normal, double* gradient) {
+  double g[MAX_PARAMETERS];
+  double cost = 0.0;
+  for (size_t i = first; i < last; ++i) {
+    double residual = model.target(i) - model.evaluate(i, p, normal ? g : nullptr);
+    cost += residual * residual;
+    if (!normal) continue;
+    for (int r = 0; r < n; ++r) {
+      gradient[r] += g[r] * residual;
+      for (int c = 0; c <= r; ++c) normal[r * n + c] += g[r] * g[c];
+    }
+  }
+  return cost;
+}
+
+// Sum of squared residuals; with normal != nullptr also J^T J and J^T r
+template <typename Model>
+static double accumulate(const Model& model, int n, const double* p, double* normal, double* gradient) {
+  if (normal) {
+    std::fill(normal, normal + n * n, 0.0);
+    std::fill(gradient, gradient + n, 0.0);
+  }
+  double cost = 0.0;
+  if (model.count <= ACCUMULATE_GRAIN) {
+    cost = accumulateRange(model, n, p, 0, model.count, normal, gradient);
+  }
+  else {
+    // Partial sums per block, added in block order so the result does not depend on scheduling
+    size_t blocks = (model.count + ACCUMULATE_GRAIN - 1) / ACCUMULATE_GRAIN;
+    const size_t stride = 1 + MAX_PARAMETERS + MAX_PARAMETERS * MAX_PARAMETERS;
+    std::vector<double> partial(blocks * stride, 0.0);
+    JobSystem::parallelFor(0, blocks, 1, [&](size_t firstBlock, size_t lastBlock) {
+      for (size_t block = firstBlock; block < lastBlock; ++block) {
+        double* sums = &partial[block * stride];
+        size_t first = block * ACCUMULATE_GRAIN;
+        size_t last = std::min(model.count, first + ACCUMULATE_GRAIN);
+        sums[0] = accumulateRange(model, n, p, first, last, normal ? sums + 1 + MAX_PARAMETERS : nullptr, sums + 1);
+      }
+    });
+    for (size_t block = 0; block < blocks; ++block) {
+      const double* sums = &partial[block * stride];
+      cost += sums[0];
+      if (!normal) continue;
+      for (int r = 0; r < n; ++r) {
+        gradient[r] += sums[1 + r];
+        for (int c = 0; c <= r; ++c) normal[r * n + c] += sums[1 + MAX_PARAMETERS + r * n + c];
+      }
+    }
+  }
+  if (normal) {
+    for (int r = 0; r < n; ++r) {
+      for (int c = r + 1; c < n; ++c) normal[r * n + c] = normal[c * n + r];
+    }
+  }
+  return cost;
+}
+
+// Levenberg-Marquardt with Marquardt's diagonal scaling. Each trial step evaluates the
+// normal equations along with its cost, so an accepted step needs no second pass.
+// On return normal holds J^T J at the solution (for standard errors) and cost the
+// final sum of squared residuals.
+template <typename Model>
+static bool levenbergMarquardt(const Model& model, int n, double* p, int maxIterations,
+  int& iterations, double& cost, double* normal) {
+  double gradient[MAX_PARAMETERS], damped[MAX_PARAMETERS * MAX_PARAMETERS];
+  double step[MAX_PARAMETERS], trial[MAX_PARAMETERS];
+  double trialNormal[MAX_PARAMETERS * MAX_PARAMETERS], trialGradient[MAX_PARAMETERS];
+  double lambda = 1e-3;
+  cost = accumulate(model, n, p, normal, gradient);
+  if (!std::isfinite(cost)) return false;
+
+  for (iterations = 0; iterations < maxIterations; ++iterations) {
+    bool accepted = false;
+    while (!accepted) {
+      std::copy(normal, normal + n * n, damped);
+      for (int k = 0; k < n; ++k) damped[k * n + k] += lambda * std::max(normal[k * n + k], 1e-300);
+      if (solveCholesky(n, damped, gradient, step)) {
+        for (int k = 0; k < n; ++k) trial[k] = p[k] + step[k];
+        double trialCost = accumulate(model, n, trial, trialNormal, trialGradient);
+        if (std::isfinite(trialCost) && trialCost <= cost) {
+          bool small = true;
+          for (int k = 0; k < n; ++k) small &= std::fabs(step[k]) <= 1e-9 * (std::fabs(p[k]) + 1e-12);
+          bool flat = cost - trialCost <= 1e-12 * cost;
+          std::copy(trial, trial + n, p);
+          std::copy(trialNormal, trialNormal + n * n, normal);
+          std::copy(trialGradient, trialGradient + n, gradient);
+          cost = trialCost;
+          if (small || flat) {
+            ++iterations;
+            return true;
+          }
+          lambda = std::max(lambda * 0.1, 1e-12);
+          accepted = true;
+          continue;
+        }
+      }
+      // No downhill step even with heavy damping: p is a minimum to working precision
+      lambda *= 10.0;
+      if (lambda > 1e12) return true;
+    }
+  }
+  return false;
+}
+
+struct Gaussian1DModel {
+  const float* t;
+  const float* values;
+  size_t count;
+
+  double target(size_t i) const { return values[i]; }
+
+  // p = amplitude, center, sigma, offset
+  double evaluate(size_t i, const double* p, double* g) const {
+    double z = (t[i] - p[1]) / p[2];
+    double e = std::exp(-0.5 * z * z);
+    if (g) {
+      g[0] = e;
+      g[1] = p[0] * e * z / p[2];
+      g[2] = p[0] * e * z * z / p[2];
+      g[3] = 1.0;
+    }
+    return p[0] * e + p[3];
+  }
+};
+
+// p = amplitude, offset, then center and sigma of each fitted axis
+struct GaussianPeakModel {
+  const std::vector<float>* positions;   // Interleaved xyz of the window points
+  const std::vector<float>* values;
+  size_t count;
+  int axes[3];
+  int axisCount;
+
+  double target(size_t i) const { return (*values)[i]; }
+
+  double evaluate(size_t i, const double* p, double* g) const {
+    double z[3], exponent = 0.0;
+    for (int a = 0; a < axisCount; ++a) {
+      z[a] = ((*positions)[i * 3 + axes[a]] - p[2 + a]) / p[2 + axisCount + a];
+      exponent += z[a] * z[a];
+    }
+    double e = std::exp(-0.5 * exponent);
+    if (g) {
+      g[0] = e;
+      g[1] = 1.0;
+      for (int a = 0; a < axisCount; ++a) {
+        double sigma = p[2 + axisCount + a];
+        g[2 + a] = p[0] * e * z[a] / sigma;
+        g[2 + axisCount + a] = p[0] * e * z[a] * z[a] / sigma;
+      }
+    }
+    return p[0] * e + p[1];
+  }
+};
+
+static double totalSumOfSquares(const float* values, size_t count) {
+  double mean = 0.0;
+  for (size_t i = 0; i < count; ++i) mean += values[i];
+  mean /= count;
+  double sum = 0.0;
+  for (size_t i = 0; i < count; ++i) sum += (values[i] - mean) * (values[i] - mean);
+  return sum;
+}
+
+bool ScanFit::fitGaussian1D(const float* t, const float* values, size_t count, int maxIterations, double minRSquared,
+  PassFit& fit) {
+  fit.converged = false;
+  if (count < 5) return false;
+
+  // Start at the highest sample with the half-maximum width around it
+  size_t top = 0;
+  float lowest = values[0];
+  for (size_t i = 1; i < count; ++i) {
+    if (values[i] > values[top]) top = i;
+    lowest = std::min(lowest, values[i]);
+  }
+  double halfMaximum = 0.5 * (values[top] + lowest);
+  size_t left = top, right = top;
+  while (left > 0 && values[left - 1] > halfMaximum) --left;
+  while (right + 1 < count && values[right + 1] > halfMaximum) ++right;
+  float tMin = *std::min_element(t, t + count);
+  float tMax = *std::max_element(t, t + count);
+  double width = std::fabs(t[right] - t[left]);
+  if (width <= 0.0) width = (tMax - tMin) * 0.1;
+  if (width <= 0.0) return false;
+
+  double p[4] = { values[top] - lowest, t[top], width / FWHM_PER_SIGMA, lowest };
+  double normal[16], cost = 0.0;
+  Gaussian1DModel model = { t, values, count };
+  bool converged = levenbergMarquardt(model, 4, p, maxIterations, fit.iterations, cost, normal);
+
+  fit.amplitude = p[0];
+  fit.center = p[1];
+  fit.sigma = std::fabs(p[2]);
+  fit.offset = p[3];
+  double total = totalSumOfSquares(values, count);
+  fit.rSquared = total > 0.0 ? 1.0 - cost / total : 0.0;
+
+  // Covariance of the center: residual variance times (J^T J)^-1
+  double unit[4] = { 0.0, 1.0, 0.0, 0.0 }, column[4];
+  bool centerKnown = solveCholesky(4, normal, unit, column);
+  fit.centerError = centerKnown ? std::sqrt(std::max(0.0, column[1] * cost / (count - 4))) : 0.0;
+
+  // Only a positive peak inside the sampled range counts as a profile, and only if it
+  // explains the pass and pins the center down to within the pass (noise fits do neither)
+  fit.converged = converged && fit.amplitude > 0.0 && fit.sigma > 0.0 && std::isfinite(fit.sigma) &&
+    fit.center >= tMin && fit.center <= tMax && fit.rSquared >= minRSquared &&
+    centerKnown && std::isfinite(fit.centerError) && fit.centerError <= tMax - tMin;
+  return fit.converged;
+}
+
+static int axisIndexOf(const std::string& axis) {
+  if (axis == "X" || axis == "x") return 0;
+  if (axis == "Y" || axis == "y") return 1;
+  if (axis == "Z" || axis == "z") return 2;
+  return -1;
+}
+
+// Runs of consecutive points with the same axis and direction
+void ScanFit::findPasses(const std::vector<ScanPoint>& points, std::vector<PassFit>& passes) {
+  size_t begin = 0;
+  for (size_t i = 1; i <= points.size(); ++i) {
+    if (i < points.size() && points[i].axis == points[begin].axis && points[i].direction == points[begin].direction) continue;
+    PassFit pass;
+    pass.axis = points[begin].axis;
+    pass.direction = points[begin].direction;
+    pass.firstPoint = begin;
+    pass.pointCount = i - begin;
+
+    // Unnamed axes fall back to the coordinate the pass moves along most
+    pass.axisIndex = axisIndexOf(pass.axis);
+    if (pass.axisIndex < 0) {
+      float extent[3] = { 0, 0, 0 };
+      for (int a = 0; a < 3; ++a) {
+        float low = std::numeric_limits<float>::infinity(), high = -low;
+        for (size_t k = begin; k < i; ++k) {
+          float c = a == 0 ? points[k].x : a == 1 ? points[k].y : points[k].z;
+          low = std::min(low, c);
+          high = std::max(high, c);
+        }
+        extent[a] = high - low;
+      }
+      pass.axisIndex = static_cast<int>(std::max_element(extent, extent + 3) - extent);
+    }
+    passes.push_back(pass);
+    begin = i;
+  }
+}
+
+static float coordinate(const ScanPoint& point, int axis) {
+  return axis == 0 ? point.x : axis == 1 ? point.y : point.z;
+}
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+static void fitPeak(const std::vector<ScanPoint>& points, const std::vector<PassFit>& passes,
+  const ScanFitOptions& options, PeakFit& peak) {
+  size_t top = points.size();
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (isInlier(points[i].value) && (top == points.size() || points[i].value > points[top].value)) top = i;
+  }
+  if (top == points.size()) return;
+  const ScanPoint& maximum = points[top];
+  peak.maxPosition[0] = maximum.x;
+  peak.maxPosition[1] = maximum.y;
+  peak.maxPosition[2] = maximum.z;
+  peak.maxValue = maximum.value;
+
+  // Starting width along each axis: the median of the converged passes on it, otherwise
+  // the reach of the points above half height (about 1.18 sigma for a Gaussian)
+  float lowest = maximum.value;
+  float low[3], high[3];
+  for (int a = 0; a < 3; ++a) {
+    low[a] = std::numeric_limits<float>::infinity();
+    high[a] = -low[a];
+  }
+  for (const ScanPoint& point : points) {
+    if (!isInlier(point.value)) continue;
+    lowest = std::min(lowest, point.value);
+    for (int a = 0; a < 3; ++a) {
+      low[a] = std::min(low[a], coordinate(point, a));
+      high[a] = std::max(high[a], coordinate(point, a));
+    }
+  }
+  double halfHeight = 0.5 * (maximum.value + lowest);
+  double reach[3] = { 0, 0, 0 };
+  for (const ScanPoint& point : points) {
+    if (!isInlier(point.value) || point.value < halfHeight) continue;
+    for (int a = 0; a < 3; ++a) reach[a] = std::max<double>(reach[a], std::fabs(coordinate(point, a) - coordinate(maximum, a)));
+  }
+
+  double sigma[3] = { 0, 0, 0 };
+  for (int a = 0; a < 3; ++a) {
+    if (!(high[a] > low[a])) continue;
+    std::vector<double> sigmas;
+    for (const PassFit& pass : passes) {
+      if (pass.converged && pass.axisIndex == a) sigmas.push_back(pass.sigma);
+    }
+    if (!sigmas.empty()) {
+      std::nth_element(sigmas.begin(), sigmas.begin() + sigmas.size() / 2, sigmas.end());
+      sigma[a] = sigmas[sigmas.size() / 2];
+    }
+    else {
+      sigma[a] = reach[a] > 0.0 ? 2.0 * reach[a] / FWHM_PER_SIGMA : (high[a] - low[a]) * 0.1;
+    }
+  }
+
+  std::vector<float> positions, values;
+  for (const ScanPoint& point : points) {
+    if (!isInlier(point.value)) continue;
+    bool inside = true;
+    for (int a = 0; a < 3 && inside; ++a) {
+      if (sigma[a] > 0.0) inside = std::fabs(coordinate(point, a) - coordinate(maximum, a)) <= options.peakWindowSigmas * sigma[a];
+    }
+    if (!inside) continue;
+    positions.push_back(point.x);
+    positions.push_back(point.y);
+    positions.push_back(point.z);
+    values.push_back(point.value);
+  }
+
+  // Fit the axes along which the window points take enough distinct positions to shape a peak
+  for (int a = 0; a < 3; ++a) {
+    if (!(sigma[a] > 0.0)) continue;
+    std::vector<float> coordinates(values.size());
+    for (size_t i = 0; i < values.size(); ++i) coordinates[i] = positions[i * 3 + a];
+    std::sort(coordinates.begin(), coordinates.end());
+    float tolerance = static_cast<float>(sigma[a] * 1e-3);
+    size_t distinct = coordinates.empty() ? 0 : 1;
+    for (size_t i = 1; i < coordinates.size(); ++i) {
+      if (coordinates[i] - coordinates[i - 1] > tolerance) distinct++;
+    }
+    peak.axisFitted[a] = distinct >= MIN_PEAK_AXIS_POSITIONS;
+  }
+
+  GaussianPeakModel model = { &positions, &values, values.size(), { 0, 0, 0 }, 0 };
+  for (int a = 0; a < 3; ++a) {
+    if (peak.axisFitted[a]) model.axes[model.axisCount++] = a;
+  }
+  int n = 2 + 2 * model.axisCount;
+  peak.pointCount = values.size();
+  if (model.axisCount == 0 || values.size() <= static_cast<size_t>(n)) return;
+
+  double p[MAX_PARAMETERS];
+  p[0] = maximum.value - lowest;
+  p[1] = lowest;
+  for (int a = 0; a < model.axisCount; ++a) {
+    p[2 + a] = coordinate(maximum, model.axes[a]);
+    p[2 + model.axisCount + a] = sigma[model.axes[a]];
+  }
+  double normal[MAX_PARAMETERS * MAX_PARAMETERS], cost = 0.0;
+  bool converged = levenbergMarquardt(model, n, p, options.maxIterations, peak.iterations, cost, normal);
+
+  peak.amplitude = p[0];
+  peak.offset = p[1];
+  for (int a = 0; a < 3; ++a) peak.center[a] = coordinate(maximum, a);
+  for (int a = 0; a < model.axisCount; ++a) {
+    peak.center[model.axes[a]] = p[2 + a];
+    peak.sigma[model.axes[a]] = std::fabs(p[2 + model.axisCount + a]);
+  }
+  double total = totalSumOfSquares(values.data(), values.size());
+  peak.rSquared = total > 0.0 ? 1.0 - cost / total : 0.0;
+  peak.converged = converged && peak.amplitude > 0.0 && peak.rSquared >= options.minPeakRSquared;
+}
+
+void ScanFit::fitScan(const std::vector<ScanPoint>& points, const ScanFitOptions& options, ScanFitResult& result) {
+  auto start = std::chrono::steady_clock::now();
+  result.passes.clear();
+  result.peak = PeakFit();
+  result.fitCount = 0;
+  findPasses(points, result.passes);
+
+  // Each pass is an independent job; the sample buffers are per chunk
+  JobSystem::parallelFor(0, result.passes.size(), 1, [&](size_t first, size_t last) {
+    std::vector<float> t, values;
+    for (size_t p = first; p < last; ++p) {
+      PassFit& pass = result.passes[p];
+      t.clear();
+      values.clear();
+      for (size_t i = pass.firstPoint; i < pass.firstPoint + pass.pointCount; ++i) {
+        if (!isInlier(points[i].value)) continue;
+        t.push_back(coordinate(points[i], pass.axisIndex));
+        values.push_back(points[i].value);
+      }
+      if (t.size() >= options.minPassPoints) fitGaussian1D(t.data(), values.data(), t.size(), options.maxIterations,
+        options.minPassRSquared, pass);
+    }
+  });
+
+  for (const PassFit& pass : result.passes) {
+    if (pass.pointCount >= options.minPassPoints) result.fitCount++;
+  }
+  auto passesDone = std::chrono::steady_clock::now();
+  fitPeak(points, result.passes, options, result.peak);
+  result.fitCount++;
+  result.ok = true;
+  auto end = std::chrono::steady_clock::now();
+  result.fitMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+  result.peakMilliseconds = std::chrono::duration<double, std::milli>(end - passesDone).count();
+}
+
+std::vector<ScanFitResult> ScanFit::fitFiles(const std::vector<std::string>& filePaths, float scaleFactor,
+  const ScanFitOptions& options) {
+  return ScanAnalyzer::analyzeEach<ScanFitResult>(filePaths, scaleFactor, [&](ParsedScan& scan, ScanFitResult& result) {
+    fitScan(scan.points, options, result);
+  });
+}
+
+void ScanFit::writePassCsv(std::ostream& out, const std::vector<ScanFitResult>& results) {
+  out << "file,pass,axis,direction,first_point,points,converged,iterations,center,center_error,sigma,fwhm,amplitude,offset,r_squared\n";
+  for (const ScanFitResult& result : results) {
+    for (size_t p = 0; p < result.passes.size(); ++p) {
+      const PassFit& pass = result.passes[p];
+      out << ScanAnalyzer::csvField(result.filePath) << "," << p << "," << ScanAnalyzer::csvField(pass.axis)
+        << "," << ScanAnalyzer::csvField(pass.direction)
+        << "," << pass.firstPoint << "," << pass.pointCount << "," << (pass.converged ? 1 : 0) << "," << pass.iterations
+        << "," << pass.center << "," << pass.centerError << "," << pass.sigma << "," << pass.fwhm()
+        << "," << pass.amplitude << "," << pass.offset << "," << pass.rSquared << "\n";
+    }
+  }
+}
+
+void ScanFit::writePeakCsv(std::ostream& out, const std::vector<ScanFitResult>& results) {
+  out << "file,ok,converged,iterations,points,center_x,center_y,center_z,sigma_x,sigma_y,sigma_z,"
+    "fwhm_x,fwhm_y,fwhm_z,amplitude,offset,r_squared,max_x,max_y,max_z,max_value,passes,fit_ms,error\n";
+  for (const ScanFitResult& result : results) {
+    const PeakFit& peak = result.peak;
+    out << ScanAnalyzer::csvField(result.filePath) << "," << (result.ok ? 1 : 0) << "," << (peak.converged ? 1 : 0)
+      << "," << peak.iterations << "," << peak.pointCount;
+    for (int a = 0; a < 3; ++a) out << "," << peak.center[a];
+    // Axes that were not fitted have no width
+    for (int a = 0; a < 3; ++a) {
+      out << ",";
+      if (peak.axisFitted[a]) out << peak.sigma[a];
+    }
+    for (int a = 0; a < 3; ++a) {
+      out << ",";
+      if (peak.axisFitted[a]) out << peak.fwhm(a);
+    }
+    out << "," << peak.amplitude << "," << peak.offset << "," << peak.rSquared
+      << "," << peak.maxPosition[0] << "," << peak.maxPosition[1] << "," << peak.maxPosition[2] << "," << peak.maxValue
+      << "," << result.passes.size() << "," << result.fitMilliseconds << "," << ScanAnalyzer::csvField(result.error) << "\n";
+  }
+}
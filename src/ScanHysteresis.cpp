@@ -0,0 +1,417 @@
+#include "ScanHysteresis.h"
+#include "ScanFit.h"
+#include "ScanAnalyzer.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <ctime>
+#include <utility>
+
+static const double PI = 3.14159265358979323846;
+
+// Pairs whose profiles correlate less than this (e.g. passes that missed the beam) stay out of the axis summaries
+static const double MIN_PAIR_CORRELATION = 0.5;
+
+// Resampling grid cap per pair; scans are far shorter than this
+static const size_t MAX_LAG_SAMPLES = 65536;
+
+// Welch segment length; shorter sequences use the largest power of two that fits
+static const size_t SPECTRUM_SEGMENT = 256;
+
+// Product without std::complex's operator*, which goes through the NaN/Inf-checking
+// library call when fast-math is off and dominated the transform
+static inline std::complex<double> multiply(const std::complex<double>& a, const std::complex<double>& b) {
+  return std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// In-place iterative radix-2 FFT; size must be a power of two. The inverse is unscaled.
+static void fft(std::vector<std::complex<double>>& data, bool inverse) {
+  size_t n = data.size();
+  for (size_t i = 1, j = 0; i < n; ++i) {
+    size_t bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(data[i], data[j]);
+  }
+  // Forward twiddles of the largest stage, kept per thread across calls of the same size;
+  // the stage of length L uses every (n / L)-th one
+  thread_local std::vector<std::complex<double>> twiddles;
+  if (twiddles.size() != n / 2) {
+    twiddles.resize(n / 2);
+    for (size_t k = 0; k < n / 2; ++k) {
+      double angle = -2.0 * PI * k / n;
+      twiddles[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+    }
+  }
+  for (size_t length = 2; length <= n; length <<= 1) {
+    size_t half = length / 2, stride = n / length;
+    for (size_t i = 0; i < n; i += length) {
+      for (size_t k = 0; k < half; ++k) {
+        std::complex<double> even = data[i + k];
+        const std::complex<double>& twiddle = twiddles[k * stride];
+        std::complex<double> odd = multiply(data[i + k + half], inverse ? std::conj(twiddle) : twiddle);
+        data[i + k] = even + odd;
+        data[i + k + half] = even - odd;
+      }
+    }
+  }
+}
+
+// Spectra of two real sequences packed as the real and imaginary parts of one transform
+static inline void splitRealSpectra(const std::vector<std::complex<double>>& packed, size_t k,
+  std::complex<double>& first, std::complex<double>& second) {
+  std::complex<double> a = packed[k];
+  std::complex<double> b = std::conj(packed[(packed.size() - k) % packed.size()]);
+  first = 0.5 * (a + b);
+  second = std::complex<double>(0.5 * (a.imag() - b.imag()), -0.5 * (a.real() - b.real()));
+}
+
+static size_t nextPowerOfTwo(size_t n) {
+  size_t power = 1;
+  while (power < n) power <<= 1;
+  return power;
+}
+
+// (t, value) samples sorted by t
+static void sortSamples(const float* t, const float* values, size_t count, std::vector<std::pair<float, float>>& out) {
+  out.clear();
+  for (size_t i = 0; i < count; ++i) {
+    if (values[i] > -VerticesLoader::VALUE_OUTLIER_LIMIT && values[i] < VerticesLoader::VALUE_OUTLIER_LIMIT) {
+      out.emplace_back(t[i], values[i]);
+    }
+  }
+  std::sort(out.begin(), out.end());
+}
+
+static double medianSpacing(const std::vector<std::pair<float, float>>& samples) {
+  std::vector<double> gaps;
+  for (size_t i = 1; i < samples.size(); ++i) {
+    double gap = samples[i].first - samples[i - 1].first;
+    if (gap > 0.0) gaps.push_back(gap);
+  }
+  if (gaps.empty()) return 0.0;
+  std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+  return gaps[gaps.size() / 2];
+}
+
+// Linear interpolation of the sorted samples at t0 + i * step
+static void resample(const std::vector<std::pair<float, float>>& samples, double t0, double step, size_t count, std::vector<double>& out) {
+  out.resize(count);
+  size_t j = 0;
+  for (size_t i = 0; i < count; ++i) {
+    double t = t0 + i * step;
+    while (j + 2 < samples.size() && samples[j + 1].first < t) ++j;
+    const auto& a = samples[j];
+    const auto& b = samples[std::min(j + 1, samples.size() - 1)];
+    double span = b.first - a.first;
+    double f = span > 0.0 ? std::min(1.0, std::max(0.0, (t - a.first) / span)) : 0.0;
+    out[i] = a.second + f * (b.second - a.second);
+  }
+}
+
+// Mean of the outer 5% at both ends of the profile
+static double edgeLevel(const std::vector<double>& profile) {
+  size_t edge = std::max<size_t>(1, profile.size() / 20);
+  double sum = 0.0;
+  for (size_t i = 0; i < edge; ++i) sum += profile[i] + profile[profile.size() - 1 - i];
+  return sum / (2 * edge);
+}
+
+bool ScanHysteresis::estimateLag(const float* tA, const float* valuesA, size_t countA,
+  const float* tB, const float* valuesB, size_t countB, PassPairLag& out) {
+  std::vector<std::pair<float, float>> a, b;
+  sortSamples(tA, valuesA, countA, a);
+  sortSamples(tB, valuesB, countB, b);
+  if (a.size() < 8 || b.size() < 8) return false;
+
+  double step = std::min(medianSpacing(a), medianSpacing(b));
+  double low = std::max(a.front().first, b.front().first);
+  double high = std::min(a.back().first, b.back().first);
+  if (!(step > 0.0) || high <= low) return false;
+  size_t n = static_cast<size_t>((high - low) / step) + 1;
+  if (n > MAX_LAG_SAMPLES) {
+    n = MAX_LAG_SAMPLES;
+    step = (high - low) / (n - 1);
+  }
+  if (n < 8) return false;
+
+  std::vector<double> x, y;
+  resample(a, low, step, n, x);
+  resample(b, low, step, n, y);
+  double range = *std::max_element(x.begin(), x.end()) - *std::min_element(x.begin(), x.end());
+  // Subtract the edge level rather than the mean: a non-zero baseline puts a cusp at zero lag
+  // (one baseline product drops out of the overlap per step) that pulls the refinement to whole samples
+  double baseX = edgeLevel(x), baseY = edgeLevel(y);
+  double energyX = 0.0, energyY = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    x[i] -= baseX;
+    y[i] -= baseY;
+    energyX += x[i] * x[i];
+    energyY += y[i] * y[i];
+  }
+  if (!(energyX > 0.0 && energyY > 0.0)) return false;
+
+  // r[k] = sum_i x[i] y[i + k] = IFFT(conj(X) Y), zero-padded so no lag wraps around
+  size_t m = nextPowerOfTwo(2 * n);
+  std::vector<std::complex<double>> packed(m), product(m);
+  for (size_t i = 0; i < n; ++i) packed[i] = std::complex<double>(x[i], y[i]);
+  fft(packed, false);
+  for (size_t k = 0; k < m; ++k) {
+    std::complex<double> fx, fy;
+    splitRealSpectra(packed, k, fx, fy);
+    product[k] = multiply(std::conj(fx), fy);
+  }
+  fft(product, true);
+  auto correlationAt = [&](long k) { return product[static_cast<size_t>((k + static_cast<long>(m)) % static_cast<long>(m))].real() / m; };
+
+  // Lags up to half the overlap; beyond that too little of the profiles overlaps
+  long maxLag = static_cast<long>(n / 2);
+  long best = 0;
+  for (long k = -maxLag; k <= maxLag; ++k) {
+    if (correlationAt(k) > correlationAt(best)) best = k;
+  }
+  double y0 = correlationAt(best - 1), y1 = correlationAt(best), y2 = correlationAt(best + 1);
+  double curvature = y0 - 2.0 * y1 + y2;
+  double delta = curvature < 0.0 ? std::max(-0.5, std::min(0.5, 0.5 * (y0 - y2) / curvature)) : 0.0;
+  double shift = best + delta;
+
+  out.lag = shift * step;
+  out.correlation = y1 / std::sqrt(energyX * energyY);
+  out.samples = n;
+  out.step = step;
+
+  // Mismatch left once B is shifted back by the lag
+  double sum = 0.0;
+  size_t used = 0;
+  for (size_t i = 0; i < n; ++i) {
+    double position = i + shift;
+    if (position < 0.0 || position > n - 1) continue;
+    size_t j = std::min(static_cast<size_t>(position), n - 2);
+    double f = position - j;
+    double shifted = y[j] + f * (y[j + 1] - y[j]);
+    sum += (x[i] - shifted) * (x[i] - shifted);
+    used++;
+  }
+  out.residual = used > 0 && range > 0.0 ? std::sqrt(sum / used) / range : 0.0;
+  return true;
+}
+
+void ScanHysteresis::computeSpectrum(const float* values, size_t count, double sampleInterval, NoiseSpectrum& out) {
+  out = NoiseSpectrum();
+  size_t length = SPECTRUM_SEGMENT;
+  while (length > count) length >>= 1;
+  if (length < 16) return;
+
+  size_t hop = length / 2;
+  size_t segments = (count - length) / hop + 1;
+  double sampleRate = sampleInterval > 0.0 ? 1.0 / sampleInterval : 1.0;
+  std::vector<double> window(length), accumulated(length / 2 + 1, 0.0);
+  double windowEnergy = 0.0;
+  for (size_t i = 0; i < length; ++i) {
+    window[i] = 0.5 - 0.5 * std::cos(2.0 * PI * i / length);
+    windowEnergy += window[i] * window[i];
+  }
+
+  // Hann-windowed segments with 50% overlap, each with its linear trend removed
+  std::vector<std::complex<double>> buffer(length);
+  double meanIndex = 0.5 * (length - 1);
+  double indexVariance = 0.0;
+  for (size_t i = 0; i < length; ++i) indexVariance += (i - meanIndex) * (i - meanIndex);
+  auto prepare = [&](size_t s, std::vector<double>& prepared) {
+    const float* segment = values + s * hop;
+    double mean = 0.0, slope = 0.0;
+    for (size_t i = 0; i < length; ++i) mean += segment[i];
+    mean /= length;
+    for (size_t i = 0; i < length; ++i) slope += (i - meanIndex) * (segment[i] - mean);
+    slope /= indexVariance;
+    for (size_t i = 0; i < length; ++i) prepared[i] = (segment[i] - mean - slope * (i - meanIndex)) * window[i];
+  };
+  // Two segments per transform (real and imaginary part)
+  std::vector<double> first(length), second(length, 0.0);
+  for (size_t s = 0; s < segments; s += 2) {
+    prepare(s, first);
+    if (s + 1 < segments) prepare(s + 1, second);
+    else std::fill(second.begin(), second.end(), 0.0);
+    for (size_t i = 0; i < length; ++i) buffer[i] = std::complex<double>(first[i], second[i]);
+    fft(buffer, false);
+    for (size_t k = 0; k <= length / 2; ++k) {
+      std::complex<double> a, b;
+      splitRealSpectra(buffer, k, a, b);
+      accumulated[k] += std::norm(a) + std::norm(b);
+    }
+  }
+
+  out.power.resize(length / 2 + 1);
+  for (size_t k = 0; k <= length / 2; ++k) {
+    double oneSided = (k == 0 || k == length / 2) ? 1.0 : 2.0;
+    out.power[k] = static_cast<float>(oneSided * accumulated[k] / segments / (sampleRate * windowEnergy));
+  }
+  out.binWidth = sampleRate / length;
+  out.inHertz = sampleInterval > 0.0;
+  out.segmentLength = length;
+  out.segmentCount = segments;
+
+  std::vector<float> upper(out.power.begin() + length / 4, out.power.end());
+  std::nth_element(upper.begin(), upper.begin() + upper.size() / 2, upper.end());
+  out.noiseFloor = upper[upper.size() / 2];
+  out.noiseRms = std::sqrt(out.noiseFloor * sampleRate / 2.0);
+  size_t peak = std::max_element(out.power.begin() + 4, out.power.end()) - out.power.begin();
+  out.peakFrequency = peak * out.binWidth;
+}
+
+static float coordinate(const ScanPoint& point, int axis) {
+  return axis == 0 ? point.x : axis == 1 ? point.y : point.z;
+}
+
+// Direction names come from file data, so case varies between writers
+static bool isReverse(const std::string& direction) {
+  static const char NEGATIVE[] = "negative";
+  if (direction.size() != sizeof(NEGATIVE) - 1) return false;
+  for (size_t i = 0; i < direction.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(direction[i])) != NEGATIVE[i]) return false;
+  }
+  return true;
+}
+
+void ScanHysteresis::analyze(const std::vector<ScanPoint>& points, HysteresisResult& out) {
+  auto start = std::chrono::steady_clock::now();
+  out.pairs.clear();
+  out.axes.clear();
+  std::vector<PassFit> passes;
+  ScanFit::findPasses(points, passes);
+
+  // Each pass pairs with the next unpaired pass on the same axis in the other direction
+  std::vector<bool> paired(passes.size(), false);
+  std::vector<bool> reversed(passes.size());
+  for (size_t i = 0; i < passes.size(); ++i) reversed[i] = isReverse(passes[i].direction);
+  std::vector<PassPairLag> candidates;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    if (paired[i]) continue;
+    for (size_t j = i + 1; j < passes.size(); ++j) {
+      if (paired[j] || passes[j].axisIndex != passes[i].axisIndex || reversed[j] == reversed[i]) continue;
+      paired[i] = paired[j] = true;
+      PassPairLag pair;
+      pair.axis = passes[i].axis;
+      pair.axisIndex = passes[i].axisIndex;
+      pair.forwardPass = reversed[i] ? j : i;
+      pair.reversePass = reversed[i] ? i : j;
+      candidates.push_back(pair);
+      break;
+    }
+  }
+
+  // Pairs are independent; long multi-pass scans estimate them as jobs
+  std::vector<char> estimated(candidates.size(), 0);
+  JobSystem::parallelFor(0, candidates.size(), 16, [&](size_t first, size_t last) {
+    std::vector<float> tA, vA, tB, vB;
+    for (size_t c = first; c < last; ++c) {
+      PassPairLag& pair = candidates[c];
+      const PassFit& forward = passes[pair.forwardPass];
+      const PassFit& reverse = passes[pair.reversePass];
+      tA.clear(); vA.clear(); tB.clear(); vB.clear();
+      for (size_t k = forward.firstPoint; k < forward.firstPoint + forward.pointCount; ++k) {
+        tA.push_back(coordinate(points[k], pair.axisIndex));
+        vA.push_back(points[k].value);
+      }
+      for (size_t k = reverse.firstPoint; k < reverse.firstPoint + reverse.pointCount; ++k) {
+        tB.push_back(coordinate(points[k], pair.axisIndex));
+        vB.push_back(points[k].value);
+      }
+      estimated[c] = estimateLag(tA.data(), vA.data(), tA.size(), tB.data(), vB.data(), tB.size(), pair);
+    }
+  });
+  for (size_t c = 0; c < candidates.size(); ++c) {
+    if (estimated[c]) out.pairs.push_back(candidates[c]);
+  }
+
+  for (int axis = 0; axis < 3; ++axis) {
+    std::vector<const PassPairLag*> reliable;
+    for (const PassPairLag& pair : out.pairs) {
+      if (pair.axisIndex == axis && pair.correlation >= MIN_PAIR_CORRELATION) reliable.push_back(&pair);
+    }
+    if (reliable.empty()) continue;
+    AxisHysteresis summary;
+    summary.axis = reliable[0]->axis;
+    summary.axisIndex = axis;
+    summary.pairCount = reliable.size();
+    std::vector<double> magnitudes;
+    for (const PassPairLag* pair : reliable) {
+      summary.meanLag += pair->lag;
+      summary.hysteresis += pair->residual;
+      magnitudes.push_back(std::fabs(pair->lag));
+    }
+    summary.meanLag /= reliable.size();
+    summary.hysteresis /= reliable.size();
+    for (const PassPairLag* pair : reliable) summary.lagStdDev += (pair->lag - summary.meanLag) * (pair->lag - summary.meanLag);
+    summary.lagStdDev = reliable.size() > 1 ? std::sqrt(summary.lagStdDev / (reliable.size() - 1)) : 0.0;
+    std::nth_element(magnitudes.begin(), magnitudes.begin() + magnitudes.size() / 2, magnitudes.end());
+    summary.backlash = magnitudes[magnitudes.size() / 2];
+    out.axes.push_back(summary);
+  }
+
+  // Value sequence in acquisition order; real time axis when every point is timestamped
+  std::vector<float> sequence;
+  std::vector<double> intervals;
+  bool timed = !points.empty();
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (points[i].value > -VerticesLoader::VALUE_OUTLIER_LIMIT && points[i].value < VerticesLoader::VALUE_OUTLIER_LIMIT) {
+      sequence.push_back(points[i].value);
+    }
+    timed &= points[i].time >= 0.0f;
+    if (timed && i > 0 && points[i].time > points[i - 1].time) intervals.push_back(points[i].time - points[i - 1].time);
+  }
+  double interval = 0.0;
+  if (timed && !intervals.empty()) {
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    interval = intervals[intervals.size() / 2];
+  }
+  computeSpectrum(sequence.data(), sequence.size(), interval, out.spectrum);
+
+  out.ok = true;
+  out.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<HysteresisResult> ScanHysteresis::analyzeFiles(const std::vector<std::string>& filePaths, float scaleFactor) {
+  return ScanAnalyzer::analyzeEach<HysteresisResult>(filePaths, scaleFactor, [](ParsedScan& scan, HysteresisResult& result) {
+    if (scan.header.hasTimestamps) result.startTime = scan.header.startTime;
+    analyze(scan.points, result);
+  });
+}
+
+void ScanHysteresis::writeCsv(std::ostream& out, const std::vector<HysteresisResult>& results) {
+  const char* axisNames[3] = { "x", "y", "z" };
+  out << "file,ok,start_time";
+  for (const char* axis : axisNames) {
+    out << "," << axis << "_pairs," << axis << "_mean_lag," << axis << "_lag_sd," << axis << "_backlash," << axis << "_hysteresis";
+  }
+  out << ",noise_rms,noise_floor,noise_peak_frequency,frequency_unit,ms,error\n";
+
+  for (const HysteresisResult& result : results) {
+    char date[32] = "";
+    if (result.startTime > 0.0) {
+      std::time_t time = static_cast<std::time_t>(result.startTime);
+      std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::gmtime(&time));
+    }
+    out << ScanAnalyzer::csvField(result.filePath) << "," << (result.ok ? 1 : 0) << "," << date;
+    for (int axis = 0; axis < 3; ++axis) {
+      const AxisHysteresis* summary = nullptr;
+      for (const AxisHysteresis& candidate : result.axes) {
+        if (candidate.axisIndex == axis) summary = &candidate;
+      }
+      if (summary) {
+        out << "," << summary->pairCount << "," << summary->meanLag << "," << summary->lagStdDev
+          << "," << summary->backlash << "," << summary->hysteresis;
+      }
+      else {
+        out << ",0,,,,";
+      }
+    }
+    const NoiseSpectrum& spectrum = result.spectrum;
+    out << "," << spectrum.noiseRms << "," << spectrum.noiseFloor << "," << spectrum.peakFrequency
+      << "," << (spectrum.inHertz ? "Hz" : "cycles/sample") << "," << result.milliseconds
+      << "," << ScanAnalyzer::csvField(result.error) << "\n";
+  }
+}
@@ -0,0 +1,229 @@
+#include "ScanParser.h"
+#include "ScanDiscovery.h"
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <filesystem>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#define SCAN_PARSER_POSIX 1
+#else
+#define SCAN_PARSER_POSIX 0
+#endif
+
+static bool isJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool ScanParser::readFile(const std::string& filePath, std::string& content) {
+  std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) return false;
+
+  std::streamsize size = file.tellg();
+  if (size < 0) return false;
+  file.seekg(0, std::ios::beg);
+
+  content.resize(static_cast<size_t>(size));
+  if (size > 0 && !file.read(&content[0], size)) return false;
+  return true;
+}
+
+bool ScanParser::getFileSignature(const std::string& filePath, uint64_t& bytes, int64_t& modifiedTime) {
+#if SCAN_PARSER_POSIX
+  // One stat call instead of the two std::filesystem needs
+  struct stat info;
+  if (stat(filePath.c_str(), &info) != 0) return false;
+  bytes = static_cast<uint64_t>(info.st_size);
+  modifiedTime = static_cast<int64_t>(info.st_mtime);
+  return true;
+#else
+  std::error_code ec;
+  bytes = std::filesystem::file_size(filePath, ec);
+  if (ec) return false;
+  auto time = std::filesystem::last_write_time(filePath, ec);
+  if (ec) return false;
+  modifiedTime = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+  return true;
+#endif
+}
+
+// Index of the bracket closing the one at open, skipping string literals; npos if unbalanced
+size_t ScanParser::findMatching(const std::string& content, size_t open, size_t limit) {
+  char openChar = content[open];
+  char closeChar = openChar == '{' ? '}' : ']';
+  int depth = 0;
+  bool inString = false;
+
+  for (size_t i = open; i < limit; ++i) {
+    char c = content[i];
+    if (inString) {
+      if (c == '\\') i++;
+      else if (c == '"') inString = false;
+      continue;
+    }
+    if (c == '"') inString = true;
+    else if (c == openChar) depth++;
+    else if (c == closeChar && --depth == 0) return i;
+  }
+  return std::string::npos;
+}
+
+// Position just past the colon of "key": within [begin, end); npos if absent
+size_t ScanParser::findKey(const std::string& content, const char* key, size_t begin, size_t end) {
+  size_t keyLength = std::strlen(key);
+  size_t pos = begin;
+  while (true) {
+    pos = content.find(key, pos);
+    if (pos == std::string::npos || pos + keyLength > end) return std::string::npos;
+
+    size_t colon = pos + keyLength;
+    while (colon < end && isJsonSpace(content[colon])) colon++;
+    if (colon < end && content[colon] == ':') return colon + 1;
+    pos += keyLength;
+  }
+}
+
+bool ScanParser::readNumber(const std::string& content, const char* key, size_t begin, size_t end, float& out) {
+  size_t pos = findKey(content, key, begin, end);
+  if (pos == std::string::npos) return false;
+
+  const char* start = content.c_str() + pos;
+  char* stop = nullptr;
+  float value = std::strtof(start, &stop);
+  if (stop == start) return false;
+  out = value;
+  return true;
+}
+
+bool ScanParser::readString(const std::string& content, const char* key, size_t begin, size_t end, std::string& out) {
+  size_t pos = findKey(content, key, begin, end);
+  if (pos == std::string::npos) return false;
+
+  while (pos < end && isJsonSpace(content[pos])) pos++;
+  if (pos >= end || content[pos] != '"') return false;
+
+  size_t stringEnd = content.find('"', pos + 1);
+  if (stringEnd == std::string::npos || stringEnd >= end) return false;
+  out.assign(content, pos + 1, stringEnd - pos - 1);
+  return true;
+}
+
+// ISO 8601 "2025-06-12T14:30:00.010" (UTC, any zone suffix ignored) in seconds since 1970
+bool ScanParser::readTimestamp(const std::string& content, const char* key, size_t begin, size_t end, double& seconds) {
+  std::string text;
+  if (!readString(content, key, begin, end, text)) return false;
+
+  int64_t wholeSeconds = 0;
+  if (text.size() < 19 || !ScanDiscovery::parseFileNameTimestamp(text.substr(0, 19), wholeSeconds)) return false;
+
+  double fraction = 0.0;
+  if (text.size() > 20 && text[19] == '.') {
+    double scale = 0.1;
+    for (size_t i = 20; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i, scale *= 0.1) {
+      fraction += (text[i] - '0') * scale;
+    }
+  }
+  seconds = static_cast<double>(wholeSeconds) + fraction;
+  return true;
+}
+
+bool ScanParser::readBool(const std::string& content, const char* key, size_t begin, size_t end, bool& out) {
+  size_t pos = findKey(content, key, begin, end);
+  if (pos == std::string::npos) return false;
+
+  while (pos < end && isJsonSpace(content[pos])) pos++;
+  out = content.compare(pos, 4, "true") == 0;
+  return true;
+}
+
+bool ScanParser::readPosition(const std::string& content, size_t begin, size_t end, float& x, float& y, float& z) {
+  size_t pos = findKey(content, "\"position\"", begin, end);
+  if (pos == std::string::npos) return false;
+
+  size_t open = content.find('{', pos);
+  if (open == std::string::npos || open >= end) return false;
+  size_t close = findMatching(content, open, end);
+  if (close == std::string::npos) return false;
+
+  return readNumber(content, "\"x\"", open, close, x) &&
+    readNumber(content, "\"y\"", open, close, y) &&
+    readNumber(content, "\"z\"", open, close, z);
+}
+
+bool ScanParser::parse(const std::string& content, float scaleFactor, std::vector<ScanPoint>& points, ScanFileHeader& header) {
+  header = ScanFileHeader();
+
+  // Baseline: the reference position the measurements are made relative to
+  size_t baselinePos = findKey(content, "\"baseline\"", 0, content.size());
+  if (baselinePos != std::string::npos) {
+    size_t open = content.find('{', baselinePos);
+    size_t close = open == std::string::npos ? std::string::npos : findMatching(content, open, content.size());
+    if (close != std::string::npos) {
+      readPosition(content, open, close, header.baselineX, header.baselineY, header.baselineZ);
+      readNumber(content, "\"value\"", open, close, header.baselineValue);
+    }
+  }
+
+  size_t measurementsPos = findKey(content, "\"measurements\"", 0, content.size());
+  if (measurementsPos == std::string::npos) return false;
+  size_t arrayStart = content.find('[', measurementsPos);
+  if (arrayStart == std::string::npos) return false;
+  size_t arrayEnd = findMatching(content, arrayStart, content.size());
+  if (arrayEnd == std::string::npos) arrayEnd = content.size(); // Truncated file: keep what is complete
+
+  size_t pos = arrayStart + 1;
+  size_t measurementCount = 0;
+  bool allTimestamped = true;
+  while (true) {
+    size_t objectStart = content.find('{', pos);
+    if (objectStart == std::string::npos || objectStart >= arrayEnd) break;
+    size_t objectEnd = findMatching(content, objectStart, arrayEnd);
+    if (objectEnd == std::string::npos) break;
+
+    ScanPoint point;
+    float rawX = 0.0f, rawY = 0.0f, rawZ = 0.0f;
+    readPosition(content, objectStart, objectEnd, rawX, rawY, rawZ);
+
+    point.x = (rawX - header.baselineX) * scaleFactor;
+    point.y = (rawY - header.baselineY) * scaleFactor;
+    point.z = (rawZ - header.baselineZ) * scaleFactor;
+
+    point.value = 0.0f;
+    readNumber(content, "\"value\"", objectStart, objectEnd, point.value);
+    readBool(content, "\"isPeak\"", objectStart, objectEnd, point.isPeak);
+    readString(content, "\"axis\"", objectStart, objectEnd, point.axis);
+    readString(content, "\"direction\"", objectStart, objectEnd, point.direction);
+
+    // Times are kept relative to the first measurement so float holds millisecond precision
+    double seconds = 0.0;
+    if (allTimestamped && readTimestamp(content, "\"timestamp\"", objectStart, objectEnd, seconds)) {
+      if (measurementCount == 0) header.startTime = seconds;
+      point.time = static_cast<float>(seconds - header.startTime);
+    }
+    else {
+      allTimestamped = false;
+    }
+    measurementCount++;
+
+    points.push_back(point);
+    pos = objectEnd + 1;
+  }
+
+  header.hasTimestamps = allTimestamped && measurementCount > 0;
+
+  // Optional summary block written by the acquisition software
+  size_t statsPos = findKey(content, "\"statistics\"", arrayEnd, content.size());
+  if (statsPos != std::string::npos) {
+    size_t open = content.find('{', statsPos);
+    size_t close = open == std::string::npos ? std::string::npos : findMatching(content, open, content.size());
+    if (close != std::string::npos &&
+      readNumber(content, "\"minValue\"", open, close, header.statisticsMinValue) &&
+      readNumber(content, "\"maxValue\"", open, close, header.statisticsMaxValue)) {
+      header.hasStatistics = true;
+    }
+  }
+
+  return true;
+}
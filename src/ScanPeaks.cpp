@@ -0,0 +1,423 @@
+#include "ScanPeaks.h"
+#include "VerticesLoader.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+// Cell coordinates are packed 21 bits per axis, x lowest, so the cells of one
+// (y, z) row with consecutive x have consecutive keys
+static const int CELL_BITS = 21;
+static const int64_t CELL_MASK = (int64_t(1) << CELL_BITS) - 1;
+
+// Cells per job; cells differ a lot in occupancy, so chunks are kept small
+static const size_t CELL_GRAIN = 256;
+
+// Cells of edge epsilon / sqrt(3) within epsilon of each other are at most two apart
+static const int NEIGHBOUR_REACH = 2;
+
+static uint64_t packCell(int64_t x, int64_t y, int64_t z) {
+  return (static_cast<uint64_t>(z) << (2 * CELL_BITS)) | (static_cast<uint64_t>(y) << CELL_BITS) | static_cast<uint64_t>(x);
+}
+
+// Candidate points bucketed into occupied cells (sorted keys, CSR point lists)
+struct PeakGrid {
+  float origin[3] = { 0, 0, 0 };
+  float cellSize = 1.0f;
+  std::vector<uint64_t> cellKeys;
+  std::vector<uint32_t> cellStart;   // cellKeys.size() + 1 offsets into slots
+  std::vector<uint32_t> slots;       // Point indices in cell order
+  std::vector<uint32_t> neighbourStart;  // CSR lists of the occupied cells within NEIGHBOUR_REACH
+  std::vector<uint32_t> neighbours;
+
+  size_t cellCount() const { return cellKeys.size(); }
+
+  // Call fn(neighbourCell) for every occupied cell within reach cells of cell; fn returns false to stop
+  template <typename Fn>
+  bool forEachNeighbour(size_t cell, int reach, Fn&& fn) const {
+    if (reach == NEIGHBOUR_REACH && !neighbourStart.empty()) {
+      for (uint32_t n = neighbourStart[cell]; n < neighbourStart[cell + 1]; ++n) {
+        if (!fn(static_cast<size_t>(neighbours[n]))) return false;
+      }
+      return true;
+    }
+    uint64_t key = cellKeys[cell];
+    int64_t x = static_cast<int64_t>(key & CELL_MASK);
+    int64_t y = static_cast<int64_t>((key >> CELL_BITS) & CELL_MASK);
+    int64_t z = static_cast<int64_t>(key >> (2 * CELL_BITS));
+    for (int64_t dz = -reach; dz <= reach; ++dz) {
+      int64_t zz = z + dz;
+      if (zz < 0 || zz > CELL_MASK) continue;
+      for (int64_t dy = -reach; dy <= reach; ++dy) {
+        int64_t yy = y + dy;
+        if (yy < 0 || yy > CELL_MASK) continue;
+        // One binary search per row of cells
+        uint64_t low = packCell(std::max<int64_t>(x - reach, 0), yy, zz);
+        uint64_t high = packCell(std::min<int64_t>(x + reach, CELL_MASK), yy, zz);
+        auto it = std::lower_bound(cellKeys.begin(), cellKeys.end(), low);
+        for (; it != cellKeys.end() && *it <= high; ++it) {
+          if (!fn(static_cast<size_t>(it - cellKeys.begin()))) return false;
+        }
+      }
+    }
+    return true;
+  }
+};
+
+static void buildGrid(const float* positions, const std::vector<uint32_t>& candidates, float cellSize, PeakGrid& grid) {
+  float low[3] = { std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity() };
+  for (uint32_t index : candidates) {
+    for (int a = 0; a < 3; ++a) low[a] = std::min(low[a], positions[index * 3 + a]);
+  }
+  std::copy(low, low + 3, grid.origin);
+  grid.cellSize = cellSize;
+
+  std::vector<std::pair<uint64_t, uint32_t>> keyed(candidates.size());
+  JobSystem::parallelFor(0, candidates.size(), 65536, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const float* p = &positions[candidates[i] * 3];
+      int64_t c[3];
+      for (int a = 0; a < 3; ++a) {
+        c[a] = std::min<int64_t>(static_cast<int64_t>((p[a] - grid.origin[a]) / cellSize), CELL_MASK);
+      }
+      keyed[i] = std::make_pair(packCell(c[0], c[1], c[2]), candidates[i]);
+    }
+  });
+  std::sort(keyed.begin(), keyed.end());
+
+  grid.cellKeys.clear();
+  grid.cellStart.clear();
+  grid.slots.resize(keyed.size());
+  for (size_t i = 0; i < keyed.size(); ++i) {
+    if (i == 0 || keyed[i].first != keyed[i - 1].first) {
+      grid.cellKeys.push_back(keyed[i].first);
+      grid.cellStart.push_back(static_cast<uint32_t>(i));
+    }
+    grid.slots[i] = keyed[i].second;
+  }
+  grid.cellStart.push_back(static_cast<uint32_t>(keyed.size()));
+}
+
+// Neighbour lists for NEIGHBOUR_REACH, built once and shared by every pass over the cells.
+// For a fixed row offset the first key to look for grows with the cell key, so each of
+// the 25 rows keeps a cursor that only moves forward instead of binary searching per cell.
+static void buildNeighbours(PeakGrid& grid) {
+  const int rows = (2 * NEIGHBOUR_REACH + 1) * (2 * NEIGHBOUR_REACH + 1);
+  size_t cellCount = grid.cellCount();
+  std::vector<uint32_t> counts(cellCount + 1, 0);
+  std::mutex chunkMutex;
+  std::vector<std::pair<size_t, std::vector<uint32_t>>> chunks;
+
+  JobSystem::parallelFor(0, cellCount, 4096, [&](size_t first, size_t last) {
+    std::vector<uint32_t> list;
+    size_t cursor[rows];
+    bool rowStarted[rows] = {};
+    for (size_t cell = first; cell < last; ++cell) {
+      uint64_t key = grid.cellKeys[cell];
+      int64_t x = static_cast<int64_t>(key & CELL_MASK);
+      int64_t y = static_cast<int64_t>((key >> CELL_BITS) & CELL_MASK);
+      int64_t z = static_cast<int64_t>(key >> (2 * CELL_BITS));
+      size_t before = list.size();
+      int row = 0;
+      for (int64_t dz = -NEIGHBOUR_REACH; dz <= NEIGHBOUR_REACH; ++dz) {
+        for (int64_t dy = -NEIGHBOUR_REACH; dy <= NEIGHBOUR_REACH; ++dy, ++row) {
+          int64_t yy = y + dy, zz = z + dz;
+          if (yy < 0 || yy > CELL_MASK || zz < 0 || zz > CELL_MASK) continue;
+          uint64_t low = packCell(std::max<int64_t>(x - NEIGHBOUR_REACH, 0), yy, zz);
+          uint64_t high = packCell(std::min<int64_t>(x + NEIGHBOUR_REACH, CELL_MASK), yy, zz);
+          size_t& c = cursor[row];
+          if (!rowStarted[row]) {
+            c = std::lower_bound(grid.cellKeys.begin(), grid.cellKeys.end(), low) - grid.cellKeys.begin();
+            rowStarted[row] = true;
+          }
+          while (c < cellCount && grid.cellKeys[c] < low) ++c;
+          for (size_t n = c; n < cellCount && grid.cellKeys[n] <= high; ++n) list.push_back(static_cast<uint32_t>(n));
+        }
+      }
+      counts[cell + 1] = static_cast<uint32_t>(list.size() - before);
+    }
+    std::lock_guard<std::mutex> lock(chunkMutex);
+    chunks.emplace_back(first, std::move(list));
+  });
+
+  for (size_t cell = 0; cell < cellCount; ++cell) counts[cell + 1] += counts[cell];
+  grid.neighbourStart.swap(counts);
+  grid.neighbours.resize(grid.neighbourStart[cellCount]);
+  for (const auto& chunk : chunks) {
+    std::copy(chunk.second.begin(), chunk.second.end(), grid.neighbours.begin() + grid.neighbourStart[chunk.first]);
+  }
+}
+
+static float distanceSquared(const float* a, const float* b) {
+  float dx = a[0] - b[0], dy = a[1] - b[1], dz = a[2] - b[2];
+  return dx * dx + dy * dy + dz * dz;
+}
+
+static uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t cell) {
+  while (parent[cell] != cell) {
+    parent[cell] = parent[parent[cell]];
+    cell = parent[cell];
+  }
+  return cell;
+}
+
+void ScanPeaks::detect(const float* positions, const float* values, size_t pointCount,
+  const PeakOptions& options, PeakDetectionResult& out) {
+  out = PeakDetectionResult();
+  out.labels.assign(pointCount, -1);
+  auto start = std::chrono::steady_clock::now();
+
+  // Value range and bounds over the inliers
+  float minValue = std::numeric_limits<float>::infinity(), maxValue = -minValue;
+  float low[3] = { minValue, minValue, minValue }, high[3] = { maxValue, maxValue, maxValue };
+  for (size_t i = 0; i < pointCount; ++i) {
+    float v = values[i];
+    if (!(v > -VerticesLoader::VALUE_OUTLIER_LIMIT && v < VerticesLoader::VALUE_OUTLIER_LIMIT)) continue;
+    minValue = std::min(minValue, v);
+    maxValue = std::max(maxValue, v);
+    for (int a = 0; a < 3; ++a) {
+      low[a] = std::min(low[a], positions[i * 3 + a]);
+      high[a] = std::max(high[a], positions[i * 3 + a]);
+    }
+  }
+  if (!(minValue <= maxValue)) return;
+
+  float diagonal = std::sqrt((high[0] - low[0]) * (high[0] - low[0]) + (high[1] - low[1]) * (high[1] - low[1]) +
+    (high[2] - low[2]) * (high[2] - low[2]));
+  out.threshold = minValue + options.thresholdFraction * (maxValue - minValue);
+  out.epsilon = options.epsilon > 0.0f ? options.epsilon : (diagonal > 0.0f ? diagonal * 0.02f : 1.0f);
+  // Keep the cell coordinates within their 21 bits
+  out.epsilon = std::max(out.epsilon, diagonal * 1.8f / static_cast<float>(CELL_MASK));
+  out.maximaRadius = options.maximaRadius > 0.0f ? options.maximaRadius : out.epsilon;
+
+  std::vector<uint32_t> candidates;
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (values[i] >= out.threshold && values[i] < VerticesLoader::VALUE_OUTLIER_LIMIT) candidates.push_back(static_cast<uint32_t>(i));
+  }
+  out.candidateCount = candidates.size();
+
+  // Cell diagonal just under epsilon: points sharing a cell are always neighbours
+  PeakGrid grid;
+  buildGrid(positions, candidates, out.epsilon / std::sqrt(3.0f) * 0.9999f, grid);
+  buildNeighbours(grid);
+  size_t cellCount = grid.cellCount();
+  out.cellCount = cellCount;
+  auto gridBuilt = std::chrono::steady_clock::now();
+
+  // Local maxima: no higher point (ties broken by index) within the radius. Cells whose
+  // highest point is lower cannot hold a higher neighbour, and when the radius spans
+  // a cell's diagonal only the highest point of each cell can qualify.
+  const int maximaReach = static_cast<int>(std::ceil(out.maximaRadius / grid.cellSize));
+  const float maximaRadiusSquared = out.maximaRadius * out.maximaRadius;
+  const bool cellMaximaOnly = out.maximaRadius >= grid.cellSize * std::sqrt(3.0f);
+  std::vector<float> cellMax(cellCount);
+  for (size_t cell = 0; cell < cellCount; ++cell) {
+    cellMax[cell] = -std::numeric_limits<float>::infinity();
+    for (uint32_t s = grid.cellStart[cell]; s < grid.cellStart[cell + 1]; ++s) cellMax[cell] = std::max(cellMax[cell], values[grid.slots[s]]);
+  }
+  std::mutex mergeMutex;
+  JobSystem::parallelFor(0, cellCount, CELL_GRAIN, [&](size_t first, size_t last) {
+    std::vector<uint32_t> found;
+    for (size_t cell = first; cell < last; ++cell) {
+      for (uint32_t s = grid.cellStart[cell]; s < grid.cellStart[cell + 1]; ++s) {
+        uint32_t p = grid.slots[s];
+        float value = values[p];
+        if (cellMaximaOnly && value < cellMax[cell]) continue;
+        const float* position = &positions[p * 3];
+        bool isMaximum = grid.forEachNeighbour(cell, maximaReach, [&](size_t neighbour) {
+          if (cellMax[neighbour] < value) return true;
+          for (uint32_t t = grid.cellStart[neighbour]; t < grid.cellStart[neighbour + 1]; ++t) {
+            uint32_t q = grid.slots[t];
+            if (values[q] < value || (values[q] == value && q >= p)) continue;
+            if (distanceSquared(position, &positions[q * 3]) <= maximaRadiusSquared) return false;
+          }
+          return true;
+        });
+        if (isMaximum) found.push_back(p);
+      }
+    }
+    std::lock_guard<std::mutex> lock(mergeMutex);
+    out.localMaxima.insert(out.localMaxima.end(), found.begin(), found.end());
+  });
+  std::sort(out.localMaxima.begin(), out.localMaxima.end(), [&](uint32_t a, uint32_t b) {
+    return values[a] > values[b] || (values[a] == values[b] && a < b);
+  });
+  auto maximaFound = std::chrono::steady_clock::now();
+
+  // Core points: whole cells of minPoints, otherwise count neighbours until minPoints is reached
+  const float epsilonSquared = out.epsilon * out.epsilon;
+  std::vector<uint8_t> core(grid.slots.size(), 0), cellHasCore(cellCount, 0);
+  JobSystem::parallelFor(0, cellCount, CELL_GRAIN, [&](size_t first, size_t last) {
+    for (size_t cell = first; cell < last; ++cell) {
+      uint32_t begin = grid.cellStart[cell], end = grid.cellStart[cell + 1];
+      if (end - begin >= options.minPoints) {
+        std::fill(core.begin() + begin, core.begin() + end, 1);
+        cellHasCore[cell] = 1;
+        continue;
+      }
+      for (uint32_t s = begin; s < end; ++s) {
+        const float* position = &positions[grid.slots[s] * 3];
+        size_t neighbours = 0;
+        grid.forEachNeighbour(cell, NEIGHBOUR_REACH, [&](size_t neighbour) {
+          for (uint32_t t = grid.cellStart[neighbour]; t < grid.cellStart[neighbour + 1]; ++t) {
+            if (distanceSquared(position, &positions[grid.slots[t] * 3]) <= epsilonSquared && ++neighbours >= options.minPoints) return false;
+          }
+          return true;
+        });
+        if (neighbours >= options.minPoints) {
+          core[s] = 1;
+          cellHasCore[cell] = 1;
+        }
+      }
+    }
+  });
+  out.coreCount = static_cast<size_t>(std::count(core.begin(), core.end(), 1));
+
+  // Bounds of each cell's core points, to skip cell pairs that are too far apart
+  std::vector<float> coreBounds(cellCount * 6);
+  for (size_t cell = 0; cell < cellCount; ++cell) {
+    float* bounds = &coreBounds[cell * 6];
+    for (int a = 0; a < 3; ++a) {
+      bounds[a] = std::numeric_limits<float>::infinity();
+      bounds[3 + a] = -std::numeric_limits<float>::infinity();
+    }
+    for (uint32_t s = grid.cellStart[cell]; s < grid.cellStart[cell + 1]; ++s) {
+      if (!core[s]) continue;
+      for (int a = 0; a < 3; ++a) {
+        bounds[a] = std::min(bounds[a], positions[grid.slots[s] * 3 + a]);
+        bounds[3 + a] = std::max(bounds[3 + a], positions[grid.slots[s] * 3 + a]);
+      }
+    }
+  }
+  auto boundsDistanceSquared = [&](size_t a, size_t b) {
+    float sum = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      float gap = std::max(coreBounds[a * 6 + k] - coreBounds[b * 6 + 3 + k], coreBounds[b * 6 + k] - coreBounds[a * 6 + 3 + k]);
+      if (gap > 0.0f) sum += gap * gap;
+    }
+    return sum;
+  };
+
+  // Two core cells join when any of their core pairs is within epsilon. Cells are joined
+  // in order with a union-find check first, so once a lobe's neighbouring cells have
+  // merged through adjacent cells the remaining pairs need no distance tests at all.
+  auto pointBoundsDistanceSquared = [&](const float* position, size_t cell) {
+    float sum = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      float gap = std::max(coreBounds[cell * 6 + k] - position[k], position[k] - coreBounds[cell * 6 + 3 + k]);
+      if (gap > 0.0f) sum += gap * gap;
+    }
+    return sum;
+  };
+  std::vector<uint32_t> parent(cellCount);
+  std::iota(parent.begin(), parent.end(), 0u);
+  for (size_t cell = 0; cell < cellCount; ++cell) {
+    if (!cellHasCore[cell]) continue;
+    grid.forEachNeighbour(cell, NEIGHBOUR_REACH, [&](size_t neighbour) {
+      if (neighbour <= cell || !cellHasCore[neighbour] || boundsDistanceSquared(cell, neighbour) > epsilonSquared) return true;
+      uint32_t a = findRoot(parent, static_cast<uint32_t>(cell)), b = findRoot(parent, static_cast<uint32_t>(neighbour));
+      if (a == b) return true;
+      bool linked = false;
+      for (uint32_t s = grid.cellStart[cell]; s < grid.cellStart[cell + 1] && !linked; ++s) {
+        const float* position = &positions[grid.slots[s] * 3];
+        if (!core[s] || pointBoundsDistanceSquared(position, neighbour) > epsilonSquared) continue;
+        for (uint32_t t = grid.cellStart[neighbour]; t < grid.cellStart[neighbour + 1]; ++t) {
+          if (core[t] && distanceSquared(position, &positions[grid.slots[t] * 3]) <= epsilonSquared) {
+            linked = true;
+            break;
+          }
+        }
+      }
+      if (linked) parent[std::max(a, b)] = std::min(a, b);
+      return true;
+    });
+  }
+  for (size_t cell = 0; cell < cellCount; ++cell) findRoot(parent, static_cast<uint32_t>(cell));
+
+  // Core points take their cell's cluster; border points that of any core point within epsilon
+  std::vector<int32_t> slotRoot(grid.slots.size(), -1);
+  JobSystem::parallelFor(0, cellCount, CELL_GRAIN, [&](size_t first, size_t last) {
+    for (size_t cell = first; cell < last; ++cell) {
+      for (uint32_t s = grid.cellStart[cell]; s < grid.cellStart[cell + 1]; ++s) {
+        if (cellHasCore[cell]) {
+          slotRoot[s] = static_cast<int32_t>(parent[cell]);
+          continue;
+        }
+        const float* position = &positions[grid.slots[s] * 3];
+        grid.forEachNeighbour(cell, NEIGHBOUR_REACH, [&](size_t neighbour) {
+          if (!cellHasCore[neighbour]) return true;
+          for (uint32_t t = grid.cellStart[neighbour]; t < grid.cellStart[neighbour + 1]; ++t) {
+            if (core[t] && distanceSquared(position, &positions[grid.slots[t] * 3]) <= epsilonSquared) {
+              slotRoot[s] = static_cast<int32_t>(parent[neighbour]);
+              return false;
+            }
+          }
+          return true;
+        });
+      }
+    }
+  });
+
+  // Lobe statistics, then number the lobes from the highest peak down
+  std::vector<int32_t> clusterOfRoot(cellCount, -1);
+  std::vector<double> weightedSums;
+  for (size_t s = 0; s < grid.slots.size(); ++s) {
+    if (slotRoot[s] < 0) {
+      out.noiseCount++;
+      continue;
+    }
+    int32_t& id = clusterOfRoot[slotRoot[s]];
+    if (id < 0) {
+      id = static_cast<int32_t>(out.clusters.size());
+      out.clusters.emplace_back();
+      weightedSums.resize(weightedSums.size() + 4, 0.0);
+    }
+    uint32_t p = grid.slots[s];
+    const float* position = &positions[p * 3];
+    PeakCluster& cluster = out.clusters[id];
+    if (cluster.pointCount == 0 || values[p] > cluster.peakValue) {
+      cluster.peakValue = values[p];
+      cluster.peakIndex = p;
+      std::copy(position, position + 3, cluster.peakPosition);
+    }
+    for (int a = 0; a < 3; ++a) {
+      cluster.minCorner[a] = cluster.pointCount == 0 ? position[a] : std::min(cluster.minCorner[a], position[a]);
+      cluster.maxCorner[a] = cluster.pointCount == 0 ? position[a] : std::max(cluster.maxCorner[a], position[a]);
+      weightedSums[id * 4 + a] += static_cast<double>(values[p]) * position[a];
+    }
+    weightedSums[id * 4 + 3] += values[p];
+    cluster.pointCount++;
+    out.labels[p] = id;
+  }
+  for (size_t c = 0; c < out.clusters.size(); ++c) {
+    for (int a = 0; a < 3; ++a) {
+      out.clusters[c].centroid[a] = weightedSums[c * 4 + 3] != 0.0 ?
+        static_cast<float>(weightedSums[c * 4 + a] / weightedSums[c * 4 + 3]) : out.clusters[c].peakPosition[a];
+    }
+  }
+
+  std::vector<int32_t> order(out.clusters.size()), rank(out.clusters.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int32_t a, int32_t b) { return out.clusters[a].peakValue > out.clusters[b].peakValue; });
+  std::vector<PeakCluster> sorted(out.clusters.size());
+  for (size_t c = 0; c < order.size(); ++c) {
+    rank[order[c]] = static_cast<int32_t>(c);
+    sorted[c] = out.clusters[order[c]];
+  }
+  out.clusters.swap(sorted);
+  for (uint32_t p : candidates) {
+    if (out.labels[p] >= 0) out.labels[p] = rank[out.labels[p]];
+  }
+  for (uint32_t p : out.localMaxima) {
+    if (out.labels[p] >= 0) out.clusters[out.labels[p]].localMaxima++;
+  }
+
+  auto end = std::chrono::steady_clock::now();
+  out.gridMilliseconds = std::chrono::duration<double, std::milli>(gridBuilt - start).count();
+  out.maximaMilliseconds = std::chrono::duration<double, std::milli>(maximaFound - gridBuilt).count();
+  out.clusterMilliseconds = std::chrono::duration<double, std::milli>(end - maximaFound).count();
+}
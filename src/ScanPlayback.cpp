@@ -0,0 +1,152 @@
+#include "ScanPlayback.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+ScanPlayback::ScanPlayback(ScanResidency& residency)
+  : residency(residency), decodedCount(0), cancelDecode(false) {
+}
+
+ScanPlayback::~ScanPlayback() {
+  joinDecodeThread();
+}
+
+void ScanPlayback::joinDecodeThread() {
+  cancelDecode = true;
+  if (decodeThread.joinable()) decodeThread.join();
+}
+
+void ScanPlayback::load(const std::vector<std::string>& files, float scaleFactor) {
+  stop();
+  frames = files;
+  this->scaleFactor = scaleFactor;
+  if (frames.empty()) return;
+
+  // The thread decodes its own copy: the frame list is trimmed or compacted later
+  cancelDecode = false;
+  decodedCount = 0;
+  decodeThread = std::thread([this, files, scaleFactor]() {
+    for (size_t i = 0; i < files.size() && !cancelDecode; ++i) {
+      residency.acquire(files[i], scaleFactor);
+      decodedCount = i + 1;
+    }
+  });
+}
+
+void ScanPlayback::stop() {
+  joinDecodeThread();
+  frames.clear();
+  decodedCount = 0;
+  uploadedCount = 0;
+  uploadedBytes = 0;
+  trimmedCount = 0;
+  failedFrames.clear();
+  frameIndex = 0;
+  playing = false;
+  frameTime = 0.0;
+  rateWindow = 0.0;
+  rateFrames = 0;
+  measuredRate = 0.0;
+}
+
+bool ScanPlayback::preload(double budgetMilliseconds) {
+  if (frames.empty() || uploadedCount == frames.size()) return isReady();
+
+  auto start = std::chrono::steady_clock::now();
+  const size_t vramBudget = residency.getStats().vramBudget;
+
+  // Frames only upload once the thread has decoded them, so this thread never parses
+  while (uploadedCount < decodedCount && uploadedCount < frames.size()) {
+    if (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() > budgetMilliseconds) break;
+
+    // Stop before the next frame would push the sequence's own frames out of video memory
+    if (uploadedCount > 0 && uploadedBytes + uploadedBytes / uploadedCount > vramBudget) {
+      joinDecodeThread();
+      trimmedCount = frames.size() - uploadedCount;
+      frames.resize(uploadedCount);
+      break;
+    }
+
+    std::string error;
+    const GpuScanBuffers* buffers = residency.acquireGpu(frames[uploadedCount], scaleFactor, &error);
+    if (buffers != nullptr) {
+      uploadedBytes += buffers->bytes;
+    }
+    else {
+      std::cerr << "Playback skips " << frames[uploadedCount] << ": " << error << std::endl;
+      failedFrames.push_back(uploadedCount);
+    }
+    uploadedCount++;
+  }
+
+  if (!frames.empty() && uploadedCount == frames.size()) {
+    joinDecodeThread();
+    // Unreadable files are dropped from the sequence once the decoding thread is done with it
+    for (auto it = failedFrames.rbegin(); it != failedFrames.rend(); ++it) {
+      frames.erase(frames.begin() + *it);
+    }
+    uploadedCount = frames.size();
+    failedFrames.clear();
+    std::cout << "Playback ready: " << frames.size() << " scans resident on the GPU ("
+      << uploadedBytes / (1024 * 1024) << " MB)" << std::endl;
+    if (trimmedCount > 0) {
+      std::cout << "  " << trimmedCount << " later scans left out to stay within the VRAM budget" << std::endl;
+    }
+  }
+  return isReady();
+}
+
+bool ScanPlayback::advance(double elapsedSeconds) {
+  if (!playing || !isReady()) return false;
+
+  rateWindow += elapsedSeconds;
+  if (rateWindow >= 1.0) {
+    measuredRate = rateFrames / rateWindow;
+    rateWindow = 0.0;
+    rateFrames = 0;
+  }
+
+  // Every frame is shown: when rendering is slower than the chosen rate, playback slows down
+  if (framesPerSecond > 0.0f) {
+    const double period = 1.0 / framesPerSecond;
+    frameTime = std::min(frameTime + elapsedSeconds, 2.0 * period);
+    if (frameTime < period) return false;
+    frameTime -= period;
+  }
+
+  if (frameIndex + 1 < frames.size()) {
+    frameIndex++;
+  }
+  else if (looping) {
+    frameIndex = 0;
+  }
+  else {
+    playing = false;
+    return false;
+  }
+  rateFrames++;
+  return true;
+}
+
+void ScanPlayback::setPlaying(bool playing) {
+  // Playing from the last frame of a non-looping sequence restarts it
+  if (playing && !this->playing && !looping && frameIndex + 1 >= frames.size()) frameIndex = 0;
+  this->playing = playing && !frames.empty();
+  frameTime = 0.0;
+  rateWindow = 0.0;
+  rateFrames = 0;
+}
+
+void ScanPlayback::seek(size_t frame) {
+  if (frames.empty()) return;
+  frameIndex = std::min(frame, frames.size() - 1);
+  frameTime = 0.0;
+}
+
+const GpuScanBuffers* ScanPlayback::getFrameBuffers() {
+  if (!isReady()) return nullptr;
+  const GpuScanBuffers* buffers = residency.findGpu(frames[frameIndex]);
+  // Evicted by other viewing since preload: upload again rather than show nothing
+  if (buffers == nullptr) buffers = residency.acquireGpu(frames[frameIndex], scaleFactor);
+  return buffers;
+}
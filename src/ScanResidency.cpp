@@ -0,0 +1,272 @@
+#include "ScanResidency.h"
+
+// Heap bytes of a string beyond the object itself (short strings live inline)
+static size_t stringHeapBytes(const std::string& s) {
+  return s.capacity() > std::string().capacity() ? s.capacity() + 1 : 0;
+}
+
+ScanResidency::ScanResidency(size_t ramBudget, size_t vramBudget) {
+  stats.ramBudget = ramBudget;
+  stats.vramBudget = vramBudget;
+}
+
+std::shared_ptr<DecodedScan> ScanResidency::decode(const std::string& filePath, float scaleFactor, std::string* error) {
+  auto scan = std::make_shared<DecodedScan>();
+  scan->filePath = filePath;
+  scan->scaleFactor = scaleFactor;
+  ScanParser::getFileSignature(filePath, scan->fileBytes, scan->modifiedTime);
+
+  std::string content;
+  if (!ScanParser::readFile(filePath, content)) {
+    if (error != nullptr) *error = "cannot open file";
+    return nullptr;
+  }
+  if (!ScanParser::parse(content, scaleFactor, scan->points, scan->header)) {
+    if (error != nullptr) *error = "no measurements array";
+    return nullptr;
+  }
+
+  scan->points.shrink_to_fit();
+  scan->positions.resize(scan->points.size() * 3);
+  scan->values.resize(scan->points.size());
+  size_t stringBytes = 0;
+  for (size_t i = 0; i < scan->points.size(); ++i) {
+    const ScanPoint& p = scan->points[i];
+    scan->positions[i * 3] = p.x;
+    scan->positions[i * 3 + 1] = p.y;
+    scan->positions[i * 3 + 2] = p.z;
+    scan->values[i] = p.value;
+    stringBytes += stringHeapBytes(p.axis) + stringHeapBytes(p.direction);
+  }
+
+  scan->memoryBytes = scan->points.capacity() * sizeof(ScanPoint) + stringBytes +
+    scan->positions.capacity() * sizeof(float) + scan->values.capacity() * sizeof(float);
+  return scan;
+}
+
+// Entry for filePath moved to the front of the recency list (created if missing). Caller holds the mutex.
+ScanResidency::Entry& ScanResidency::touch(const std::string& filePath) {
+  auto it = entries.find(filePath);
+  if (it == entries.end()) {
+    recency.push_front(filePath);
+    Entry& entry = entries[filePath];
+    entry.recency = recency.begin();
+    return entry;
+  }
+  recency.splice(recency.begin(), recency, it->second.recency);
+  return it->second;
+}
+
+void ScanResidency::eraseIfEmpty(std::unordered_map<std::string, Entry>::iterator it) {
+  if (it->second.scan || it->second.gpuResident) return;
+  recency.erase(it->second.recency);
+  entries.erase(it);
+}
+
+// Drop decoded data from the least recently viewed scans until RAM usage fits. Caller holds the mutex.
+void ScanResidency::enforceRamBudget(const std::string& keep) {
+  auto candidate = recency.end();
+  while (stats.ramBytes > stats.ramBudget && candidate != recency.begin()) {
+    --candidate;
+    if (*candidate == keep) continue;
+    auto it = entries.find(*candidate);
+    if (!it->second.scan) continue;
+
+    stats.ramBytes -= it->second.scan->memoryBytes;
+    stats.residentScans--;
+    stats.evictions++;
+    it->second.scan.reset();
+    // Erasing invalidates the list position, so step past it first
+    auto next = std::next(candidate);
+    eraseIfEmpty(it);
+    candidate = next;
+  }
+}
+
+// Same for GPU buffers; they are released by the caller after the mutex is dropped
+void ScanResidency::enforceVramBudget(const std::string& keep, std::vector<GpuScanBuffers>& toRelease) {
+  auto candidate = recency.end();
+  while (stats.vramBytes > stats.vramBudget && candidate != recency.begin()) {
+    --candidate;
+    if (*candidate == keep) continue;
+    auto it = entries.find(*candidate);
+    if (!it->second.gpuResident) continue;
+
+    stats.vramBytes -= it->second.gpu.bytes;
+    stats.gpuResidentScans--;
+    stats.gpuEvictions++;
+    toRelease.push_back(it->second.gpu);
+    it->second.gpu = GpuScanBuffers();
+    it->second.gpuResident = false;
+    auto next = std::next(candidate);
+    eraseIfEmpty(it);
+    candidate = next;
+  }
+}
+
+void ScanResidency::releaseBuffers(std::vector<GpuScanBuffers>& buffers) {
+  if (release) {
+    for (GpuScanBuffers& b : buffers) release(b);
+  }
+  buffers.clear();
+}
+
+std::shared_ptr<const DecodedScan> ScanResidency::acquire(const std::string& filePath, float scaleFactor, std::string* error) {
+  uint64_t bytes = 0;
+  int64_t modified = 0;
+  if (!ScanParser::getFileSignature(filePath, bytes, modified)) {
+    if (error != nullptr) *error = "cannot open file";
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(filePath);
+    if (it != entries.end() && it->second.scan && it->second.scan->scaleFactor == scaleFactor &&
+      it->second.scan->fileBytes == bytes && it->second.scan->modifiedTime == modified) {
+      stats.hits++;
+      return touch(filePath).scan;
+    }
+    stats.misses++;
+  }
+
+  // Parse without the lock so other threads keep hitting the cache meanwhile
+  std::shared_ptr<DecodedScan> scan = decode(filePath, scaleFactor, error);
+  if (!scan) return nullptr;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  Entry& entry = touch(filePath);
+  if (entry.scan) {
+    stats.ramBytes -= entry.scan->memoryBytes; // Replaced: stale, or decoded concurrently by another thread
+    stats.residentScans--;
+  }
+  entry.scan = scan;
+  stats.ramBytes += scan->memoryBytes;
+  stats.residentScans++;
+  enforceRamBudget(filePath);
+  return scan;
+}
+
+const GpuScanBuffers* ScanResidency::acquireGpu(const std::string& filePath, float scaleFactor, std::string* error) {
+  uint64_t bytes = 0;
+  int64_t modified = 0;
+  if (!ScanParser::getFileSignature(filePath, bytes, modified)) {
+    if (error != nullptr) *error = "cannot open file";
+    return nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(filePath);
+    if (it != entries.end() && it->second.gpuResident && it->second.gpuScaleFactor == scaleFactor &&
+      it->second.gpuFileBytes == bytes && it->second.gpuModifiedTime == modified) {
+      stats.gpuHits++;
+      return &touch(filePath).gpu;
+    }
+    stats.gpuMisses++;
+  }
+
+  if (!upload) {
+    if (error != nullptr) *error = "no GPU upload callback";
+    return nullptr;
+  }
+
+  std::shared_ptr<const DecodedScan> scan = acquire(filePath, scaleFactor, error);
+  if (!scan) return nullptr;
+
+  GpuScanBuffers buffers;
+  if (!upload(*scan, buffers)) {
+    if (error != nullptr) *error = "upload failed";
+    return nullptr;
+  }
+
+  std::vector<GpuScanBuffers> toRelease;
+  const GpuScanBuffers* result = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Entry& entry = touch(filePath);
+    if (entry.gpuResident) {
+      toRelease.push_back(entry.gpu);
+      stats.vramBytes -= entry.gpu.bytes;
+      stats.gpuResidentScans--;
+    }
+    entry.gpu = buffers;
+    entry.gpuResident = true;
+    entry.gpuFileBytes = scan->fileBytes;
+    entry.gpuModifiedTime = scan->modifiedTime;
+    entry.gpuScaleFactor = scaleFactor;
+    stats.vramBytes += buffers.bytes;
+    stats.gpuResidentScans++;
+    enforceVramBudget(filePath, toRelease);
+    result = &entry.gpu;
+  }
+  releaseBuffers(toRelease);
+  return result;
+}
+
+const GpuScanBuffers* ScanResidency::findGpu(const std::string& filePath) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(filePath);
+  if (it == entries.end() || !it->second.gpuResident) return nullptr;
+  stats.gpuHits++;
+  return &touch(filePath).gpu;
+}
+
+bool ScanResidency::isResident(const std::string& filePath) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(filePath);
+  return it != entries.end() && it->second.scan != nullptr;
+}
+
+bool ScanResidency::isGpuResident(const std::string& filePath) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(filePath);
+  return it != entries.end() && it->second.gpuResident;
+}
+
+void ScanResidency::setGpuCallbacks(UploadFunction uploadFunction, ReleaseFunction releaseFunction) {
+  std::lock_guard<std::mutex> lock(mutex);
+  upload = std::move(uploadFunction);
+  release = std::move(releaseFunction);
+}
+
+void ScanResidency::setBudgets(size_t ramBudget, size_t vramBudget) {
+  std::vector<GpuScanBuffers> toRelease;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.ramBudget = ramBudget;
+    stats.vramBudget = vramBudget;
+    // Shrinking spares only the most recently viewed scan
+    std::string keep = recency.empty() ? std::string() : recency.front();
+    enforceRamBudget(keep);
+    enforceVramBudget(keep, toRelease);
+  }
+  releaseBuffers(toRelease);
+}
+
+void ScanResidency::clear() {
+  std::vector<GpuScanBuffers> toRelease;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& item : entries) {
+      if (item.second.gpuResident) toRelease.push_back(item.second.gpu);
+    }
+    entries.clear();
+    recency.clear();
+    stats.ramBytes = stats.vramBytes = 0;
+    stats.residentScans = stats.gpuResidentScans = 0;
+  }
+  releaseBuffers(toRelease);
+}
+
+ResidencyStats ScanResidency::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+void ScanResidency::resetCounters() {
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.hits = stats.misses = 0;
+  stats.gpuHits = stats.gpuMisses = 0;
+  stats.evictions = stats.gpuEvictions = 0;
+}
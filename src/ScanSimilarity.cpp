@@ -0,0 +1,418 @@
+#include "ScanSimilarity.h"
+#include "ScanAnalyzer.h"
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+// Scans per tile edge and cells per k-block: two 32-row blocks of 1024 floats stay in L2
+static const size_t TILE_ROWS = 32;
+static const size_t K_BLOCK = 1024;
+// Cell coordinates are packed 21 bits per axis, offset so negative cells stay positive
+static const int64_t CELL_COORD_OFFSET = int64_t(1) << 20;
+static const int64_t CELL_COORD_LIMIT = (int64_t(1) << 21) - 1;
+
+static uint64_t cellKey(const float* p, float inverseCellSize) {
+  uint64_t key = 0;
+  for (int c = 0; c < 3; ++c) {
+    int64_t coord = static_cast<int64_t>(std::floor(p[c] * inverseCellSize)) + CELL_COORD_OFFSET;
+    coord = std::max<int64_t>(0, std::min(coord, CELL_COORD_LIMIT));
+    key = (key << 21) | static_cast<uint64_t>(coord);
+  }
+  return key;
+}
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+// Outliers and non-finite values are left out of the cell means
+static void binPoints(const float* xyz, const float* values, size_t pointCount, float cellSize, SimilarityCells& out) {
+  std::vector<std::pair<uint64_t, float>> keyed;
+  keyed.reserve(pointCount);
+  const float inverseCellSize = 1.0f / cellSize;
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (!isInlier(values[i])) continue;
+    keyed.emplace_back(cellKey(&xyz[i * 3], inverseCellSize), values[i]);
+  }
+  std::sort(keyed.begin(), keyed.end(),
+    [](const std::pair<uint64_t, float>& a, const std::pair<uint64_t, float>& b) { return a.first < b.first; });
+
+  out.keys.clear();
+  out.means.clear();
+  for (size_t i = 0; i < keyed.size();) {
+    size_t j = i;
+    double sum = 0.0;
+    for (; j < keyed.size() && keyed[j].first == keyed[i].first; ++j) sum += keyed[j].second;
+    out.keys.push_back(keyed[i].first);
+    out.means.push_back(static_cast<float>(sum / (j - i)));
+    i = j;
+  }
+}
+
+// Cell edge giving cellsPerAxis cells across the largest extent of one scan
+static float autoCellSize(const float* xyz, size_t pointCount, int cellsPerAxis) {
+  if (pointCount == 0) return 0.0f;
+  float lo[3] = { xyz[0], xyz[1], xyz[2] }, hi[3] = { xyz[0], xyz[1], xyz[2] };
+  for (size_t i = 1; i < pointCount; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      lo[c] = std::min(lo[c], xyz[i * 3 + c]);
+      hi[c] = std::max(hi[c], xyz[i * 3 + c]);
+    }
+  }
+  float extent = std::max(hi[0] - lo[0], std::max(hi[1] - lo[1], hi[2] - lo[2]));
+  return extent > 0.0f ? extent / std::max(1, cellsPerAxis) : 1.0f;
+}
+
+// out[i * TILE_ROWS + j] = sum over k in [k0, k0 + kLength) of a[i][k] * b[j][k]
+static void dotTileScalar(const float* a, size_t aRows, const float* b, size_t bRows, size_t stride,
+  size_t k0, size_t kLength, float* out) {
+  for (size_t i = 0; i < aRows; ++i) {
+    const float* rowA = a + i * stride + k0;
+    for (size_t j = 0; j < bRows; ++j) {
+      const float* rowB = b + j * stride + k0;
+      float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+      size_t k = 0;
+      for (; k + 4 <= kLength; k += 4) {
+        s0 += rowA[k] * rowB[k];
+        s1 += rowA[k + 1] * rowB[k + 1];
+        s2 += rowA[k + 2] * rowB[k + 2];
+        s3 += rowA[k + 3] * rowB[k + 3];
+      }
+      for (; k < kLength; ++k) s0 += rowA[k] * rowB[k];
+      out[i * TILE_ROWS + j] = (s0 + s1) + (s2 + s3);
+    }
+  }
+}
+
+#if CPU_FEATURES_X86
+
+static TARGET_AVX2 float horizontalSum(__m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+  return _mm_cvtss_f32(sum);
+}
+
+// Rows are padded to a multiple of 8 floats, so kLength is too
+static TARGET_AVX2 void dotTileAVX2(const float* a, size_t aRows, const float* b, size_t bRows, size_t stride,
+  size_t k0, size_t kLength, float* out) {
+  size_t i = 0;
+  // 2 x 4 register tile: 8 accumulators, every loaded vector used 2 or 4 times
+  for (; i + 2 <= aRows; i += 2) {
+    const float* a0 = a + i * stride + k0;
+    const float* a1 = a0 + stride;
+    size_t j = 0;
+    for (; j + 4 <= bRows; j += 4) {
+      const float* b0 = b + j * stride + k0;
+      const float* b1 = b0 + stride;
+      const float* b2 = b1 + stride;
+      const float* b3 = b2 + stride;
+      __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c02 = _mm256_setzero_ps(), c03 = _mm256_setzero_ps();
+      __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps(), c12 = _mm256_setzero_ps(), c13 = _mm256_setzero_ps();
+      for (size_t k = 0; k < kLength; k += 8) {
+        __m256 va0 = _mm256_loadu_ps(a0 + k), va1 = _mm256_loadu_ps(a1 + k);
+        __m256 vb = _mm256_loadu_ps(b0 + k);
+        c00 = _mm256_fmadd_ps(va0, vb, c00);
+        c10 = _mm256_fmadd_ps(va1, vb, c10);
+        vb = _mm256_loadu_ps(b1 + k);
+        c01 = _mm256_fmadd_ps(va0, vb, c01);
+        c11 = _mm256_fmadd_ps(va1, vb, c11);
+        vb = _mm256_loadu_ps(b2 + k);
+        c02 = _mm256_fmadd_ps(va0, vb, c02);
+        c12 = _mm256_fmadd_ps(va1, vb, c12);
+        vb = _mm256_loadu_ps(b3 + k);
+        c03 = _mm256_fmadd_ps(va0, vb, c03);
+        c13 = _mm256_fmadd_ps(va1, vb, c13);
+      }
+      float* row0 = out + i * TILE_ROWS + j;
+      float* row1 = row0 + TILE_ROWS;
+      row0[0] = horizontalSum(c00); row0[1] = horizontalSum(c01); row0[2] = horizontalSum(c02); row0[3] = horizontalSum(c03);
+      row1[0] = horizontalSum(c10); row1[1] = horizontalSum(c11); row1[2] = horizontalSum(c12); row1[3] = horizontalSum(c13);
+    }
+    if (j < bRows) {
+      dotTileScalar(a0 - k0, 2, b + j * stride, bRows - j, stride, k0, kLength, out + i * TILE_ROWS + j);
+    }
+  }
+  if (i < aRows) {
+    dotTileScalar(a + i * stride, aRows - i, b, bRows, stride, k0, kLength, out + i * TILE_ROWS);
+  }
+}
+
+#endif
+
+static void dotTile(SimdLevel level, const float* a, size_t aRows, const float* b, size_t bRows, size_t stride,
+  size_t k0, size_t kLength, float* out) {
+#if CPU_FEATURES_X86
+  if (level == SimdLevel::AVX2) {
+    dotTileAVX2(a, aRows, b, bRows, stride, k0, kLength, out);
+    return;
+  }
+#endif
+  (void)level;
+  dotTileScalar(a, aRows, b, bRows, stride, k0, kLength, out);
+}
+
+// Dense rows over the union of occupied cells, then every upper-triangle tile pair
+static void buildMatrix(const std::vector<SimilarityCells>& cells, const std::atomic<bool>* cancel, SimilarityMatrix& out) {
+  auto start = std::chrono::steady_clock::now();
+  const size_t n = cells.size();
+
+  std::vector<uint64_t> columns;
+  for (const SimilarityCells& scan : cells) columns.insert(columns.end(), scan.keys.begin(), scan.keys.end());
+  std::sort(columns.begin(), columns.end());
+  columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+  out.cellCount = columns.size();
+
+  // Standardise with the mean and spread of all cell values: correlation is unaffected,
+  // RMSE is scaled back, and the float sums stay well conditioned
+  double sum = 0.0, sumSquares = 0.0;
+  size_t valueCount = 0;
+  for (const SimilarityCells& scan : cells) {
+    for (float v : scan.means) {
+      sum += v;
+      sumSquares += static_cast<double>(v) * v;
+    }
+    valueCount += scan.means.size();
+  }
+  double mean = valueCount > 0 ? sum / valueCount : 0.0;
+  double spread = valueCount > 0 ? std::sqrt(std::max(0.0, sumSquares / valueCount - mean * mean)) : 0.0;
+  if (!(spread > 0.0)) spread = 1.0;
+
+  const size_t stride = std::max<size_t>(8, (columns.size() + 7) / 8 * 8);
+  std::vector<float> x(n * stride, 0.0f), mask(n * stride, 0.0f), xSquared(n * stride, 0.0f);
+  JobSystem::parallelFor(0, n, 16, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      const SimilarityCells& scan = cells[i];
+      auto column = columns.begin();
+      for (size_t c = 0; c < scan.keys.size(); ++c) {
+        column = std::lower_bound(column, columns.end(), scan.keys[c]);
+        size_t k = column - columns.begin();
+        float v = static_cast<float>((scan.means[c] - mean) / spread);
+        x[i * stride + k] = v;
+        mask[i * stride + k] = 1.0f;
+        xSquared[i * stride + k] = v * v;
+      }
+    }
+  });
+
+  out.correlation.assign(n * n, std::numeric_limits<float>::quiet_NaN());
+  out.rmse.assign(n * n, std::numeric_limits<float>::quiet_NaN());
+  out.commonCells.assign(n * n, 0);
+
+  const size_t tileCount = (n + TILE_ROWS - 1) / TILE_ROWS;
+  std::vector<std::pair<size_t, size_t>> tilePairs;
+  for (size_t a = 0; a < tileCount; ++a) {
+    for (size_t b = a; b < tileCount; ++b) tilePairs.emplace_back(a, b);
+  }
+
+  // When every scan covers every cell (same raster each run) the masks are all ones:
+  // only x.x is needed and the other sums are per-row totals
+  bool fullCoverage = true;
+  for (const SimilarityCells& scan : cells) fullCoverage = fullCoverage && scan.keys.size() == columns.size();
+  std::vector<double> rowSums(n, 0.0), rowSquareSums(n, 0.0);
+  if (fullCoverage) {
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t k = 0; k < columns.size(); ++k) {
+        rowSums[i] += x[i * stride + k];
+        rowSquareSums[i] += xSquared[i * stride + k];
+      }
+    }
+  }
+  const int productCount = fullCoverage ? 1 : 6;
+
+  const SimdLevel level = CpuFeatures::getSimdLevel();
+  JobSystem::parallelFor(0, tilePairs.size(), 1, [&](size_t first, size_t last) {
+    const size_t TILE = TILE_ROWS * TILE_ROWS;
+    // Per pair: x.x, m.m, x_i.m_j, m_i.x_j, x_i^2.m_j, m_i.x_j^2
+    std::vector<double> sums(6 * TILE);
+    std::vector<float> block(TILE);
+    for (size_t p = first; p < last; ++p) {
+      if (cancel && cancel->load(std::memory_order_relaxed)) return;
+      size_t rowA = tilePairs[p].first * TILE_ROWS, rowB = tilePairs[p].second * TILE_ROWS;
+      size_t rowsA = std::min(TILE_ROWS, n - rowA), rowsB = std::min(TILE_ROWS, n - rowB);
+      std::fill(sums.begin(), sums.end(), 0.0);
+
+      const float* sources[6][2] = {
+        { x.data(), x.data() }, { mask.data(), mask.data() }, { x.data(), mask.data() },
+        { mask.data(), x.data() }, { xSquared.data(), mask.data() }, { mask.data(), xSquared.data() } };
+      // Float partial sums per k-block, accumulated in double across blocks
+      for (size_t k0 = 0; k0 < stride; k0 += K_BLOCK) {
+        size_t kLength = std::min(K_BLOCK, stride - k0);
+        for (int product = 0; product < productCount; ++product) {
+          dotTile(level, sources[product][0] + rowA * stride, rowsA, sources[product][1] + rowB * stride, rowsB,
+            stride, k0, kLength, block.data());
+          double* target = &sums[product * TILE];
+          for (size_t i = 0; i < rowsA; ++i) {
+            for (size_t j = 0; j < rowsB; ++j) target[i * TILE_ROWS + j] += block[i * TILE_ROWS + j];
+          }
+        }
+      }
+
+      for (size_t i = 0; i < rowsA; ++i) {
+        for (size_t j = 0; j < rowsB; ++j) {
+          size_t t = i * TILE_ROWS + j;
+          double sab = sums[t], common, sa, sb, saa, sbb;
+          if (fullCoverage) {
+            common = static_cast<double>(columns.size());
+            sa = rowSums[rowA + i];
+            sb = rowSums[rowB + j];
+            saa = rowSquareSums[rowA + i];
+            sbb = rowSquareSums[rowB + j];
+          }
+          else {
+            common = sums[TILE + t];
+            sa = sums[2 * TILE + t];
+            sb = sums[3 * TILE + t];
+            saa = sums[4 * TILE + t];
+            sbb = sums[5 * TILE + t];
+          }
+
+          float correlation = std::numeric_limits<float>::quiet_NaN();
+          float rmse = std::numeric_limits<float>::quiet_NaN();
+          if (common > 0.5) {
+            rmse = static_cast<float>(std::sqrt(std::max(0.0, (saa + sbb - 2.0 * sab) / common)) * spread);
+            double covariance = sab - sa * sb / common;
+            double varianceA = saa - sa * sa / common, varianceB = sbb - sb * sb / common;
+            if (common > 1.5 && varianceA > 0.0 && varianceB > 0.0) {
+              correlation = static_cast<float>(std::max(-1.0, std::min(1.0, covariance / std::sqrt(varianceA * varianceB))));
+            }
+          }
+          size_t row = rowA + i, column = rowB + j;
+          if (row == column && common > 0.5) rmse = 0.0f;  // Exact, rather than a float cancellation residue
+          uint32_t commonCount = static_cast<uint32_t>(std::lround(common));
+          out.correlation[row * n + column] = out.correlation[column * n + row] = correlation;
+          out.rmse[row * n + column] = out.rmse[column * n + row] = rmse;
+          out.commonCells[row * n + column] = out.commonCells[column * n + row] = commonCount;
+        }
+      }
+    }
+  });
+
+  out.cancelled = cancel && cancel->load();
+  out.matrixMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool ScanSimilarity::compute(const std::vector<std::string>& files, const SimilarityOptions& options, SimilarityMatrix& out) {
+  ResampledScans scans;
+  bool ok = resample(files, options, scans);
+  computeMatrix(scans, options, out);
+  return ok && !out.cancelled;
+}
+
+bool ScanSimilarity::resample(const std::vector<std::string>& files, const SimilarityOptions& options, ResampledScans& out) {
+  out = ResampledScans();
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<SimilarityCells> cells(files.size());
+  std::vector<char> ok(files.size(), 0);
+  float cellSize = options.cellSize;
+  std::vector<float> xyz, values;
+
+  // The grid is sized from the first readable scan unless a cell size was given
+  size_t firstFile = 0;
+  if (!(cellSize > 0.0f)) {
+    for (; firstFile < files.size() && !(cellSize > 0.0f); ++firstFile) {
+      ScanAnalyzer::parseFiles({ files[firstFile] }, options.scaleFactor, [&](ParsedScan& scan) {
+        if (!scan.ok || scan.points.empty()) return;
+        ScanAnalyzer::splitPoints(scan.points, xyz, values);
+        cellSize = autoCellSize(xyz.data(), scan.points.size(), options.cellsPerAxis);
+        binPoints(xyz.data(), values.data(), scan.points.size(), cellSize, cells[firstFile]);
+        ok[firstFile] = 1;
+      }, options.cancel);
+    }
+    if (!(cellSize > 0.0f)) {
+      out.failed = files;
+      out.cancelled = options.cancel && options.cancel->load();
+      return false;
+    }
+  }
+  out.cellSize = cellSize;
+
+  std::vector<std::string> rest(files.begin() + firstFile, files.end());
+  ScanAnalyzer::parseFiles(rest, options.scaleFactor, [&](ParsedScan& scan) {
+    if (!scan.ok) return;
+    std::vector<float> scanXyz, scanValues;
+    ScanAnalyzer::splitPoints(scan.points, scanXyz, scanValues);
+    size_t i = firstFile + scan.fileIndex;
+    binPoints(scanXyz.data(), scanValues.data(), scan.points.size(), cellSize, cells[i]);
+    ok[i] = 1;
+  }, options.cancel);
+
+  // Unreadable files are left out of the matrix
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (ok[i]) {
+      out.paths.push_back(files[i]);
+      out.cells.push_back(std::move(cells[i]));
+    }
+    else {
+      out.failed.push_back(files[i]);
+    }
+  }
+  out.cancelled = options.cancel && options.cancel->load();
+  out.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return !out.paths.empty();
+}
+
+void ScanSimilarity::computeMatrix(const ResampledScans& scans, const SimilarityOptions& options, SimilarityMatrix& out) {
+  out = SimilarityMatrix();
+  out.paths = scans.paths;
+  out.failed = scans.failed;
+  out.cellSize = scans.cellSize;
+  out.resampleMilliseconds = scans.milliseconds;
+  if (scans.cancelled || (options.cancel && options.cancel->load())) {
+    out.cancelled = true;
+    return;
+  }
+  buildMatrix(scans.cells, options.cancel, out);
+}
+
+void ScanSimilarity::computeFromPoints(const std::vector<const float*>& positions, const std::vector<const float*>& values,
+  const std::vector<size_t>& pointCounts, const SimilarityOptions& options, SimilarityMatrix& out) {
+  out = SimilarityMatrix();
+  auto start = std::chrono::steady_clock::now();
+  size_t n = positions.size();
+
+  float cellSize = options.cellSize;
+  for (size_t i = 0; i < n && !(cellSize > 0.0f); ++i) {
+    if (pointCounts[i] > 0) cellSize = autoCellSize(positions[i], pointCounts[i], options.cellsPerAxis);
+  }
+  if (!(cellSize > 0.0f)) cellSize = 1.0f;
+  out.cellSize = cellSize;
+
+  std::vector<SimilarityCells> cells(n);
+  JobSystem::parallelFor(0, n, 1, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) binPoints(positions[i], values[i], pointCounts[i], cellSize, cells[i]);
+  });
+  for (size_t i = 0; i < n; ++i) out.paths.push_back("scan " + std::to_string(i));
+  out.resampleMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  buildMatrix(cells, options.cancel, out);
+}
+
+void ScanSimilarity::writeCsv(std::ostream& out, const SimilarityMatrix& matrix, SimilarityMetric metric) {
+  size_t n = matrix.size();
+  out << getMetricName(metric);
+  for (const std::string& path : matrix.paths) out << "," << ScanAnalyzer::csvField(path);
+  out << "\n";
+  for (size_t row = 0; row < n; ++row) {
+    out << ScanAnalyzer::csvField(matrix.paths[row]);
+    for (size_t column = 0; column < n; ++column) {
+      float value = matrix.at(metric, row, column);
+      out << ",";
+      if (!std::isnan(value)) out << value;
+    }
+    out << "\n";
+  }
+}
+
+const char* ScanSimilarity::getMetricName(SimilarityMetric metric) {
+  return metric == SimilarityMetric::Rmse ? "rmse" : "correlation";
+}
@@ -0,0 +1,186 @@
+#include "ScanSlices.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <utility>
+
+// Rows of slice cells per contour job
+static const size_t CONTOUR_ROW_GRAIN = 16;
+
+void ScanSlices::slice(const VolumeGrid& grid, int normalAxis, float position, SliceImage& out) {
+  out.normalAxis = normalAxis;
+  out.axisU = normalAxis == 0 ? 1 : 0;
+  out.axisV = normalAxis == 2 ? 1 : 2;
+  out.position = position;
+  out.width = grid.dims[out.axisU];
+  out.height = grid.dims[out.axisV];
+  out.origin[0] = grid.origin[out.axisU];
+  out.origin[1] = grid.origin[out.axisV];
+  out.cellSize = grid.cellSize;
+  out.values.assign(static_cast<size_t>(out.width) * out.height, std::numeric_limits<float>::quiet_NaN());
+  if (out.values.empty() || grid.cellSize <= 0.0f) return;
+
+  // Layers below and above the cut; an empty node on one side gives way to the other
+  int layers = grid.dims[normalAxis];
+  float t = std::max(0.0f, std::min(static_cast<float>(layers - 1), (position - grid.origin[normalAxis]) / grid.cellSize));
+  int below = std::min(static_cast<int>(t), layers - 1);
+  int above = std::min(below + 1, layers - 1);
+  float fraction = t - below;
+
+  JobSystem::parallelFor(0, out.height, 16, [&](size_t firstRow, size_t lastRow) {
+    int node[3];
+    for (size_t v = firstRow; v < lastRow; ++v) {
+      node[out.axisV] = static_cast<int>(v);
+      for (int u = 0; u < out.width; ++u) {
+        node[out.axisU] = u;
+        node[normalAxis] = below;
+        float low = grid.values[grid.nodeIndex(node[0], node[1], node[2])];
+        node[normalAxis] = above;
+        float high = grid.values[grid.nodeIndex(node[0], node[1], node[2])];
+        float value;
+        if (std::isnan(low)) value = high;
+        else if (std::isnan(high)) value = low;
+        else value = low + fraction * (high - low);
+        out.values[v * out.width + u] = value;
+      }
+    }
+  });
+}
+
+// Segments per case, as pairs of cell edges (0 = bottom, 1 = right, 2 = top, 3 = left);
+// corner bits are 1 = (u, v), 2 = (u + 1, v), 4 = (u + 1, v + 1), 8 = (u, v + 1).
+// Cases 5 and 10 are saddles and list the split for an inside centre first.
+static const int CASE_SEGMENTS[16][4] = {
+  { -1, -1, -1, -1 }, { 3, 0, -1, -1 }, { 0, 1, -1, -1 }, { 3, 1, -1, -1 },
+  { 1, 2, -1, -1 }, { 0, 1, 2, 3 }, { 0, 2, -1, -1 }, { 3, 2, -1, -1 },
+  { 2, 3, -1, -1 }, { 0, 2, -1, -1 }, { 3, 0, 1, 2 }, { 1, 2, -1, -1 },
+  { 1, 3, -1, -1 }, { 0, 1, -1, -1 }, { 3, 0, -1, -1 }, { -1, -1, -1, -1 }
+};
+static const int SADDLE_OUTSIDE[2][4] = { { 3, 0, 1, 2 }, { 0, 1, 2, 3 } };  // Cases 5 and 10
+
+void ScanSlices::extractContours(const SliceImage& image, float level, std::vector<float>& segments) {
+  segments.clear();
+  if (image.width < 2 || image.height < 2) return;
+
+  size_t rows = static_cast<size_t>(image.height - 1);
+  size_t bandCount = (rows + CONTOUR_ROW_GRAIN - 1) / CONTOUR_ROW_GRAIN;
+  std::vector<std::vector<float>> bands(bandCount);
+  JobSystem::parallelFor(0, bandCount, 1, [&](size_t firstBand, size_t lastBand) {
+    for (size_t band = firstBand; band < lastBand; ++band) {
+      std::vector<float>& out = bands[band];
+      size_t lastRow = std::min(rows, (band + 1) * CONTOUR_ROW_GRAIN);
+      for (size_t v = band * CONTOUR_ROW_GRAIN; v < lastRow; ++v) {
+        const float* row = &image.values[v * image.width];
+        const float* next = row + image.width;
+        for (int u = 0; u + 1 < image.width; ++u) {
+          float a = row[u], b = row[u + 1], c = next[u + 1], d = next[u];
+          if (std::isnan(a) || std::isnan(b) || std::isnan(c) || std::isnan(d)) continue;
+          int index = (a >= level ? 1 : 0) | (b >= level ? 2 : 0) | (c >= level ? 4 : 0) | (d >= level ? 8 : 0);
+          if (index == 0 || index == 15) continue;
+
+          // Crossing on one edge, always interpolated from its lower node
+          auto crossing = [&](int edge, float& pu, float& pv) {
+            float from, to;
+            float fu = static_cast<float>(u), fv = static_cast<float>(v);
+            if (edge == 0 || edge == 2) {
+              from = edge == 0 ? a : d;
+              to = edge == 0 ? b : c;
+              pu = fu + (level - from) / (to - from);
+              pv = edge == 0 ? fv : fv + 1.0f;
+            }
+            else {
+              from = edge == 3 ? a : b;
+              to = edge == 3 ? d : c;
+              pu = edge == 3 ? fu : fu + 1.0f;
+              pv = fv + (level - from) / (to - from);
+            }
+            pu = image.origin[0] + pu * image.cellSize;
+            pv = image.origin[1] + pv * image.cellSize;
+          };
+
+          const int* edges = CASE_SEGMENTS[index];
+          if ((index == 5 || index == 10) && 0.25f * (a + b + c + d) < level) edges = SADDLE_OUTSIDE[index == 5 ? 0 : 1];
+          for (int s = 0; s < 4 && edges[s] >= 0; s += 2) {
+            float u0, v0, u1, v1;
+            crossing(edges[s], u0, v0);
+            crossing(edges[s + 1], u1, v1);
+            out.insert(out.end(), { u0, v0, u1, v1 });
+          }
+        }
+      }
+    }
+  });
+  for (const std::vector<float>& band : bands) segments.insert(segments.end(), band.begin(), band.end());
+}
+
+static uint64_t pointKey(const float* point) {
+  uint32_t u, v;
+  std::memcpy(&u, &point[0], sizeof(u));
+  std::memcpy(&v, &point[1], sizeof(v));
+  return static_cast<uint64_t>(u) << 32 | v;
+}
+
+void ScanSlices::chainContours(const std::vector<float>& segments, std::vector<ContourLine>& out) {
+  out.clear();
+  size_t segmentCount = segments.size() / 4;
+  // Segment ends sorted by position; end e of segment s is stored as 2 * s + e
+  std::vector<std::pair<uint64_t, uint32_t>> ends(segmentCount * 2);
+  for (size_t i = 0; i < ends.size(); ++i) ends[i] = { pointKey(&segments[i * 2]), static_cast<uint32_t>(i) };
+  std::sort(ends.begin(), ends.end());
+  auto sharing = [&](uint64_t key) {
+    auto range = std::equal_range(ends.begin(), ends.end(), std::make_pair(key, uint32_t(0)),
+      [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) { return a.first < b.first; });
+    return std::make_pair(range.first, range.second);
+  };
+
+  std::vector<bool> used(segmentCount, false);
+  auto follow = [&](size_t seed, int startEnd) {
+    ContourLine line;
+    used[seed] = true;
+    const float* first = &segments[(seed * 2 + startEnd) * 2];
+    const float* current = &segments[(seed * 2 + 1 - startEnd) * 2];
+    line.points.insert(line.points.end(), { first[0], first[1], current[0], current[1] });
+    uint64_t startKey = pointKey(first);
+    for (;;) {
+      uint64_t key = pointKey(current);
+      if (key == startKey) {
+        line.closed = true;
+        line.points.resize(line.points.size() - 2);
+        break;
+      }
+      auto range = sharing(key);
+      auto next = range.first;
+      while (next != range.second && used[next->second / 2]) ++next;
+      if (next == range.second) break;
+      used[next->second / 2] = true;
+      current = &segments[(next->second ^ 1u) * 2];
+      line.points.insert(line.points.end(), { current[0], current[1] });
+    }
+    out.push_back(std::move(line));
+  };
+
+  // Open lines start at an end no other segment shares; whatever is left forms loops
+  for (size_t i = 0; i < ends.size(); ++i) {
+    uint32_t end = ends[i].second;
+    if (used[end / 2]) continue;
+    auto range = sharing(ends[i].first);
+    if (range.second - range.first == 1) follow(end / 2, static_cast<int>(end & 1u));
+  }
+  for (size_t s = 0; s < segmentCount; ++s) {
+    if (!used[s]) follow(s, 0);
+  }
+}
+
+bool ScanSlices::findPeak(const VolumeGrid& grid, float position[3]) {
+  size_t best = grid.values.size();
+  for (size_t i = 0; i < grid.values.size(); ++i) {
+    if (!std::isnan(grid.values[i]) && (best == grid.values.size() || grid.values[i] > grid.values[best])) best = i;
+  }
+  if (best == grid.values.size()) return false;
+  size_t layer = static_cast<size_t>(grid.dims[0]) * grid.dims[1];
+  size_t node[3] = { best % grid.dims[0], best % layer / grid.dims[0], best / layer };
+  for (int a = 0; a < 3; ++a) position[a] = grid.origin[a] + node[a] * grid.cellSize;
+  return true;
+}
@@ -0,0 +1,207 @@
+#include "ScanStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+ScanStatistics::ScanStatistics(int histogramBins, double compression)
+  : compression(compression) {
+  // An even bin count lets the histogram halve its resolution by merging pairs
+  int bins = std::max(2, histogramBins + (histogramBins & 1));
+  histogram.assign(bins, 0);
+  clear();
+}
+
+void ScanStatistics::clear() {
+  count = 0;
+  mean = 0.0;
+  m2 = 0.0;
+  minValue = std::numeric_limits<float>::max();
+  maxValue = std::numeric_limits<float>::lowest();
+
+  centroids.clear();
+  pending.clear();
+
+  std::fill(histogram.begin(), histogram.end(), 0);
+  histogramLow = 0.0;
+  histogramBinWidth = 0.0;
+  firstValue = 0.0f;
+  firstValueCount = 0;
+}
+
+void ScanStatistics::add(float value) {
+  if (!std::isfinite(value)) return;
+
+  // Welford update
+  count++;
+  double delta = value - mean;
+  mean += delta / static_cast<double>(count);
+  m2 += delta * (value - mean);
+  minValue = std::min(minValue, value);
+  maxValue = std::max(maxValue, value);
+
+  // Values are buffered and folded into the digest in sorted batches
+  pending.push_back(value);
+  if (pending.size() >= static_cast<size_t>(compression * 5.0)) {
+    mergePending();
+  }
+
+  addToHistogram(value, 1);
+}
+
+void ScanStatistics::addRange(const float* values, size_t valueCount) {
+  for (size_t i = 0; i < valueCount; ++i) {
+    add(values[i]);
+  }
+}
+
+double ScanStatistics::getVariance() const {
+  return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0;
+}
+
+double ScanStatistics::getStdDev() const {
+  return std::sqrt(getVariance());
+}
+
+size_t ScanStatistics::getCentroidCount() const {
+  mergePending();
+  return centroids.size();
+}
+
+// k1 scale function of the t-digest: keeps centroids small near the tails
+static double scaleK(double q, double compression) {
+  return compression / (2.0 * M_PI) * std::asin(2.0 * q - 1.0);
+}
+
+static double scaleKInverse(double k, double compression) {
+  return (std::sin(k * 2.0 * M_PI / compression) + 1.0) / 2.0;
+}
+
+void ScanStatistics::mergePending() const {
+  if (pending.empty()) return;
+
+  std::vector<Centroid> all;
+  all.reserve(centroids.size() + pending.size());
+  all.insert(all.end(), centroids.begin(), centroids.end());
+  for (float v : pending) {
+    all.push_back({ static_cast<double>(v), 1.0 });
+  }
+  pending.clear();
+
+  std::sort(all.begin(), all.end(), [](const Centroid& a, const Centroid& b) {
+    return a.mean < b.mean;
+  });
+
+  double total = 0.0;
+  for (const auto& c : all) total += c.weight;
+
+  centroids.clear();
+  Centroid current = all[0];
+  double weightSoFar = 0.0;
+  double weightLimit = total * scaleKInverse(scaleK(0.0, compression) + 1.0, compression);
+
+  for (size_t i = 1; i < all.size(); ++i) {
+    const Centroid& next = all[i];
+    if (weightSoFar + current.weight + next.weight <= weightLimit) {
+      // Absorb into the current centroid
+      current.weight += next.weight;
+      current.mean += (next.mean - current.mean) * next.weight / current.weight;
+    }
+    else {
+      weightSoFar += current.weight;
+      centroids.push_back(current);
+      weightLimit = total * scaleKInverse(scaleK(std::min(1.0, weightSoFar / total), compression) + 1.0, compression);
+      current = next;
+    }
+  }
+  centroids.push_back(current);
+}
+
+float ScanStatistics::getPercentile(double fraction) const {
+  if (count == 0) return 0.0f;
+  mergePending();
+
+  fraction = std::max(0.0, std::min(1.0, fraction));
+  if (centroids.size() == 1) return static_cast<float>(centroids[0].mean);
+
+  double total = static_cast<double>(count);
+  double target = fraction * total;
+
+  // Centroid i is treated as sitting at cumulative weight (left + weight / 2)
+  double left = 0.0;
+  double prevCenter = 0.0;
+  double prevMean = minValue;
+  for (const auto& c : centroids) {
+    double center = left + c.weight / 2.0;
+    if (target < center) {
+      double span = center - prevCenter;
+      double t = span > 0.0 ? (target - prevCenter) / span : 0.0;
+      return static_cast<float>(prevMean + t * (c.mean - prevMean));
+    }
+    prevCenter = center;
+    prevMean = c.mean;
+    left += c.weight;
+  }
+
+  // Past the last centroid: interpolate towards the maximum
+  double span = total - prevCenter;
+  double t = span > 0.0 ? (target - prevCenter) / span : 1.0;
+  return static_cast<float>(prevMean + t * (maxValue - prevMean));
+}
+
+void ScanStatistics::addToHistogram(float value, uint64_t weight) {
+  int bins = static_cast<int>(histogram.size());
+
+  if (histogramBinWidth == 0.0) {
+    // The range is undefined until two distinct values have arrived
+    if (firstValueCount == 0 || value == firstValue) {
+      firstValue = value;
+      firstValueCount += weight;
+      return;
+    }
+
+    double lo = std::min(firstValue, value);
+    double hi = std::max(firstValue, value);
+    histogramLow = lo;
+    histogramBinWidth = (hi - lo) / (bins / 2);
+
+    uint64_t firstCount = firstValueCount;
+    firstValueCount = 0;
+    addToHistogram(firstValue, firstCount);
+  }
+
+  while (value < histogramLow) growHistogramDown();
+  while (value >= histogramLow + histogramBinWidth * bins) growHistogramUp();
+
+  int bin = static_cast<int>((value - histogramLow) / histogramBinWidth);
+  bin = std::max(0, std::min(bins - 1, bin));
+  histogram[bin] += weight;
+}
+
+void ScanStatistics::growHistogramDown() {
+  // Old range becomes the upper half at half the resolution
+  int bins = static_cast<int>(histogram.size());
+  int half = bins / 2;
+  std::vector<uint64_t> merged(bins, 0);
+  for (int i = 0; i < half; ++i) {
+    merged[half + i] = histogram[2 * i] + histogram[2 * i + 1];
+  }
+  histogram.swap(merged);
+  histogramLow -= histogramBinWidth * bins;
+  histogramBinWidth *= 2.0;
+}
+
+void ScanStatistics::growHistogramUp() {
+  // Old range becomes the lower half at half the resolution
+  int bins = static_cast<int>(histogram.size());
+  int half = bins / 2;
+  std::vector<uint64_t> merged(bins, 0);
+  for (int i = 0; i < half; ++i) {
+    merged[i] = histogram[2 * i] + histogram[2 * i + 1];
+  }
+  histogram.swap(merged);
+  histogramBinWidth *= 2.0;
+}
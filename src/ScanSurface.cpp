@@ -0,0 +1,368 @@
+#include "ScanSurface.h"
+#include "JobSystem.h"
+#include "VerticesLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// Flips need the in-circle determinant to clear rounding by this margin, so the
+// cocircular quadruples of a regular raster cannot flip back and forth
+static const double INCIRCLE_TOLERANCE = 1e-12;
+
+// Super-triangle size in multiples of the point extent
+static const double SUPER_TRIANGLE_SCALE = 100.0;
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+namespace {
+
+// n[i] is the triangle across the edge opposite v[i]; -1 = none. Vertices are counter-clockwise.
+struct Triangle {
+  uint32_t v[3];
+  int32_t n[3];
+};
+
+class Triangulator {
+public:
+  Triangulator(const double* uv, size_t pointCount) : count(pointCount), x(pointCount + 3), y(pointCount + 3) {
+    for (size_t i = 0; i < pointCount; ++i) {
+      x[i] = uv[i * 2];
+      y[i] = uv[i * 2 + 1];
+    }
+  }
+
+  // Enclose everything in one large triangle of three extra vertices
+  void begin(double minX, double minY, double maxX, double maxY) {
+    double size = std::max(std::max(maxX - minX, maxY - minY), 1e-9) * SUPER_TRIANGLE_SCALE;
+    double centerX = 0.5 * (minX + maxX), centerY = 0.5 * (minY + maxY);
+    uint32_t a = static_cast<uint32_t>(count), b = a + 1, c = a + 2;
+    x[a] = centerX - 2.0 * size; y[a] = centerY - size;
+    x[b] = centerX + 2.0 * size; y[b] = centerY - size;
+    x[c] = centerX;              y[c] = centerY + 2.0 * size;
+    triangles.clear();
+    triangles.reserve(count * 2 + 16);
+    triangles.push_back(Triangle{ { a, b, c }, { -1, -1, -1 } });
+    last = 0;
+  }
+
+  // false when p coincides with a vertex already in the triangulation
+  bool insert(uint32_t p) {
+    int32_t t = last;
+    int zeroEdge = -1;
+    // Walk towards p across any edge it lies beyond; the starting edge rotates so the walk cannot cycle
+    for (;;) {
+      const Triangle& tri = triangles[t];
+      int zeros = 0;
+      int32_t next = -1;
+      for (int k = 0; k < 3; ++k) {
+        int i = (k + rotation) % 3;
+        double o = orient(tri.v[(i + 1) % 3], tri.v[(i + 2) % 3], p);
+        if (o < 0.0) {
+          next = tri.n[i];
+          break;
+        }
+        if (o == 0.0) {
+          zeros++;
+          zeroEdge = i;
+        }
+      }
+      rotation = (rotation + 1) % 3;
+      if (next < 0) {
+        if (zeros >= 2) return false;
+        if (zeros == 0) zeroEdge = -1;
+        break;
+      }
+      t = next;
+    }
+
+    if (zeroEdge < 0) splitTriangle(t, p);
+    else splitEdge(t, zeroEdge, p);
+    legalize();
+    last = t;
+    return true;
+  }
+
+  // Triangles of input points only (those touching the super triangle are the hull's outside)
+  void collect(std::vector<uint32_t>& out) const {
+    out.clear();
+    for (const Triangle& tri : triangles) {
+      if (tri.v[0] < count && tri.v[1] < count && tri.v[2] < count) out.insert(out.end(), tri.v, tri.v + 3);
+    }
+  }
+
+private:
+  size_t count;
+  std::vector<double> x, y;
+  std::vector<Triangle> triangles;
+  std::vector<int32_t> flipStack;  // Triangles whose edge opposite v[0] (the new point) needs a check
+  int32_t last = 0;
+  int rotation = 0;
+
+  double orient(uint32_t a, uint32_t b, uint32_t c) const {
+    return (x[b] - x[a]) * (y[c] - y[a]) - (y[b] - y[a]) * (x[c] - x[a]);
+  }
+
+  // d strictly inside the circle through the counter-clockwise a, b, c
+  bool inCircle(uint32_t a, uint32_t b, uint32_t c, uint32_t d) const {
+    double adx = x[a] - x[d], ady = y[a] - y[d];
+    double bdx = x[b] - x[d], bdy = y[b] - y[d];
+    double cdx = x[c] - x[d], cdy = y[c] - y[d];
+    double aLift = adx * adx + ady * ady, bLift = bdx * bdx + bdy * bdy, cLift = cdx * cdx + cdy * cdy;
+    double det = aLift * (bdx * cdy - cdx * bdy) + bLift * (cdx * ady - adx * cdy) + cLift * (adx * bdy - bdx * ady);
+    double bound = aLift * (std::fabs(bdx * cdy) + std::fabs(cdx * bdy)) + bLift * (std::fabs(cdx * ady) + std::fabs(adx * cdy))
+      + cLift * (std::fabs(adx * bdy) + std::fabs(bdx * ady));
+    return det > bound * INCIRCLE_TOLERANCE;
+  }
+
+  void replaceNeighbor(int32_t t, int32_t from, int32_t to) {
+    if (t < 0) return;
+    Triangle& tri = triangles[t];
+    for (int i = 0; i < 3; ++i) {
+      if (tri.n[i] == from) {
+        tri.n[i] = to;
+        return;
+      }
+    }
+  }
+
+  // p strictly inside t = (a, b, c): three triangles around p
+  void splitTriangle(int32_t t, uint32_t p) {
+    Triangle old = triangles[t];
+    int32_t t1 = static_cast<int32_t>(triangles.size()), t2 = t1 + 1;
+    uint32_t a = old.v[0], b = old.v[1], c = old.v[2];
+    triangles[t] = Triangle{ { p, b, c }, { old.n[0], t1, t2 } };
+    triangles.push_back(Triangle{ { p, c, a }, { old.n[1], t2, t } });
+    triangles.push_back(Triangle{ { p, a, b }, { old.n[2], t, t1 } });
+    replaceNeighbor(old.n[1], t, t1);
+    replaceNeighbor(old.n[2], t, t2);
+    flipStack.push_back(t);
+    flipStack.push_back(t1);
+    flipStack.push_back(t2);
+  }
+
+  // p on the edge of t opposite vertex i: both triangles sharing it split in two
+  void splitEdge(int32_t t, int i, uint32_t p) {
+    Triangle old = triangles[t];
+    uint32_t a = old.v[i], b = old.v[(i + 1) % 3], c = old.v[(i + 2) % 3];
+    int32_t nB = old.n[(i + 1) % 3], nC = old.n[(i + 2) % 3];
+    int32_t u = old.n[i];
+    int32_t t1 = static_cast<int32_t>(triangles.size());
+
+    if (u < 0) {
+      triangles[t] = Triangle{ { p, c, a }, { nB, t1, -1 } };
+      triangles.push_back(Triangle{ { p, a, b }, { nC, -1, t } });
+      replaceNeighbor(nC, t, t1);
+      flipStack.push_back(t);
+      flipStack.push_back(t1);
+      return;
+    }
+
+    Triangle other = triangles[u];
+    int j = other.n[0] == t ? 0 : other.n[1] == t ? 1 : 2;
+    uint32_t d = other.v[j];
+    int32_t uB = other.n[(j + 1) % 3], uC = other.n[(j + 2) % 3];
+    int32_t u1 = t1 + 1;
+    triangles[t] = Triangle{ { p, c, a }, { nB, t1, u1 } };
+    triangles.push_back(Triangle{ { p, a, b }, { nC, u, t } });
+    triangles[u] = Triangle{ { p, b, d }, { uB, u1, t1 } };
+    triangles.push_back(Triangle{ { p, d, c }, { uC, t, u } });
+    replaceNeighbor(nC, t, t1);
+    replaceNeighbor(uC, u, u1);
+    flipStack.push_back(t);
+    flipStack.push_back(t1);
+    flipStack.push_back(u);
+    flipStack.push_back(u1);
+  }
+
+  // Lawson flips: every triangle on the stack has the new point at v[0]
+  void legalize() {
+    while (!flipStack.empty()) {
+      int32_t t = flipStack.back();
+      flipStack.pop_back();
+      Triangle& tri = triangles[t];
+      int32_t u = tri.n[0];
+      if (u < 0) continue;
+      Triangle& other = triangles[u];
+      int j = other.n[0] == t ? 0 : other.n[1] == t ? 1 : 2;
+      uint32_t q = other.v[j];
+      if (!inCircle(tri.v[0], tri.v[1], tri.v[2], q)) continue;
+
+      uint32_t p = tri.v[0], b = tri.v[1], c = tri.v[2];
+      int32_t tA = tri.n[1], tB = tri.n[2];
+      int32_t uA = other.n[(j + 1) % 3], uB = other.n[(j + 2) % 3];
+      tri = Triangle{ { p, b, q }, { uA, u, tB } };
+      other = Triangle{ { p, q, c }, { uB, tA, t } };
+      replaceNeighbor(uA, u, t);
+      replaceNeighbor(tA, t, u);
+      flipStack.push_back(t);
+      flipStack.push_back(u);
+    }
+  }
+};
+
+// Position along a Hilbert curve over a 65536 x 65536 grid
+uint32_t hilbertIndex(uint32_t x, uint32_t y) {
+  const uint32_t n = 1u << 16;
+  uint32_t index = 0;
+  for (uint32_t s = n / 2; s > 0; s /= 2) {
+    uint32_t rx = (x & s) > 0, ry = (y & s) > 0;
+    index += s * s * ((3 * rx) ^ ry);
+    if (ry == 0) {
+      if (rx == 1) {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+}
+
+size_t ScanSurface::triangulate(const double* uv, size_t pointCount, std::vector<uint32_t>& triangles, double* sortMilliseconds) {
+  triangles.clear();
+  if (pointCount < 3) return 0;
+  auto start = std::chrono::steady_clock::now();
+
+  double minX = std::numeric_limits<double>::infinity(), minY = minX, maxX = -minX, maxY = -minX;
+  for (size_t i = 0; i < pointCount; ++i) {
+    minX = std::min(minX, uv[i * 2]);
+    maxX = std::max(maxX, uv[i * 2]);
+    minY = std::min(minY, uv[i * 2 + 1]);
+    maxY = std::max(maxY, uv[i * 2 + 1]);
+  }
+
+  // Insertion order along the curve keeps consecutive points (and the walks between them) local.
+  // Keys are curve position << 32 | point index, so a plain integer sort orders them.
+  std::vector<uint64_t> order(pointCount);
+  double scaleX = maxX > minX ? 65535.0 / (maxX - minX) : 0.0;
+  double scaleY = maxY > minY ? 65535.0 / (maxY - minY) : 0.0;
+  JobSystem::parallelFor(0, pointCount, 65536, [&](size_t first, size_t last) {
+    for (size_t i = first; i < last; ++i) {
+      uint32_t cellX = static_cast<uint32_t>((uv[i * 2] - minX) * scaleX);
+      uint32_t cellY = static_cast<uint32_t>((uv[i * 2 + 1] - minY) * scaleY);
+      order[i] = static_cast<uint64_t>(hilbertIndex(cellX, cellY)) << 32 | i;
+    }
+  });
+  std::sort(order.begin(), order.end());
+  if (sortMilliseconds) *sortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  Triangulator triangulator(uv, pointCount);
+  triangulator.begin(minX, minY, maxX, maxY);
+  // Repeated positions land on an existing vertex and are left out
+  size_t duplicates = 0;
+  for (uint64_t key : order) {
+    if (!triangulator.insert(static_cast<uint32_t>(key))) duplicates++;
+  }
+  triangulator.collect(triangles);
+  return duplicates;
+}
+
+void ScanSurface::build(const float* positions, size_t pointCount, const SurfaceOptions& options, SurfaceMesh& out) {
+  out = SurfaceMesh();
+  if (pointCount < 3) return;
+
+  float minCorner[3], maxCorner[3];
+  for (int a = 0; a < 3; ++a) minCorner[a] = maxCorner[a] = positions[a];
+  for (size_t i = 1; i < pointCount; ++i) {
+    for (int a = 0; a < 3; ++a) {
+      minCorner[a] = std::min(minCorner[a], positions[i * 3 + a]);
+      maxCorner[a] = std::max(maxCorner[a], positions[i * 3 + a]);
+    }
+  }
+  switch (options.plane) {
+  case SurfacePlane::XY: out.heightAxis = 2; break;
+  case SurfacePlane::XZ: out.heightAxis = 1; break;
+  case SurfacePlane::YZ: out.heightAxis = 0; break;
+  default: {
+    float extent[3] = { maxCorner[0] - minCorner[0], maxCorner[1] - minCorner[1], maxCorner[2] - minCorner[2] };
+    out.heightAxis = static_cast<int>(std::min_element(extent, extent + 3) - extent);
+  }
+  }
+  out.axisU = out.heightAxis == 0 ? 1 : 0;
+  out.axisV = out.heightAxis == 2 ? 1 : 2;
+
+  std::vector<double> uv(pointCount * 2);
+  for (size_t i = 0; i < pointCount; ++i) {
+    uv[i * 2] = positions[i * 3 + out.axisU];
+    uv[i * 2 + 1] = positions[i * 3 + out.axisV];
+  }
+  auto start = std::chrono::steady_clock::now();
+  out.duplicateCount = triangulate(uv.data(), pointCount, out.triangles, &out.sortMilliseconds);
+  out.vertexCount = pointCount - out.duplicateCount;
+  out.delaunayCount = out.triangles.size() / 3;
+  auto triangulated = std::chrono::steady_clock::now();
+  out.triangulateMilliseconds = std::chrono::duration<double, std::milli>(triangulated - start).count() - out.sortMilliseconds;
+
+  // Triangles spanning gaps between passes (or the concave parts of the hull) are far longer than the raster spacing
+  if (options.maxEdgeFactor > 0.0f && !out.triangles.empty()) {
+    size_t triangleCount = out.triangles.size() / 3;
+    std::vector<float> longest(triangleCount);
+    JobSystem::parallelFor(0, triangleCount, 16384, [&](size_t first, size_t last) {
+      for (size_t t = first; t < last; ++t) {
+        float edge = 0.0f;
+        for (int e = 0; e < 3; ++e) {
+          uint32_t a = out.triangles[t * 3 + e], b = out.triangles[t * 3 + (e + 1) % 3];
+          float du = static_cast<float>(uv[a * 2] - uv[b * 2]), dv = static_cast<float>(uv[a * 2 + 1] - uv[b * 2 + 1]);
+          edge = std::max(edge, du * du + dv * dv);
+        }
+        longest[t] = edge;
+      }
+    });
+    std::vector<float> sorted(longest);
+    std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+    float limit = sorted[sorted.size() / 2] * options.maxEdgeFactor * options.maxEdgeFactor;
+    size_t kept = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+      if (longest[t] > limit) continue;
+      for (int k = 0; k < 3; ++k) out.triangles[kept * 3 + k] = out.triangles[t * 3 + k];
+      kept++;
+    }
+    out.triangles.resize(kept * 3);
+  }
+  out.filterMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - triangulated).count();
+}
+
+void ScanSurface::liftVertices(const float* positions, const float* values, size_t pointCount, const SurfaceMesh& mesh,
+  float minValue, float maxValue, float height, std::vector<float>& out) {
+  out.assign(positions, positions + pointCount * 3);
+  if (pointCount == 0) return;
+  float base = positions[mesh.heightAxis];
+  for (size_t i = 1; i < pointCount; ++i) base = std::min(base, positions[i * 3 + mesh.heightAxis]);
+  float range = maxValue > minValue ? maxValue - minValue : 1.0f;
+  size_t outlierCount = 0;
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (!isInlier(values[i])) {
+      outlierCount++;
+      continue;
+    }
+    float normalized = std::max(0.0f, std::min(1.0f, (values[i] - minValue) / range));
+    out[i * 3 + mesh.heightAxis] = base + normalized * height;
+  }
+  if (outlierCount == 0) return;
+
+  // Outliers and NaN carry no height of their own: they take the mean height of the
+  // inlier vertices they share a triangle with, or the base when they have none
+  std::vector<double> heightSum(pointCount, 0.0);
+  std::vector<uint32_t> heightCount(pointCount, 0);
+  for (size_t t = 0; t + 2 < mesh.triangles.size(); t += 3) {
+    for (int a = 0; a < 3; ++a) {
+      uint32_t vertex = mesh.triangles[t + a];
+      if (vertex >= pointCount || isInlier(values[vertex])) continue;
+      for (int b = 0; b < 3; ++b) {
+        uint32_t neighbor = mesh.triangles[t + b];
+        if (neighbor >= pointCount || !isInlier(values[neighbor])) continue;
+        heightSum[vertex] += out[neighbor * 3 + mesh.heightAxis];
+        heightCount[vertex]++;
+      }
+    }
+  }
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (isInlier(values[i])) continue;
+    out[i * 3 + mesh.heightAxis] = heightCount[i] > 0 ? static_cast<float>(heightSum[i] / heightCount[i]) : base;
+  }
+}
@@ -0,0 +1,333 @@
+#include "ScanVolume.h"
+#include "KdTree.h"
+#include "VerticesLoader.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// Measurements sampled for the spacing estimate
+static const size_t SPACING_SAMPLES = 2048;
+
+// The six tetrahedra of a cell, as corner indices (bit 0 = +x, bit 1 = +y, bit 2 = +z).
+// Each is a monotone path from corner 0 to corner 7, so every edge joins a corner to one
+// whose bits are a superset, and neighbouring cells split their shared faces the same way.
+static const int TETRAHEDRA[6][4] = {
+  { 0, 1, 3, 7 }, { 0, 3, 2, 7 }, { 0, 2, 6, 7 }, { 0, 6, 4, 7 }, { 0, 4, 5, 7 }, { 0, 5, 1, 7 }
+};
+
+static bool isInlier(float value) {
+  return value > -VerticesLoader::VALUE_OUTLIER_LIMIT && value < VerticesLoader::VALUE_OUTLIER_LIMIT;
+}
+
+// Set every node within radius nodes (per axis) of a set node, one axis at a time
+static void dilateMask(std::vector<uint8_t>& mask, const int dims[3], int radius) {
+  std::vector<int> prefix;
+  size_t strides[3] = { 1, static_cast<size_t>(dims[0]), static_cast<size_t>(dims[0]) * dims[1] };
+  for (int axis = 0; axis < 3; ++axis) {
+    int length = dims[axis];
+    if (length < 2) continue;
+    int u = axis == 0 ? 1 : 0, v = axis == 2 ? 1 : 2;
+    prefix.resize(length + 1);
+    for (int j = 0; j < dims[v]; ++j) {
+      for (int i = 0; i < dims[u]; ++i) {
+        size_t base = i * strides[u] + j * strides[v];
+        prefix[0] = 0;
+        for (int t = 0; t < length; ++t) prefix[t + 1] = prefix[t] + mask[base + t * strides[axis]];
+        for (int t = 0; t < length; ++t) {
+          int first = std::max(0, t - radius), last = std::min(length, t + radius + 1);
+          mask[base + t * strides[axis]] = prefix[last] > prefix[first] ? 1 : 0;
+        }
+      }
+    }
+  }
+}
+
+void ScanVolume::grid(const float* positions, const float* values, size_t pointCount,
+  const VolumeGridOptions& options, VolumeGrid& out) {
+  out = VolumeGrid();
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<float> kept;
+  std::vector<float> keptValues;
+  kept.reserve(pointCount * 3);
+  keptValues.reserve(pointCount);
+  float low[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+  float high[3] = { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+  out.peakValue = std::numeric_limits<float>::lowest();
+  for (size_t i = 0; i < pointCount; ++i) {
+    if (!isInlier(values[i])) continue;
+    for (int a = 0; a < 3; ++a) {
+      float p = positions[i * 3 + a];
+      kept.push_back(p);
+      low[a] = std::min(low[a], p);
+      high[a] = std::max(high[a], p);
+    }
+    keptValues.push_back(values[i]);
+    out.peakValue = std::max(out.peakValue, values[i]);
+  }
+  out.measurementCount = keptValues.size();
+  if (keptValues.empty()) {
+    out.peakValue = 0.0f;
+    return;
+  }
+
+  KdTree tree;
+  tree.build(kept.data(), keptValues.size());
+
+  // Typical measurement spacing from the nearest neighbour of a sample (repeated positions ignored)
+  std::vector<float> distances;
+  std::vector<KdNeighbor> found;
+  size_t stride = std::max<size_t>(1, keptValues.size() / SPACING_SAMPLES);
+  for (size_t i = 0; i < keptValues.size(); i += stride) {
+    tree.findNearest(&kept[i * 3], 8, found);
+    for (const KdNeighbor& n : found) {
+      if (n.distanceSquared > 0.0f) {
+        distances.push_back(n.distanceSquared);
+        break;
+      }
+    }
+  }
+  if (!distances.empty()) {
+    std::nth_element(distances.begin(), distances.begin() + distances.size() / 2, distances.end());
+    out.spacing = std::sqrt(distances[distances.size() / 2]);
+  }
+  auto indexed = std::chrono::steady_clock::now();
+  out.indexMilliseconds = std::chrono::duration<double, std::milli>(indexed - start).count();
+
+  // Cubic cells sized by the longest extent; a flat axis keeps a single layer of nodes
+  float longest = std::max({ high[0] - low[0], high[1] - low[1], high[2] - low[2] });
+  int resolution = std::max(2, options.resolution);
+  out.cellSize = longest > 0.0f ? longest / (resolution - 1) : 1.0f;
+  for (int a = 0; a < 3; ++a) {
+    float extent = high[a] - low[a];
+    out.dims[a] = extent > 1e-3f * longest ? static_cast<int>(std::ceil(extent / out.cellSize - 1e-4f)) + 1 : 1;
+    out.origin[a] = low[a] - 0.5f * ((out.dims[a] - 1) * out.cellSize - extent);
+  }
+  out.values.assign(static_cast<size_t>(out.dims[0]) * out.dims[1] * out.dims[2], std::numeric_limits<float>::quiet_NaN());
+
+  float reach = options.maxDistanceFactor * std::max(out.spacing, out.cellSize);
+  float reachSquared = options.maxDistanceFactor > 0.0f ? reach * reach : std::numeric_limits<float>::infinity();
+  size_t k = std::max<size_t>(1, options.neighbours);
+  float halfPower = 0.5f * options.power;
+  bool inverseSquare = options.power == 2.0f;
+
+  // Nodes with no measurement in the surrounding box of nodes cannot be within reach; k-NN
+  // queries far from every point are the slowest, so they are skipped up front
+  std::vector<uint8_t> nearScan;
+  if (reachSquared < std::numeric_limits<float>::infinity()) {
+    nearScan.assign(out.values.size(), 0);
+    for (size_t i = 0; i < keptValues.size(); ++i) {
+      int node[3];
+      for (int a = 0; a < 3; ++a) {
+        int n = static_cast<int>(std::lround((kept[i * 3 + a] - out.origin[a]) / out.cellSize));
+        node[a] = std::max(0, std::min(out.dims[a] - 1, n));
+      }
+      nearScan[out.nodeIndex(node[0], node[1], node[2])] = 1;
+    }
+    dilateMask(nearScan, out.dims, static_cast<int>(std::ceil(reach / out.cellSize)) + 1);
+  }
+
+  JobSystem::parallelFor(0, out.dims[2], 1, [&](size_t firstSlab, size_t lastSlab) {
+    std::vector<KdNeighbor> neighbours;
+    for (size_t z = firstSlab; z < lastSlab; ++z) {
+      if (options.cancel && options.cancel->load(std::memory_order_relaxed)) return;
+      for (int y = 0; y < out.dims[1]; ++y) {
+        for (int x = 0; x < out.dims[0]; ++x) {
+          float node[3] = { out.origin[0] + x * out.cellSize, out.origin[1] + y * out.cellSize,
+            out.origin[2] + static_cast<float>(z) * out.cellSize };
+          size_t index = out.nodeIndex(x, y, static_cast<int>(z));
+          if (!nearScan.empty() && !nearScan[index]) continue;
+          tree.findNearest(node, k, neighbours);
+          if (neighbours.empty() || neighbours[0].distanceSquared > reachSquared) continue;
+
+          float value;
+          if (neighbours[0].distanceSquared <= 1e-12f * out.cellSize * out.cellSize) {
+            value = keptValues[neighbours[0].index];
+          }
+          else {
+            double weighted = 0.0, weights = 0.0;
+            for (const KdNeighbor& n : neighbours) {
+              double w = inverseSquare ? 1.0 / n.distanceSquared : 1.0 / std::pow(static_cast<double>(n.distanceSquared), halfPower);
+              weighted += w * keptValues[n.index];
+              weights += w;
+            }
+            value = static_cast<float>(weighted / weights);
+          }
+          out.values[index] = value;
+        }
+      }
+    }
+  });
+
+  if (options.cancel && options.cancel->load()) {
+    out.cancelled = true;
+    return;
+  }
+
+  out.minValue = std::numeric_limits<float>::max();
+  out.maxValue = std::numeric_limits<float>::lowest();
+  for (float v : out.values) {
+    if (std::isnan(v)) {
+      out.emptyCount++;
+      continue;
+    }
+    out.minValue = std::min(out.minValue, v);
+    out.maxValue = std::max(out.maxValue, v);
+  }
+  if (out.emptyCount == out.values.size()) out.minValue = out.maxValue = 0.0f;
+  out.gridMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - indexed).count();
+}
+
+float ScanVolume::levelFromDecibels(const VolumeGrid& grid, float decibels) {
+  return grid.peakValue * std::pow(10.0f, decibels / 10.0f);
+}
+
+// Gradient at a node by central differences, one-sided next to the border or an empty node
+static void nodeGradient(const VolumeGrid& grid, int x, int y, int z, float gradient[3]) {
+  int at[3] = { x, y, z };
+  float centre = grid.values[grid.nodeIndex(x, y, z)];
+  for (int a = 0; a < 3; ++a) {
+    int lowAt[3] = { x, y, z }, highAt[3] = { x, y, z };
+    lowAt[a] = std::max(0, at[a] - 1);
+    highAt[a] = std::min(grid.dims[a] - 1, at[a] + 1);
+    float lowValue = grid.values[grid.nodeIndex(lowAt[0], lowAt[1], lowAt[2])];
+    float highValue = grid.values[grid.nodeIndex(highAt[0], highAt[1], highAt[2])];
+    if (std::isnan(lowValue)) {
+      lowValue = centre;
+      lowAt[a] = at[a];
+    }
+    if (std::isnan(highValue)) {
+      highValue = centre;
+      highAt[a] = at[a];
+    }
+    int span = highAt[a] - lowAt[a];
+    gradient[a] = span > 0 ? (highValue - lowValue) / (span * grid.cellSize) : 0.0f;
+  }
+}
+
+// Triangles and welded vertices of one slab of cells
+struct IsoSlab {
+  std::vector<float> vertices;
+  std::vector<float> normals;
+  std::vector<uint32_t> triangles;
+};
+
+static void extractSlab(const VolumeGrid& grid, float level, int z, IsoSlab& slab) {
+  // Edge key: node index of the lower corner * 8 + offset bits to the upper corner
+  std::unordered_map<uint64_t, uint32_t> edgeVertices;
+  int nx = grid.dims[0], ny = grid.dims[1];
+
+  for (int y = 0; y + 1 < ny; ++y) {
+    for (int x = 0; x + 1 < nx; ++x) {
+      float corner[8];
+      int inside = 0;
+      bool complete = true;
+      for (int c = 0; c < 8; ++c) {
+        corner[c] = grid.values[grid.nodeIndex(x + (c & 1), y + ((c >> 1) & 1), z + (c >> 2))];
+        if (std::isnan(corner[c])) {
+          complete = false;
+          break;
+        }
+        if (corner[c] >= level) inside++;
+      }
+      if (!complete || inside == 0 || inside == 8) continue;
+
+      // Vertex where the level crosses the edge between corners a and b (b's bits contain a's)
+      auto edgeVertex = [&](int a, int b) -> uint32_t {
+        uint64_t key = static_cast<uint64_t>(grid.nodeIndex(x + (a & 1), y + ((a >> 1) & 1), z + (a >> 2))) * 8 + (a ^ b);
+        auto found = edgeVertices.find(key);
+        if (found != edgeVertices.end()) return found->second;
+
+        float t = (level - corner[a]) / (corner[b] - corner[a]);
+        float gradientA[3], gradientB[3];
+        nodeGradient(grid, x + (a & 1), y + ((a >> 1) & 1), z + (a >> 2), gradientA);
+        nodeGradient(grid, x + (b & 1), y + ((b >> 1) & 1), z + (b >> 2), gradientB);
+        float normal[3], length = 0.0f;
+        for (int d = 0; d < 3; ++d) {
+          float pa = static_cast<float>(d == 0 ? x + (a & 1) : d == 1 ? y + ((a >> 1) & 1) : z + (a >> 2));
+          float pb = static_cast<float>(d == 0 ? x + (b & 1) : d == 1 ? y + ((b >> 1) & 1) : z + (b >> 2));
+          slab.vertices.push_back(grid.origin[d] + (pa + t * (pb - pa)) * grid.cellSize);
+          normal[d] = -(gradientA[d] + t * (gradientB[d] - gradientA[d]));
+          length += normal[d] * normal[d];
+        }
+        length = length > 0.0f ? 1.0f / std::sqrt(length) : 0.0f;
+        for (int d = 0; d < 3; ++d) slab.normals.push_back(normal[d] * length);
+        uint32_t index = static_cast<uint32_t>(slab.vertices.size() / 3 - 1);
+        edgeVertices.emplace(key, index);
+        return index;
+      };
+      auto edge = [&](int a, int b) { return a < b ? edgeVertex(a, b) : edgeVertex(b, a); };
+
+      // Counter-clockwise seen from the lower side: the normal points away from an inside corner
+      auto emit = [&](uint32_t i0, uint32_t i1, uint32_t i2, int insideCorner) {
+        const float* p0 = &slab.vertices[i0 * 3];
+        const float* p1 = &slab.vertices[i1 * 3];
+        const float* p2 = &slab.vertices[i2 * 3];
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        float toInside[3] = {
+          grid.origin[0] + (x + (insideCorner & 1)) * grid.cellSize - p0[0],
+          grid.origin[1] + (y + ((insideCorner >> 1) & 1)) * grid.cellSize - p0[1],
+          grid.origin[2] + (z + (insideCorner >> 2)) * grid.cellSize - p0[2] };
+        if (n[0] * toInside[0] + n[1] * toInside[1] + n[2] * toInside[2] > 0.0f) std::swap(i1, i2);
+        slab.triangles.push_back(i0);
+        slab.triangles.push_back(i1);
+        slab.triangles.push_back(i2);
+      };
+
+      for (const int* tet : TETRAHEDRA) {
+        int in[4], out[4], inCount = 0, outCount = 0;
+        for (int v = 0; v < 4; ++v) {
+          if (corner[tet[v]] >= level) in[inCount++] = tet[v];
+          else out[outCount++] = tet[v];
+        }
+        if (inCount == 0 || outCount == 0) continue;
+        if (inCount == 1) {
+          emit(edge(in[0], out[0]), edge(in[0], out[1]), edge(in[0], out[2]), in[0]);
+        }
+        else if (inCount == 3) {
+          emit(edge(out[0], in[0]), edge(out[0], in[1]), edge(out[0], in[2]), in[0]);
+        }
+        else {
+          // Quad around the two inside corners, split along one diagonal
+          uint32_t q0 = edge(in[0], out[0]), q1 = edge(in[0], out[1]);
+          uint32_t q2 = edge(in[1], out[1]), q3 = edge(in[1], out[0]);
+          emit(q0, q1, q2, in[0]);
+          emit(q0, q2, q3, in[1]);
+        }
+      }
+    }
+  }
+}
+
+void ScanVolume::extractIsoSurface(const VolumeGrid& grid, float level, IsoSurfaceMesh& out) {
+  out = IsoSurfaceMesh();
+  out.level = level;
+  if (!grid.isVolumetric()) return;
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<IsoSlab> slabs(grid.dims[2] - 1);
+  JobSystem::parallelFor(0, slabs.size(), 1, [&](size_t first, size_t last) {
+    for (size_t z = first; z < last; ++z) extractSlab(grid, level, static_cast<int>(z), slabs[z]);
+  });
+
+  size_t vertexCount = 0, indexCount = 0;
+  for (const IsoSlab& slab : slabs) {
+    vertexCount += slab.vertices.size();
+    indexCount += slab.triangles.size();
+  }
+  out.vertices.reserve(vertexCount);
+  out.normals.reserve(vertexCount);
+  out.triangles.reserve(indexCount);
+  for (const IsoSlab& slab : slabs) {
+    uint32_t base = static_cast<uint32_t>(out.vertices.size() / 3);
+    out.vertices.insert(out.vertices.end(), slab.vertices.begin(), slab.vertices.end());
+    out.normals.insert(out.normals.end(), slab.normals.begin(), slab.normals.end());
+    for (uint32_t index : slab.triangles) out.triangles.push_back(base + index);
+  }
+  out.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
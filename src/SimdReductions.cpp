@@ -0,0 +1,526 @@
+#include "SimdReductions.h"
+#include "CpuFeatures.h"
+#include "PointBitset.h"
+#include <algorithm>
+
+#if CPU_FEATURES_X86
+#include <immintrin.h>
+#endif
+
+static ValueReduction reduceValuesScalar(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  ValueReduction result;
+  for (size_t i = 0; i < count; ++i) {
+    float v = values[i];
+    if (v > lowerLimit && v < upperLimit) {
+      result.minValue = std::min(result.minValue, v);
+      result.maxValue = std::max(result.maxValue, v);
+      result.sum += v;
+      result.count++;
+    }
+  }
+  return result;
+}
+
+static void reducePositionsScalar(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  for (int c = 0; c < 3; ++c) {
+    minOut[c] = maxOut[c] = xyz[c];
+  }
+  for (size_t i = 1; i < pointCount; ++i) {
+    const float* p = xyz + i * 3;
+    for (int c = 0; c < 3; ++c) {
+      minOut[c] = std::min(minOut[c], p[c]);
+      maxOut[c] = std::max(maxOut[c], p[c]);
+    }
+  }
+}
+
+// Selected-subset kernels walk the selection a block at a time; blocks past the
+// last full vector and anything the vector loop skipped fall back to these.
+static void reduceSelectedValuesTail(const float* values, const uint64_t* words, size_t first, size_t count, ValueReduction& result) {
+  for (size_t i = first; i < count; ++i) {
+    if (!((words[i >> 6] >> (i & 63)) & 1)) continue;
+    float v = values[i];
+    result.minValue = std::min(result.minValue, v);
+    result.maxValue = std::max(result.maxValue, v);
+    result.sum += v;
+    result.count++;
+  }
+}
+
+static ValueReduction reduceSelectedValuesScalar(const float* values, const uint64_t* words, size_t count) {
+  ValueReduction result;
+  size_t wordCount = (count + 63) / 64;
+  for (size_t w = 0; w < wordCount; ++w) {
+    uint64_t word = words[w];
+    while (word) {
+      float v = values[w * 64 + PointBitset::countTrailingZeros(word)];
+      result.minValue = std::min(result.minValue, v);
+      result.maxValue = std::max(result.maxValue, v);
+      result.sum += v;
+      result.count++;
+      word &= word - 1;
+    }
+  }
+  return result;
+}
+
+static size_t sumSelectedPositionsTail(const float* xyz, const uint64_t* words, size_t first, size_t pointCount, double sumOut[3]) {
+  size_t selected = 0;
+  for (size_t i = first; i < pointCount; ++i) {
+    if (!((words[i >> 6] >> (i & 63)) & 1)) continue;
+    sumOut[0] += xyz[i * 3];
+    sumOut[1] += xyz[i * 3 + 1];
+    sumOut[2] += xyz[i * 3 + 2];
+    selected++;
+  }
+  return selected;
+}
+
+static size_t sumSelectedPositionsScalar(const float* xyz, const uint64_t* words, size_t pointCount, double sumOut[3]) {
+  size_t selected = 0;
+  size_t wordCount = (pointCount + 63) / 64;
+  for (size_t w = 0; w < wordCount; ++w) {
+    uint64_t word = words[w];
+    while (word) {
+      const float* p = xyz + (w * 64 + PointBitset::countTrailingZeros(word)) * 3;
+      sumOut[0] += p[0];
+      sumOut[1] += p[1];
+      sumOut[2] += p[2];
+      selected++;
+      word &= word - 1;
+    }
+  }
+  return selected;
+}
+
+#if CPU_FEATURES_X86
+
+// Merge a scalar tail result into a vector result
+static void mergeReduction(ValueReduction& into, const ValueReduction& tail) {
+  into.minValue = std::min(into.minValue, tail.minValue);
+  into.maxValue = std::max(into.maxValue, tail.maxValue);
+  into.sum += tail.sum;
+  into.count += tail.count;
+}
+
+static TARGET_SSE41 ValueReduction reduceValuesSSE41(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  const __m128 lo = _mm_set1_ps(lowerLimit);
+  const __m128 hi = _mm_set1_ps(upperLimit);
+  const __m128 posInf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+  const __m128 negInf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+  __m128 vmin = posInf;
+  __m128 vmax = negInf;
+  __m128d sum = _mm_setzero_pd();
+  __m128i counts = _mm_setzero_si128();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(values + i);
+    // Ordered compares are false for NaN, so NaNs drop out with the outliers
+    __m128 inside = _mm_and_ps(_mm_cmpgt_ps(x, lo), _mm_cmplt_ps(x, hi));
+    vmin = _mm_min_ps(vmin, _mm_blendv_ps(posInf, x, inside));
+    vmax = _mm_max_ps(vmax, _mm_blendv_ps(negInf, x, inside));
+    __m128 kept = _mm_and_ps(x, inside);
+    sum = _mm_add_pd(sum, _mm_cvtps_pd(kept));
+    sum = _mm_add_pd(sum, _mm_cvtps_pd(_mm_movehl_ps(kept, kept)));
+    counts = _mm_sub_epi32(counts, _mm_castps_si128(inside));
+  }
+
+  alignas(16) float mins[4], maxs[4];
+  alignas(16) double sums[2];
+  alignas(16) int lanes[4];
+  _mm_store_ps(mins, vmin);
+  _mm_store_ps(maxs, vmax);
+  _mm_store_pd(sums, sum);
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), counts);
+
+  ValueReduction result;
+  for (int l = 0; l < 4; ++l) {
+    result.minValue = std::min(result.minValue, mins[l]);
+    result.maxValue = std::max(result.maxValue, maxs[l]);
+    result.count += static_cast<size_t>(lanes[l]);
+  }
+  result.sum = sums[0] + sums[1];
+
+  mergeReduction(result, reduceValuesScalar(values + i, count - i, lowerLimit, upperLimit));
+  return result;
+}
+
+static TARGET_AVX2 ValueReduction reduceValuesAVX2(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  const __m256 lo = _mm256_set1_ps(lowerLimit);
+  const __m256 hi = _mm256_set1_ps(upperLimit);
+  const __m256 posInf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  const __m256 negInf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+
+  __m256 vmin = posInf;
+  __m256 vmax = negInf;
+  __m256d sumLow = _mm256_setzero_pd();
+  __m256d sumHigh = _mm256_setzero_pd();
+  __m256i counts = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 x = _mm256_loadu_ps(values + i);
+    __m256 inside = _mm256_and_ps(_mm256_cmp_ps(x, lo, _CMP_GT_OQ), _mm256_cmp_ps(x, hi, _CMP_LT_OQ));
+    vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(posInf, x, inside));
+    vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(negInf, x, inside));
+    __m256 kept = _mm256_and_ps(x, inside);
+    sumLow = _mm256_add_pd(sumLow, _mm256_cvtps_pd(_mm256_castps256_ps128(kept)));
+    sumHigh = _mm256_add_pd(sumHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(kept, 1)));
+    counts = _mm256_sub_epi32(counts, _mm256_castps_si256(inside));
+  }
+
+  alignas(32) float mins[8], maxs[8];
+  alignas(32) double sums[4];
+  alignas(32) int lanes[8];
+  _mm256_store_ps(mins, vmin);
+  _mm256_store_ps(maxs, vmax);
+  _mm256_store_pd(sums, _mm256_add_pd(sumLow, sumHigh));
+  _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), counts);
+
+  ValueReduction result;
+  for (int l = 0; l < 8; ++l) {
+    result.minValue = std::min(result.minValue, mins[l]);
+    result.maxValue = std::max(result.maxValue, maxs[l]);
+    result.count += static_cast<size_t>(lanes[l]);
+  }
+  result.sum = sums[0] + sums[1] + sums[2] + sums[3];
+
+  mergeReduction(result, reduceValuesScalar(values + i, count - i, lowerLimit, upperLimit));
+  return result;
+}
+
+// Interleaved xyz is reduced without shuffles: a block of N points spans three
+// registers, and lane l of register r always holds component (r * width + l) % 3.
+// Each register keeps its own min/max and the lanes are sorted out at the end.
+static void foldPositionLanes(const float* mins, const float* maxs, int width, float minOut[3], float maxOut[3]) {
+  for (int r = 0; r < 3; ++r) {
+    for (int l = 0; l < width; ++l) {
+      int c = (r * width + l) % 3;
+      minOut[c] = std::min(minOut[c], mins[r * width + l]);
+      maxOut[c] = std::max(maxOut[c], maxs[r * width + l]);
+    }
+  }
+}
+
+static void mergePositionTail(const float* xyz, size_t first, size_t pointCount, float minOut[3], float maxOut[3]) {
+  for (size_t i = first; i < pointCount; ++i) {
+    const float* p = xyz + i * 3;
+    for (int c = 0; c < 3; ++c) {
+      minOut[c] = std::min(minOut[c], p[c]);
+      maxOut[c] = std::max(maxOut[c], p[c]);
+    }
+  }
+}
+
+static TARGET_SSE41 void reducePositionsSSE41(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  for (int c = 0; c < 3; ++c) {
+    minOut[c] = maxOut[c] = xyz[c];
+  }
+
+  size_t i = 0;
+  if (pointCount >= 4) {
+    __m128 min0 = _mm_loadu_ps(xyz), min1 = _mm_loadu_ps(xyz + 4), min2 = _mm_loadu_ps(xyz + 8);
+    __m128 max0 = min0, max1 = min1, max2 = min2;
+    for (i = 4; i + 4 <= pointCount; i += 4) {
+      const float* p = xyz + i * 3;
+      __m128 r0 = _mm_loadu_ps(p), r1 = _mm_loadu_ps(p + 4), r2 = _mm_loadu_ps(p + 8);
+      min0 = _mm_min_ps(min0, r0); max0 = _mm_max_ps(max0, r0);
+      min1 = _mm_min_ps(min1, r1); max1 = _mm_max_ps(max1, r1);
+      min2 = _mm_min_ps(min2, r2); max2 = _mm_max_ps(max2, r2);
+    }
+
+    alignas(16) float mins[12], maxs[12];
+    _mm_store_ps(mins, min0); _mm_store_ps(mins + 4, min1); _mm_store_ps(mins + 8, min2);
+    _mm_store_ps(maxs, max0); _mm_store_ps(maxs + 4, max1); _mm_store_ps(maxs + 8, max2);
+    foldPositionLanes(mins, maxs, 4, minOut, maxOut);
+  }
+
+  mergePositionTail(xyz, i, pointCount, minOut, maxOut);
+}
+
+static TARGET_AVX2 void reducePositionsAVX2(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  for (int c = 0; c < 3; ++c) {
+    minOut[c] = maxOut[c] = xyz[c];
+  }
+
+  size_t i = 0;
+  if (pointCount >= 8) {
+    __m256 min0 = _mm256_loadu_ps(xyz), min1 = _mm256_loadu_ps(xyz + 8), min2 = _mm256_loadu_ps(xyz + 16);
+    __m256 max0 = min0, max1 = min1, max2 = min2;
+    for (i = 8; i + 8 <= pointCount; i += 8) {
+      const float* p = xyz + i * 3;
+      __m256 r0 = _mm256_loadu_ps(p), r1 = _mm256_loadu_ps(p + 8), r2 = _mm256_loadu_ps(p + 16);
+      min0 = _mm256_min_ps(min0, r0); max0 = _mm256_max_ps(max0, r0);
+      min1 = _mm256_min_ps(min1, r1); max1 = _mm256_max_ps(max1, r1);
+      min2 = _mm256_min_ps(min2, r2); max2 = _mm256_max_ps(max2, r2);
+    }
+
+    alignas(32) float mins[24], maxs[24];
+    _mm256_store_ps(mins, min0); _mm256_store_ps(mins + 8, min1); _mm256_store_ps(mins + 16, min2);
+    _mm256_store_ps(maxs, max0); _mm256_store_ps(maxs + 8, max1); _mm256_store_ps(maxs + 16, max2);
+    foldPositionLanes(mins, maxs, 8, minOut, maxOut);
+  }
+
+  mergePositionTail(xyz, i, pointCount, minOut, maxOut);
+}
+
+// Selection bits become lane masks by broadcasting a block's bits and comparing
+// against each lane's own bit. For interleaved xyz, lane l of register r belongs
+// to point (r * width + l) / 3, so the lane bits repeat in threes.
+static TARGET_SSE41 ValueReduction reduceSelectedValuesSSE41(const float* values, const uint64_t* words, size_t count) {
+  const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+  const __m128 posInf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+  const __m128 negInf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+
+  __m128 vmin = posInf;
+  __m128 vmax = negInf;
+  __m128d sum = _mm_setzero_pd();
+  size_t selected = 0;
+
+  size_t blocks = count / 4;
+  for (size_t b = 0; b < blocks; ++b) {
+    uint64_t word = words[b >> 4];
+    if (word == 0) {
+      b |= 15; // Skip the rest of an empty word
+      continue;
+    }
+    int bits = static_cast<int>((word >> ((b & 15) * 4)) & 0xF);
+    if (bits == 0) continue;
+
+    __m128 inside = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), laneBits), laneBits));
+    __m128 x = _mm_loadu_ps(values + b * 4);
+    vmin = _mm_min_ps(vmin, _mm_blendv_ps(posInf, x, inside));
+    vmax = _mm_max_ps(vmax, _mm_blendv_ps(negInf, x, inside));
+    __m128 kept = _mm_and_ps(x, inside);
+    sum = _mm_add_pd(sum, _mm_cvtps_pd(kept));
+    sum = _mm_add_pd(sum, _mm_cvtps_pd(_mm_movehl_ps(kept, kept)));
+    selected += PointBitset::popCount(static_cast<uint64_t>(bits));
+  }
+
+  alignas(16) float mins[4], maxs[4];
+  alignas(16) double sums[2];
+  _mm_store_ps(mins, vmin);
+  _mm_store_ps(maxs, vmax);
+  _mm_store_pd(sums, sum);
+
+  ValueReduction result;
+  for (int l = 0; l < 4; ++l) {
+    result.minValue = std::min(result.minValue, mins[l]);
+    result.maxValue = std::max(result.maxValue, maxs[l]);
+  }
+  result.sum = sums[0] + sums[1];
+  result.count = selected;
+
+  reduceSelectedValuesTail(values, words, blocks * 4, count, result);
+  return result;
+}
+
+static TARGET_AVX2 ValueReduction reduceSelectedValuesAVX2(const float* values, const uint64_t* words, size_t count) {
+  const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  const __m256 posInf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  const __m256 negInf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+
+  __m256 vmin = posInf;
+  __m256 vmax = negInf;
+  __m256d sumLow = _mm256_setzero_pd();
+  __m256d sumHigh = _mm256_setzero_pd();
+  size_t selected = 0;
+
+  size_t blocks = count / 8;
+  for (size_t b = 0; b < blocks; ++b) {
+    uint64_t word = words[b >> 3];
+    if (word == 0) {
+      b |= 7;
+      continue;
+    }
+    int bits = static_cast<int>((word >> ((b & 7) * 8)) & 0xFF);
+    if (bits == 0) continue;
+
+    __m256 inside = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), laneBits), laneBits));
+    __m256 x = _mm256_loadu_ps(values + b * 8);
+    vmin = _mm256_min_ps(vmin, _mm256_blendv_ps(posInf, x, inside));
+    vmax = _mm256_max_ps(vmax, _mm256_blendv_ps(negInf, x, inside));
+    __m256 kept = _mm256_and_ps(x, inside);
+    sumLow = _mm256_add_pd(sumLow, _mm256_cvtps_pd(_mm256_castps256_ps128(kept)));
+    sumHigh = _mm256_add_pd(sumHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(kept, 1)));
+    selected += PointBitset::popCount(static_cast<uint64_t>(bits));
+  }
+
+  alignas(32) float mins[8], maxs[8];
+  alignas(32) double sums[4];
+  _mm256_store_ps(mins, vmin);
+  _mm256_store_ps(maxs, vmax);
+  _mm256_store_pd(sums, _mm256_add_pd(sumLow, sumHigh));
+
+  ValueReduction result;
+  for (int l = 0; l < 8; ++l) {
+    result.minValue = std::min(result.minValue, mins[l]);
+    result.maxValue = std::max(result.maxValue, maxs[l]);
+  }
+  result.sum = sums[0] + sums[1] + sums[2] + sums[3];
+  result.count = selected;
+
+  reduceSelectedValuesTail(values, words, blocks * 8, count, result);
+  return result;
+}
+
+static TARGET_SSE41 size_t sumSelectedPositionsSSE41(const float* xyz, const uint64_t* words, size_t pointCount, double sumOut[3]) {
+  const __m128i laneBits0 = _mm_setr_epi32(1, 1, 1, 2);
+  const __m128i laneBits1 = _mm_setr_epi32(2, 2, 4, 4);
+  const __m128i laneBits2 = _mm_setr_epi32(4, 8, 8, 8);
+
+  __m128d sums[6] = { _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(),
+    _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd() };
+  size_t selected = 0;
+
+  size_t blocks = pointCount / 4;
+  for (size_t b = 0; b < blocks; ++b) {
+    uint64_t word = words[b >> 4];
+    if (word == 0) {
+      b |= 15;
+      continue;
+    }
+    int bits = static_cast<int>((word >> ((b & 15) * 4)) & 0xF);
+    if (bits == 0) continue;
+
+    __m128i broadcast = _mm_set1_epi32(bits);
+    const float* p = xyz + b * 12;
+    __m128 r0 = _mm_and_ps(_mm_loadu_ps(p), _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(broadcast, laneBits0), laneBits0)));
+    __m128 r1 = _mm_and_ps(_mm_loadu_ps(p + 4), _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(broadcast, laneBits1), laneBits1)));
+    __m128 r2 = _mm_and_ps(_mm_loadu_ps(p + 8), _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(broadcast, laneBits2), laneBits2)));
+    sums[0] = _mm_add_pd(sums[0], _mm_cvtps_pd(r0));
+    sums[1] = _mm_add_pd(sums[1], _mm_cvtps_pd(_mm_movehl_ps(r0, r0)));
+    sums[2] = _mm_add_pd(sums[2], _mm_cvtps_pd(r1));
+    sums[3] = _mm_add_pd(sums[3], _mm_cvtps_pd(_mm_movehl_ps(r1, r1)));
+    sums[4] = _mm_add_pd(sums[4], _mm_cvtps_pd(r2));
+    sums[5] = _mm_add_pd(sums[5], _mm_cvtps_pd(_mm_movehl_ps(r2, r2)));
+    selected += PointBitset::popCount(static_cast<uint64_t>(bits));
+  }
+
+  // Element e of the 12 summed lanes holds component e % 3
+  alignas(16) double lanes[12];
+  for (int h = 0; h < 6; ++h) _mm_store_pd(lanes + h * 2, sums[h]);
+  for (int e = 0; e < 12; ++e) sumOut[e % 3] += lanes[e];
+
+  return selected + sumSelectedPositionsTail(xyz, words, blocks * 4, pointCount, sumOut);
+}
+
+static TARGET_AVX2 size_t sumSelectedPositionsAVX2(const float* xyz, const uint64_t* words, size_t pointCount, double sumOut[3]) {
+  const __m256i laneBits0 = _mm256_setr_epi32(1, 1, 1, 2, 2, 2, 4, 4);
+  const __m256i laneBits1 = _mm256_setr_epi32(4, 8, 8, 8, 16, 16, 16, 32);
+  const __m256i laneBits2 = _mm256_setr_epi32(32, 32, 64, 64, 64, 128, 128, 128);
+
+  __m256d sums[6] = { _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(),
+    _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd() };
+  size_t selected = 0;
+
+  size_t blocks = pointCount / 8;
+  for (size_t b = 0; b < blocks; ++b) {
+    uint64_t word = words[b >> 3];
+    if (word == 0) {
+      b |= 7;
+      continue;
+    }
+    int bits = static_cast<int>((word >> ((b & 7) * 8)) & 0xFF);
+    if (bits == 0) continue;
+
+    __m256i broadcast = _mm256_set1_epi32(bits);
+    const float* p = xyz + b * 24;
+    __m256 r0 = _mm256_and_ps(_mm256_loadu_ps(p), _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(broadcast, laneBits0), laneBits0)));
+    __m256 r1 = _mm256_and_ps(_mm256_loadu_ps(p + 8), _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(broadcast, laneBits1), laneBits1)));
+    __m256 r2 = _mm256_and_ps(_mm256_loadu_ps(p + 16), _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(broadcast, laneBits2), laneBits2)));
+    sums[0] = _mm256_add_pd(sums[0], _mm256_cvtps_pd(_mm256_castps256_ps128(r0)));
+    sums[1] = _mm256_add_pd(sums[1], _mm256_cvtps_pd(_mm256_extractf128_ps(r0, 1)));
+    sums[2] = _mm256_add_pd(sums[2], _mm256_cvtps_pd(_mm256_castps256_ps128(r1)));
+    sums[3] = _mm256_add_pd(sums[3], _mm256_cvtps_pd(_mm256_extractf128_ps(r1, 1)));
+    sums[4] = _mm256_add_pd(sums[4], _mm256_cvtps_pd(_mm256_castps256_ps128(r2)));
+    sums[5] = _mm256_add_pd(sums[5], _mm256_cvtps_pd(_mm256_extractf128_ps(r2, 1)));
+    selected += PointBitset::popCount(static_cast<uint64_t>(bits));
+  }
+
+  alignas(32) double lanes[24];
+  for (int h = 0; h < 6; ++h) _mm256_store_pd(lanes + h * 4, sums[h]);
+  for (int e = 0; e < 24; ++e) sumOut[e % 3] += lanes[e];
+
+  return selected + sumSelectedPositionsTail(xyz, words, blocks * 8, pointCount, sumOut);
+}
+
+#else
+
+static ValueReduction reduceValuesSSE41(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  return reduceValuesScalar(values, count, lowerLimit, upperLimit);
+}
+
+static ValueReduction reduceValuesAVX2(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  return reduceValuesScalar(values, count, lowerLimit, upperLimit);
+}
+
+static void reducePositionsSSE41(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  reducePositionsScalar(xyz, pointCount, minOut, maxOut);
+}
+
+static void reducePositionsAVX2(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  reducePositionsScalar(xyz, pointCount, minOut, maxOut);
+}
+
+static ValueReduction reduceSelectedValuesSSE41(const float* values, const uint64_t* words, size_t count) {
+  return reduceSelectedValuesScalar(values, words, count);
+}
+
+static ValueReduction reduceSelectedValuesAVX2(const float* values, const uint64_t* words, size_t count) {
+  return reduceSelectedValuesScalar(values, words, count);
+}
+
+static size_t sumSelectedPositionsSSE41(const float* xyz, const uint64_t* words, size_t pointCount, double sumOut[3]) {
+  return sumSelectedPositionsScalar(xyz, words, pointCount, sumOut);
+}
+
+static size_t sumSelectedPositionsAVX2(const float* xyz, const uint64_t* words, size_t pointCount, double sumOut[3]) {
+  return sumSelectedPositionsScalar(xyz, words, pointCount, sumOut);
+}
+
+#endif
+
+ValueReduction SimdReductions::reduceValues(const float* values, size_t count, float lowerLimit, float upperLimit) {
+  if (values == nullptr || count == 0) return ValueReduction();
+
+  switch (CpuFeatures::getSimdLevel()) {
+  case SimdLevel::AVX2: return reduceValuesAVX2(values, count, lowerLimit, upperLimit);
+  case SimdLevel::SSE41: return reduceValuesSSE41(values, count, lowerLimit, upperLimit);
+  default: return reduceValuesScalar(values, count, lowerLimit, upperLimit);
+  }
+}
+
+bool SimdReductions::reducePositions(const float* xyz, size_t pointCount, float minOut[3], float maxOut[3]) {
+  if (xyz == nullptr || pointCount == 0) return false;
+
+  switch (CpuFeatures::getSimdLevel()) {
+  case SimdLevel::AVX2: reducePositionsAVX2(xyz, pointCount, minOut, maxOut); break;
+  case SimdLevel::SSE41: reducePositionsSSE41(xyz, pointCount, minOut, maxOut); break;
+  default: reducePositionsScalar(xyz, pointCount, minOut, maxOut); break;
+  }
+  return true;
+}
+
+ValueReduction SimdReductions::reduceSelectedValues(const float* values, const uint64_t* selectionWords, size_t count) {
+  if (values == nullptr || selectionWords == nullptr || count == 0) return ValueReduction();
+
+  switch (CpuFeatures::getSimdLevel()) {
+  case SimdLevel::AVX2: return reduceSelectedValuesAVX2(values, selectionWords, count);
+  case SimdLevel::SSE41: return reduceSelectedValuesSSE41(values, selectionWords, count);
+  default: return reduceSelectedValuesScalar(values, selectionWords, count);
+  }
+}
+
+size_t SimdReductions::sumSelectedPositions(const float* xyz, const uint64_t* selectionWords, size_t pointCount, double sumOut[3]) {
+  sumOut[0] = sumOut[1] = sumOut[2] = 0.0;
+  if (xyz == nullptr || selectionWords == nullptr || pointCount == 0) return 0;
+
+  switch (CpuFeatures::getSimdLevel()) {
+  case SimdLevel::AVX2: return sumSelectedPositionsAVX2(xyz, selectionWords, pointCount, sumOut);
+  case SimdLevel::SSE41: return sumSelectedPositionsSSE41(xyz, selectionWords, pointCount, sumOut);
+  default: return sumSelectedPositionsScalar(xyz, selectionWords, pointCount, sumOut);
+  }
+}
@@ -1,5 +1,8 @@
 #include "VerticesLoader.h"
-#include <fstream>
+#include "SimdReductions.h"
+#include "ScanParser.h"
+#include "ScanDiscovery.h"
+#include "ScanResidency.h"
 #include <iostream>
 #include <filesystem>
 #include <sstream>
@@ -8,6 +11,21 @@
 
 // Static member definitions
 std::vector<ScanPoint> VerticesLoader::scanPoints;
+std::vector<float> VerticesLoader::positionData;
+std::vector<float> VerticesLoader::valueData;
+std::vector<float> VerticesLoader::timeData;
+bool VerticesLoader::timestamped = false;
+BoundingBox VerticesLoader::boundingBox = { 0, 0, 0, 0, 0, 0 };
+int VerticesLoader::peakCount = 0;
+ScanStatistics VerticesLoader::valueStatistics;
+std::vector<uint8_t> VerticesLoader::peakFlags;
+std::vector<uint8_t> VerticesLoader::axisCodes;
+std::vector<uint8_t> VerticesLoader::directionCodes;
+std::vector<std::string> VerticesLoader::axisNames;
+std::vector<std::string> VerticesLoader::directionNames;
+ScanBitmapIndex VerticesLoader::bitmapIndex;
+KdTree VerticesLoader::spatialIndex;
+bool VerticesLoader::spatialIndexValid = false;
 std::string VerticesLoader::currentScanFile;
 float VerticesLoader::minValue = std::numeric_limits<float>::max();
 float VerticesLoader::maxValue = std::numeric_limits<float>::lowest();
@@ -19,26 +37,35 @@ bool VerticesLoader::loadScanFromFile(const std::string& filePath, float scaleFa
 }
 
 bool VerticesLoader::initializeScanFiles(const std::string& directory, float scaleFactor) {
-  try {
-    // Check if directory exists
-    if (!std::filesystem::exists(directory)) {
-      std::cerr << "Scan directory not found: " << directory << std::endl;
-      return false;
-    }
+  return initializeScanFiles(std::vector<std::string>{ directory }, scaleFactor);
+}
 
-    availableFiles = findScanFiles(directory);
-    if (availableFiles.empty()) {
-      std::cerr << "No scan files found in " << directory << std::endl;
+bool VerticesLoader::initializeScanFiles(const std::vector<std::string>& directories, float scaleFactor) {
+  try {
+    // Newest first: filename timestamps where present, modification time otherwise
+    ScanDiscoveryStats stats;
+    std::vector<ScanFileEntry> entries = ScanDiscovery::discover(directories, true, &stats);
+    if (entries.empty()) {
+      std::cerr << "No scan files found in";
+      for (const std::string& directory : directories) std::cerr << " " << directory;
+      std::cerr << std::endl;
       return false;
     }
 
-    // Sort files by date (newest first)
-    sortFilesByDate(availableFiles);
+    availableFiles.clear();
+    availableFiles.reserve(entries.size());
+    for (ScanFileEntry& entry : entries) availableFiles.push_back(std::move(entry.path));
 
-    std::cout << "Found " << availableFiles.size() << " scan files:" << std::endl;
-    for (size_t i = 0; i < availableFiles.size(); ++i) {
+    std::cout << "Found " << availableFiles.size() << " scan files in " << stats.directoriesVisited << " directories ("
+      << stats.milliseconds << " ms, " << stats.statCalls << " without a filename timestamp)" << std::endl;
+    // Long archives are summarised rather than listed in full
+    const size_t LISTED_FILES = 20;
+    for (size_t i = 0; i < availableFiles.size() && i < LISTED_FILES; ++i) {
       std::cout << "  [" << i << "] " << std::filesystem::path(availableFiles[i]).filename().string() << std::endl;
     }
+    if (availableFiles.size() > LISTED_FILES) {
+      std::cout << "  ... " << (availableFiles.size() - LISTED_FILES) << " more" << std::endl;
+    }
 
     // Load the most recent file (index 0)
     currentFileIndex = 0;
@@ -76,21 +103,81 @@ bool VerticesLoader::loadPreviousScanFile(float scaleFactor) {
   return parseScanFile(availableFiles[currentFileIndex], scaleFactor);
 }
 
+bool VerticesLoader::selectScanFile(const std::string& filePath, float scaleFactor) {
+  auto found = std::find(availableFiles.begin(), availableFiles.end(), filePath);
+  if (found != availableFiles.end()) currentFileIndex = static_cast<int>(found - availableFiles.begin());
+  std::cout << "Loading file: " << std::filesystem::path(filePath).filename().string() << std::endl;
+  return parseScanFile(filePath, scaleFactor);
+}
+
+const std::string& VerticesLoader::getCurrentScanFile() {
+  return currentScanFile;
+}
+
+const std::vector<float>& VerticesLoader::getTimeData() {
+  return timeData;
+}
+
+bool VerticesLoader::hasTimestamps() {
+  return timestamped;
+}
+
+const std::vector<std::string>& VerticesLoader::getAvailableFiles() {
+  return availableFiles;
+}
+
 std::pair<int, int> VerticesLoader::getCurrentFileInfo() {
   return std::make_pair(currentFileIndex, static_cast<int>(availableFiles.size()));
 }
 
-std::vector<float> VerticesLoader::generateScanVertices() {
-  std::vector<float> vertices;
-  vertices.reserve(scanPoints.size() * 3);
+void VerticesLoader::appendScanPoint(const ScanPoint& point) {
+  if (scanPoints.empty()) {
+    boundingBox = { point.x, point.x, point.y, point.y, point.z, point.z };
+  }
+  else {
+    boundingBox.minX = std::min(boundingBox.minX, point.x);
+    boundingBox.maxX = std::max(boundingBox.maxX, point.x);
+    boundingBox.minY = std::min(boundingBox.minY, point.y);
+    boundingBox.maxY = std::max(boundingBox.maxY, point.y);
+    boundingBox.minZ = std::min(boundingBox.minZ, point.z);
+    boundingBox.maxZ = std::max(boundingBox.maxZ, point.z);
+  }
 
-  for (const auto& point : scanPoints) {
-    vertices.push_back(point.x);
-    vertices.push_back(point.y);
-    vertices.push_back(point.z);
+  scanPoints.push_back(point);
+  positionData.push_back(point.x);
+  positionData.push_back(point.y);
+  positionData.push_back(point.z);
+  valueData.push_back(point.value);
+  timeData.push_back(point.time);
+  peakFlags.push_back(point.isPeak ? 1 : 0);
+  spatialIndexValid = false;
+  axisCodes.push_back(internCode(axisNames, point.axis));
+  directionCodes.push_back(internCode(directionNames, point.direction));
+
+  if (point.isPeak) peakCount++;
+  valueStatistics.add(point.value);
+
+  // Update min/max values with outlier filtering
+  // Only include reasonable measurement values (not extreme outliers)
+  if (point.value > -VALUE_OUTLIER_LIMIT && point.value < VALUE_OUTLIER_LIMIT) {
+    minValue = std::min(minValue, point.value);
+    maxValue = std::max(maxValue, point.value);
   }
+  else {
+    std::cout << "Excluding outlier from min/max: " << point.value << std::endl;
+  }
+}
 
-  return vertices;
+std::vector<float> VerticesLoader::generateScanVertices() {
+  return positionData;
+}
+
+const std::vector<float>& VerticesLoader::getPositionData() {
+  return positionData;
+}
+
+const std::vector<float>& VerticesLoader::getValueData() {
+  return valueData;
 }
 
 std::vector<float> VerticesLoader::generateScanVerticesWithValues() {
@@ -111,6 +198,7 @@ std::vector<unsigned int> VerticesLoader::generateScanLineIndices() {
   std::vector<unsigned int> indices;
 
   if (scanPoints.size() < 2) return indices;
+  indices.reserve((scanPoints.size() - 1) * 2);
 
   // Connect all points in sequence
   for (unsigned int i = 0; i < static_cast<unsigned int>(scanPoints.size()) - 1; ++i) {
@@ -123,6 +211,7 @@ std::vector<unsigned int> VerticesLoader::generateScanLineIndices() {
 
 std::vector<unsigned int> VerticesLoader::generateScanPointIndices() {
   std::vector<unsigned int> indices;
+  indices.reserve(scanPoints.size());
 
   for (unsigned int i = 0; i < static_cast<unsigned int>(scanPoints.size()); ++i) {
     indices.push_back(i);
@@ -131,21 +220,92 @@ std::vector<unsigned int> VerticesLoader::generateScanPointIndices() {
   return indices;
 }
 
-std::vector<float> VerticesLoader::getMeasurementValues() {
-  std::vector<float> values;
-  values.reserve(scanPoints.size());
+const std::vector<uint8_t>& VerticesLoader::getPeakFlags() {
+  return peakFlags;
+}
 
-  for (const auto& point : scanPoints) {
-    values.push_back(point.value);
+const std::vector<uint8_t>& VerticesLoader::getAxisCodes() {
+  return axisCodes;
+}
+
+const std::vector<uint8_t>& VerticesLoader::getDirectionCodes() {
+  return directionCodes;
+}
+
+const std::vector<std::string>& VerticesLoader::getAxisNames() {
+  return axisNames;
+}
+
+const std::vector<std::string>& VerticesLoader::getDirectionNames() {
+  return directionNames;
+}
+
+const ScanBitmapIndex& VerticesLoader::getBitmapIndex() {
+  return bitmapIndex;
+}
+
+ScanResidency& VerticesLoader::getResidency() {
+  static ScanResidency residency;
+  return residency;
+}
+
+const KdTree& VerticesLoader::getSpatialIndex() {
+  if (!spatialIndexValid) {
+    spatialIndex.build(positionData.data(), scanPoints.size());
+    spatialIndexValid = true;
   }
+  return spatialIndex;
+}
+
+uint8_t VerticesLoader::internCode(std::vector<std::string>& names, const std::string& name) {
+  for (size_t i = 0; i < names.size(); ++i) {
+    if (names[i] == name) return static_cast<uint8_t>(i);
+  }
+  // Codes are bytes; anything past 255 distinct names shares the last code
+  if (names.size() >= 255) return 255;
+  names.push_back(name);
+  return static_cast<uint8_t>(names.size() - 1);
+}
 
-  return values;
+std::vector<float> VerticesLoader::getMeasurementValues() {
+  return valueData;
 }
 
 std::pair<float, float> VerticesLoader::getValueRange() {
   return std::make_pair(minValue, maxValue);
 }
 
+const ScanStatistics& VerticesLoader::getValueStatistics() {
+  return valueStatistics;
+}
+
+std::pair<float, float> VerticesLoader::getPercentileRange(double lowFraction, double highFraction) {
+  return std::make_pair(valueStatistics.getPercentile(lowFraction), valueStatistics.getPercentile(highFraction));
+}
+
+BoundingBox VerticesLoader::getBoundingBox() {
+  return boundingBox;
+}
+
+void VerticesLoader::recomputeBounds() {
+  float minPos[3], maxPos[3];
+  if (SimdReductions::reducePositions(positionData.data(), scanPoints.size(), minPos, maxPos)) {
+    boundingBox = { minPos[0], maxPos[0], minPos[1], maxPos[1], minPos[2], maxPos[2] };
+  }
+  else {
+    boundingBox = { 0, 0, 0, 0, 0, 0 };
+  }
+
+  ValueReduction range = SimdReductions::reduceValues(valueData.data(), valueData.size(),
+    -VALUE_OUTLIER_LIMIT, VALUE_OUTLIER_LIMIT);
+  minValue = range.minValue;
+  maxValue = range.maxValue;
+}
+
+int VerticesLoader::getPeakCount() {
+  return peakCount;
+}
+
 std::string VerticesLoader::getScanInfo() {
   if (scanPoints.empty()) {
     return "No scan data loaded";
@@ -160,12 +320,8 @@ std::string VerticesLoader::getScanInfo() {
 
   info << "Points: " << scanPoints.size() << "\\n";
   info << "Value Range: " << minValue << " to " << maxValue << "\\n";
-
-  // Count peaks
-  int peakCount = 0;
-  for (const auto& point : scanPoints) {
-    if (point.isPeak) peakCount++;
-  }
+  info << "Mean: " << valueStatistics.getMean() << " (std dev " << valueStatistics.getStdDev() << ")\\n";
+  info << "P1-P99: " << valueStatistics.getPercentile(0.01) << " to " << valueStatistics.getPercentile(0.99) << "\\n";
   info << "Peaks: " << peakCount;
 
   return info.str();
@@ -173,6 +329,21 @@ std::string VerticesLoader::getScanInfo() {
 
 void VerticesLoader::clear() {
   scanPoints.clear();
+  positionData.clear();
+  valueData.clear();
+  timeData.clear();
+  timestamped = false;
+  boundingBox = { 0, 0, 0, 0, 0, 0 };
+  peakCount = 0;
+  valueStatistics.clear();
+  peakFlags.clear();
+  axisCodes.clear();
+  directionCodes.clear();
+  axisNames.clear();
+  directionNames.clear();
+  bitmapIndex.clear();
+  spatialIndex.clear();
+  spatialIndexValid = false;
   currentScanFile.clear();
   minValue = std::numeric_limits<float>::max();
   maxValue = std::numeric_limits<float>::lowest();
@@ -180,282 +351,63 @@ void VerticesLoader::clear() {
 }
 
 std::vector<std::string> VerticesLoader::findScanFiles(const std::string& directory) {
-  std::vector<std::string> files;
-
-  try {
-    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-      if (entry.is_regular_file()) {
-        std::string filename = entry.path().filename().string();
-        // Look for JSON files that contain "scan" in the name
-        if (filename.find(".json") != std::string::npos &&
-          filename.find("scan") != std::string::npos) {
-          files.push_back(entry.path().string());
-        }
-      }
-    }
-  }
-  catch (const std::exception& e) {
-    std::cerr << "Error reading directory: " << e.what() << std::endl;
-  }
-
-  return files;
-}
-
-std::string VerticesLoader::getMostRecentFile(const std::vector<std::string>& files) {
-  if (files.empty()) return "";
-
-  std::string mostRecent = files[0];
-  std::filesystem::file_time_type mostRecentTime = std::filesystem::last_write_time(files[0]);
-
-  for (const auto& file : files) {
-    auto fileTime = std::filesystem::last_write_time(file);
-    if (fileTime > mostRecentTime) {
-      mostRecentTime = fileTime;
-      mostRecent = file;
-    }
-  }
-
-  return mostRecent;
+  return ScanDiscovery::discoverPaths({ directory });
 }
 
 bool VerticesLoader::parseScanFile(const std::string& filePath, float scaleFactor) {
   clear();
 
-  // Initialize min/max properly
-  minValue = std::numeric_limits<float>::max();
-  maxValue = std::numeric_limits<float>::lowest();
-
-  std::cout << "Initial min/max values: " << minValue << " to " << maxValue << std::endl;
-
-  std::ifstream file(filePath);
-  if (!file.is_open()) {
-    std::cerr << "Cannot open file: " << filePath << std::endl;
-    return false;
-  }
-
-  // Read entire file content
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string content = buffer.str();
-  file.close();
-
   try {
-    // Simple JSON parsing - find baseline position first
-    float baselineX = 0, baselineY = 0, baselineZ = 0, baselineValue = 0;
-
-    // Find baseline section
-    size_t baselinePos = content.find("\"baseline\"");
-    if (baselinePos != std::string::npos) {
-      // Extract baseline position
-      size_t posStart = content.find("\"position\"", baselinePos);
-      if (posStart != std::string::npos) {
-        // Find x, y, z values in baseline
-        size_t xPos = content.find("\"x\":", posStart);
-        size_t yPos = content.find("\"y\":", posStart);
-        size_t zPos = content.find("\"z\":", posStart);
-
-        if (xPos != std::string::npos && yPos != std::string::npos && zPos != std::string::npos) {
-          // Parse baseline coordinates
-          sscanf(content.substr(xPos + 4, 20).c_str(), "%f", &baselineX);
-          sscanf(content.substr(yPos + 4, 20).c_str(), "%f", &baselineY);
-          sscanf(content.substr(zPos + 4, 20).c_str(), "%f", &baselineZ);
-        }
-      }
-
-      // Extract baseline value
-      size_t valuePos = content.find("\"value\":", baselinePos);
-      if (valuePos != std::string::npos) {
-        sscanf(content.substr(valuePos + 8, 30).c_str(), "%f", &baselineValue);
-      }
-    }
-
-    std::cout << "Baseline: (" << baselineX << ", " << baselineY << ", " << baselineZ << "), value: " << baselineValue << std::endl;
-
-    // Don't add baseline as a scan point - it's just a reference
-    // The measurements are already relative to baseline position
-
-    // Find measurements array
-    size_t measurementsPos = content.find("\"measurements\"");
-    if (measurementsPos == std::string::npos) {
-      std::cerr << "No measurements found in file" << std::endl;
+    // Revisited scans come straight from the residency cache
+    std::string error;
+    std::shared_ptr<const DecodedScan> scan = getResidency().acquire(filePath, scaleFactor, &error);
+    if (!scan) {
+      std::cerr << "Cannot load " << filePath << ": " << error << std::endl;
       return false;
     }
-
-    // Parse each measurement with better brace matching
-    size_t currentPos = measurementsPos;
-    int measurementCount = 0;
-
-    std::cout << "Starting to parse measurements with improved JSON parsing..." << std::endl;
-
-    while (true) {
-      // Find next measurement object
-      size_t nextMeasurement = content.find("{", currentPos + 1);
-      if (nextMeasurement == std::string::npos) break;
-
-      // Find the matching closing brace by counting nested braces
-      size_t bracePos = nextMeasurement;
-      int braceCount = 0;
-      size_t measurementEnd = std::string::npos;
-
-      do {
-        if (content[bracePos] == '{') {
-          braceCount++;
-        }
-        else if (content[bracePos] == '}') {
-          braceCount--;
-          if (braceCount == 0) {
-            measurementEnd = bracePos;
-            break;
-          }
-        }
-        bracePos++;
-      } while (bracePos < content.size());
-
-      if (measurementEnd == std::string::npos) {
-        std::cout << "Could not find matching brace for measurement " << measurementCount << std::endl;
-        break;
-      }
-
-      std::string measurementJson = content.substr(nextMeasurement, measurementEnd - nextMeasurement + 1);
-
-      // Debug: Show raw JSON for first few measurements
-      if (measurementCount < 2) {
-        std::cout << "=== Complete JSON for measurement " << measurementCount << " ===" << std::endl;
-        std::cout << measurementJson.substr(0, 300) << std::endl;
-        if (measurementJson.size() > 300) {
-          std::cout << "... (total length: " << measurementJson.size() << " chars)" << std::endl;
-        }
-        std::cout << "=============================================" << std::endl;
-      }
-
-      // Parse this measurement
-      ScanPoint point;
-      float rawX = 0, rawY = 0, rawZ = 0;
-
-      // Extract position
-      size_t posStart = measurementJson.find("\"position\"");
-      if (posStart != std::string::npos) {
-        size_t xPos = measurementJson.find("\"x\":", posStart);
-        size_t yPos = measurementJson.find("\"y\":", posStart);
-        size_t zPos = measurementJson.find("\"z\":", posStart);
-
-        if (xPos != std::string::npos && yPos != std::string::npos && zPos != std::string::npos) {
-          sscanf(measurementJson.substr(xPos + 4, 20).c_str(), "%f", &rawX);
-          sscanf(measurementJson.substr(yPos + 4, 20).c_str(), "%f", &rawY);
-          sscanf(measurementJson.substr(zPos + 4, 20).c_str(), "%f", &rawZ);
-        }
-      }
-
-      // Normalize relative to baseline and scale
-      point.x = (rawX - baselineX) * scaleFactor;
-      point.y = (rawY - baselineY) * scaleFactor;
-      point.z = (rawZ - baselineZ) * scaleFactor;
-
-      // Extract value
-      size_t valuePos = measurementJson.find("\"value\":");
-      if (valuePos != std::string::npos) {
-        // Debug: show the string we're trying to parse
-        std::string valueStr = measurementJson.substr(valuePos + 8, 30);
-        if (measurementCount < 5) {
-          std::cout << "  Raw value string [" << measurementCount << "]: '" << valueStr.substr(0, 20) << "'" << std::endl;
-        }
-
-        sscanf(measurementJson.substr(valuePos + 8, 30).c_str(), "%f", &point.value);
-
-        // Debug: Print first few values to check parsing
-        if (measurementCount < 5) {
-          std::cout << "  Parsed value [" << measurementCount << "]: " << point.value << std::endl;
-        }
-
-        // Check for suspicious values
-        if (point.value < -1000000 || point.value > 1000000) {
-          std::cout << "Warning: Suspicious value detected: " << point.value << std::endl;
-        }
-      }
-      else {
-        std::cout << "Warning: Could not find 'value' field in measurement " << measurementCount << std::endl;
-        point.value = 0.0f; // Default value
-      }
-
-      // Extract isPeak
-      size_t peakPos = measurementJson.find("\"isPeak\":");
-      if (peakPos != std::string::npos) {
-        std::string peakStr = measurementJson.substr(peakPos + 9, 5);
-        point.isPeak = (peakStr.find("true") != std::string::npos);
-      }
-
-      // Extract axis
-      size_t axisPos = measurementJson.find("\"axis\":");
-      if (axisPos != std::string::npos) {
-        size_t axisStart = measurementJson.find("\"", axisPos + 7) + 1;
-        size_t axisEnd = measurementJson.find("\"", axisStart);
-        if (axisStart != std::string::npos && axisEnd != std::string::npos) {
-          point.axis = measurementJson.substr(axisStart, axisEnd - axisStart);
-        }
-      }
-
-      // Extract direction
-      size_t dirPos = measurementJson.find("\"direction\":");
-      if (dirPos != std::string::npos) {
-        size_t dirStart = measurementJson.find("\"", dirPos + 11) + 1;
-        size_t dirEnd = measurementJson.find("\"", dirStart);
-        if (dirStart != std::string::npos && dirEnd != std::string::npos) {
-          point.direction = measurementJson.substr(dirStart, dirEnd - dirStart);
-        }
-      }
-
-      scanPoints.push_back(point);
-
-      // Update min/max values with outlier filtering
-      // Only include reasonable measurement values (not extreme outliers)
-      if (point.value > -1000 && point.value < 1000) {
-        minValue = std::min(minValue, point.value);
-        maxValue = std::max(maxValue, point.value);
-      }
-      else {
-        std::cout << "Excluding outlier from min/max: " << point.value << std::endl;
-      }
-
-      currentPos = measurementEnd;
-      measurementCount++;
-
-      // Safety check to prevent infinite loop
-      if (measurementCount > 1000) {
-        std::cout << "Warning: Stopped parsing at 1000 measurements" << std::endl;
-        break;
-      }
+    const std::vector<ScanPoint>& points = scan->points;
+    const ScanFileHeader& header = scan->header;
+
+    std::cout << "Baseline: (" << header.baselineX << ", " << header.baselineY << ", " << header.baselineZ
+      << "), value: " << header.baselineValue << std::endl;
+
+    // Bounds, value range and peak count are updated as each point is appended
+    scanPoints.reserve(points.size());
+    positionData.reserve(points.size() * 3);
+    valueData.reserve(points.size());
+    timeData.reserve(points.size());
+    peakFlags.reserve(points.size());
+    axisCodes.reserve(points.size());
+    directionCodes.reserve(points.size());
+    for (const ScanPoint& point : points) {
+      appendScanPoint(point);
     }
 
-    // Don't include baseline value in min/max since we're not adding it as a scan point
-
+    timestamped = header.hasTimestamps;
     std::cout << "Loaded " << scanPoints.size() << " points from " << filePath << std::endl;
+    if (timestamped && !timeData.empty()) {
+      std::cout << "Acquisition time: " << timeData.back() << " s" << std::endl;
+    }
 
-    // Try to get better min/max from statistics section if available
-    size_t statsPos = content.find("\"statistics\"");
-    if (statsPos != std::string::npos) {
-      size_t minValuePos = content.find("\"minValue\":", statsPos);
-      size_t maxValuePos = content.find("\"maxValue\":", statsPos);
-
-      if (minValuePos != std::string::npos && maxValuePos != std::string::npos) {
-        float statsMinValue, statsMaxValue;
-        if (sscanf(content.substr(minValuePos + 11, 30).c_str(), "%f", &statsMinValue) == 1 &&
-          sscanf(content.substr(maxValuePos + 11, 30).c_str(), "%f", &statsMaxValue) == 1) {
-
-          std::cout << "Using statistics min/max: " << statsMinValue << " to " << statsMaxValue << std::endl;
-          std::cout << "Original parsed min/max: " << minValue << " to " << maxValue << std::endl;
-
-          // Use statistics values if they seem reasonable
-          if (statsMinValue > -1000 && statsMaxValue < 1000 && statsMaxValue > statsMinValue) {
-            minValue = statsMinValue;
-            maxValue = statsMaxValue;
-            std::cout << "Updated to use statistics values!" << std::endl;
-          }
-        }
+    // Prefer the file's own statistics block for min/max when it is reasonable
+    if (header.hasStatistics) {
+      std::cout << "Using statistics min/max: " << header.statisticsMinValue << " to " << header.statisticsMaxValue << std::endl;
+      std::cout << "Original parsed min/max: " << minValue << " to " << maxValue << std::endl;
+
+      if (header.statisticsMinValue > -VALUE_OUTLIER_LIMIT && header.statisticsMaxValue < VALUE_OUTLIER_LIMIT &&
+        header.statisticsMaxValue > header.statisticsMinValue) {
+        minValue = header.statisticsMinValue;
+        maxValue = header.statisticsMaxValue;
+        std::cout << "Updated to use statistics values!" << std::endl;
       }
     }
 
     std::cout << "Final value range: " << minValue << " to " << maxValue << std::endl;
 
+    // Index the attribute columns so filters can be applied without reparsing
+    bitmapIndex.build(valueData, peakFlags, axisCodes, static_cast<int>(axisNames.size()),
+      directionCodes, static_cast<int>(directionNames.size()), valueStatistics);
+
     currentScanFile = filePath;
     return true;
   }
@@ -465,19 +417,6 @@ bool VerticesLoader::parseScanFile(const std::string& filePath, float scaleFacto
   }
 }
 
-void VerticesLoader::sortFilesByDate(std::vector<std::string>& files) {
-  std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
-    try {
-      auto timeA = std::filesystem::last_write_time(a);
-      auto timeB = std::filesystem::last_write_time(b);
-      return timeA > timeB; // Newest first
-    }
-    catch (const std::exception&) {
-      return a > b; // Fallback to string comparison
-    }
-  });
-}
-
 bool VerticesLoader::loadMostRecentScan(float scaleFactor) {
   try {
     std::string scanDirectory = "logs/scanning";
@@ -494,7 +433,8 @@ bool VerticesLoader::loadMostRecentScan(float scaleFactor) {
       return false;
     }
 
-    std::string mostRecentFile = getMostRecentFile(files);
+    // findScanFiles lists newest first
+    const std::string& mostRecentFile = files.front();
     std::cout << "Loading scan file: " << mostRecentFile << std::endl;
 
     return parseScanFile(mostRecentFile, scaleFactor);
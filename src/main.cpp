@@ -6,11 +6,39 @@
 #include "VerticesLoader.h"
 #include "CameraController.h"
 #include "InputHandler.h"
+#include "ColorMapper.h"
+#include "PointPicker.h"
+#include "RegionSelection.h"
+#include "ScanCatalog.h"
+#include "ScanResidency.h"
+#include "ScanPlayback.h"
+#include "ScanDiff.h"
+#include "ScanSimilarity.h"
+#include "ScanFit.h"
+#include "ScanPeaks.h"
+#include "ScanHysteresis.h"
+#include "ScanFilters.h"
+#include "ScanSurface.h"
+#include "ScanVolume.h"
+#include "ScanSlices.h"
+#include "ScanBeamWidth.h"
+#include "JobSystem.h"
+#include "imgui.h"
+#include "backends/imgui_impl_glfw.h"
+#include "backends/imgui_impl_opengl3.h"
 #include <iostream>
 #include <vector>
 #include <array>
 #include <algorithm>
 #include <limits>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <ctime>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 #define USE_GPU_ENGINE 0
 extern "C"
@@ -23,27 +51,235 @@ extern "C"
 CameraController camera;
 
 // Global OpenGL buffer IDs for updating scan data
-unsigned int g_lineVAO, g_pointVAO, g_boxVAO, g_VBO, g_lineEBO, g_pointEBO, g_boxVBO, g_boxEBO;
+unsigned int g_lineVAO, g_pointVAO, g_boxVAO, g_lineEBO, g_pointEBO, g_boxVBO, g_boxEBO;
+// Position and RGBA8 colour buffers of the displayed scan are owned by the loader's
+// residency manager; the VAOs are re-pointed at them whenever the scan changes
+const float SCAN_SCALE_FACTOR = 1000.0f;
+unsigned int g_boundVertexBuffer = 0;  // Vertex buffer the VAOs currently read from
+
+// Acquisition-order replay of the loaded scan: only points [begin, end) of the file order are drawn
+bool g_replayEnabled = false;
+bool g_replayPlaying = false;
+bool g_replayRealTime = true;          // Follow measurement timestamps (when the scan has them)
+size_t g_replayEnd = 0;
+int g_replayTrail = 0;                 // Points kept behind the newest one (0 = all)
+float g_replaySpeed = 1.0f;            // Real-time multiplier
+float g_replayPointsPerSecond = 200.0f;
+double g_replayClock = 0.0;            // Seconds since the first measurement
+double g_replayPointCarry = 0.0;       // Fractional points owed at the fixed rate
+std::vector<float> g_replayTimes;      // Running maximum of the point times, so it can be binary searched
+
+// Compare mode: loaded scan minus its nearest-neighbour matches in a reference scan,
+// shown through a diverging colour buffer that replaces the scan's own colours
+bool g_diffEnabled = false;
+std::string g_diffReferenceFile;
+float g_diffMaxDistance = 0.0f;        // 0 = match at any distance
+bool g_diffAutoRange = true;
+float g_diffColorRange = 0.0f;         // Deltas map to [-range, +range]
+ScanDiffResult g_diffResult;
+unsigned int g_diffColorBuffer = 0;
+
+// Time-lapse playback over a range of the scan files (Playback window)
+ScanPlayback g_playback(VerticesLoader::getResidency());
+int g_playbackFrom = 0, g_playbackTo = 0;  // Chronological positions in the file list (0 = oldest)
+int g_swapInterval = 1;
+// Time slice per frame for uploading preloaded scans, so the window stays responsive
+const double PLAYBACK_PRELOAD_MILLISECONDS = 8.0;
 
 // Cached scan data to avoid regenerating every frame
 std::vector<float> g_cachedMeasurementValues;
 std::pair<float, float> g_cachedValueRange;
 std::vector<unsigned int> g_cachedPointIndices;
 std::vector<unsigned int> g_cachedLineIndices;
-bool g_needsColorUpdate = true;
 
-// Bounding box data
-struct BoundingBox {
-  float minX, maxX;
-  float minY, maxY;
-  float minZ, maxZ;
+// Active attribute filter (resolved through the loader's bitmap index)
+ScanFilter g_scanFilter;
+PointBitset g_filterSelection; // Points passing the active filter (only valid while it is active)
+
+// Hover picking state
+const float PICK_RADIUS_PIXELS = 6.0f;
+PickResult g_hoverPick;
+double g_lastPickCursorX = -1.0, g_lastPickCursorY = -1.0;
+bool g_pickDirty = true; // Data, filter or camera changed since the last pick
+
+// Region selection (box/lasso), highlighted through its own index buffer
+unsigned int g_selectionEBO;
+PointBitset g_regionSelection;
+size_t g_selectionIndexCount = 0;
+SelectionStatistics g_selectionStats;
+double g_selectionMicroseconds = 0.0;
+
+// Matrices of the last rendered frame (selection is resolved from input callbacks)
+Mat4 g_renderView = { 0 };
+Mat4 g_renderProjection = { 0 };
+
+// Scan catalog, built on a background thread at startup and browsed in the Catalog window
+std::vector<std::string> g_scanRoots;
+ScanCatalog g_catalog;
+ScanCatalog g_pendingCatalog;          // Owned by the indexing thread until g_catalogReady
+std::thread g_catalogThread;
+std::atomic<bool> g_catalogReady(false);
+bool g_catalogLoaded = false;
+char g_catalogQueryText[256] = "";
+std::vector<size_t> g_catalogMatches;
+std::string g_catalogQueryError;
+double g_catalogQueryMilliseconds = 0.0;
+
+// Similarity matrix of the session's scans (oldest first). A loader thread reads and
+// resamples the files, then the pairwise pass runs as a job.
+SimilarityMatrix g_similarity;
+std::thread g_similarityLoader;
+std::atomic<bool> g_similarityLoaded(false);
+std::shared_ptr<ResampledScans> g_similarityScans;   // Owned by the loader until g_similarityLoaded
+JobHandle g_similarityJob;
+SimilarityMatrix g_pendingSimilarity;  // Owned by the matrix job until g_similarityReady
+std::atomic<bool> g_similarityReady(false);
+std::atomic<bool> g_similarityCancel(false);
+SimilarityOptions g_similarityRunOptions;
+int g_similarityCells = 32;
+int g_similarityMetric = 0;            // SimilarityMetric
+unsigned int g_similarityTexture = 0;  // N x N heatmap
+char g_similarityExportPath[256] = "similarity.csv";
+
+// Gaussian beam-profile fits of the loaded scan
+ScanFitResult g_fitResult;
+bool g_fitAuto = true;                 // Refit whenever another scan is loaded
+
+// Lobes of the loaded scan: local maxima plus grid DBSCAN over the high-value points
+PeakOptions g_peakOptions;
+PeakDetectionResult g_peakResult;
+std::string g_peakFile;                // Scan g_peakResult belongs to
+bool g_peakHighlight = false;          // Colour points by lobe (overrides compare colours)
+unsigned int g_peakColorBuffer = 0;
+
+// Backlash/hysteresis between the loaded scan's forward and reverse passes, plus its noise spectrum
+HysteresisResult g_hysteresisResult;
+
+// Along-path denoising: a filtered copy of the loaded values with its own colour buffer, so
+// switching between raw and filtered only rebinds the point colours
+ScanFilterOptions g_denoiseOptions;
+bool g_denoiseEnabled = false;         // Colour points by the filtered channel
+std::vector<float> g_denoisedValues;   // Same order as VerticesLoader::getValueData()
+std::string g_denoiseFile;             // Scan the filtered channel belongs to
+ScanFilterOptions g_denoiseApplied;    // Options the channel was computed with
+unsigned int g_denoiseColorBuffer = 0;
+double g_denoiseMilliseconds = 0.0;
+
+// Delaunay value surface over the scan plane. Its VAO has its own lifted vertex buffer but shares
+// whichever colour buffer the point VAO currently uses, so every colour mode carries over
+SurfaceOptions g_surfaceOptions;
+bool g_surfaceEnabled = false;
+bool g_surfaceOnly = false;            // Hide the path and points under the surface
+float g_surfaceHeight = 0.25f;         // Value range as a fraction of the larger plane extent
+SurfaceMesh g_surfaceMesh;
+std::string g_surfaceFile;             // Scan g_surfaceMesh belongs to
+unsigned int g_surfaceVAO = 0, g_surfaceVertexBuffer = 0, g_surfaceEBO = 0;
+
+// Volumetric grid of the loaded scan, interpolated as a background job; the iso-surfaces are
+// extracted from it on the main thread whenever a level changes
+struct IsoLevel {
+  bool enabled = false;
+  float decibels = -3.0f;              // Relative to the peak measurement
+  IsoSurfaceMesh mesh;
+  unsigned int vao = 0, vertexBuffer = 0, colorBuffer = 0, ebo = 0;
+
+  IsoLevel(bool enabled, float decibels) : enabled(enabled), decibels(decibels) {}
 };
+VolumeGridOptions g_volumeOptions;
+VolumeGrid g_volumeGrid;
+VolumeGrid g_pendingVolumeGrid;        // Owned by the volume job until g_volumeReady
+std::string g_volumeFile;              // Scan g_volumeGrid belongs to
+std::string g_pendingVolumeFile;
+JobHandle g_volumeJob;
+std::atomic<bool> g_volumeReady(false);
+std::atomic<bool> g_volumeCancel(false);
+bool g_volumeQueued = false;           // Scan or options changed while the job was busy
+bool g_volumeEnabled = false;
+bool g_volumeOnly = false;             // Hide the path and points inside the surfaces
+IsoLevel g_isoLevels[3] = { IsoLevel(true, -3.0f), IsoLevel(false, -6.0f), IsoLevel(false, -10.0f) };
+
+// Orthogonal cuts through the volume grid (normal X, Y and Z) as heatmaps with contour lines.
+// The cut positions are outlined in the 3D view
+bool g_slicesEnabled = false;
+bool g_slicesFollowPeak = true;        // Move the cuts to the grid peak whenever a new grid arrives
+float g_slicePositions[3] = { 0.0f, 0.0f, 0.0f };
+SliceImage g_slices[3];
+std::vector<std::vector<float>> g_sliceContours[3];  // Segments per level
+char g_sliceLevelText[128] = "-1 -3 -6 -10";
+std::vector<float> g_sliceLevels;      // dB relative to the peak, parsed from g_sliceLevelText
+unsigned int g_sliceTextures[3] = { 0, 0, 0 };
+unsigned int g_sliceOutlineVAO = 0, g_sliceOutlineVBO = 0;
+double g_sliceMilliseconds = 0.0;      // Last slice + contour update
+
+// -3 dB and 1/e^2 contour metrics of the loaded scan; the closed contours are drawn in the peak plane
+BeamWidthOptions g_beamOptions;
+BeamWidthResult g_beamResult;
+bool g_beamShowContours = true;
+unsigned int g_beamVAO = 0, g_beamVBO = 0;
+
+// Bounding box data
 BoundingBox g_boundingBox;
 
 // Forward declarations
 void updateScanBuffers();
-void valueToColor(float normalizedValue, float& r, float& g, float& b);
 void updateCachedData();
+void buildFilteredDrawLists();
+void applyScanFilter();
+void updateHoverPick(GLFWwindow* window, const Mat4& view, const Mat4& projection);
+void showHoverTooltip();
+void applyRegionSelection(GLFWwindow* window, const std::vector<double>& path, bool lasso);
+void clearRegionSelection();
+void updateRegionSelection();
+void showSelectionWindow();
+void drawSelectionOverlay();
+void startCatalogIndexing();
+void runCatalogQuery();
+void showCatalogWindow();
+bool uploadScanBuffers(const DecodedScan& scan, GpuScanBuffers& buffers);
+void releaseScanBuffers(GpuScanBuffers& buffers);
+void bindScanBuffers(const GpuScanBuffers& buffers);
+bool bindCurrentScanBuffers();
+void showMemoryWindow();
+void startPlayback();
+void stopPlayback();
+void showPlaybackWindow();
+void resetReplay();
+void advanceReplay(double elapsedSeconds);
+void showReplayWindow();
+void computeScanDiff();
+void bindDiffColors();
+void showCompareWindow();
+bool similarityBusy();
+void startSimilarity();
+void pollSimilarity();
+void cancelSimilarity();
+void updateSimilarityTexture();
+void showSimilarityWindow();
+void fitLoadedScan();
+void showFitWindow();
+void detectPeaks();
+void bindPeakColors();
+void showPeaksWindow();
+void analyzeHysteresis();
+void showHysteresisWindow();
+void computeDenoisedChannel();
+void bindDenoisedColors();
+void showDenoiseWindow();
+void buildSurface();
+void liftSurface();
+void bindSurfaceColors();
+void showSurfaceWindow();
+void startVolumeGrid();
+void cancelVolumeGrid();
+void extractIsoLevel(IsoLevel& level);
+void showVolumeWindow();
+void updateSlice(int axis);
+void updateSlices();
+void renderSliceOutlines(GLint colorLocation);
+void showSlicesWindow();
+void analyzeBeamWidths();
+void renderBeamContours(GLint colorLocation);
+void showBeamWidthWindow();
 void calculateBoundingBox();
 void setupBoundingBoxBuffers();
 void renderBoundingBox(GLint colorLocation);
@@ -200,55 +436,17 @@ Mat4 createOrthographicViewMatrixWithRotationAndPan() {
   );
 }
 
-// Helper function to map value to color (0=blue, 0.5=green, 1=red)
-void valueToColor(float normalizedValue, float& r, float& g, float& b) {
-  // Clamp value between 0 and 1
-  normalizedValue = std::max(0.0f, std::min(1.0f, normalizedValue));
-
-  if (normalizedValue < 0.5f) {
-    // Blue to Green (0 to 0.5)
-    float t = normalizedValue * 2.0f;
-    r = 0.0f;
-    g = t;
-    b = 1.0f - t;
-  }
-  else {
-    // Green to Red (0.5 to 1)
-    float t = (normalizedValue - 0.5f) * 2.0f;
-    r = t;
-    g = 1.0f - t;
-    b = 0.0f;
-  }
-}
-
-// Function to calculate bounding box from scan vertices
+// Function to fetch the bounding box maintained by the loader (no pass over the points)
 void calculateBoundingBox() {
-  std::vector<float> scanVertices = VerticesLoader::generateScanVertices();
-
-  if (scanVertices.empty()) {
+  if (VerticesLoader::getPositionData().empty()) {
     g_boundingBox = { 0, 0, 0, 0, 0, 0 };
     std::cout << "Warning: No vertices for bounding box calculation!" << std::endl;
     return;
   }
 
-  g_boundingBox.minX = g_boundingBox.maxX = scanVertices[0];
-  g_boundingBox.minY = g_boundingBox.maxY = scanVertices[1];
-  g_boundingBox.minZ = g_boundingBox.maxZ = scanVertices[2];
-
-  for (size_t i = 0; i < scanVertices.size(); i += 3) {
-    float x = scanVertices[i];
-    float y = scanVertices[i + 1];
-    float z = scanVertices[i + 2];
+  g_boundingBox = VerticesLoader::getBoundingBox();
 
-    g_boundingBox.minX = std::min(g_boundingBox.minX, x);
-    g_boundingBox.maxX = std::max(g_boundingBox.maxX, x);
-    g_boundingBox.minY = std::min(g_boundingBox.minY, y);
-    g_boundingBox.maxY = std::max(g_boundingBox.maxY, y);
-    g_boundingBox.minZ = std::min(g_boundingBox.minZ, z);
-    g_boundingBox.maxZ = std::max(g_boundingBox.maxZ, z);
-  }
-
-  std::cout << "Bounding box calculated - Vertices: " << (scanVertices.size() / 3) << std::endl;
+  std::cout << "Bounding box calculated - Vertices: " << (VerticesLoader::getPositionData().size() / 3) << std::endl;
   std::cout << "  X: [" << g_boundingBox.minX << " to " << g_boundingBox.maxX << "]" << std::endl;
   std::cout << "  Y: [" << g_boundingBox.minY << " to " << g_boundingBox.maxY << "]" << std::endl;
   std::cout << "  Z: [" << g_boundingBox.minZ << " to " << g_boundingBox.maxZ << "]" << std::endl;
@@ -320,9 +518,7 @@ void renderBoundingBox(GLint colorLocation) {
 void updateCachedData() {
   g_cachedMeasurementValues = VerticesLoader::getMeasurementValues();
   g_cachedValueRange = VerticesLoader::getValueRange();
-  g_cachedPointIndices = VerticesLoader::generateScanPointIndices();
-  g_cachedLineIndices = VerticesLoader::generateScanLineIndices();
-  g_needsColorUpdate = true;
+  buildFilteredDrawLists();
 
   std::cout << "Cached data updated:" << std::endl;
   std::cout << "  Points: " << g_cachedPointIndices.size() << std::endl;
@@ -330,12 +526,1744 @@ void updateCachedData() {
   std::cout << "  Values: " << g_cachedMeasurementValues.size() << std::endl;
 }
 
+// Build the point/line draw lists, honouring the active filter
+void buildFilteredDrawLists() {
+  if (g_scanFilter.isActive()) {
+    // Keep the selection around so picking can skip hidden points
+    VerticesLoader::getBitmapIndex().resolve(g_scanFilter, VerticesLoader::getValueData(), g_filterSelection);
+    g_cachedPointIndices.clear();
+    g_cachedLineIndices.clear();
+    g_filterSelection.appendSetBits(g_cachedPointIndices);
+    g_filterSelection.appendAdjacentPairs(g_cachedLineIndices);
+  }
+  else {
+    g_cachedPointIndices = VerticesLoader::generateScanPointIndices();
+    g_cachedLineIndices = VerticesLoader::generateScanLineIndices();
+  }
+  g_pickDirty = true;
+}
+
+// Re-resolve the filter and upload only the (small) index buffers; vertex data stays on the GPU
+void applyScanFilter() {
+  auto start = std::chrono::steady_clock::now();
+
+  buildFilteredDrawLists();
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_lineEBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, g_cachedLineIndices.size() * sizeof(unsigned int), g_cachedLineIndices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_pointEBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, g_cachedPointIndices.size() * sizeof(unsigned int), g_cachedPointIndices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+  // A selection only keeps the points that are still visible
+  if (g_regionSelection.size() > 0 && g_scanFilter.isActive()) {
+    g_regionSelection.andWith(g_filterSelection);
+    updateRegionSelection();
+  }
+
+  auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "Filter applied: " << g_cachedPointIndices.size() << " / " << VerticesLoader::getValueData().size()
+    << " points, " << g_cachedLineIndices.size() / 2 << " segments (" << elapsed << " us)" << std::endl;
+}
+
+// Re-pick the point under the cursor when the cursor, data, filter or camera changed
+void updateHoverPick(GLFWwindow* window, const Mat4& view, const Mat4& projection) {
+  double cursorX, cursorY;
+  glfwGetCursorPos(window, &cursorX, &cursorY);
+
+  static Mat4 lastViewProjection = { 0 };
+  Mat4 viewProjection = matrixMultiply(projection, view);
+  if (viewProjection != lastViewProjection) {
+    lastViewProjection = viewProjection;
+    g_pickDirty = true;
+  }
+
+  if (!g_pickDirty && cursorX == g_lastPickCursorX && cursorY == g_lastPickCursorY) return;
+  g_lastPickCursorX = cursorX;
+  g_lastPickCursorY = cursorY;
+  g_pickDirty = false;
+
+  g_hoverPick = PickResult();
+  if (ImGui::GetIO().WantCaptureMouse || VerticesLoader::getPositionData().empty()) return;
+
+  // Cursor coordinates are in window units, so use the window size rather than the framebuffer size
+  int windowWidth = 0, windowHeight = 0;
+  glfwGetWindowSize(window, &windowWidth, &windowHeight);
+  if (windowWidth <= 0 || windowHeight <= 0) return;
+
+  const PointBitset* visible = g_scanFilter.isActive() ? &g_filterSelection : nullptr;
+  g_hoverPick = PointPicker::pick(VerticesLoader::getSpatialIndex(), cursorX, cursorY, windowWidth, windowHeight,
+    view, projection, PICK_RADIUS_PIXELS, visible);
+}
+
+// Tooltip with the exact data of the hovered point
+void showHoverTooltip() {
+  if (!g_hoverPick.hit) return;
+
+  uint32_t index = g_hoverPick.index;
+  // Points not yet (or no longer) drawn by the replay
+  if (g_replayEnabled && (index >= g_replayEnd || (g_replayTrail > 0 && index + g_replayTrail < g_replayEnd))) return;
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  if (static_cast<size_t>(index) >= values.size()) return;
+
+  const std::vector<std::string>& axisNames = VerticesLoader::getAxisNames();
+  const std::vector<std::string>& directionNames = VerticesLoader::getDirectionNames();
+  uint8_t axisCode = VerticesLoader::getAxisCodes()[index];
+  uint8_t directionCode = VerticesLoader::getDirectionCodes()[index];
+
+  ImGui::BeginTooltip();
+  ImGui::Text("Point %u", index);
+  ImGui::Separator();
+  ImGui::Text("Position: (%.4f, %.4f, %.4f)", positions[index * 3], positions[index * 3 + 1], positions[index * 3 + 2]);
+  ImGui::Text("Value: %.6g", values[index]);
+  if (g_denoiseEnabled && index < g_denoisedValues.size()) {
+    ImGui::Text("Filtered: %.6g", g_denoisedValues[index]);
+  }
+  ImGui::Text("Axis: %s", axisCode < axisNames.size() ? axisNames[axisCode].c_str() : "?");
+  ImGui::Text("Direction: %s", directionCode < directionNames.size() ? directionNames[directionCode].c_str() : "?");
+  if (VerticesLoader::getPeakFlags()[index]) {
+    ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.2f, 1.0f), "Peak");
+  }
+  if (g_diffEnabled && index < g_diffResult.deltas.size()) {
+    if (std::isnan(g_diffResult.deltas[index])) {
+      ImGui::Text("No reference point within range");
+    }
+    else {
+      ImGui::Text("Delta: %.6g (reference point %u, %.4f away)", g_diffResult.deltas[index],
+        g_diffResult.matches[index], g_diffResult.distances[index]);
+    }
+  }
+  if (g_peakHighlight && index < g_peakResult.labels.size() && g_peakResult.labels[index] >= 0) {
+    ImGui::Text("Lobe %d", g_peakResult.labels[index] + 1);
+  }
+  ImGui::TextDisabled("Pick: %.1f us", g_hoverPick.elapsedMicroseconds);
+  ImGui::EndTooltip();
+}
+
+// Select the visible points inside a box (two corners) or lasso drawn in window coordinates
+void applyRegionSelection(GLFWwindow* window, const std::vector<double>& path, bool lasso) {
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  int windowWidth = 0, windowHeight = 0;
+  glfwGetWindowSize(window, &windowWidth, &windowHeight);
+  if (positions.empty() || windowWidth <= 0 || windowHeight <= 0 || path.size() < 4) return;
+
+  // A click without a real drag clears the selection
+  double minX = path[0], maxX = path[0], minY = path[1], maxY = path[1];
+  for (size_t v = 2; v + 1 < path.size(); v += 2) {
+    minX = std::min(minX, path[v]);
+    maxX = std::max(maxX, path[v]);
+    minY = std::min(minY, path[v + 1]);
+    maxY = std::max(maxY, path[v + 1]);
+  }
+  if (maxX - minX < 3.0 || maxY - minY < 3.0 || (lasso && path.size() < 6)) {
+    clearRegionSelection();
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<float> ndcPath(path.size());
+  for (size_t v = 0; v + 1 < path.size(); v += 2) {
+    PointPicker::windowToNdc(path[v], path[v + 1], windowWidth, windowHeight, &ndcPath[v]);
+  }
+
+  Mat4 viewProjection = matrixMultiply(g_renderProjection, g_renderView);
+  const PointBitset* visible = g_scanFilter.isActive() ? &g_filterSelection : nullptr;
+  size_t pointCount = positions.size() / 3;
+  if (lasso) {
+    RegionSelection::selectLasso(positions.data(), pointCount, viewProjection, ndcPath, visible, g_regionSelection);
+  }
+  else {
+    RegionSelection::selectRectangle(positions.data(), pointCount, viewProjection, &ndcPath[0], &ndcPath[2], visible, g_regionSelection);
+  }
+  updateRegionSelection();
+
+  g_selectionMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  std::cout << (lasso ? "Lasso" : "Box") << " selection: " << g_selectionStats.count << " points ("
+    << g_selectionMicroseconds << " us)" << std::endl;
+}
+
+// Recompute the statistics and highlight index buffer of the current selection
+void updateRegionSelection() {
+  g_selectionStats = RegionSelection::computeStatistics(g_regionSelection, VerticesLoader::getPositionData(),
+    VerticesLoader::getValueData(), VerticesLoader::getBitmapIndex().getPeakBits());
+
+  std::vector<unsigned int> selectionIndices;
+  g_regionSelection.appendSetBits(selectionIndices);
+  g_selectionIndexCount = selectionIndices.size();
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_selectionEBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, selectionIndices.size() * sizeof(unsigned int), selectionIndices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void clearRegionSelection() {
+  if (g_regionSelection.size() == 0) return;
+  g_regionSelection = PointBitset();
+  g_selectionIndexCount = 0;
+  g_selectionStats = SelectionStatistics();
+  std::cout << "Selection cleared" << std::endl;
+}
+
+// Statistics of the selected points
+void showSelectionWindow() {
+  if (g_regionSelection.size() == 0) return;
+
+  ImGui::SetNextWindowPos(ImVec2(10.0f, 10.0f), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Selection", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Text("Points: %zu", g_selectionStats.count);
+  if (g_selectionStats.count > 0) {
+    ImGui::Text("Value min: %.6g", g_selectionStats.minValue);
+    ImGui::Text("Value max: %.6g", g_selectionStats.maxValue);
+    ImGui::Text("Value mean: %.6g", g_selectionStats.meanValue);
+    ImGui::Text("Peaks: %zu", g_selectionStats.peakCount);
+    ImGui::Text("Centroid: (%.4f, %.4f, %.4f)", g_selectionStats.centroid[0], g_selectionStats.centroid[1], g_selectionStats.centroid[2]);
+  }
+  ImGui::TextDisabled("Selected in %.0f us", g_selectionMicroseconds);
+  if (ImGui::Button("Clear (X)")) {
+    clearRegionSelection();
+  }
+  ImGui::End();
+}
+
+// Load the saved catalogs immediately, then bring them up to date in the background
+void startCatalogIndexing() {
+  g_catalog.load(g_scanRoots);
+  g_catalogLoaded = g_catalog.size() > 0;
+  runCatalogQuery();
+
+  g_catalogThread = std::thread([]() {
+    CatalogUpdateStats stats = g_pendingCatalog.update(g_scanRoots);
+    std::cout << "Catalog updated: " << g_pendingCatalog.size() << " scans (" << stats.added << " added, "
+      << stats.changed << " changed, " << stats.removed << " removed) in " << stats.milliseconds << " ms" << std::endl;
+    g_catalogReady = true;
+  });
+}
+
+void runCatalogQuery() {
+  CatalogQuery query;
+  if (!ScanCatalog::parseQuery(g_catalogQueryText, query, g_catalogQueryError)) return;
+  auto start = std::chrono::steady_clock::now();
+  g_catalogMatches = g_catalog.query(query, ScanCatalog::currentTime());
+  g_catalogQueryMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Every catalogued scan with its summary; clicking a row loads it
+void showCatalogWindow() {
+  if (g_catalogReady) {
+    g_catalogThread.join();
+    g_catalogReady = false;
+    std::swap(g_catalog, g_pendingCatalog);
+    g_catalogLoaded = true;
+    runCatalogQuery();
+  }
+
+  ImGui::SetNextWindowPos(ImVec2(10.0f, 200.0f), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(620.0f, 320.0f), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Catalog");
+  if (!g_catalogLoaded) {
+    ImGui::Text("Indexing scan files...");
+    ImGui::End();
+    return;
+  }
+
+  if (ImGui::InputTextWithHint("##query", "peak>0.0005 days<7 points>=1000", g_catalogQueryText, sizeof(g_catalogQueryText))) {
+    runCatalogQuery();
+  }
+  if (!g_catalogQueryError.empty()) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_catalogQueryError.c_str());
+  }
+  ImGui::TextDisabled("%zu of %zu scans (%.2f ms)%s", g_catalogMatches.size(), g_catalog.size(), g_catalogQueryMilliseconds,
+    g_catalogThread.joinable() ? ", updating..." : "");
+
+  const std::vector<CatalogRecord>& records = g_catalog.getRecords();
+  const std::vector<std::string>& paths = g_catalog.getPaths();
+  ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+  if (ImGui::BeginTable("catalog", 5, flags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Date (UTC)");
+    ImGui::TableSetupColumn("Points");
+    ImGui::TableSetupColumn("Peak value");
+    ImGui::TableSetupColumn("Peak position");
+    ImGui::TableSetupColumn("File");
+    ImGui::TableHeadersRow();
+
+    // Only the visible rows are submitted, so 100k matches scroll smoothly
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(g_catalogMatches.size()));
+    while (clipper.Step()) {
+      for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+        size_t i = g_catalogMatches[row];
+        const CatalogRecord& r = records[i];
+        std::time_t time = static_cast<std::time_t>(r.timestamp);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::gmtime(&time));
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::PushID(row);
+        if (ImGui::Selectable(date, false, ImGuiSelectableFlags_SpanAllColumns)) {
+          if (VerticesLoader::selectScanFile(paths[i], SCAN_SCALE_FACTOR)) {
+            std::cout << VerticesLoader::getScanInfo() << std::endl;
+            updateScanBuffers();
+          }
+        }
+        ImGui::PopID();
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", r.pointCount);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.6g", r.peakValue);
+        ImGui::TableNextColumn();
+        ImGui::Text("(%.3f, %.3f, %.3f)", r.peakX, r.peakY, r.peakZ);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(paths[i].c_str());
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+// Outline of the box or lasso being dragged
+void drawSelectionOverlay() {
+  if (!InputHandler::isSelecting()) return;
+  const std::vector<double>& path = InputHandler::getSelectionPath();
+  if (path.size() < 4) return;
+
+  ImDrawList* drawList = ImGui::GetForegroundDrawList();
+  ImU32 outline = IM_COL32(255, 120, 255, 255);
+  if (InputHandler::isLassoSelection()) {
+    std::vector<ImVec2> points;
+    points.reserve(path.size() / 2);
+    for (size_t v = 0; v + 1 < path.size(); v += 2) {
+      points.push_back(ImVec2(static_cast<float>(path[v]), static_cast<float>(path[v + 1])));
+    }
+    drawList->AddPolyline(points.data(), static_cast<int>(points.size()), outline, ImDrawFlags_Closed, 1.5f);
+  }
+  else {
+    ImVec2 a(static_cast<float>(path[0]), static_cast<float>(path[1]));
+    ImVec2 b(static_cast<float>(path[2]), static_cast<float>(path[3]));
+    drawList->AddRectFilled(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)), ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), IM_COL32(255, 120, 255, 40));
+    drawList->AddRect(ImVec2(std::min(a.x, b.x), std::min(a.y, b.y)), ImVec2(std::max(a.x, b.x), std::max(a.y, b.y)), outline, 0.0f, 0, 1.5f);
+  }
+}
+
+static const float MIN_VALID_VALUE = 0.000005f; // 5 micro threshold
+
+// Colour range of one scan: the P1-P99 range of its values
+static void computeColorRange(const std::vector<float>& values, float& minValidValue, float& maxValidValue) {
+  const double COLOR_RANGE_LOW_PERCENTILE = 0.01;
+  const double COLOR_RANGE_HIGH_PERCENTILE = 0.99;
+
+  ScanStatistics valueStats;
+  valueStats.addRange(values.data(), values.size());
+
+  minValidValue = 0.0f;
+  maxValidValue = 0.0f;
+  if (valueStats.getCount() > 0 && valueStats.getMax() >= MIN_VALID_VALUE) {
+    minValidValue = std::max(valueStats.getPercentile(COLOR_RANGE_LOW_PERCENTILE), MIN_VALID_VALUE);
+    maxValidValue = std::max(valueStats.getPercentile(COLOR_RANGE_HIGH_PERCENTILE), minValidValue);
+  }
+}
+
+// Per-point colours for one scan: LUT over the P1-P99 range of its values
+static void computePointColors(const std::vector<float>& values, std::vector<PackedColor>& colors) {
+  float minValidValue, maxValidValue;
+  computeColorRange(values, minValidValue, maxValidValue);
+  colors.resize(values.size());
+  ColorMapper::mapToRGBA(values.data(), values.size(), minValidValue, maxValidValue, MIN_VALID_VALUE, colors.data());
+}
+
+// Upload callback of the residency cache: positions and colours of one scan in two buffers
+bool uploadScanBuffers(const DecodedScan& scan, GpuScanBuffers& buffers) {
+  std::vector<PackedColor> colors;
+  computePointColors(scan.values, colors);
+
+  glGenBuffers(1, &buffers.vertexBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, scan.positions.size() * sizeof(float), scan.positions.data(), GL_STATIC_DRAW);
+
+  glGenBuffers(1, &buffers.colorBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.colorBuffer);
+  glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(PackedColor), colors.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  buffers.pointCount = scan.values.size();
+  buffers.bytes = scan.positions.size() * sizeof(float) + colors.size() * sizeof(PackedColor);
+  return glGetError() == GL_NO_ERROR;
+}
+
+void releaseScanBuffers(GpuScanBuffers& buffers) {
+  glDeleteBuffers(1, &buffers.vertexBuffer);
+  glDeleteBuffers(1, &buffers.colorBuffer);
+  buffers = GpuScanBuffers();
+}
+
+// Point the line and point VAOs at one scan's resident buffers (no data is copied)
+void bindScanBuffers(const GpuScanBuffers& buffers) {
+  glBindVertexArray(g_lineVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.vertexBuffer);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+
+  glBindVertexArray(g_pointVAO);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, buffers.colorBuffer);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glEnableVertexAttribArray(1);
+
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  g_boundVertexBuffer = buffers.vertexBuffer;
+}
+
+bool bindCurrentScanBuffers() {
+  std::string error;
+  const GpuScanBuffers* buffers = VerticesLoader::getResidency().acquireGpu(
+    VerticesLoader::getCurrentScanFile(), SCAN_SCALE_FACTOR, &error);
+  if (buffers == nullptr) {
+    std::cerr << "Cannot upload " << VerticesLoader::getCurrentScanFile() << ": " << error << std::endl;
+    return false;
+  }
+  bindScanBuffers(*buffers);
+  bindDenoisedColors();
+  bindDiffColors();
+  bindPeakColors();
+  bindSurfaceColors();
+  return true;
+}
+
+// In compare mode the point VAO takes its colours from the diff buffer instead
+void bindDiffColors() {
+  if (!g_diffEnabled || g_diffColorBuffer == 0 || g_peakHighlight) return;
+  glBindVertexArray(g_pointVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, g_diffColorBuffer);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Match the loaded scan against the reference and colour the deltas
+void computeScanDiff() {
+  std::string error;
+  std::shared_ptr<const DecodedScan> reference = VerticesLoader::getResidency().acquire(g_diffReferenceFile, SCAN_SCALE_FACTOR, &error);
+  if (!reference) {
+    std::cerr << "Cannot load reference " << g_diffReferenceFile << ": " << error << std::endl;
+    g_diffEnabled = false;
+    bindCurrentScanBuffers();
+    return;
+  }
+
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  ScanDiff::compute(positions.data(), values.data(), values.size(), reference->positions.data(),
+    reference->values.data(), reference->values.size(), g_diffMaxDistance, g_diffResult);
+
+  // Symmetric range at the 99th percentile of |delta| keeps single outliers from washing out the map
+  if (g_diffAutoRange) {
+    ScanStatistics magnitude;
+    for (float delta : g_diffResult.deltas) {
+      if (!std::isnan(delta)) magnitude.add(std::fabs(delta));
+    }
+    g_diffColorRange = magnitude.getCount() > 0 ? magnitude.getPercentile(0.99) : 0.0f;
+  }
+
+  std::vector<PackedColor> colors(g_diffResult.deltas.size());
+  ColorMapper::mapToRGBA(g_diffResult.deltas.data(), colors.size(), -g_diffColorRange, g_diffColorRange,
+    -std::numeric_limits<float>::infinity(), ColorMapper::getDivergingLut(), colors.data());
+
+  if (g_diffColorBuffer == 0) glGenBuffers(1, &g_diffColorBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, g_diffColorBuffer);
+  glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(PackedColor), colors.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  bindDiffColors();
+
+  std::cout << "Diff against " << g_diffReferenceFile << ": " << g_diffResult.matchedCount << " / " << values.size()
+    << " matched, mean delta " << g_diffResult.meanDelta << ", RMS " << g_diffResult.rmsDelta << " ("
+    << g_diffResult.buildMilliseconds + g_diffResult.matchMilliseconds << " ms)" << std::endl;
+}
+
+void showCompareWindow() {
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(420, 10), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Compare", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Text("Reference: %s", g_diffReferenceFile.empty() ? "(none)" :
+    std::filesystem::path(g_diffReferenceFile).filename().string().c_str());
+  if (ImGui::Button("Use loaded scan as reference")) {
+    g_diffReferenceFile = VerticesLoader::getCurrentScanFile();
+    if (g_diffEnabled) computeScanDiff();
+  }
+
+  if (!g_diffReferenceFile.empty()) {
+    if (ImGui::Checkbox("Show difference to reference", &g_diffEnabled)) {
+      if (g_diffEnabled) computeScanDiff();
+      else bindCurrentScanBuffers();
+    }
+    bool rematch = false;
+    ImGui::SliderFloat("Max match distance", &g_diffMaxDistance, 0.0f, 100.0f, g_diffMaxDistance > 0.0f ? "%.2f" : "any");
+    rematch |= ImGui::IsItemDeactivatedAfterEdit();
+    rematch |= ImGui::Checkbox("Auto colour range", &g_diffAutoRange);
+    if (!g_diffAutoRange) {
+      ImGui::SliderFloat("Colour range (+/-)", &g_diffColorRange, 0.0f, std::max(g_diffResult.maxAbsDelta, 1e-9f), "%.3g");
+      rematch |= ImGui::IsItemDeactivatedAfterEdit();
+    }
+    if (rematch && g_diffEnabled) computeScanDiff();
+  }
+
+  if (g_diffEnabled) {
+    ImGui::Separator();
+    ImGui::Text("Matched: %zu / %zu", g_diffResult.matchedCount, g_diffResult.deltas.size());
+    ImGui::Text("Delta mean %.4g, RMS %.4g", g_diffResult.meanDelta, g_diffResult.rmsDelta);
+    ImGui::Text("Delta range %.4g to %.4g (colours +/- %.4g)", g_diffResult.minDelta, g_diffResult.maxDelta, g_diffColorRange);
+    ImGui::Text("Mean match distance %.4g", g_diffResult.meanDistance);
+    ImGui::TextDisabled("Index %.1f ms, match %.1f ms", g_diffResult.buildMilliseconds, g_diffResult.matchMilliseconds);
+    ImGui::TextDisabled("Blue: below reference, red: above, grey: unmatched");
+  }
+  ImGui::End();
+}
+
+// Compare every scan of the session in the background
+bool similarityBusy() {
+  return g_similarityLoader.joinable() || g_similarityJob != nullptr;
+}
+
+void startSimilarity() {
+  if (similarityBusy()) return;
+  const std::vector<std::string>& files = VerticesLoader::getAvailableFiles();
+  std::vector<std::string> chronological(files.rbegin(), files.rend()); // The file list is newest first
+  g_similarityRunOptions = SimilarityOptions();
+  g_similarityRunOptions.cellsPerAxis = g_similarityCells;
+  g_similarityRunOptions.scaleFactor = SCAN_SCALE_FACTOR;
+  g_similarityRunOptions.cancel = &g_similarityCancel;
+  g_similarityCancel = false;
+
+  // Reading blocks on I/O, so it stays off the job pool
+  g_similarityScans = std::make_shared<ResampledScans>();
+  std::shared_ptr<ResampledScans> scans = g_similarityScans;
+  SimilarityOptions options = g_similarityRunOptions;
+  g_similarityLoader = std::thread([chronological, options, scans]() {
+    ScanSimilarity::resample(chronological, options, *scans);
+    g_similarityLoaded = true;
+  });
+}
+
+// Hand loaded scans to a matrix job and pick up a finished matrix
+void pollSimilarity() {
+  if (g_similarityLoaded) {
+    g_similarityLoader.join();
+    g_similarityLoaded = false;
+    std::shared_ptr<ResampledScans> scans = std::move(g_similarityScans);
+    SimilarityOptions options = g_similarityRunOptions;
+    g_similarityJob = JobSystem::submit([scans, options]() {
+      ScanSimilarity::computeMatrix(*scans, options, g_pendingSimilarity);
+      g_similarityReady = true;
+    });
+  }
+  if (g_similarityReady) {
+    g_similarityJob.reset();
+    g_similarityReady = false;
+    if (g_pendingSimilarity.cancelled) return;
+    std::cout << "Similarity: " << g_pendingSimilarity.size() << " scans on " << g_pendingSimilarity.cellCount
+      << " cells, resampled in " << g_pendingSimilarity.resampleMilliseconds << " ms, matrix in "
+      << g_pendingSimilarity.matrixMilliseconds << " ms" << std::endl;
+    std::swap(g_similarity, g_pendingSimilarity);
+    updateSimilarityTexture();
+  }
+}
+
+// Stop a running comparison; returns once the loader and the matrix job have finished
+void cancelSimilarity() {
+  g_similarityCancel = true;
+  if (g_similarityLoader.joinable()) g_similarityLoader.join();
+  g_similarityLoaded = false;
+  g_similarityScans.reset();
+  JobSystem::wait(g_similarityJob);
+  g_similarityJob.reset();
+  g_similarityReady = false;
+}
+
+// Correlation on the diverging map (-1 blue, +1 red), RMSE on the rainbow map from 0
+void updateSimilarityTexture() {
+  size_t n = g_similarity.size();
+  if (n == 0) return;
+  SimilarityMetric metric = static_cast<SimilarityMetric>(g_similarityMetric);
+  const std::vector<float>& cells = metric == SimilarityMetric::Rmse ? g_similarity.rmse : g_similarity.correlation;
+  std::vector<PackedColor> pixels(cells.size());
+  if (metric == SimilarityMetric::Rmse) {
+    float maxRmse = 0.0f;
+    for (float value : cells) {
+      if (!std::isnan(value)) maxRmse = std::max(maxRmse, value);
+    }
+    ColorMapper::mapToRGBA(cells.data(), cells.size(), 0.0f, maxRmse, -std::numeric_limits<float>::infinity(),
+      ColorMapper::getRainbowLut(), pixels.data());
+  }
+  else {
+    ColorMapper::mapToRGBA(cells.data(), cells.size(), -1.0f, 1.0f, -std::numeric_limits<float>::infinity(),
+      ColorMapper::getDivergingLut(), pixels.data());
+  }
+
+  if (g_similarityTexture == 0) glGenTextures(1, &g_similarityTexture);
+  glBindTexture(GL_TEXTURE_2D, g_similarityTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, static_cast<GLsizei>(n), static_cast<GLsizei>(n), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void showSimilarityWindow() {
+  pollSimilarity();
+  if (VerticesLoader::getAvailableFiles().size() < 2) return;
+
+  ImGui::SetNextWindowPos(ImVec2(830, 10), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Similarity", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SliderInt("Grid cells", &g_similarityCells, 4, 128);
+  ImGui::SameLine();
+  if (similarityBusy()) {
+    if (ImGui::Button("Cancel")) cancelSimilarity();
+    ImGui::Text("Comparing %zu scans...", VerticesLoader::getAvailableFiles().size());
+  }
+  else if (ImGui::Button(g_similarity.size() > 0 ? "Recompute" : "Compute")) {
+    startSimilarity();
+  }
+
+  size_t n = g_similarity.size();
+  if (n > 0) {
+    if (ImGui::RadioButton("Correlation", &g_similarityMetric, static_cast<int>(SimilarityMetric::Correlation)) |
+      ImGui::RadioButton("RMSE", &g_similarityMetric, static_cast<int>(SimilarityMetric::Rmse))) {
+      updateSimilarityTexture();
+    }
+    SimilarityMetric metric = static_cast<SimilarityMetric>(g_similarityMetric);
+
+    // Rows and columns run oldest to newest
+    const float size = 512.0f;
+    ImGui::Image((ImTextureID)(intptr_t)g_similarityTexture, ImVec2(size, size));
+    if (ImGui::IsItemHovered()) {
+      ImVec2 origin = ImGui::GetItemRectMin();
+      ImVec2 mouse = ImGui::GetIO().MousePos;
+      size_t row = std::min(n - 1, static_cast<size_t>(std::max(0.0f, (mouse.y - origin.y) / size * n)));
+      size_t column = std::min(n - 1, static_cast<size_t>(std::max(0.0f, (mouse.x - origin.x) / size * n)));
+      ImGui::BeginTooltip();
+      ImGui::Text("%s", std::filesystem::path(g_similarity.paths[row]).filename().string().c_str());
+      ImGui::Text("%s", std::filesystem::path(g_similarity.paths[column]).filename().string().c_str());
+      ImGui::Text("%s %.4f over %u common cells", ScanSimilarity::getMetricName(metric),
+        g_similarity.at(metric, row, column), g_similarity.commonCells[row * n + column]);
+      ImGui::TextDisabled("Click: load the row scan and compare it to the column scan");
+      ImGui::EndTooltip();
+
+      if (ImGui::IsItemClicked() && !g_playback.isActive()) {
+        if (VerticesLoader::selectScanFile(g_similarity.paths[row], SCAN_SCALE_FACTOR)) {
+          std::cout << VerticesLoader::getScanInfo() << std::endl;
+          g_diffReferenceFile = g_similarity.paths[column];
+          g_diffEnabled = true;
+          updateScanBuffers(); // Also matches against the new reference
+        }
+      }
+    }
+    ImGui::TextDisabled("%zu scans, %zu cells of %.3g, matrix %.1f ms (resampling %.1f ms)", n, g_similarity.cellCount,
+      g_similarity.cellSize, g_similarity.matrixMilliseconds, g_similarity.resampleMilliseconds);
+    if (!g_similarity.failed.empty()) {
+      ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.3f, 1.0f), "%zu scans could not be read", g_similarity.failed.size());
+    }
+
+    ImGui::InputText("##export", g_similarityExportPath, sizeof(g_similarityExportPath));
+    ImGui::SameLine();
+    if (ImGui::Button("Export CSV")) {
+      std::ofstream out(g_similarityExportPath);
+      if (out) {
+        ScanSimilarity::writeCsv(out, g_similarity, metric);
+        std::cout << "Wrote " << ScanSimilarity::getMetricName(metric) << " matrix to " << g_similarityExportPath << std::endl;
+      }
+      else {
+        std::cerr << "Cannot write " << g_similarityExportPath << std::endl;
+      }
+    }
+  }
+  ImGui::End();
+}
+
+// Fit the passes and the peak of the loaded scan (its decoded points come from the residency cache)
+void fitLoadedScan() {
+  const std::string& file = VerticesLoader::getCurrentScanFile();
+  g_fitResult = ScanFitResult();
+  g_fitResult.filePath = file;
+  std::string error;
+  std::shared_ptr<const DecodedScan> scan = VerticesLoader::getResidency().acquire(file, SCAN_SCALE_FACTOR, &error);
+  if (!scan) {
+    g_fitResult.error = error;
+    return;
+  }
+  ScanFit::fitScan(scan->points, ScanFitOptions(), g_fitResult);
+}
+
+void showFitWindow() {
+  if (VerticesLoader::getCurrentScanFile().empty() || g_playback.isActive()) return;
+  if (g_fitAuto && g_fitResult.filePath != VerticesLoader::getCurrentScanFile()) fitLoadedScan();
+
+  ImGui::SetNextWindowPos(ImVec2(420, 300), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(620, 300), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Fits");
+  ImGui::Checkbox("Fit each loaded scan", &g_fitAuto);
+  ImGui::SameLine();
+  if (ImGui::Button("Fit")) {
+    fitLoadedScan();
+  }
+  if (g_fitResult.filePath != VerticesLoader::getCurrentScanFile()) {
+    ImGui::TextDisabled("Not fitted yet");
+    ImGui::End();
+    return;
+  }
+  if (!g_fitResult.ok) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_fitResult.error.c_str());
+    ImGui::End();
+    return;
+  }
+
+  const PeakFit& peak = g_fitResult.peak;
+  ImGui::Text("Peak %s (%zu points, %d iterations, R^2 %.4f)", peak.converged ? "fit" : "fit did not converge",
+    peak.pointCount, peak.iterations, peak.rSquared);
+  ImGui::Text("Centre (%.4f, %.4f, %.4f), amplitude %.4g, offset %.4g", peak.center[0], peak.center[1], peak.center[2],
+    peak.amplitude, peak.offset);
+  std::string widths = "FWHM";
+  const char* axisNames[3] = { " x ", " y ", " z " };
+  for (int a = 0; a < 3; ++a) {
+    if (peak.axisFitted[a]) widths += axisNames[a] + std::to_string(peak.fwhm(a));
+  }
+  ImGui::TextUnformatted(widths.c_str());
+  ImGui::TextDisabled("%zu fits in %.2f ms (%.0f fits/s)", g_fitResult.fitCount, g_fitResult.fitMilliseconds,
+    g_fitResult.fitMilliseconds > 0.0 ? g_fitResult.fitCount / (g_fitResult.fitMilliseconds / 1000.0) : 0.0);
+
+  ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+  if (ImGui::BeginTable("passes", 7, flags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Axis");
+    ImGui::TableSetupColumn("Direction");
+    ImGui::TableSetupColumn("Points");
+    ImGui::TableSetupColumn("Centre");
+    ImGui::TableSetupColumn("FWHM");
+    ImGui::TableSetupColumn("Amplitude");
+    ImGui::TableSetupColumn("R^2");
+    ImGui::TableHeadersRow();
+    for (const PassFit& pass : g_fitResult.passes) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(pass.axis.c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(pass.direction.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", pass.pointCount);
+      ImGui::TableNextColumn();
+      if (!pass.converged) {
+        ImGui::TextDisabled("no fit");
+        continue;
+      }
+      ImGui::Text("%.4f +/- %.4f", pass.center, pass.centerError);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.4f", pass.fwhm());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.4g", pass.amplitude);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.4f", pass.rSquared);
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+// With the highlight on, the point VAO takes one colour per lobe and dim grey elsewhere
+void bindPeakColors() {
+  if (!g_peakHighlight || g_peakColorBuffer == 0) return;
+  glBindVertexArray(g_pointVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, g_peakColorBuffer);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void detectPeaks() {
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  ScanPeaks::detect(positions.data(), values.data(), values.size(), g_peakOptions, g_peakResult);
+  g_peakFile = VerticesLoader::getCurrentScanFile();
+  if (!g_peakHighlight) return;
+
+  // Lobe colours step around the rainbow by the golden ratio so neighbouring ids differ
+  std::vector<PackedColor> colors(values.size(), ColorMapper::packColor(0.2f, 0.2f, 0.2f));
+  for (size_t i = 0; i < colors.size(); ++i) {
+    int32_t label = g_peakResult.labels[i];
+    if (label < 0) continue;
+    float r, g, b;
+    ColorMapper::valueToColor(std::fmod(label * 0.618034f, 1.0f), r, g, b);
+    colors[i] = ColorMapper::packColor(r, g, b);
+  }
+  if (g_peakColorBuffer == 0) glGenBuffers(1, &g_peakColorBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, g_peakColorBuffer);
+  glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(PackedColor), colors.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  bindPeakColors();
+}
+
+void showPeaksWindow() {
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+  if (g_peakFile != VerticesLoader::getCurrentScanFile()) detectPeaks();
+
+  ImGui::SetNextWindowPos(ImVec2(420, 620), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(620, 280), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Peaks");
+  bool redetect = false;
+  ImGui::SliderFloat("Threshold (fraction of range)", &g_peakOptions.thresholdFraction, 0.0f, 1.0f, "%.2f");
+  redetect |= ImGui::IsItemDeactivatedAfterEdit();
+  ImGui::SliderFloat("Neighbourhood radius", &g_peakOptions.epsilon, 0.0f, 50.0f, g_peakOptions.epsilon > 0.0f ? "%.2f" : "auto");
+  redetect |= ImGui::IsItemDeactivatedAfterEdit();
+  int minPoints = static_cast<int>(g_peakOptions.minPoints);
+  if (ImGui::SliderInt("Min points", &minPoints, 1, 50)) g_peakOptions.minPoints = static_cast<size_t>(minPoints);
+  redetect |= ImGui::IsItemDeactivatedAfterEdit();
+  if (ImGui::Checkbox("Highlight lobes", &g_peakHighlight)) {
+    if (g_peakHighlight) redetect = true;
+    else bindCurrentScanBuffers();
+  }
+  if (redetect) detectPeaks();
+
+  const PeakDetectionResult& r = g_peakResult;
+  ImGui::TextDisabled("%zu points >= %.4g, radius %.3f: %zu lobes, %zu local maxima, %zu noise", r.candidateCount,
+    r.threshold, r.epsilon, r.clusters.size(), r.localMaxima.size(), r.noiseCount);
+  ImGui::TextDisabled("Grid %.1f ms, maxima %.1f ms, clustering %.1f ms", r.gridMilliseconds, r.maximaMilliseconds,
+    r.clusterMilliseconds);
+
+  ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+  if (ImGui::BeginTable("lobes", 6, flags)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Lobe");
+    ImGui::TableSetupColumn("Points");
+    ImGui::TableSetupColumn("Peak value");
+    ImGui::TableSetupColumn("Peak position");
+    ImGui::TableSetupColumn("Centroid");
+    ImGui::TableSetupColumn("Extent");
+    ImGui::TableHeadersRow();
+    ImGuiListClipper clipper;
+    clipper.Begin(static_cast<int>(r.clusters.size()));
+    while (clipper.Step()) {
+      for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+        const PeakCluster& c = r.clusters[row];
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", row + 1);
+        ImGui::TableNextColumn();
+        ImGui::Text("%zu", c.pointCount);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.6g", c.peakValue);
+        ImGui::TableNextColumn();
+        ImGui::Text("(%.3f, %.3f, %.3f)", c.peakPosition[0], c.peakPosition[1], c.peakPosition[2]);
+        ImGui::TableNextColumn();
+        ImGui::Text("(%.3f, %.3f, %.3f)", c.centroid[0], c.centroid[1], c.centroid[2]);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f x %.3f x %.3f", c.maxCorner[0] - c.minCorner[0], c.maxCorner[1] - c.minCorner[1],
+          c.maxCorner[2] - c.minCorner[2]);
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
+
+// Pair the loaded scan's passes (decoded points come from the residency cache) and estimate their lags
+void analyzeHysteresis() {
+  const std::string& file = VerticesLoader::getCurrentScanFile();
+  g_hysteresisResult = HysteresisResult();
+  g_hysteresisResult.filePath = file;
+  std::string error;
+  std::shared_ptr<const DecodedScan> scan = VerticesLoader::getResidency().acquire(file, SCAN_SCALE_FACTOR, &error);
+  if (!scan) {
+    g_hysteresisResult.error = error;
+    return;
+  }
+  ScanHysteresis::analyze(scan->points, g_hysteresisResult);
+}
+
+void showHysteresisWindow() {
+  if (VerticesLoader::getCurrentScanFile().empty() || g_playback.isActive()) return;
+  if (g_hysteresisResult.filePath != VerticesLoader::getCurrentScanFile()) analyzeHysteresis();
+
+  ImGui::SetNextWindowPos(ImVec2(1060, 300), ImGuiCond_FirstUseEver);
+  ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Hysteresis");
+  if (!g_hysteresisResult.ok) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", g_hysteresisResult.error.c_str());
+    ImGui::End();
+    return;
+  }
+  if (g_hysteresisResult.pairs.empty()) {
+    ImGui::TextDisabled("No forward/reverse pass pairs in this scan");
+  }
+
+  ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_Resizable;
+  if (!g_hysteresisResult.axes.empty() && ImGui::BeginTable("axes", 5, flags)) {
+    ImGui::TableSetupColumn("Axis");
+    ImGui::TableSetupColumn("Pairs");
+    ImGui::TableSetupColumn("Mean lag");
+    ImGui::TableSetupColumn("Backlash");
+    ImGui::TableSetupColumn("Hysteresis");
+    ImGui::TableHeadersRow();
+    for (const AxisHysteresis& axis : g_hysteresisResult.axes) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(axis.axis.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", axis.pairCount);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.4f +/- %.4f", axis.meanLag, axis.lagStdDev);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.4f", axis.backlash);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f%%", axis.hysteresis * 100.0);
+    }
+    ImGui::EndTable();
+  }
+
+  if (ImGui::CollapsingHeader("Pass pairs")) {
+    for (const PassPairLag& pair : g_hysteresisResult.pairs) {
+      ImGui::Text("%s passes %zu/%zu: lag %.4f, r %.4f, residual %.2f%% (%zu samples)", pair.axis.c_str(),
+        pair.forwardPass, pair.reversePass, pair.lag, pair.correlation, pair.residual * 100.0, pair.samples);
+    }
+  }
+
+  // Log power spectrum; the beam profile sits in the lowest bins, noise and vibration above
+  const NoiseSpectrum& spectrum = g_hysteresisResult.spectrum;
+  if (!spectrum.power.empty()) {
+    std::vector<float> logPower(spectrum.power.size());
+    for (size_t k = 0; k < logPower.size(); ++k) logPower[k] = std::log10(std::max(spectrum.power[k], 1e-30f));
+    const char* unit = spectrum.inHertz ? "Hz" : "cycles/sample";
+    ImGui::Separator();
+    ImGui::Text("Noise RMS %.4g, floor %.4g /%s, strongest line %.4g %s", spectrum.noiseRms, spectrum.noiseFloor,
+      unit, spectrum.peakFrequency, unit);
+    ImGui::PlotLines("##spectrum", logPower.data(), static_cast<int>(logPower.size()), 0, "log10 PSD",
+      FLT_MAX, FLT_MAX, ImVec2(-1.0f, 120.0f));
+    ImGui::TextDisabled("0 .. %.4g %s, %zu segments of %zu, %.2f ms", spectrum.binWidth * (spectrum.power.size() - 1),
+      unit, spectrum.segmentCount, spectrum.segmentLength, g_hysteresisResult.milliseconds);
+  }
+  ImGui::End();
+}
+
+// The filtered channel overrides the raw colours; compare and lobe colours still take precedence
+void bindDenoisedColors() {
+  if (!g_denoiseEnabled || g_denoiseColorBuffer == 0 || g_denoiseFile != VerticesLoader::getCurrentScanFile()) return;
+  glBindVertexArray(g_pointVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, g_denoiseColorBuffer);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static bool sameFilterOptions(const ScanFilterOptions& a, const ScanFilterOptions& b) {
+  return a.type == b.type && a.radius == b.radius && a.polynomialOrder == b.polynomialOrder &&
+    a.alpha == b.alpha && a.zeroPhase == b.zeroPhase;
+}
+
+// Filter each pass of the loaded values and upload the colours once; toggling afterwards only rebinds
+void computeDenoisedChannel() {
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<size_t> passBounds;
+  ScanFilters::findPasses(VerticesLoader::getAxisCodes().data(), VerticesLoader::getDirectionCodes().data(),
+    values.size(), passBounds);
+  g_denoisedValues = values;
+  ScanFilters::apply(g_denoisedValues.data(), g_denoisedValues.size(), passBounds, g_denoiseOptions);
+  g_denoiseMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  g_denoiseFile = VerticesLoader::getCurrentScanFile();
+  g_denoiseApplied = g_denoiseOptions;
+
+  // Same colour range as the raw values, so toggling shows only what the filter changed
+  float minValidValue, maxValidValue;
+  computeColorRange(values, minValidValue, maxValidValue);
+  std::vector<PackedColor> colors(g_denoisedValues.size());
+  ColorMapper::mapToRGBA(g_denoisedValues.data(), colors.size(), minValidValue, maxValidValue, MIN_VALID_VALUE, colors.data());
+  if (g_denoiseColorBuffer == 0) glGenBuffers(1, &g_denoiseColorBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, g_denoiseColorBuffer);
+  glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(PackedColor), colors.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  bindCurrentScanBuffers();
+}
+
+void showDenoiseWindow() {
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(1060, 730), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Denoise", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  bool changed = false;
+  int type = static_cast<int>(g_denoiseOptions.type);
+  const char* typeNames[] = { ScanFilters::getFilterName(ScanFilterType::Median),
+    ScanFilters::getFilterName(ScanFilterType::SavitzkyGolay), ScanFilters::getFilterName(ScanFilterType::Exponential) };
+  if (ImGui::Combo("Filter", &type, typeNames, IM_ARRAYSIZE(typeNames))) {
+    g_denoiseOptions.type = static_cast<ScanFilterType>(type);
+    changed = true;
+  }
+  if (g_denoiseOptions.type == ScanFilterType::Exponential) {
+    ImGui::SliderFloat("Alpha", &g_denoiseOptions.alpha, 0.01f, 1.0f, "%.2f");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    changed |= ImGui::Checkbox("Zero phase (forward + backward)", &g_denoiseOptions.zeroPhase);
+  }
+  else {
+    ImGui::SliderInt("Half window", &g_denoiseOptions.radius, 1, ScanFilters::MAX_RADIUS);
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    if (g_denoiseOptions.type == ScanFilterType::SavitzkyGolay) {
+      ImGui::SliderInt("Polynomial order", &g_denoiseOptions.polynomialOrder, 0, 2 * g_denoiseOptions.radius);
+      changed |= ImGui::IsItemDeactivatedAfterEdit();
+    }
+  }
+
+  if (ImGui::Checkbox("Show filtered values", &g_denoiseEnabled)) {
+    bool current = g_denoiseFile == VerticesLoader::getCurrentScanFile() && sameFilterOptions(g_denoiseApplied, g_denoiseOptions);
+    if (g_denoiseEnabled && !current) computeDenoisedChannel();
+    else bindCurrentScanBuffers();
+  }
+  else if (changed && g_denoiseEnabled) {
+    computeDenoisedChannel();
+  }
+  if (g_denoiseFile == VerticesLoader::getCurrentScanFile()) {
+    ImGui::TextDisabled("%zu values filtered in %.2f ms", g_denoisedValues.size(), g_denoiseMilliseconds);
+  }
+  ImGui::End();
+}
+
+// The surface takes the colours the points are drawn with (raw, filtered, compare or lobes)
+void bindSurfaceColors() {
+  if (g_surfaceVAO == 0) return;
+  GLint colorBuffer = 0;
+  glBindVertexArray(g_pointVAO);
+  glGetVertexAttribiv(1, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &colorBuffer);
+  glBindVertexArray(g_surfaceVAO);
+  glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(colorBuffer));
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Replace the height axis of the loaded positions by the value and upload them (the triangles stay)
+void liftSurface() {
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  float extent = 0.0f;
+  for (int axis : { g_surfaceMesh.axisU, g_surfaceMesh.axisV }) {
+    float low = std::numeric_limits<float>::max(), high = std::numeric_limits<float>::lowest();
+    for (size_t i = 0; i < values.size(); ++i) {
+      low = std::min(low, positions[i * 3 + axis]);
+      high = std::max(high, positions[i * 3 + axis]);
+    }
+    if (high > low) extent = std::max(extent, high - low);
+  }
+  float minValidValue, maxValidValue;
+  computeColorRange(values, minValidValue, maxValidValue);
+  std::vector<float> vertices;
+  ScanSurface::liftVertices(positions.data(), values.data(), values.size(), g_surfaceMesh,
+    minValidValue, maxValidValue, g_surfaceHeight * extent, vertices);
+  glBindBuffer(GL_ARRAY_BUFFER, g_surfaceVertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Triangulate the loaded scan's plane and upload the mesh as one indexed draw
+void buildSurface() {
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  ScanSurface::build(positions.data(), positions.size() / 3, g_surfaceOptions, g_surfaceMesh);
+  g_surfaceFile = VerticesLoader::getCurrentScanFile();
+
+  if (g_surfaceVAO == 0) {
+    glGenVertexArrays(1, &g_surfaceVAO);
+    glGenBuffers(1, &g_surfaceVertexBuffer);
+    glGenBuffers(1, &g_surfaceEBO);
+    glBindVertexArray(g_surfaceVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_surfaceVertexBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_surfaceEBO);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  liftSurface();
+  glBindVertexArray(g_surfaceVAO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, g_surfaceMesh.triangles.size() * sizeof(uint32_t),
+    g_surfaceMesh.triangles.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  bindSurfaceColors();
+}
+
+void showSurfaceWindow() {
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(1060, 850), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Surface", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  bool rebuild = false;
+  int plane = static_cast<int>(g_surfaceOptions.plane);
+  const char* planeNames[] = { "Auto", "XY", "XZ", "YZ" };
+  if (ImGui::Combo("Plane", &plane, planeNames, IM_ARRAYSIZE(planeNames))) {
+    g_surfaceOptions.plane = static_cast<SurfacePlane>(plane);
+    rebuild = true;
+  }
+  ImGui::SliderFloat("Max edge (x median)", &g_surfaceOptions.maxEdgeFactor, 0.0f, 20.0f,
+    g_surfaceOptions.maxEdgeFactor > 0.0f ? "%.1f" : "keep all");
+  rebuild |= ImGui::IsItemDeactivatedAfterEdit();
+  ImGui::SliderFloat("Height", &g_surfaceHeight, 0.0f, 1.0f, "%.2f");
+  bool relift = ImGui::IsItemDeactivatedAfterEdit();
+
+  bool current = g_surfaceFile == VerticesLoader::getCurrentScanFile();
+  if (ImGui::Checkbox("Show surface", &g_surfaceEnabled) && g_surfaceEnabled && !current) {
+    buildSurface();
+  }
+  else if (g_surfaceEnabled && rebuild) {
+    buildSurface();
+  }
+  else if (g_surfaceEnabled && relift && current) {
+    liftSurface();
+  }
+  ImGui::Checkbox("Surface only", &g_surfaceOnly);
+
+  if (g_surfaceFile == VerticesLoader::getCurrentScanFile()) {
+    const SurfaceMesh& mesh = g_surfaceMesh;
+    const char* axisNames = "XYZ";
+    ImGui::Text("%zu triangles over %c%c (%zu dropped as gaps)", mesh.triangles.size() / 3,
+      axisNames[mesh.axisU], axisNames[mesh.axisV], mesh.delaunayCount - mesh.triangles.size() / 3);
+    if (mesh.duplicateCount > 0) {
+      ImGui::Text("%zu points share a position with an earlier one", mesh.duplicateCount);
+    }
+    ImGui::TextDisabled("Hilbert sort %.1f ms, Delaunay %.1f ms, filter %.1f ms", mesh.sortMilliseconds,
+      mesh.triangulateMilliseconds, mesh.filterMilliseconds);
+  }
+  ImGui::End();
+}
+
+// Interpolate the loaded scan onto the grid as a job. A request while one runs cancels
+// it and is started once it has stopped, so only the latest scan and options are gridded.
+void startVolumeGrid() {
+  if (g_volumeJob) {
+    g_volumeQueued = true;
+    g_volumeCancel = true;
+    return;
+  }
+  g_volumeQueued = false;
+  g_volumeCancel = false;
+  std::string file = VerticesLoader::getCurrentScanFile();
+  // The current scan is resident, so this does not read the file inside the job
+  std::string error;
+  std::shared_ptr<const DecodedScan> scan = VerticesLoader::getResidency().acquire(file, SCAN_SCALE_FACTOR, &error);
+  if (!scan) {
+    std::cerr << "Cannot grid " << file << ": " << error << std::endl;
+    return;
+  }
+  VolumeGridOptions options = g_volumeOptions;
+  options.cancel = &g_volumeCancel;
+  g_volumeJob = JobSystem::submit([file, options, scan]() {
+    g_pendingVolumeGrid = VolumeGrid();
+    ScanVolume::grid(scan->positions.data(), scan->values.data(), scan->values.size(), options, g_pendingVolumeGrid);
+    if (!g_pendingVolumeGrid.cancelled) {
+      std::cout << "Volume grid " << g_pendingVolumeGrid.dims[0] << " x " << g_pendingVolumeGrid.dims[1] << " x "
+        << g_pendingVolumeGrid.dims[2] << " in " << g_pendingVolumeGrid.gridMilliseconds << " ms (KD-tree "
+        << g_pendingVolumeGrid.indexMilliseconds << " ms)" << std::endl;
+    }
+    g_pendingVolumeFile = file;
+    g_volumeReady = true;
+  });
+}
+
+// Stop a running grid job and wait for it
+void cancelVolumeGrid() {
+  g_volumeCancel = true;
+  JobSystem::wait(g_volumeJob);
+  g_volumeJob.reset();
+  g_volumeReady = false;
+  g_volumeQueued = false;
+}
+
+// Extract one level and upload it with colours shaded by the surface normal
+void extractIsoLevel(IsoLevel& level) {
+  ScanVolume::extractIsoSurface(g_volumeGrid, ScanVolume::levelFromDecibels(g_volumeGrid, level.decibels), level.mesh);
+  const IsoSurfaceMesh& mesh = level.mesh;
+
+  // Level colour on the scan's colour scale, lit from a fixed direction (both sides of the surface)
+  float minValidValue, maxValidValue;
+  computeColorRange(VerticesLoader::getValueData(), minValidValue, maxValidValue);
+  float range = maxValidValue - minValidValue;
+  float r, g, b;
+  ColorMapper::valueToColor(range > 0.0f ? std::max(0.0f, std::min(1.0f, (mesh.level - minValidValue) / range)) : 1.0f, r, g, b);
+  const float LIGHT[3] = { 0.36f, 0.48f, 0.8f };
+  std::vector<PackedColor> colors(mesh.vertices.size() / 3);
+  for (size_t i = 0; i < colors.size(); ++i) {
+    const float* n = &mesh.normals[i * 3];
+    float shade = 0.35f + 0.65f * std::fabs(n[0] * LIGHT[0] + n[1] * LIGHT[1] + n[2] * LIGHT[2]);
+    colors[i] = ColorMapper::packColor(r * shade, g * shade, b * shade);
+  }
+
+  if (level.vao == 0) {
+    glGenVertexArrays(1, &level.vao);
+    glGenBuffers(1, &level.vertexBuffer);
+    glGenBuffers(1, &level.colorBuffer);
+    glGenBuffers(1, &level.ebo);
+  }
+  glBindVertexArray(level.vao);
+  glBindBuffer(GL_ARRAY_BUFFER, level.vertexBuffer);
+  glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(float), mesh.vertices.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, level.colorBuffer);
+  glBufferData(GL_ARRAY_BUFFER, colors.size() * sizeof(PackedColor), colors.data(), GL_STATIC_DRAW);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedColor), (void*)0);
+  glEnableVertexAttribArray(1);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level.ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.triangles.size() * sizeof(uint32_t), mesh.triangles.data(), GL_STATIC_DRAW);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void showVolumeWindow() {
+  if (g_volumeReady) {
+    g_volumeJob.reset();
+    g_volumeReady = false;
+    if (!g_pendingVolumeGrid.cancelled) {
+      std::swap(g_volumeGrid, g_pendingVolumeGrid);
+      g_volumeFile = g_pendingVolumeFile;
+      for (IsoLevel& level : g_isoLevels) {
+        if (level.enabled) extractIsoLevel(level);
+      }
+      if (g_slicesEnabled) updateSlices();
+    }
+    if (g_volumeQueued) startVolumeGrid();
+  }
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(1060, 970), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Volume", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  bool regrid = false;
+  ImGui::SliderInt("Resolution", &g_volumeOptions.resolution, 8, 160);
+  regrid |= ImGui::IsItemDeactivatedAfterEdit();
+  int neighbours = static_cast<int>(g_volumeOptions.neighbours);
+  if (ImGui::SliderInt("Neighbours", &neighbours, 1, 32)) g_volumeOptions.neighbours = static_cast<size_t>(neighbours);
+  regrid |= ImGui::IsItemDeactivatedAfterEdit();
+  ImGui::SliderFloat("Distance power", &g_volumeOptions.power, 1.0f, 6.0f, "%.1f");
+  regrid |= ImGui::IsItemDeactivatedAfterEdit();
+  ImGui::SliderFloat("Max distance (x spacing)", &g_volumeOptions.maxDistanceFactor, 0.0f, 10.0f,
+    g_volumeOptions.maxDistanceFactor > 0.0f ? "%.1f" : "fill all");
+  regrid |= ImGui::IsItemDeactivatedAfterEdit();
+
+  bool current = g_volumeFile == VerticesLoader::getCurrentScanFile();
+  if ((ImGui::Checkbox("Show iso-surfaces", &g_volumeEnabled) && g_volumeEnabled && !current) || (g_volumeEnabled && regrid)) {
+    startVolumeGrid();
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox("Surfaces only", &g_volumeOnly);
+
+  for (int i = 0; i < IM_ARRAYSIZE(g_isoLevels); ++i) {
+    IsoLevel& level = g_isoLevels[i];
+    ImGui::PushID(i);
+    bool changed = ImGui::Checkbox("##enabled", &level.enabled);
+    ImGui::SameLine();
+    ImGui::SliderFloat("dB", &level.decibels, -30.0f, 0.0f, "%.1f dB");
+    changed |= ImGui::IsItemDeactivatedAfterEdit();
+    if (changed && level.enabled && current) extractIsoLevel(level);
+    if (level.enabled && current) {
+      ImGui::SameLine();
+      ImGui::TextDisabled("%zu triangles, %.1f ms", level.mesh.triangles.size() / 3, level.mesh.milliseconds);
+    }
+    ImGui::PopID();
+  }
+
+  if (g_volumeJob) {
+    ImGui::Text("Gridding...");
+  }
+  else if (current) {
+    const VolumeGrid& grid = g_volumeGrid;
+    if (!grid.isVolumetric()) {
+      ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.3f, 1.0f), "Scan is not volumetric (grid %d x %d x %d)", grid.dims[0], grid.dims[1], grid.dims[2]);
+    }
+    ImGui::TextDisabled("Grid %d x %d x %d, cell %.3g, %zu empty nodes", grid.dims[0], grid.dims[1], grid.dims[2],
+      grid.cellSize, grid.emptyCount);
+    ImGui::TextDisabled("KD-tree %.1f ms, interpolation %.1f ms", grid.indexMilliseconds, grid.gridMilliseconds);
+  }
+  ImGui::End();
+}
+
+// Cut the grid at the axis' slice position, trace the contour levels and upload the heatmap
+void updateSlice(int axis) {
+  auto start = std::chrono::steady_clock::now();
+  SliceImage& image = g_slices[axis];
+  ScanSlices::slice(g_volumeGrid, axis, g_slicePositions[axis], image);
+  g_sliceContours[axis].resize(g_sliceLevels.size());
+  for (size_t i = 0; i < g_sliceLevels.size(); ++i) {
+    ScanSlices::extractContours(image, ScanVolume::levelFromDecibels(g_volumeGrid, g_sliceLevels[i]), g_sliceContours[axis][i]);
+  }
+  g_sliceMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // Same colour range as the points; empty nodes are grey
+  float minValidValue, maxValidValue;
+  computeColorRange(VerticesLoader::getValueData(), minValidValue, maxValidValue);
+  std::vector<PackedColor> pixels(image.values.size());
+  ColorMapper::mapToRGBA(image.values.data(), pixels.size(), minValidValue, maxValidValue, MIN_VALID_VALUE, pixels.data());
+  if (g_sliceTextures[axis] == 0) glGenTextures(1, &g_sliceTextures[axis]);
+  glBindTexture(GL_TEXTURE_2D, g_sliceTextures[axis]);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // Rectangles of all three cuts across the grid, as line pairs
+  std::vector<float> outline;
+  const VolumeGrid& grid = g_volumeGrid;
+  for (int normal = 0; normal < 3; ++normal) {
+    int u = normal == 0 ? 1 : 0, v = normal == 2 ? 1 : 2;
+    float low[2] = { grid.origin[u], grid.origin[v] };
+    float high[2] = { grid.origin[u] + (grid.dims[u] - 1) * grid.cellSize, grid.origin[v] + (grid.dims[v] - 1) * grid.cellSize };
+    float corners[4][2] = { { low[0], low[1] }, { high[0], low[1] }, { high[0], high[1] }, { low[0], high[1] } };
+    for (int c = 0; c < 4; ++c) {
+      for (int end = 0; end < 2; ++end) {
+        float point[3];
+        point[normal] = g_slicePositions[normal];
+        point[u] = corners[(c + end) % 4][0];
+        point[v] = corners[(c + end) % 4][1];
+        outline.insert(outline.end(), point, point + 3);
+      }
+    }
+  }
+  if (g_sliceOutlineVAO == 0) {
+    glGenVertexArrays(1, &g_sliceOutlineVAO);
+    glGenBuffers(1, &g_sliceOutlineVBO);
+    glBindVertexArray(g_sliceOutlineVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_sliceOutlineVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, g_sliceOutlineVBO);
+  glBufferData(GL_ARRAY_BUFFER, outline.size() * sizeof(float), outline.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// New grid or new levels: optionally recentre on the peak, then redo every slice
+void updateSlices() {
+  if (g_volumeFile != VerticesLoader::getCurrentScanFile() || g_volumeGrid.values.empty()) return;
+  float peak[3];
+  if (g_slicesFollowPeak && ScanSlices::findPeak(g_volumeGrid, peak)) {
+    std::copy(peak, peak + 3, g_slicePositions);
+  }
+  for (int axis = 0; axis < 3; ++axis) updateSlice(axis);
+}
+
+void renderSliceOutlines(GLint colorLocation) {
+  if (!g_slicesEnabled || g_sliceOutlineVAO == 0 || g_volumeFile != VerticesLoader::getCurrentScanFile()) return;
+  glUniform3f(colorLocation, 1.0f, 0.85f, 0.2f);
+  glBindVertexArray(g_sliceOutlineVAO);
+  glDrawArrays(GL_LINES, 0, 24);
+}
+
+void showSlicesWindow() {
+  if (VerticesLoader::getValueData().empty() || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(10, 730), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Slices", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  bool current = g_volumeFile == VerticesLoader::getCurrentScanFile() && !g_volumeGrid.values.empty();
+  if (ImGui::Checkbox("Show slices", &g_slicesEnabled) && g_slicesEnabled) {
+    if (current) updateSlices();
+    else startVolumeGrid();
+  }
+  ImGui::SameLine();
+  if (ImGui::Checkbox("Follow peak", &g_slicesFollowPeak) && g_slicesFollowPeak && g_slicesEnabled && current) {
+    updateSlices();
+  }
+  ImGui::SliderInt("Grid resolution", &g_volumeOptions.resolution, 8, 160);
+  if (ImGui::IsItemDeactivatedAfterEdit() && g_slicesEnabled) startVolumeGrid();
+  if (ImGui::InputText("Contour levels (dB)", g_sliceLevelText, sizeof(g_sliceLevelText), ImGuiInputTextFlags_EnterReturnsTrue) ||
+    ImGui::IsItemDeactivatedAfterEdit() || (g_sliceLevels.empty() && g_sliceLevelText[0] != '\0')) {
+    g_sliceLevels.clear();
+    std::istringstream levels(g_sliceLevelText);
+    float decibels;
+    while (levels >> decibels) g_sliceLevels.push_back(decibels);
+    if (g_slicesEnabled && current) {
+      for (int axis = 0; axis < 3; ++axis) updateSlice(axis);
+    }
+  }
+
+  if (!g_slicesEnabled || !current) {
+    if (g_slicesEnabled) ImGui::Text(g_volumeJob ? "Gridding..." : "No grid for this scan");
+    ImGui::End();
+    return;
+  }
+
+  const char* axisNames = "XYZ";
+  const float IMAGE_SIZE = 240.0f;
+  const VolumeGrid& grid = g_volumeGrid;
+  for (int axis = 2; axis >= 0; --axis) {
+    const SliceImage& image = g_slices[axis];
+    ImGui::PushID(axis);
+    ImGui::BeginGroup();
+    ImGui::Text("%c%c at %c", axisNames[image.axisU], axisNames[image.axisV], axisNames[axis]);
+    float low = grid.origin[axis], high = grid.origin[axis] + (grid.dims[axis] - 1) * grid.cellSize;
+    ImGui::SetNextItemWidth(IMAGE_SIZE);
+    if (ImGui::SliderFloat("##position", &g_slicePositions[axis], low, high, "%.3f")) {
+      g_slicesFollowPeak = false;
+      updateSlice(axis);
+    }
+
+    // Node (0, 0) at the bottom left; pixel centres are the grid nodes
+    float scale = IMAGE_SIZE / std::max(1, std::max(image.width, image.height));
+    ImVec2 size(image.width * scale, image.height * scale);
+    ImGui::Image((ImTextureID)(intptr_t)g_sliceTextures[axis], size, ImVec2(0, 1), ImVec2(1, 0));
+    ImVec2 corner = ImGui::GetItemRectMin();
+    auto toScreen = [&](float u, float v) {
+      return ImVec2(corner.x + ((u - image.origin[0]) / image.cellSize + 0.5f) * scale,
+        corner.y + size.y - ((v - image.origin[1]) / image.cellSize + 0.5f) * scale);
+    };
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    drawList->PushClipRect(corner, ImVec2(corner.x + size.x, corner.y + size.y), true);
+    for (const std::vector<float>& segments : g_sliceContours[axis]) {
+      for (size_t i = 0; i + 3 < segments.size(); i += 4) {
+        drawList->AddLine(toScreen(segments[i], segments[i + 1]), toScreen(segments[i + 2], segments[i + 3]), IM_COL32(255, 255, 255, 220), 1.5f);
+      }
+    }
+    drawList->PopClipRect();
+    if (ImGui::IsItemHovered() && image.width > 0 && image.height > 0) {
+      ImVec2 mouse = ImGui::GetIO().MousePos;
+      int u = std::max(0, std::min(image.width - 1, static_cast<int>((mouse.x - corner.x) / scale)));
+      int v = std::max(0, std::min(image.height - 1, static_cast<int>((corner.y + size.y - mouse.y) / scale)));
+      float value = image.values[static_cast<size_t>(v) * image.width + u];
+      ImGui::BeginTooltip();
+      ImGui::Text("%c %.3f  %c %.3f", axisNames[image.axisU], image.origin[0] + u * image.cellSize,
+        axisNames[image.axisV], image.origin[1] + v * image.cellSize);
+      if (std::isnan(value)) ImGui::Text("No measurement nearby");
+      else ImGui::Text("%.6g (%.1f dB)", value, grid.peakValue > 0.0f && value > 0.0f ? 10.0f * std::log10(value / grid.peakValue) : 0.0f);
+      ImGui::EndTooltip();
+    }
+    ImGui::EndGroup();
+    ImGui::PopID();
+    if (axis > 0) ImGui::SameLine();
+  }
+  ImGui::TextDisabled("Grid %d x %d x %d, slice + contours %.2f ms", grid.dims[0], grid.dims[1], grid.dims[2], g_sliceMilliseconds);
+  ImGui::End();
+}
+
+// Contour the loaded scan and upload the closed contours as 3D line loops
+void analyzeBeamWidths() {
+  const std::vector<float>& positions = VerticesLoader::getPositionData();
+  const std::vector<float>& values = VerticesLoader::getValueData();
+  g_beamResult = BeamWidthResult();
+  ScanBeamWidth::analyze(positions.data(), values.data(), values.size(), g_beamOptions, g_beamResult);
+  g_beamResult.filePath = VerticesLoader::getCurrentScanFile();
+
+  std::vector<float> loops;
+  for (const BeamContour& contour : g_beamResult.contours) {
+    for (size_t i = 0; i + 1 < contour.polygon.size(); i += 2) {
+      float point[3];
+      point[g_beamResult.normalAxis] = g_beamResult.peakPosition[g_beamResult.normalAxis];
+      point[g_beamResult.axisU] = contour.polygon[i];
+      point[g_beamResult.axisV] = contour.polygon[i + 1];
+      loops.insert(loops.end(), point, point + 3);
+    }
+  }
+  if (g_beamVAO == 0) {
+    glGenVertexArrays(1, &g_beamVAO);
+    glGenBuffers(1, &g_beamVBO);
+    glBindVertexArray(g_beamVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, g_beamVBO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, g_beamVBO);
+  glBufferData(GL_ARRAY_BUFFER, loops.size() * sizeof(float), loops.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// -3 dB in white, 1/e^2 in orange, on top of the points
+void renderBeamContours(GLint colorLocation) {
+  if (!g_beamShowContours || g_beamVAO == 0 || g_beamResult.filePath != VerticesLoader::getCurrentScanFile()) return;
+  const float colors[2][3] = { { 1.0f, 1.0f, 1.0f }, { 1.0f, 0.55f, 0.1f } };
+  glDisable(GL_DEPTH_TEST);
+  glBindVertexArray(g_beamVAO);
+  GLint first = 0;
+  for (int c = 0; c < 2; ++c) {
+    GLsizei count = static_cast<GLsizei>(g_beamResult.contours[c].polygon.size() / 2);
+    if (count == 0) continue;
+    glUniform3f(colorLocation, colors[c][0], colors[c][1], colors[c][2]);
+    glDrawArrays(GL_LINE_LOOP, first, count);
+    first += count;
+  }
+  glEnable(GL_DEPTH_TEST);
+}
+
+void showBeamWidthWindow() {
+  if (VerticesLoader::getCurrentScanFile().empty() || g_playback.isActive()) return;
+  if (g_beamResult.filePath != VerticesLoader::getCurrentScanFile()) analyzeBeamWidths();
+
+  ImGui::SetNextWindowPos(ImVec2(420, 610), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Beam widths", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::SliderInt("Grid resolution", &g_beamOptions.grid.resolution, 16, 256);
+  if (ImGui::IsItemDeactivatedAfterEdit()) analyzeBeamWidths();
+  ImGui::Checkbox("Show contours", &g_beamShowContours);
+
+  const BeamWidthResult& r = g_beamResult;
+  if (!r.ok) {
+    ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", r.error.c_str());
+    ImGui::End();
+    return;
+  }
+  const char* axisNames = "XYZ";
+  ImGui::Text("Peak %.6g at (%.3f, %.3f, %.3f), contours in the %c%c plane", r.peakValue,
+    r.peakPosition[0], r.peakPosition[1], r.peakPosition[2], axisNames[r.axisU], axisNames[r.axisV]);
+  if (ImGui::BeginTable("beam", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("");
+    ImGui::TableSetupColumn("-3 dB");
+    ImGui::TableSetupColumn("1/e^2");
+    ImGui::TableHeadersRow();
+    auto row = [&](const char* label, auto&& cell) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(label);
+      for (const BeamContour& contour : r.contours) {
+        ImGui::TableNextColumn();
+        cell(contour);
+      }
+    };
+    const char* widthLabels[3] = { "Width X", "Width Y", "Width Z" };
+    for (int a = 0; a < 3; ++a) {
+      row(widthLabels[a], [&](const BeamContour& contour) {
+        if (contour.axisWidths[a] > 0.0f) ImGui::Text("%.4f", contour.axisWidths[a]);
+        else ImGui::TextDisabled("-");
+      });
+    }
+    row("Major / minor", [](const BeamContour& contour) {
+      if (contour.closed) ImGui::Text("%.4f / %.4f", contour.majorWidth, contour.minorWidth);
+      else ImGui::TextDisabled("not closed");
+    });
+    row("Ellipticity", [](const BeamContour& contour) {
+      if (contour.closed) ImGui::Text("%.3f at %.1f deg", contour.ellipticity, contour.angleDegrees);
+      else ImGui::TextDisabled("-");
+    });
+    row("Area", [](const BeamContour& contour) {
+      if (contour.closed) ImGui::Text("%.4f", contour.area);
+      else ImGui::TextDisabled("-");
+    });
+    ImGui::EndTable();
+  }
+  ImGui::TextDisabled("Grid %d x %d x %d, %.1f ms", r.gridDims[0], r.gridDims[1], r.gridDims[2], r.milliseconds);
+  ImGui::End();
+}
+
+// Preload the chosen range, oldest scan first
+void startPlayback() {
+  const std::vector<std::string>& files = VerticesLoader::getAvailableFiles();
+  if (files.empty()) return;
+  int last = static_cast<int>(files.size()) - 1;
+  int from = std::max(0, std::min(g_playbackFrom, g_playbackTo));
+  int to = std::min(last, std::max(g_playbackFrom, g_playbackTo));
+
+  // The file list is newest first
+  std::vector<std::string> frames;
+  for (int position = from; position <= to; ++position) {
+    frames.push_back(files[last - position]);
+  }
+  std::cout << "Preloading " << frames.size() << " scans for playback..." << std::endl;
+  g_playback.load(frames, SCAN_SCALE_FACTOR);
+}
+
+// Leave playback and show the loaded scan again
+void stopPlayback() {
+  g_playback.stop();
+  bindCurrentScanBuffers();
+}
+
+void showPlaybackWindow() {
+  const std::vector<std::string>& files = VerticesLoader::getAvailableFiles();
+  if (files.size() < 2) return;
+  int last = static_cast<int>(files.size()) - 1;
+
+  ImGui::SetNextWindowPos(ImVec2(10, 560), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Playback", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+  if (!g_playback.isActive()) {
+    if (g_playbackFrom == 0 && g_playbackTo == 0) g_playbackTo = last;
+    ImGui::SliderInt("From", &g_playbackFrom, 0, last);
+    ImGui::SliderInt("To", &g_playbackTo, 0, last);
+    g_playbackFrom = std::max(0, std::min(g_playbackFrom, last));
+    g_playbackTo = std::max(0, std::min(g_playbackTo, last));
+    ImGui::TextDisabled("%s", std::filesystem::path(files[last - g_playbackFrom]).filename().string().c_str());
+    ImGui::TextDisabled("%s", std::filesystem::path(files[last - g_playbackTo]).filename().string().c_str());
+    if (ImGui::Button("Preload")) {
+      startPlayback();
+    }
+    ImGui::End();
+    return;
+  }
+
+  size_t frameCount = g_playback.getFrameCount();
+  if (!g_playback.isReady()) {
+    ImGui::Text("Preloading: %zu decoded, %zu uploaded of %zu", g_playback.getDecodedCount(),
+      g_playback.getUploadedCount(), frameCount);
+    ImGui::ProgressBar(frameCount > 0 ? static_cast<float>(g_playback.getUploadedCount()) / frameCount : 0.0f);
+  }
+  else {
+    if (ImGui::Button(g_playback.isPlaying() ? "Pause" : "Play")) {
+      g_playback.setPlaying(!g_playback.isPlaying());
+    }
+    ImGui::SameLine();
+    bool looping = g_playback.isLooping();
+    if (ImGui::Checkbox("Loop", &looping)) {
+      g_playback.setLooping(looping);
+    }
+
+    float fps = g_playback.getFramesPerSecond();
+    if (ImGui::SliderFloat("Scans/s", &fps, 0.0f, 120.0f, fps > 0.0f ? "%.1f" : "unlimited")) {
+      g_playback.setFramesPerSecond(fps);
+    }
+    int frame = static_cast<int>(g_playback.getFrameIndex());
+    if (ImGui::SliderInt("Scan", &frame, 0, static_cast<int>(frameCount) - 1)) {
+      g_playback.seek(static_cast<size_t>(frame));
+    }
+    ImGui::Text("%s", std::filesystem::path(g_playback.getFramePath(g_playback.getFrameIndex())).filename().string().c_str());
+    ImGui::TextDisabled("%zu scans, %.1f MB on the GPU, showing %.1f scans/s", frameCount,
+      g_playback.getUploadedBytes() / (1024.0 * 1024.0), g_playback.getMeasuredRate());
+    if (g_playback.wasTrimmed()) {
+      ImGui::TextColored(ImVec4(1.0f, 0.7f, 0.3f, 1.0f), "%zu scans left out by the VRAM budget", g_playback.getTrimmedCount());
+    }
+    ImGui::TextDisabled("Filters and selection apply to the loaded scan only");
+  }
+  if (ImGui::Button("Stop")) {
+    stopPlayback();
+  }
+  ImGui::End();
+}
+
+void showMemoryWindow() {
+  ScanResidency& residency = VerticesLoader::getResidency();
+  ResidencyStats stats = residency.getStats();
+  const double MB = 1024.0 * 1024.0;
+
+  ImGui::SetNextWindowPos(ImVec2(10, 420), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Memory", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  ImGui::Text("RAM:  %.1f / %.0f MB, %zu scans", stats.ramBytes / MB, stats.ramBudget / MB, stats.residentScans);
+  ImGui::Text("VRAM: %.1f / %.0f MB, %zu scans", stats.vramBytes / MB, stats.vramBudget / MB, stats.gpuResidentScans);
+  ImGui::Text("Hit rate: RAM %.0f%% (%llu/%llu), GPU %.0f%% (%llu/%llu)",
+    stats.hitRate() * 100.0, (unsigned long long)stats.hits, (unsigned long long)(stats.hits + stats.misses),
+    stats.gpuHitRate() * 100.0, (unsigned long long)stats.gpuHits, (unsigned long long)(stats.gpuHits + stats.gpuMisses));
+  ImGui::Text("Evictions: RAM %llu, GPU %llu", (unsigned long long)stats.evictions, (unsigned long long)stats.gpuEvictions);
+
+  int ramBudgetMB = static_cast<int>(stats.ramBudget / (1024 * 1024));
+  int vramBudgetMB = static_cast<int>(stats.vramBudget / (1024 * 1024));
+  bool changed = ImGui::SliderInt("RAM budget (MB)", &ramBudgetMB, 64, 16384);
+  changed |= ImGui::SliderInt("VRAM budget (MB)", &vramBudgetMB, 32, 8192);
+  if (changed) {
+    residency.setBudgets(static_cast<size_t>(ramBudgetMB) << 20, static_cast<size_t>(vramBudgetMB) << 20);
+  }
+  if (ImGui::Button("Reset counters")) {
+    residency.resetCounters();
+  }
+  ImGui::End();
+}
+
+// Show the whole scan again, with the replay clock at the end of the acquisition
+void resetReplay() {
+  const std::vector<float>& times = VerticesLoader::getTimeData();
+  g_replayTimes.resize(times.size());
+  float latest = 0.0f;
+  for (size_t i = 0; i < times.size(); ++i) {
+    latest = std::max(latest, times[i]);
+    g_replayTimes[i] = latest;
+  }
+  g_replayEnd = VerticesLoader::getValueData().size();
+  g_replayClock = g_replayTimes.empty() ? 0.0 : g_replayTimes.back();
+  g_replayPointCarry = 0.0;
+  g_replayPlaying = false;
+}
+
+void advanceReplay(double elapsedSeconds) {
+  size_t pointCount = VerticesLoader::getValueData().size();
+  if (!g_replayEnabled || !g_replayPlaying || pointCount == 0) return;
+
+  if (g_replayRealTime && VerticesLoader::hasTimestamps()) {
+    g_replayClock += elapsedSeconds * g_replaySpeed;
+    g_replayEnd = std::upper_bound(g_replayTimes.begin(), g_replayTimes.end(), static_cast<float>(g_replayClock)) - g_replayTimes.begin();
+  }
+  else {
+    g_replayPointCarry += elapsedSeconds * g_replayPointsPerSecond;
+    size_t step = static_cast<size_t>(g_replayPointCarry);
+    g_replayPointCarry -= static_cast<double>(step);
+    g_replayEnd = std::min(pointCount, g_replayEnd + step);
+  }
+  if (g_replayEnd >= pointCount) {
+    g_replayEnd = pointCount;
+    g_replayPlaying = false;
+  }
+}
+
+// Number of entries among indices[0], indices[stride], ... (ascending) that are below limit
+static size_t countIndicesBelow(const std::vector<unsigned int>& indices, size_t stride, size_t offset, size_t limit) {
+  size_t low = 0, high = indices.size() / stride;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (indices[middle * stride + offset] < limit) low = middle + 1;
+    else high = middle;
+  }
+  return low;
+}
+
+void showReplayWindow() {
+  size_t pointCount = VerticesLoader::getValueData().size();
+  if (pointCount == 0 || g_playback.isActive()) return;
+
+  ImGui::SetNextWindowPos(ImVec2(10, 700), ImGuiCond_FirstUseEver);
+  ImGui::Begin("Replay", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+  if (ImGui::Checkbox("Replay in acquisition order", &g_replayEnabled) && g_replayEnabled && g_replayEnd >= pointCount) {
+    g_replayEnd = 0;
+    g_replayClock = 0.0;
+  }
+  if (g_replayEnabled) {
+    bool timed = VerticesLoader::hasTimestamps();
+    int end = static_cast<int>(g_replayEnd);
+    if (ImGui::SliderInt("Points", &end, 0, static_cast<int>(pointCount))) {
+      g_replayEnd = static_cast<size_t>(end);
+      g_replayClock = g_replayEnd > 0 && timed ? g_replayTimes[g_replayEnd - 1] : 0.0;
+      g_replayPointCarry = 0.0;
+    }
+    ImGui::SliderInt("Trail", &g_replayTrail, 0, static_cast<int>(pointCount));
+    if (ImGui::Button(g_replayPlaying ? "Pause" : "Play")) {
+      if (!g_replayPlaying && g_replayEnd >= pointCount) {
+        g_replayEnd = 0;
+        g_replayClock = 0.0;
+      }
+      g_replayPlaying = !g_replayPlaying;
+    }
+    if (timed) {
+      ImGui::SameLine();
+      ImGui::Checkbox("Real time", &g_replayRealTime);
+    }
+    if (timed && g_replayRealTime) {
+      ImGui::SliderFloat("Speed", &g_replaySpeed, 0.1f, 100.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+      ImGui::Text("t = %.3f / %.3f s", g_replayEnd > 0 ? g_replayTimes[g_replayEnd - 1] : 0.0f, g_replayTimes.back());
+    }
+    else {
+      ImGui::SliderFloat("Points/s", &g_replayPointsPerSecond, 1.0f, 100000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+      if (!timed) ImGui::TextDisabled("No measurement timestamps in this scan");
+    }
+  }
+  ImGui::End();
+}
+
 // Function to update GPU buffers with new scan data
 void updateScanBuffers() {
-  // Generate new scan data
-  std::vector<float> scanVertices = VerticesLoader::generateScanVertices();
-  std::vector<unsigned int> lineIndices = VerticesLoader::generateScanLineIndices();
-  std::vector<unsigned int> pointIndices = VerticesLoader::generateScanPointIndices();
+  // A selection refers to the points of the previous scan
+  clearRegionSelection();
+
+  // Refresh cached indices/values once and upload straight from them
+  updateCachedData();
+  resetReplay();
+
+  const std::vector<float>& scanVertices = VerticesLoader::getPositionData();
+  const std::vector<unsigned int>& lineIndices = g_cachedLineIndices;
+  const std::vector<unsigned int>& pointIndices = g_cachedPointIndices;
 
   if (scanVertices.empty()) {
     std::cerr << "Warning: No vertices to update!" << std::endl;
@@ -344,9 +2272,25 @@ void updateScanBuffers() {
 
   std::cout << "Updating buffers - Vertices: " << scanVertices.size() / 3 << ", Lines: " << lineIndices.size() / 2 << ", Points: " << pointIndices.size() << std::endl;
 
-  // Update vertex buffer
-  glBindBuffer(GL_ARRAY_BUFFER, g_VBO);
-  glBufferData(GL_ARRAY_BUFFER, scanVertices.size() * sizeof(float), scanVertices.data(), GL_STATIC_DRAW);
+  // Vertex and colour buffers come from the residency cache (uploaded only on a miss)
+  if (!bindCurrentScanBuffers()) {
+    return;
+  }
+  if (g_diffEnabled) {
+    computeScanDiff();
+  }
+  if (g_peakHighlight) {
+    detectPeaks();
+  }
+  if (g_denoiseEnabled) {
+    computeDenoisedChannel();
+  }
+  if (g_surfaceEnabled) {
+    buildSurface();
+  }
+  if (g_volumeEnabled || g_slicesEnabled) {
+    startVolumeGrid();
+  }
 
   // Update line indices buffer
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_lineEBO);
@@ -360,17 +2304,14 @@ void updateScanBuffers() {
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-  // Update cached data
-  updateCachedData();
-
-  // Recalculate and update bounding box
+  // Update bounding box from the loader's incremental bounds
   calculateBoundingBox();
   setupBoundingBoxBuffers();
 
   std::cout << "Buffer update complete!" << std::endl;
 }
 
-int main(void)
+int main(int argc, char** argv)
 {
   if (!glfwInit())
     return -1;
@@ -406,6 +2347,14 @@ int main(void)
   glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 #pragma endregion
 
+  // ImGui (installs its callbacks on top of ours and chains to them)
+  IMGUI_CHECKVERSION();
+  ImGui::CreateContext();
+  ImGui::GetIO().IniFilename = nullptr;
+  ImGui::StyleColorsDark();
+  ImGui_ImplGlfw_InitForOpenGL(window, true);
+  ImGui_ImplOpenGL3_Init("#version 330");
+
   // Enable depth testing
   glEnable(GL_DEPTH_TEST);
 
@@ -419,7 +2368,10 @@ int main(void)
 
   // Load scan data from JSON file
   std::cout << "Initializing scan file system..." << std::endl;
-  if (!VerticesLoader::initializeScanFiles("logs/scanning", 1000.0f)) {
+  // Scan roots from the command line (searched recursively), logs/scanning by default
+  g_scanRoots.assign(argv + 1, argv + argc);
+  if (g_scanRoots.empty()) g_scanRoots.push_back("logs/scanning");
+  if (!VerticesLoader::initializeScanFiles(g_scanRoots, SCAN_SCALE_FACTOR)) {
     std::cout << "Failed to initialize scan files. Exiting." << std::endl;
     glfwTerminate();
     return -1;
@@ -427,16 +2379,17 @@ int main(void)
 
   // Initialize cached data for first file
   updateCachedData();
+  resetReplay();
 
   // Display scan information
   std::cout << "=== Scan Data Information ===" << std::endl;
   std::cout << VerticesLoader::getScanInfo() << std::endl;
   std::cout << "=============================" << std::endl;
 
-  // Generate scan data
-  std::vector<float> scanVertices = VerticesLoader::generateScanVertices();
-  std::vector<unsigned int> lineIndices = VerticesLoader::generateScanLineIndices();
-  std::vector<unsigned int> pointIndices = VerticesLoader::generateScanPointIndices();
+  // Scan data (positions live in the loader, indices in the cache)
+  const std::vector<float>& scanVertices = VerticesLoader::getPositionData();
+  const std::vector<unsigned int>& lineIndices = g_cachedLineIndices;
+  const std::vector<unsigned int>& pointIndices = g_cachedPointIndices;
 
   if (scanVertices.empty()) {
     std::cout << "No vertices generated. Exiting." << std::endl;
@@ -458,35 +2411,33 @@ int main(void)
   // Calculate bounding box
   calculateBoundingBox();
 
-  // Create VAO, VBO, and EBOs for the scan data
+  // Create VAOs and EBOs for the scan data; vertex and colour buffers are per scan
+  // and owned by the residency cache, which calls back here to upload and release them
+  VerticesLoader::getResidency().setGpuCallbacks(uploadScanBuffers, releaseScanBuffers);
+
   // Line rendering setup
   glGenVertexArrays(1, &g_lineVAO);
-  glGenBuffers(1, &g_VBO);
   glGenBuffers(1, &g_lineEBO);
 
   glBindVertexArray(g_lineVAO);
-  glBindBuffer(GL_ARRAY_BUFFER, g_VBO);
-  glBufferData(GL_ARRAY_BUFFER, scanVertices.size() * sizeof(float), scanVertices.data(), GL_STATIC_DRAW);
-
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_lineEBO);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, lineIndices.size() * sizeof(unsigned int), lineIndices.data(), GL_STATIC_DRAW);
 
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
   // Point rendering setup
   glGenVertexArrays(1, &g_pointVAO);
   glGenBuffers(1, &g_pointEBO);
 
   glBindVertexArray(g_pointVAO);
-  glBindBuffer(GL_ARRAY_BUFFER, g_VBO); // Reuse same VBO
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
-
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_pointEBO);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, pointIndices.size() * sizeof(unsigned int), pointIndices.data(), GL_STATIC_DRAW);
 
   glBindVertexArray(0); // Unbind
+  bindCurrentScanBuffers();
+
+  glBindVertexArray(0); // Unbind
+
+  // Selected point indices, drawn over the point VAO
+  glGenBuffers(1, &g_selectionEBO);
 
   // Setup bounding box buffers
   setupBoundingBoxBuffers();
@@ -494,6 +2445,7 @@ int main(void)
   // Get uniform locations
   shader.bind();
   GLint colorLocation = shader.getUniform("color");
+  GLint useVertexColorLocation = shader.getUniform("useVertexColor");
   GLint modelLocation = shader.getUniform("model");
   GLint viewLocation = shader.getUniform("view");
   GLint projectionLocation = shader.getUniform("projection");
@@ -506,8 +2458,35 @@ int main(void)
   // Print control instructions
   InputHandler::printControlInstructions();
 
+  // Index the scan roots while the first scan is already on screen
+  startCatalogIndexing();
+
+  double lastFrameTime = glfwGetTime();
   while (!glfwWindowShouldClose(window))
   {
+    double frameTime = glfwGetTime();
+    double elapsedSeconds = frameTime - lastFrameTime;
+    lastFrameTime = frameTime;
+    advanceReplay(elapsedSeconds);
+
+    // Playback: upload pending scans in a time slice, then step by re-pointing the VAOs
+    const GpuScanBuffers* playbackBuffers = nullptr;
+    if (g_playback.isActive()) {
+      if (g_playback.preload(PLAYBACK_PRELOAD_MILLISECONDS)) {
+        g_playback.advance(elapsedSeconds);
+        playbackBuffers = g_playback.getFrameBuffers();
+        if (playbackBuffers != nullptr && playbackBuffers->vertexBuffer != g_boundVertexBuffer) {
+          bindScanBuffers(*playbackBuffers);
+        }
+      }
+    }
+    // Unlimited playback rate also lifts vsync
+    int swapInterval = g_playback.isPlaying() && g_playback.getFramesPerSecond() <= 0.0f ? 0 : 1;
+    if (swapInterval != g_swapInterval) {
+      glfwSwapInterval(swapInterval);
+      g_swapInterval = swapInterval;
+    }
+
     int width = 0, height = 0;
     glfwGetFramebufferSize(window, &width, &height);
     glViewport(0, 0, width, height);
@@ -515,6 +2494,10 @@ int main(void)
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // Dark gray background
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
     shader.bind();
 
     // Create orthographic projection and view matrices with proper camera panning
@@ -527,14 +2510,66 @@ int main(void)
     glUniformMatrix4fv(viewLocation, 1, GL_FALSE, view.data());
     glUniformMatrix4fv(modelLocation, 1, GL_FALSE, model.data());
 
+    // Pick and select with the same matrices the scene is drawn with
+    g_renderView = view;
+    g_renderProjection = projection;
+    if (playbackBuffers == nullptr) {
+      updateHoverPick(window, view, projection);
+    }
+
     // Render bounding box first (so it appears behind other elements)
     renderBoundingBox(colorLocation);
+    renderSliceOutlines(colorLocation);
+
+    size_t replayFirstPoint = 0, replayPointCount = g_cachedPointIndices.size();
+
+    // Value surface under the path (not while playback or replay draw partial scans)
+    bool surfaceDrawn = g_surfaceEnabled && playbackBuffers == nullptr && !g_replayEnabled &&
+      g_surfaceFile == VerticesLoader::getCurrentScanFile() && !g_surfaceMesh.triangles.empty();
+    if (surfaceDrawn) {
+      glUniform1i(useVertexColorLocation, 1);
+      glBindVertexArray(g_surfaceVAO);
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(g_surfaceMesh.triangles.size()), GL_UNSIGNED_INT, 0);
+      glUniform1i(useVertexColorLocation, 0);
+    }
+
+    // Iso-surfaces of the volume grid
+    bool volumeDrawn = g_volumeEnabled && playbackBuffers == nullptr && !g_replayEnabled &&
+      g_volumeFile == VerticesLoader::getCurrentScanFile();
+    if (volumeDrawn) {
+      glUniform1i(useVertexColorLocation, 1);
+      for (const IsoLevel& level : g_isoLevels) {
+        if (!level.enabled || level.mesh.triangles.empty()) continue;
+        glBindVertexArray(level.vao);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.mesh.triangles.size()), GL_UNSIGNED_INT, 0);
+      }
+      glUniform1i(useVertexColorLocation, 0);
+    }
+    bool drawCloud = !(surfaceDrawn && g_surfaceOnly) && !(volumeDrawn && g_volumeOnly);
 
     // Render lines in green
     glUniform3f(colorLocation, 0.0f, 1.0f, 0.0f);
     glBindVertexArray(g_lineVAO);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_lineEBO);
-    if (!g_cachedLineIndices.empty()) {
+    if (playbackBuffers != nullptr) {
+      // Playback frames draw every point in sequence, without the loaded scan's index lists
+      glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(playbackBuffers->pointCount));
+    }
+    else if (g_replayEnabled) {
+      // Replay draws a sub-range of the uploaded index lists (both ascending): segments whose
+      // two ends fall in [begin, end) and the points in it, without touching any buffer
+      size_t end = std::min(g_replayEnd, g_cachedMeasurementValues.size());
+      size_t begin = g_replayTrail > 0 && end > static_cast<size_t>(g_replayTrail) ? end - g_replayTrail : 0;
+      size_t firstSegment = countIndicesBelow(g_cachedLineIndices, 2, 0, begin);
+      size_t lastSegment = countIndicesBelow(g_cachedLineIndices, 2, 1, end);
+      if (lastSegment > firstSegment) {
+        glDrawElements(GL_LINES, static_cast<GLsizei>((lastSegment - firstSegment) * 2), GL_UNSIGNED_INT,
+          (void*)(firstSegment * 2 * sizeof(unsigned int)));
+      }
+      replayFirstPoint = countIndicesBelow(g_cachedPointIndices, 1, 0, begin);
+      replayPointCount = countIndicesBelow(g_cachedPointIndices, 1, 0, end) - replayFirstPoint;
+    }
+    else if (!g_cachedLineIndices.empty() && drawCloud) {
       glDrawElements(GL_LINES, g_cachedLineIndices.size(), GL_UNSIGNED_INT, 0);
     }
 
@@ -549,100 +2584,114 @@ int main(void)
     // Note: Point size needs to be set in vertex shader or use GL_PROGRAM_POINT_SIZE
     glEnable(GL_PROGRAM_POINT_SIZE);
 
+    if (playbackBuffers != nullptr) {
+      glUniform1i(useVertexColorLocation, 1);
+      glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(playbackBuffers->pointCount));
+      glUniform1i(useVertexColorLocation, 0);
+    }
     // Safety check - ensure we have data to render
-    if (!g_cachedPointIndices.empty() && !g_cachedMeasurementValues.empty()) {
-      // Calculate colors for points
-      static std::vector<float> pointColors;
-      static bool colorsCalculated = false;
-
-      if (g_needsColorUpdate || !colorsCalculated) {
-        std::cout << "Calculating individual point colors..." << std::endl;
-
-        // Define value ranges
-        const float MIN_VALID_VALUE = 0.000005f; // 5 micro threshold
-
-        // Filter values to get valid range
-        std::vector<float> validValues;
-        for (float val : g_cachedMeasurementValues) {
-          if (val >= MIN_VALID_VALUE) {
-            validValues.push_back(val);
-          }
-        }
-
-        float minValidValue, maxValidValue;
-        if (validValues.empty()) {
-          std::cout << "No valid values for individual coloring - using gray" << std::endl;
-          minValidValue = maxValidValue = 0.0f;
-        }
-        else {
-          minValidValue = *std::min_element(validValues.begin(), validValues.end());
-          maxValidValue = *std::max_element(validValues.begin(), validValues.end());
-          std::cout << "Individual color range: " << minValidValue << " to " << maxValidValue << std::endl;
-        }
-
-        // Calculate color for each point
-        pointColors.clear();
-        pointColors.reserve(g_cachedMeasurementValues.size() * 3);
-
-        for (size_t i = 0; i < g_cachedMeasurementValues.size(); ++i) {
-          float val = g_cachedMeasurementValues[i];
-          float r, g, b;
-
-          if (val < 0 || val < MIN_VALID_VALUE) {
-            r = g = b = 0.5f; // Gray for invalid values
-          }
-          else if (maxValidValue == minValidValue) {
-            r = 0.0f; g = 1.0f; b = 0.0f; // Green for single value
-          }
-          else {
-            float normalizedValue = (val - minValidValue) / (maxValidValue - minValidValue);
-            normalizedValue = std::max(0.0f, std::min(1.0f, normalizedValue));
-            valueToColor(normalizedValue, r, g, b);
-          }
-
-          pointColors.push_back(r);
-          pointColors.push_back(g);
-          pointColors.push_back(b);
-        }
-
-        colorsCalculated = true;
-        g_needsColorUpdate = false;
-        std::cout << "Point colors calculated for " << g_cachedMeasurementValues.size() << " points" << std::endl;
+    else if (!g_cachedPointIndices.empty() && !g_cachedMeasurementValues.empty()) {
+      // Draw all points in one call, coloured by the per-vertex colour attribute
+      if (drawCloud) {
+        glUniform1i(useVertexColorLocation, 1);
+        glDrawElements(GL_POINTS, static_cast<GLsizei>(replayPointCount), GL_UNSIGNED_INT,
+          (void*)(replayFirstPoint * sizeof(unsigned int)));
+        glUniform1i(useVertexColorLocation, 0);
       }
 
-      // Draw each point with its individual color
-      for (size_t i = 0; i < g_cachedPointIndices.size() && i < pointColors.size() / 3; ++i) {
-        float r = pointColors[i * 3];
-        float g = pointColors[i * 3 + 1];
-        float b = pointColors[i * 3 + 2];
-        glUniform3f(colorLocation, r, g, b);
+      // Selected points in magenta on top of the cloud, in one draw
+      if (g_selectionIndexCount > 0) {
+        glDisable(GL_DEPTH_TEST);
+        glUniform3f(colorLocation, 1.0f, 0.45f, 1.0f);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_selectionEBO);
+        glDrawElements(GL_POINTS, static_cast<GLsizei>(g_selectionIndexCount), GL_UNSIGNED_INT, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_pointEBO);
+        glEnable(GL_DEPTH_TEST);
+      }
 
-        // Draw single point
-        glDrawElements(GL_POINTS, 1, GL_UNSIGNED_INT, (void*)(i * sizeof(unsigned int)));
+      // Hovered point in white on top of everything
+      if (g_hoverPick.hit) {
+        glDisable(GL_DEPTH_TEST);
+        glUniform3f(colorLocation, 1.0f, 1.0f, 1.0f);
+        glDrawArrays(GL_POINTS, static_cast<GLint>(g_hoverPick.index), 1);
+        glEnable(GL_DEPTH_TEST);
       }
     }
     else {
       std::cout << "Warning: No point data to render" << std::endl;
     }
 
+    if (playbackBuffers == nullptr) {
+      renderBeamContours(colorLocation);
+    }
+
     // Unbind everything
     glBindVertexArray(0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+    if (!InputHandler::isSelecting() && playbackBuffers == nullptr) {
+      showHoverTooltip();
+    }
+    showSelectionWindow();
+    showCatalogWindow();
+    showMemoryWindow();
+    showPlaybackWindow();
+    showReplayWindow();
+    showCompareWindow();
+    showSimilarityWindow();
+    showFitWindow();
+    showPeaksWindow();
+    showHysteresisWindow();
+    showDenoiseWindow();
+    showSurfaceWindow();
+    showVolumeWindow();
+    showSlicesWindow();
+    showBeamWidthWindow();
+    drawSelectionOverlay();
+    ImGui::Render();
+    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
     glfwSwapBuffers(window);
     glfwPollEvents();
   }
 
   // Cleanup
+  if (g_catalogThread.joinable()) g_catalogThread.join();
+  cancelSimilarity();
+  cancelVolumeGrid();
+  ImGui_ImplOpenGL3_Shutdown();
+  ImGui_ImplGlfw_Shutdown();
+  ImGui::DestroyContext();
+
   glDeleteVertexArrays(1, &g_lineVAO);
   glDeleteVertexArrays(1, &g_pointVAO);
   glDeleteVertexArrays(1, &g_boxVAO);
-  glDeleteBuffers(1, &g_VBO);
   glDeleteBuffers(1, &g_lineEBO);
   glDeleteBuffers(1, &g_pointEBO);
+  glDeleteBuffers(1, &g_selectionEBO);
+  glDeleteBuffers(1, &g_diffColorBuffer);
+  glDeleteBuffers(1, &g_peakColorBuffer);
+  glDeleteBuffers(1, &g_denoiseColorBuffer);
+  glDeleteVertexArrays(1, &g_surfaceVAO);
+  glDeleteBuffers(1, &g_surfaceVertexBuffer);
+  glDeleteBuffers(1, &g_surfaceEBO);
+  for (IsoLevel& level : g_isoLevels) {
+    glDeleteVertexArrays(1, &level.vao);
+    glDeleteBuffers(1, &level.vertexBuffer);
+    glDeleteBuffers(1, &level.colorBuffer);
+    glDeleteBuffers(1, &level.ebo);
+  }
   glDeleteBuffers(1, &g_boxVBO);
   glDeleteBuffers(1, &g_boxEBO);
-
+  glDeleteTextures(1, &g_similarityTexture);
+  glDeleteTextures(3, g_sliceTextures);
+  glDeleteVertexArrays(1, &g_sliceOutlineVAO);
+  glDeleteBuffers(1, &g_sliceOutlineVBO);
+  glDeleteVertexArrays(1, &g_beamVAO);
+  glDeleteBuffers(1, &g_beamVBO);
+
+  g_playback.stop();
+  VerticesLoader::getResidency().clear(); // Releases cached GPU buffers while the context exists
   VerticesLoader::clear();
   glfwTerminate();
   return 0;
@@ -0,0 +1,483 @@
+// Headless batch analyzer: summarises every scan file in one or more directories.
+// Shares the loader/analysis sources with the viewer but opens no window or GL context.
+#include "ScanAnalyzer.h"
+#include "ScanDiscovery.h"
+#include "ScanCatalog.h"
+#include "ScanSimilarity.h"
+#include "ScanFit.h"
+#include "ScanHysteresis.h"
+#include "ScanBeamWidth.h"
+#include "Benchmarks.h"
+#include "AsyncFileReader.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct BatchOptions {
+  std::vector<std::string> directories;
+  std::string csvPath = "scan_summary.csv";
+  std::string jsonPath;          // Empty = no JSON output
+  unsigned int threads = 0;      // 0 = all cores
+  float scaleFactor = 1000.0f;
+  bool scaling = false;          // Repeat the run at 1, 2, 4, ... threads
+  bool bench = false;            // Run the micro-benchmarks
+  std::string reader = "auto";   // auto, uring, pread or ifstream
+  size_t queueDepth = 64;        // Files in flight for the async reader
+  bool compareReaders = false;   // Time every reader backend
+  bool cold = false;             // Drop the files from the page cache before each timed run
+  bool listOnly = false;         // Discover and report the files without analyzing them
+  bool catalog = false;          // Update the roots' catalog files instead of writing summaries
+  std::string query;             // Catalog query to run after the update
+  size_t queryLimit = 50;        // Matches printed per query
+  bool catalogUpdate = true;     // false = query the saved catalogs as they are
+  std::string similarityPath;    // N x N similarity matrix CSV instead of summaries
+  SimilarityMetric metric = SimilarityMetric::Correlation;
+  int similarityCells = 32;      // Grid cells across the first scan's largest extent
+  std::string passFitsPath;      // Gaussian fit per axis pass (CSV) instead of summaries
+  std::string peakFitsPath;      // 3D Gaussian fit at each scan's maximum (CSV)
+  std::string hysteresisPath;    // Backlash, hysteresis and noise per scan, oldest first (CSV)
+  std::string beamWidthsPath;    // -3 dB and 1/e^2 contour metrics per scan, oldest first (CSV)
+  int beamGridResolution = 64;   // Grid nodes along a scan's longest extent for the contours
+};
+
+static void printUsage() {
+  std::cout << "Usage: scanBatch [options] <scan directory>...   (directories are searched recursively)" << std::endl;
+  std::cout << "  --csv <file>      Per-file summary CSV (default scan_summary.csv, '-' for none)" << std::endl;
+  std::cout << "  --json <file>     Per-file summary JSON" << std::endl;
+  std::cout << "  --threads <n>     Worker threads (default: all cores)" << std::endl;
+  std::cout << "  --scale <f>       Position scale factor (default 1000)" << std::endl;
+  std::cout << "  --scaling         Report throughput at 1, 2, 4, ... threads" << std::endl;
+  std::cout << "  --bench           Run the kernel micro-benchmarks" << std::endl;
+  std::cout << "  --reader <r>      auto, uring, pread or ifstream (reads run on I/O threads, parsing on the job pool)" << std::endl;
+  std::cout << "  --queue-depth <n> Files in flight for the async reader (default 64)" << std::endl;
+  std::cout << "  --compare-readers Time every reader backend on the same files" << std::endl;
+  std::cout << "  --cold            Evict the files from the page cache before each timed run" << std::endl;
+  std::cout << "  --list            Only discover the files and report the listing time" << std::endl;
+  std::cout << "  --catalog         Update the catalog file in each directory (only new/changed files are parsed)" << std::endl;
+  std::cout << "  --query <expr>    Query the catalog, e.g. \"peak>0.5 days<7 points>=1000\" (implies --catalog)" << std::endl;
+  std::cout << "  --limit <n>       Matches printed by --query (default 50)" << std::endl;
+  std::cout << "  --no-update       Query the saved catalogs without listing the directories" << std::endl;
+  std::cout << "  --similarity <f>  Write the pairwise similarity matrix of all scans (oldest first) as CSV" << std::endl;
+  std::cout << "  --metric <m>      correlation (default) or rmse" << std::endl;
+  std::cout << "  --cells <n>       Similarity grid cells across a scan's largest extent (default 32)" << std::endl;
+  std::cout << "  --fits <f>        Write a Gaussian fit of every axis pass as CSV (scaled units)" << std::endl;
+  std::cout << "  --peak-fits <f>   Write the 3D Gaussian fit around each scan's maximum as CSV" << std::endl;
+  std::cout << "  --hysteresis <f>  Write per-axis backlash/hysteresis and the noise floor of every scan (oldest first) as CSV" << std::endl;
+  std::cout << "  --beam-widths <f> Write -3 dB and 1/e^2 widths, area and ellipticity of every scan (oldest first) as CSV" << std::endl;
+  std::cout << "  --beam-grid <n>   Grid nodes across a scan's largest extent for --beam-widths (default 64)" << std::endl;
+}
+
+static bool parseArguments(int argc, char** argv, BatchOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--csv" && hasValue) options.csvPath = argv[++i];
+    else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+    else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+    else if (arg == "--scale" && hasValue) options.scaleFactor = static_cast<float>(std::atof(argv[++i]));
+    else if (arg == "--scaling") options.scaling = true;
+    else if (arg == "--bench") options.bench = true;
+    else if (arg == "--reader" && hasValue) options.reader = argv[++i];
+    else if (arg == "--queue-depth" && hasValue) options.queueDepth = static_cast<size_t>(std::max(1, std::atoi(argv[++i])));
+    else if (arg == "--compare-readers") options.compareReaders = true;
+    else if (arg == "--cold") options.cold = true;
+    else if (arg == "--list") options.listOnly = true;
+    else if (arg == "--catalog") options.catalog = true;
+    else if (arg == "--query" && hasValue) {
+      options.query = argv[++i];
+      options.catalog = true;
+    }
+    else if (arg == "--no-update") options.catalogUpdate = false;
+    else if (arg == "--limit" && hasValue) options.queryLimit = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+    else if (arg == "--similarity" && hasValue) options.similarityPath = argv[++i];
+    else if (arg == "--metric" && hasValue) {
+      std::string metric = argv[++i];
+      if (metric == "rmse") options.metric = SimilarityMetric::Rmse;
+      else if (metric == "correlation") options.metric = SimilarityMetric::Correlation;
+      else {
+        std::cerr << "Unknown metric: " << metric << std::endl;
+        return false;
+      }
+    }
+    else if (arg == "--cells" && hasValue) options.similarityCells = std::max(1, std::atoi(argv[++i]));
+    else if (arg == "--fits" && hasValue) options.passFitsPath = argv[++i];
+    else if (arg == "--peak-fits" && hasValue) options.peakFitsPath = argv[++i];
+    else if (arg == "--hysteresis" && hasValue) options.hysteresisPath = argv[++i];
+    else if (arg == "--beam-widths" && hasValue) options.beamWidthsPath = argv[++i];
+    else if (arg == "--beam-grid" && hasValue) options.beamGridResolution = std::max(2, std::atoi(argv[++i]));
+    else if (arg == "--help" || arg == "-h") return false;
+    else if (!arg.empty() && arg[0] == '-') {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+    else options.directories.push_back(arg);
+  }
+  return !options.directories.empty() || options.bench;
+}
+
+static void printThroughput(const std::vector<ScanSummary>& summaries, double seconds, unsigned int threads) {
+  size_t points = 0, bytes = 0, failed = 0;
+  for (const ScanSummary& s : summaries) {
+    points += s.pointCount;
+    bytes += s.fileBytes;
+    if (!s.ok) failed++;
+  }
+
+  std::cout << std::fixed << std::setprecision(2)
+    << "Analyzed " << summaries.size() << " files (" << failed << " failed) on " << threads << " threads in "
+    << seconds << " s: " << (summaries.size() / seconds) << " files/s, "
+    << (bytes / (1024.0 * 1024.0) / seconds) << " MB/s, "
+    << (points / 1e6 / seconds) << " Mpts/s" << std::defaultfloat << std::endl;
+}
+
+// Bring the catalogs up to date and optionally run a query against them
+static int runCatalog(const BatchOptions& options) {
+  ScanCatalog catalog;
+  if (options.catalogUpdate) {
+    CatalogUpdateStats update = catalog.update(options.directories, options.scaleFactor);
+    std::cout << "Catalog: " << catalog.size() << " scans (" << update.added << " added, " << update.changed
+      << " changed, " << update.removed << " removed, " << update.unchanged << " unchanged) in "
+      << std::fixed << std::setprecision(1) << update.milliseconds << " ms" << std::defaultfloat << std::endl;
+  }
+  else {
+    auto start = std::chrono::steady_clock::now();
+    catalog.load(options.directories);
+    std::cout << "Catalog: " << catalog.size() << " scans loaded in " << std::fixed << std::setprecision(1)
+      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms"
+      << std::defaultfloat << std::endl;
+  }
+  if (options.query.empty()) return 0;
+
+  CatalogQuery query;
+  std::string error;
+  if (!ScanCatalog::parseQuery(options.query, query, error)) {
+    std::cerr << "Bad query: " << error << std::endl;
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<size_t> matches = catalog.query(query, ScanCatalog::currentTime());
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  std::cout << matches.size() << " of " << catalog.size() << " scans match \"" << options.query << "\" ("
+    << std::fixed << std::setprecision(3) << ms << " ms)" << std::defaultfloat << std::endl;
+
+  const std::vector<CatalogRecord>& records = catalog.getRecords();
+  for (size_t m = 0; m < matches.size() && m < options.queryLimit; ++m) {
+    const CatalogRecord& r = records[matches[m]];
+    std::time_t time = static_cast<std::time_t>(r.timestamp);
+    char date[32];
+    std::strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", std::gmtime(&time));
+    std::cout << "  " << date << "  points " << std::setw(7) << r.pointCount << "  peak " << std::setw(12) << r.peakValue
+      << " at (" << r.peakX << ", " << r.peakY << ", " << r.peakZ << ")  " << catalog.getPaths()[matches[m]] << std::endl;
+  }
+  if (matches.size() > options.queryLimit) std::cout << "  ... " << (matches.size() - options.queryLimit) << " more" << std::endl;
+  return 0;
+}
+
+// Scheduler activity for the last timed run
+static void printJobCounters() {
+  JobCounters counters = JobSystem::getCounters();
+  std::cout << "  jobs: " << counters.tasksExecuted << " executed, " << counters.steals << " stolen, "
+    << std::fixed << std::setprecision(1) << counters.idleMilliseconds << " ms worker idle on "
+    << counters.threadCount << " threads" << std::defaultfloat << std::endl;
+}
+
+// Pairwise similarity of every scan, written as an N x N CSV
+static int runSimilarity(const BatchOptions& options, const std::vector<std::string>& files) {
+  SimilarityOptions similarityOptions;
+  similarityOptions.cellsPerAxis = options.similarityCells;
+  similarityOptions.scaleFactor = options.scaleFactor;
+
+  SimilarityMatrix matrix;
+  JobSystem::resetCounters();
+  if (!ScanSimilarity::compute(files, similarityOptions, matrix)) {
+    std::cerr << "No readable scans" << std::endl;
+    return 1;
+  }
+  size_t n = matrix.size();
+  std::cout << std::fixed << std::setprecision(1) << "Similarity: " << n << " scans (" << matrix.failed.size()
+    << " unreadable) on " << matrix.cellCount << " grid cells of " << std::setprecision(3) << matrix.cellSize
+    << std::setprecision(1) << ", resampled in " << matrix.resampleMilliseconds << " ms, "
+    << n * (n + 1) / 2 << " pairs in " << matrix.matrixMilliseconds << " ms" << std::defaultfloat << std::endl;
+  printJobCounters();
+
+  std::ofstream out(options.similarityPath);
+  if (!out) {
+    std::cerr << "Cannot write " << options.similarityPath << std::endl;
+    return 1;
+  }
+  ScanSimilarity::writeCsv(out, matrix, options.metric);
+  std::cout << "Wrote " << ScanSimilarity::getMetricName(options.metric) << " matrix to " << options.similarityPath << std::endl;
+  return 0;
+}
+
+// Gaussian beam-profile fits of every file, one CSV row per pass and/or per scan
+static int runFits(const BatchOptions& options, const std::vector<std::string>& files) {
+  ScanFitOptions fitOptions;
+  JobSystem::resetCounters();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<ScanFitResult> results = ScanFit::fitFiles(files, options.scaleFactor, fitOptions);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t fits = 0, converged = 0, failed = 0;
+  double fitMilliseconds = 0.0;
+  for (const ScanFitResult& result : results) {
+    if (!result.ok) {
+      std::cerr << "  " << result.filePath << ": " << result.error << std::endl;
+      failed++;
+      continue;
+    }
+    fits += result.fitCount;
+    fitMilliseconds += result.fitMilliseconds;
+    for (const PassFit& pass : result.passes) {
+      if (pass.converged) converged++;
+    }
+    if (result.peak.converged) converged++;
+  }
+  // Fitting time alone (summed over files) and end to end including reading and parsing
+  std::cout << std::fixed << std::setprecision(1) << "Fitted " << files.size() - failed << " scans (" << failed
+    << " failed): " << fits << " fits, " << converged << " converged, " << std::setprecision(0)
+    << (fitMilliseconds > 0.0 ? fits / (fitMilliseconds / 1000.0) : 0.0) << " fits/s fitting, "
+    << (seconds > 0.0 ? fits / seconds : 0.0) << " fits/s with parsing" << std::defaultfloat << std::endl;
+  printJobCounters();
+
+  if (!options.passFitsPath.empty()) {
+    std::ofstream out(options.passFitsPath);
+    if (!out) {
+      std::cerr << "Cannot write " << options.passFitsPath << std::endl;
+      return 1;
+    }
+    ScanFit::writePassCsv(out, results);
+    std::cout << "Wrote pass fits to " << options.passFitsPath << std::endl;
+  }
+  if (!options.peakFitsPath.empty()) {
+    std::ofstream out(options.peakFitsPath);
+    if (!out) {
+      std::cerr << "Cannot write " << options.peakFitsPath << std::endl;
+      return 1;
+    }
+    ScanFit::writePeakCsv(out, results);
+    std::cout << "Wrote peak fits to " << options.peakFitsPath << std::endl;
+  }
+  return 0;
+}
+
+// Forward/reverse pass lag of every scan, oldest first so actuator wear reads down the rows
+static int runHysteresis(const BatchOptions& options, const std::vector<ScanFileEntry>& chronological) {
+  std::vector<std::string> files;
+  for (const ScanFileEntry& entry : chronological) files.push_back(entry.path);
+  JobSystem::resetCounters();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<HysteresisResult> results = ScanHysteresis::analyzeFiles(files, options.scaleFactor);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t pairs = 0, failed = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    HysteresisResult& result = results[i];
+    if (!result.ok) {
+      std::cerr << "  " << result.filePath << ": " << result.error << std::endl;
+      failed++;
+      continue;
+    }
+    // Files without measurement timestamps fall back to the name/modification time
+    if (result.startTime == 0.0) result.startTime = static_cast<double>(chronological[i].timestamp);
+    pairs += result.pairs.size();
+  }
+  std::cout << std::fixed << std::setprecision(1) << "Hysteresis: " << files.size() - failed << " scans (" << failed
+    << " failed), " << pairs << " pass pairs in " << seconds * 1000.0 << " ms" << std::defaultfloat << std::endl;
+  printJobCounters();
+
+  std::ofstream out(options.hysteresisPath);
+  if (!out) {
+    std::cerr << "Cannot write " << options.hysteresisPath << std::endl;
+    return 1;
+  }
+  ScanHysteresis::writeCsv(out, results);
+  std::cout << "Wrote hysteresis to " << options.hysteresisPath << std::endl;
+  return failed == files.size() ? 1 : 0;
+}
+
+// Mode-field contour metrics of every scan, oldest first; files are analyzed as parallel jobs
+static int runBeamWidths(const BatchOptions& options, const std::vector<std::string>& chronological) {
+  BeamWidthOptions beamOptions;
+  beamOptions.grid.resolution = options.beamGridResolution;
+  JobSystem::resetCounters();
+  auto start = std::chrono::steady_clock::now();
+  std::vector<BeamWidthResult> results = ScanBeamWidth::analyzeFiles(chronological, options.scaleFactor, beamOptions);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t failed = 0, closed = 0;
+  for (const BeamWidthResult& result : results) {
+    if (!result.ok) {
+      std::cerr << "  " << result.filePath << ": " << result.error << std::endl;
+      failed++;
+      continue;
+    }
+    if (result.contours[0].closed) closed++;
+  }
+  std::cout << std::fixed << std::setprecision(1) << "Beam widths: " << chronological.size() - failed << " scans ("
+    << failed << " failed), " << closed << " with a closed -3 dB contour, in " << seconds * 1000.0 << " ms"
+    << std::defaultfloat << std::endl;
+  printJobCounters();
+
+  std::ofstream out(options.beamWidthsPath);
+  if (!out) {
+    std::cerr << "Cannot write " << options.beamWidthsPath << std::endl;
+    return 1;
+  }
+  ScanBeamWidth::writeCsv(out, results);
+  std::cout << "Wrote beam widths to " << options.beamWidthsPath << std::endl;
+  return failed == chronological.size() ? 1 : 0;
+}
+
+// "auto" keeps the reader's default (io_uring when available)
+static void selectBackend(AsyncFileReader& fileReader, const std::string& reader) {
+  if (reader == "uring") fileReader.setBackend(ReaderBackend::IoUring);
+  else if (reader == "pread") fileReader.setBackend(ReaderBackend::ThreadPool);
+  else if (reader == "ifstream") fileReader.setBackend(ReaderBackend::Stream);
+}
+
+static double timeRun(const BatchOptions& options, const std::string& reader, const std::vector<std::string>& files,
+  unsigned int threads, std::vector<ScanSummary>& summaries) {
+  if (options.cold) AsyncFileReader::evictFromPageCache(files);
+  JobSystem::resetCounters();
+
+  auto start = std::chrono::steady_clock::now();
+  AsyncFileReader fileReader(options.queueDepth);
+  selectBackend(fileReader, reader);
+  summaries = ScanAnalyzer::analyzeFilesAsync(files, options.scaleFactor, fileReader, threads);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string readerLabel(const BatchOptions& options, const std::string& reader) {
+  AsyncFileReader fileReader(options.queueDepth);
+  selectBackend(fileReader, reader);
+  return AsyncFileReader::getBackendName(fileReader.getBackend());
+}
+
+int main(int argc, char** argv) {
+  BatchOptions options;
+  if (!parseArguments(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  if (options.bench) {
+    Benchmarks::runAll();
+    if (options.directories.empty()) return 0;
+  }
+
+  if (options.catalog) return runCatalog(options);
+
+  ScanDiscoveryStats discovery;
+  std::vector<ScanFileEntry> entries = ScanDiscovery::discover(options.directories, true, &discovery);
+  std::cout << "Listed " << discovery.filesMatched << " scan files in " << discovery.directoriesVisited
+    << " directories in " << std::fixed << std::setprecision(1) << discovery.milliseconds << " ms ("
+    << discovery.statCalls << " needed a stat)" << std::defaultfloat << std::endl;
+  if (options.listOnly) return entries.empty() ? 1 : 0;
+
+  // Similarity rows run oldest to newest, so drift shows up along the diagonal
+  if (!options.similarityPath.empty()) {
+    std::vector<std::string> chronological;
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) chronological.push_back(it->path);
+    JobSystem::initialize(options.threads);
+    return runSimilarity(options, chronological);
+  }
+  if (!options.hysteresisPath.empty()) {
+    JobSystem::initialize(options.threads);
+    return runHysteresis(options, std::vector<ScanFileEntry>(entries.rbegin(), entries.rend()));
+  }
+  if (!options.beamWidthsPath.empty()) {
+    std::vector<std::string> chronological;
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) chronological.push_back(it->path);
+    JobSystem::initialize(options.threads);
+    return runBeamWidths(options, chronological);
+  }
+
+  // Summaries are written in path order
+  std::vector<std::string> files;
+  files.reserve(entries.size());
+  for (ScanFileEntry& entry : entries) files.push_back(std::move(entry.path));
+  std::sort(files.begin(), files.end());
+
+  if (files.empty()) {
+    std::cerr << "No scan files found" << std::endl;
+    return 1;
+  }
+
+  // Parsers run as jobs, so the pool is sized to the requested thread count
+  unsigned int threads = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+  JobSystem::initialize(threads);
+  std::cout << "Found " << files.size() << " scan files, using " << threads << " threads" << std::endl;
+  if (!options.passFitsPath.empty() || !options.peakFitsPath.empty()) return runFits(options, files);
+
+  std::vector<ScanSummary> summaries;
+  if (options.compareReaders) {
+    // Same files, same parser threads; only the way bytes reach the parsers changes
+    double baseline = 0.0;
+    for (const char* reader : { "ifstream", "pread", "uring" }) {
+      if (std::string(reader) == "uring" && !AsyncFileReader::isIoUringAvailable()) {
+        std::cout << "io_uring unavailable on this system, skipped" << std::endl;
+        continue;
+      }
+      double seconds = timeRun(options, reader, files, threads, summaries);
+      if (baseline == 0.0) baseline = seconds;
+      std::cout << "[" << readerLabel(options, reader) << (options.cold ? ", cold" : ", warm") << "] ";
+      printThroughput(summaries, seconds, threads);
+      printJobCounters();
+      std::cout << "  speedup vs ifstream pool " << std::fixed << std::setprecision(2) << (baseline / seconds) << "x" << std::defaultfloat << std::endl;
+    }
+  }
+  else if (options.scaling) {
+    // Single-thread baseline first, then doubling up to the requested count
+    double baseline = 0.0;
+    for (unsigned int t = 1; ; t = std::min(t * 2, threads)) {
+      double seconds = timeRun(options, options.reader, files, t, summaries);
+      if (t == 1) baseline = seconds;
+      printThroughput(summaries, seconds, t);
+      printJobCounters();
+      std::cout << "  speedup " << std::fixed << std::setprecision(2) << (baseline / seconds) << "x" << std::defaultfloat << std::endl;
+      if (t == threads) break;
+    }
+  }
+  else {
+    double seconds = timeRun(options, options.reader, files, threads, summaries);
+    std::cout << "[" << readerLabel(options, options.reader) << "] ";
+    printThroughput(summaries, seconds, threads);
+    printJobCounters();
+  }
+
+  for (const ScanSummary& s : summaries) {
+    if (!s.ok) std::cerr << "Failed: " << s.filePath << " (" << s.error << ")" << std::endl;
+  }
+
+  if (options.csvPath != "-") {
+    std::ofstream csv(options.csvPath);
+    if (!csv) {
+      std::cerr << "Cannot write " << options.csvPath << std::endl;
+      return 1;
+    }
+    ScanAnalyzer::writeCsv(csv, summaries);
+    std::cout << "Wrote " << options.csvPath << std::endl;
+  }
+
+  if (!options.jsonPath.empty()) {
+    std::ofstream json(options.jsonPath);
+    if (!json) {
+      std::cerr << "Cannot write " << options.jsonPath << std::endl;
+      return 1;
+    }
+    ScanAnalyzer::writeJson(json, summaries);
+    std::cout << "Wrote " << options.jsonPath << std::endl;
+  }
+
+  return 0;
+}